@@ -24,6 +24,8 @@ constexpr int32_t Constants::kOpenrSupportedVersion;
 constexpr int32_t Constants::kOpenrVersion;
 constexpr int64_t Constants::kDefaultAdjWeight;
 constexpr int64_t Constants::kTtlInfinity;
+constexpr size_t Constants::kFibMaxInflightChunks;
+constexpr size_t Constants::kFibProgrammingChunkSize;
 constexpr size_t Constants::kMaxFullSyncPendingCountThreshold;
 constexpr size_t Constants::kNumTimeSeries;
 constexpr std::chrono::milliseconds Constants::kAdjacencyThrottleTimeout;
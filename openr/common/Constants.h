@@ -81,6 +81,11 @@ class Constants {
   static constexpr std::chrono::milliseconds kFibInitialBackoff{8};
   static constexpr std::chrono::milliseconds kFibMaxBackoff{4096};
 
+  // Maximum number of routes (or route keys) programmed in a single call to
+  // platform agent, and maximum number of such calls in flight
+  static constexpr size_t kFibProgrammingChunkSize{1000};
+  static constexpr size_t kFibMaxInflightChunks{4};
+
   // Persistent-Store
   static constexpr std::chrono::milliseconds kPersistentStoreInitialBackoff{
       100};
@@ -171,6 +176,14 @@ class Constants {
   // Kvstore timer for flooding pending publication
   static constexpr std::chrono::milliseconds kFloodPendingPublication{100};
 
+  // Kvstore per-peer flood control. Window of in-flight flooding requests
+  // towards a peer grows by one per timely response and halves when response
+  // latency goes beyond the target.
+  static constexpr size_t kFloodPeerMinWindow{1};
+  static constexpr size_t kFloodPeerInitWindow{8};
+  static constexpr size_t kFloodPeerMaxWindow{32};
+  static constexpr std::chrono::milliseconds kFloodPeerLatencyTarget{500};
+
   // delimiter separating prefix and name in kvstore key
   static constexpr folly::StringPiece kPrefixNameSeparator{":"};
 
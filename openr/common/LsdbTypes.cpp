@@ -51,4 +51,41 @@ PrefixKey::fromStr(const std::string& key, const std::string& areaIn) {
   return PrefixKey(node, network, areaIn);
 }
 
+PrefixShardKey::PrefixShardKey(
+    std::string const& node, uint32_t shardId, const std::string& area)
+    : nodeAndArea_(node, area),
+      shardId_(shardId),
+      prefixShardKeyString_(fmt::format(
+          "{}{}:shard:{}",
+          Constants::kPrefixDbMarker.toString(),
+          node,
+          shardId)) {}
+
+folly::Expected<PrefixShardKey, std::string>
+PrefixShardKey::fromStr(const std::string& key, const std::string& areaIn) {
+  uint32_t shardId{0};
+  std::string node{};
+
+  if (not RE2::FullMatch(
+          key, PrefixShardKey::getPrefixShardRE2(), &node, &shardId)) {
+    return folly::makeUnexpected(
+        fmt::format("Invalid format for key: {}.", key));
+  }
+  return PrefixShardKey(node, shardId, areaIn);
+}
+
+bool
+PrefixShardKey::isPrefixShardKey(const std::string& key) {
+  return RE2::FullMatch(key, PrefixShardKey::getPrefixShardRE2());
+}
+
+uint32_t
+PrefixShardKey::getShardOf(
+    folly::CIDRNetwork const& prefix, uint32_t numShards) {
+  CHECK_GT(numShards, 0);
+  // ATTN: IPAddress hash only depends on address bytes, hence is stable
+  return folly::hash::hash_combine(prefix.first.hash(), prefix.second) %
+      numShards;
+}
+
 } // namespace openr
@@ -503,6 +503,90 @@ class PrefixKey {
   std::string const prefixKeyStringV2_;
 };
 
+/**
+ * PrefixShardKey class to form and parse key of a packed prefix database.
+ * Instead of one key per prefix, a node can hash its prefixes into a fixed
+ * number of shards and advertise every shard as a single key carrying all of
+ * its prefix entries.
+ *
+ * Sample format:
+ * prefix    :    node1    :    shard    :    12
+ *   |              |             |            |
+ * marker         nodeId     shard marker   shardId
+ */
+class PrefixShardKey {
+ public:
+  // constructor using node, shard id and area
+  PrefixShardKey(
+      std::string const& node, uint32_t shardId, const std::string& area);
+
+  // construct PrefixShardKey object from a give key string
+  static folly::Expected<PrefixShardKey, std::string> fromStr(
+      const std::string& key,
+      const std::string& area = Constants::kDefaultArea.toString());
+
+  static const RE2&
+  getPrefixShardRE2() {
+    static const RE2 prefixShardKeyPattern{fmt::format(
+        "{}(?P<node>[a-zA-Z\\d\\.\\-\\_]+):"
+        "shard:(?P<shardId>[\\d]{{1,10}})",
+        Constants::kPrefixDbMarker.toString())};
+    return prefixShardKeyPattern;
+  }
+
+  // return true if key string is of packed prefix database format
+  static bool isPrefixShardKey(const std::string& key);
+
+  // return shard a prefix is packed into, out of `numShards` shards. Stable
+  // across restarts so that a node re-advertises same keys
+  static uint32_t getShardOf(
+      folly::CIDRNetwork const& prefix, uint32_t numShards);
+
+  // return node name and area pair
+  inline NodeAndArea const&
+  getNodeAndArea() const {
+    return nodeAndArea_;
+  }
+
+  // return node name
+  inline std::string const&
+  getNodeName() const {
+    return nodeAndArea_.first;
+  }
+
+  // return area of the key
+  inline std::string const&
+  getPrefixArea() const {
+    return nodeAndArea_.second;
+  }
+
+  inline uint32_t
+  getShardId() const {
+    return shardId_;
+  }
+
+  // return raw prefix shard key string from kvstore
+  inline std::string const&
+  getPrefixShardKey() const {
+    return prefixShardKeyString_;
+  }
+
+  bool
+  operator==(openr::PrefixShardKey const& other) const {
+    return shardId_ == other.shardId_ && nodeAndArea_ == other.nodeAndArea_;
+  }
+
+ private:
+  // node name
+  NodeAndArea nodeAndArea_;
+
+  // shard index
+  uint32_t shardId_{0};
+
+  // raw key string from KvStore
+  std::string prefixShardKeyString_;
+};
+
 } // namespace openr
 
 template <>
@@ -515,3 +599,14 @@ struct std::hash<openr::PrefixKey> {
         prefixKey.getPrefixArea());
   }
 };
+
+template <>
+struct std::hash<openr::PrefixShardKey> {
+  size_t
+  operator()(openr::PrefixShardKey const& prefixShardKey) const {
+    return folly::hash::hash_combine(
+        prefixShardKey.getNodeName(),
+        prefixShardKey.getShardId(),
+        prefixShardKey.getPrefixArea());
+  }
+};
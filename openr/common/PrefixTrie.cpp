@@ -0,0 +1,203 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include <folly/lang/Bits.h>
+
+#include <openr/common/PrefixTrie.h>
+
+namespace openr {
+
+bool
+PrefixTrie::insert(const folly::CIDRNetwork& prefix) {
+  const auto key = toKey(prefix);
+  const uint8_t len = prefix.second;
+
+  auto* cur = &getRoot(prefix.first);
+  while (true) {
+    if (not *cur) {
+      // Empty sub-trie. Add leaf
+      *cur = std::make_unique<Node>(key, len);
+      (*cur)->prefix = prefix;
+      ++size_;
+      return true;
+    }
+
+    auto* node = cur->get();
+    const auto commonLen =
+        getCommonPrefixLen(node->key, key, std::min(node->len, len));
+    if (commonLen == node->len) {
+      if (node->len == len) {
+        // Prefix maps to an existing node
+        if (node->prefix.has_value()) {
+          return false;
+        }
+        node->prefix = prefix;
+        ++size_;
+        return true;
+      }
+      // Node covers prefix. Descend
+      cur = &node->children.at(getBit(key, node->len));
+      continue;
+    }
+
+    // Prefix diverges from node (or covers it). Split at the common bits
+    auto split = std::make_unique<Node>(maskKey(key, commonLen), commonLen);
+    const auto nodeBit = getBit(node->key, commonLen);
+    split->children.at(nodeBit) = std::move(*cur);
+    if (commonLen == len) {
+      split->prefix = prefix;
+    } else {
+      auto leaf = std::make_unique<Node>(key, len);
+      leaf->prefix = prefix;
+      split->children.at(1 - nodeBit) = std::move(leaf);
+    }
+    *cur = std::move(split);
+    ++size_;
+    return true;
+  }
+}
+
+bool
+PrefixTrie::erase(const folly::CIDRNetwork& prefix) {
+  const auto key = toKey(prefix);
+  const uint8_t len = prefix.second;
+
+  std::unique_ptr<Node>* parent{nullptr};
+  auto* cur = &getRoot(prefix.first);
+  while (*cur) {
+    auto* node = cur->get();
+    if (node->len > len or
+        getCommonPrefixLen(node->key, key, node->len) < node->len) {
+      return false;
+    }
+    if (node->len == len) {
+      break;
+    }
+    parent = cur;
+    cur = &node->children.at(getBit(key, node->len));
+  }
+  if (not *cur or not (*cur)->prefix.has_value()) {
+    return false;
+  }
+
+  (*cur)->prefix.reset();
+  --size_;
+
+  // Removing node may leave its parent with a single child
+  compact(*cur);
+  if (parent) {
+    compact(*parent);
+  }
+  return true;
+}
+
+bool
+PrefixTrie::contains(const folly::CIDRNetwork& prefix) const {
+  const auto match = longestPrefixMatch(prefix);
+  return match.has_value() and match->second == prefix.second;
+}
+
+std::optional<folly::CIDRNetwork>
+PrefixTrie::longestPrefixMatch(const folly::CIDRNetwork& prefix) const {
+  const auto key = toKey(prefix);
+  const uint8_t len = prefix.second;
+
+  const Node* match{nullptr};
+  const auto* node = getRoot(prefix.first).get();
+  while (node) {
+    if (node->len > len or
+        getCommonPrefixLen(node->key, key, node->len) < node->len) {
+      break;
+    }
+    if (node->prefix.has_value()) {
+      match = node;
+    }
+    if (node->len == len) {
+      break;
+    }
+    node = node->children.at(getBit(key, node->len)).get();
+  }
+
+  if (not match) {
+    return std::nullopt;
+  }
+  return match->prefix;
+}
+
+void
+PrefixTrie::clear() {
+  v4Root_.reset();
+  v6Root_.reset();
+  size_ = 0;
+}
+
+std::unique_ptr<PrefixTrie::Node>&
+PrefixTrie::getRoot(const folly::IPAddress& addr) {
+  return addr.isV4() ? v4Root_ : v6Root_;
+}
+
+const std::unique_ptr<PrefixTrie::Node>&
+PrefixTrie::getRoot(const folly::IPAddress& addr) const {
+  return addr.isV4() ? v4Root_ : v6Root_;
+}
+
+PrefixTrie::Key
+PrefixTrie::toKey(const folly::CIDRNetwork& prefix) {
+  Key key{};
+  const auto& addr = prefix.first;
+  std::copy(addr.bytes(), addr.bytes() + addr.byteCount(), key.begin());
+  return maskKey(key, prefix.second);
+}
+
+PrefixTrie::Key
+PrefixTrie::maskKey(Key key, uint8_t len) {
+  for (size_t i = len / 8; i < key.size(); ++i) {
+    // Number of bits of this byte to keep
+    const size_t numBits = len > i * 8 ? std::min<size_t>(8, len - i * 8) : 0;
+    key[i] &= static_cast<uint8_t>(0xff << (8 - numBits));
+  }
+  return key;
+}
+
+uint8_t
+PrefixTrie::getBit(const Key& key, uint8_t index) {
+  return (key.at(index / 8) >> (7 - index % 8)) & 0x1;
+}
+
+uint8_t
+PrefixTrie::getCommonPrefixLen(const Key& a, const Key& b, uint8_t maxLen) {
+  uint8_t len{0};
+  for (size_t i = 0; i < a.size() and len < maxLen; ++i) {
+    const uint8_t diff = a[i] ^ b[i];
+    if (diff) {
+      // Add leading equal bits of the first differing byte
+      len += 8 - folly::findLastSet(diff);
+      return std::min(len, maxLen);
+    }
+    len += 8;
+  }
+  return std::min(len, maxLen);
+}
+
+void
+PrefixTrie::compact(std::unique_ptr<Node>& node) {
+  if (not node or node->prefix.has_value()) {
+    return;
+  }
+
+  auto& [zero, one] = node->children;
+  if (zero and one) {
+    return;
+  }
+  // Replace node with its only child, if any
+  auto child = std::move(zero ? zero : one);
+  node = std::move(child);
+}
+
+} // namespace openr
@@ -0,0 +1,109 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <array>
+#include <memory>
+#include <optional>
+
+#include <folly/IPAddress.h>
+
+namespace openr {
+
+/**
+ * Set of IP prefixes supporting longest prefix match lookups.
+ *
+ * Implemented as a path-compressed binary trie (one per address family). Every
+ * node either holds a prefix of the set or branches into two sub-tries, hence
+ * number of nodes is bounded by twice the number of prefixes and lookup cost
+ * is bounded by the address length (32 or 128 bits) irrespective of the
+ * number of prefixes.
+ */
+class PrefixTrie {
+ public:
+  PrefixTrie() = default;
+  ~PrefixTrie() = default;
+
+  PrefixTrie(PrefixTrie&&) = default;
+  PrefixTrie& operator=(PrefixTrie&&) = default;
+
+  /**
+   * Add prefix to the set. Returns false if prefix already exists.
+   * NOTE: Host bits of prefix are ignored
+   */
+  bool insert(const folly::CIDRNetwork& prefix);
+
+  /**
+   * Remove prefix from the set. Returns false if prefix doesn't exist.
+   */
+  bool erase(const folly::CIDRNetwork& prefix);
+
+  /**
+   * Returns true if exact prefix exists in the set
+   */
+  bool contains(const folly::CIDRNetwork& prefix) const;
+
+  /**
+   * Return the longest prefix in the set covering given prefix (or address,
+   * when specified with full mask length), if any.
+   */
+  std::optional<folly::CIDRNetwork> longestPrefixMatch(
+      const folly::CIDRNetwork& prefix) const;
+
+  void clear();
+
+  size_t
+  size() const {
+    return size_;
+  }
+
+  bool
+  empty() const {
+    return size_ == 0;
+  }
+
+ private:
+  // No-copy
+  PrefixTrie(const PrefixTrie&) = delete;
+  PrefixTrie& operator=(const PrefixTrie&) = delete;
+
+  // Address bits in network byte order. IPv4 uses first 4 bytes only
+  using Key = std::array<uint8_t, 16>;
+
+  struct Node {
+    Node(const Key& key, uint8_t len) : key(key), len(len) {}
+
+    // Masked to `len` bits
+    Key key;
+    uint8_t len{0};
+
+    // Prefix as inserted. Set only for nodes holding prefix of the set
+    std::optional<folly::CIDRNetwork> prefix;
+
+    // Sub-tries for next bit being 0 and 1
+    std::array<std::unique_ptr<Node>, 2> children;
+  };
+
+  // Root of trie for the address family of prefix
+  std::unique_ptr<Node>& getRoot(const folly::IPAddress& addr);
+  const std::unique_ptr<Node>& getRoot(const folly::IPAddress& addr) const;
+
+  static Key toKey(const folly::CIDRNetwork& prefix);
+  static Key maskKey(Key key, uint8_t len);
+  static uint8_t getBit(const Key& key, uint8_t index);
+  static uint8_t getCommonPrefixLen(const Key& a, const Key& b, uint8_t maxLen);
+
+  // Remove node if it holds no prefix and has less than two children
+  static void compact(std::unique_ptr<Node>& node);
+
+  std::unique_ptr<Node> v4Root_;
+  std::unique_ptr<Node> v6Root_;
+  size_t size_{0};
+};
+
+} // namespace openr
@@ -44,4 +44,225 @@ RegexSet::match(std::string const& key) const {
   return regexSet_->Match(key, &matches);
 }
 
+TtlCountdownQueue::TtlCountdownQueue(
+    std::chrono::steady_clock::time_point startTime)
+    : startTime_(startTime), slots_(kLevels * kSlots, kInvalidId) {}
+
+int64_t
+TtlCountdownQueue::toTick(
+    std::chrono::steady_clock::time_point time, bool roundUp) const {
+  if (time <= startTime_) {
+    return 0;
+  }
+  const auto elapsed =
+      std::chrono::duration_cast<std::chrono::nanoseconds>(time - startTime_)
+          .count();
+  const auto tick = std::chrono::nanoseconds(kTick).count();
+  return roundUp ? (elapsed + tick - 1) / tick : elapsed / tick;
+}
+
+void
+TtlCountdownQueue::link(uint32_t id, int64_t minDelta) {
+  auto& node = nodes_[id];
+
+  // entries already due are expired on the earliest tick allowed
+  const int64_t delta =
+      std::max<int64_t>(node.expiryTick - currentTick_, minDelta);
+
+  // pick the finest level covering `delta`. Entries beyond the range of the
+  // wheel are parked in the farthest slot and cascaded again later.
+  uint32_t level = 0;
+  while (level + 1 < kLevels and
+         delta >= (int64_t{1} << (kSlotBits * (level + 1)))) {
+    ++level;
+  }
+  const int64_t maxDelta = (int64_t{1} << (kSlotBits * kLevels)) - 1;
+  const int64_t tick = currentTick_ + std::min(delta, maxDelta);
+  const uint32_t slot =
+      level * kSlots + ((tick >> (kSlotBits * level)) & (kSlots - 1));
+
+  node.slot = slot;
+  node.prev = kInvalidId;
+  node.next = slots_[slot];
+  if (node.next != kInvalidId) {
+    nodes_[node.next].prev = id;
+  }
+  slots_[slot] = id;
+  ++levelSizes_[level];
+}
+
+void
+TtlCountdownQueue::unlink(uint32_t id) {
+  auto& node = nodes_[id];
+  if (node.prev != kInvalidId) {
+    nodes_[node.prev].next = node.next;
+  } else {
+    slots_[node.slot] = node.next;
+  }
+  if (node.next != kInvalidId) {
+    nodes_[node.next].prev = node.prev;
+  }
+  --levelSizes_[node.slot / kSlots];
+  node.slot = kInvalidId;
+  node.prev = kInvalidId;
+  node.next = kInvalidId;
+}
+
+void
+TtlCountdownQueue::cascade(uint32_t slot) {
+  while (slots_[slot] != kInvalidId) {
+    const auto id = slots_[slot];
+    unlink(id);
+    // current slot of level 0 is processed right after cascading
+    link(id, 0 /* minDelta */);
+  }
+}
+
+void
+TtlCountdownQueue::push(TtlCountdownQueueEntry entry) {
+  // round up so that entries never expire early
+  const auto expiryTick = toTick(entry.expiryTime, true /* roundUp */);
+
+  auto it = keyToId_.find(entry.key);
+  if (it != keyToId_.end()) {
+    // refresh in place, key is already interned
+    const auto id = it->second;
+    auto& node = nodes_[id];
+    node.entry.expiryTime = entry.expiryTime;
+    node.entry.version = entry.version;
+    node.entry.ttlVersion = entry.ttlVersion;
+    node.entry.originatorId = std::move(entry.originatorId);
+    // Extending the expiry (i.e. ttl refresh) leaves the node in its slot. It
+    // is re-linked once the slot is processed. Only move it for earlier expiry.
+    const bool earlier = expiryTick < node.expiryTick;
+    node.expiryTick = expiryTick;
+    if (earlier) {
+      unlink(id);
+      link(id, 1 /* minDelta */);
+    }
+    return;
+  }
+
+  uint32_t id;
+  if (freeIds_.empty()) {
+    id = nodes_.size();
+    nodes_.emplace_back();
+  } else {
+    id = freeIds_.back();
+    freeIds_.pop_back();
+  }
+  auto& node = nodes_[id];
+  node.entry = std::move(entry);
+  node.expiryTick = expiryTick;
+  keyToId_.emplace(node.entry.key, id);
+  link(id, 1 /* minDelta */);
+}
+
+bool
+TtlCountdownQueue::erase(std::string const& key) {
+  auto it = keyToId_.find(key);
+  if (it == keyToId_.end()) {
+    return false;
+  }
+  const auto id = it->second;
+  keyToId_.erase(it);
+  unlink(id);
+  nodes_[id].entry = TtlCountdownQueueEntry{};
+  freeIds_.emplace_back(id);
+  return true;
+}
+
+TtlCountdownQueueEntry const*
+TtlCountdownQueue::find(std::string const& key) const {
+  auto it = keyToId_.find(key);
+  return it == keyToId_.end() ? nullptr : &nodes_[it->second].entry;
+}
+
+std::optional<std::chrono::steady_clock::time_point>
+TtlCountdownQueue::getNextExpiryTime() const {
+  std::optional<int64_t> nextTick;
+  for (uint32_t level = 0; level < kLevels; ++level) {
+    if (levelSizes_[level] == 0) {
+      continue;
+    }
+    // first non-empty slot after the current one. Slot of level `l` is
+    // processed once the lower levels wrap around to it.
+    const auto shift = kSlotBits * level;
+    const int64_t base = currentTick_ >> shift;
+    for (int64_t i = 1; i <= kSlots; ++i) {
+      if (slots_[level * kSlots + ((base + i) & (kSlots - 1))] != kInvalidId) {
+        const int64_t tick = (base + i) << shift;
+        nextTick = nextTick ? std::min(*nextTick, tick) : tick;
+        break;
+      }
+    }
+  }
+  if (not nextTick) {
+    return std::nullopt;
+  }
+  return startTime_ + *nextTick * kTick;
+}
+
+std::vector<TtlCountdownQueueEntry>
+TtlCountdownQueue::popExpired(std::chrono::steady_clock::time_point now) {
+  std::vector<TtlCountdownQueueEntry> expired;
+  const auto nowTick = toTick(now, false /* roundUp */);
+
+  while (currentTick_ < nowTick) {
+    if (empty()) {
+      currentTick_ = nowTick;
+      break;
+    }
+
+    // skip empty levels straight to the next tick something can happen
+    uint32_t level = 0;
+    while (levelSizes_[level] == 0) {
+      ++level;
+    }
+    if (level > 0) {
+      const auto shift = kSlotBits * level;
+      const int64_t nextTick = ((currentTick_ >> shift) + 1) << shift;
+      if (nextTick > nowTick) {
+        currentTick_ = nowTick;
+        break;
+      }
+      currentTick_ = nextTick - 1;
+    }
+
+    ++currentTick_;
+
+    // cascade slots of higher levels whose time has come
+    for (uint32_t l = kLevels - 1; l > 0; --l) {
+      const auto shift = kSlotBits * l;
+      if ((currentTick_ & ((int64_t{1} << shift) - 1)) == 0) {
+        cascade(l * kSlots + ((currentTick_ >> shift) & (kSlots - 1)));
+      }
+    }
+
+    // expire the current slot. Nodes refreshed after being linked are due
+    // later and get re-linked instead.
+    const uint32_t slot = currentTick_ & (kSlots - 1);
+    uint32_t pending = slots_[slot];
+    slots_[slot] = kInvalidId;
+    while (pending != kInvalidId) {
+      const auto id = pending;
+      auto& node = nodes_[id];
+      pending = node.next;
+      --levelSizes_[0];
+      node.slot = kInvalidId;
+      node.prev = kInvalidId;
+      node.next = kInvalidId;
+      if (node.expiryTick > currentTick_) {
+        link(id, 1 /* minDelta */);
+        continue;
+      }
+      keyToId_.erase(node.entry.key);
+      expired.emplace_back(std::move(node.entry));
+      node.entry = TtlCountdownQueueEntry{};
+      freeIds_.emplace_back(id);
+    }
+  }
+  return expired;
+}
+
 } // namespace openr
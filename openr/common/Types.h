@@ -9,9 +9,12 @@
 
 #include <re2/re2.h>
 #include <re2/set.h>
+#include <array>
+#include <deque>
+#include <limits>
+#include <string_view>
 #include <variant>
 
-#include <boost/heap/priority_queue.hpp>
 #include <boost/serialization/strong_typedef.hpp>
 
 #include <openr/common/Constants.h>
@@ -40,18 +43,106 @@ struct TtlCountdownQueueEntry {
   int64_t version{0};
   int64_t ttlVersion{0};
   std::string originatorId;
+};
+
+/**
+ * Hierarchical timing wheel tracking expiry of KvStore keys.
+ *
+ * Holds at most one entry per key. Pushing an entry for a key already in the
+ * queue replaces (refreshes) it, so the size is bounded by the number of keys
+ * rather than by the ttl refresh churn. Insert, refresh and erase are O(1).
+ *
+ * Time is split into ticks of `kTick`. Level `l` of the wheel has `kSlots`
+ * slots each spanning kSlots^l ticks. Entries are cascaded down one level
+ * whenever the lower level wraps around and expire from level 0. A refresh
+ * extending the expiry leaves the entry in place, it is re-linked once its
+ * slot is processed.
+ */
+class TtlCountdownQueue {
+ public:
+  static constexpr std::chrono::milliseconds kTick{1};
+  static constexpr uint32_t kSlotBits{8};
+  static constexpr uint32_t kSlots{1 << kSlotBits};
+  static constexpr uint32_t kLevels{4};
+
+  explicit TtlCountdownQueue(
+      std::chrono::steady_clock::time_point startTime =
+          std::chrono::steady_clock::now());
+
+  // Non-copyable, `keyToId_` refers to keys stored in `nodes_`. Moving keeps
+  // them in place.
+  TtlCountdownQueue(TtlCountdownQueue const&) = delete;
+  TtlCountdownQueue& operator=(TtlCountdownQueue const&) = delete;
+  TtlCountdownQueue(TtlCountdownQueue&&) = default;
+
+  // add new entry or refresh the existing entry of the same key
+  void push(TtlCountdownQueueEntry entry);
+
+  // remove entry of the key if any. Return true if removed
+  bool erase(std::string const& key);
+
+  // entry of the key if any, nullptr otherwise
+  TtlCountdownQueueEntry const* find(std::string const& key) const;
+
+  // time of the next tick having entries to expire or cascade. Timer driving
+  // the wheel should fire no later than this
+  std::optional<std::chrono::steady_clock::time_point> getNextExpiryTime()
+      const;
+
+  // advance the wheel to `now` and remove all entries expiring by then
+  std::vector<TtlCountdownQueueEntry> popExpired(
+      std::chrono::steady_clock::time_point now);
+
+  size_t
+  size() const {
+    return keyToId_.size();
+  }
 
   bool
-  operator>(TtlCountdownQueueEntry other) const {
-    return expiryTime > other.expiryTime;
+  empty() const {
+    return keyToId_.empty();
   }
-};
 
-using TtlCountdownQueue = boost::heap::priority_queue<
-    TtlCountdownQueueEntry,
-    // Always returns smallest first
-    boost::heap::compare<std::greater<TtlCountdownQueueEntry>>,
-    boost::heap::stable<true>>;
+ private:
+  static constexpr uint32_t kInvalidId{std::numeric_limits<uint32_t>::max()};
+
+  struct Node {
+    TtlCountdownQueueEntry entry;
+    int64_t expiryTick{0};
+    // index into slots_, kInvalidId when free
+    uint32_t slot{kInvalidId};
+    uint32_t prev{kInvalidId};
+    uint32_t next{kInvalidId};
+  };
+
+  int64_t toTick(
+      std::chrono::steady_clock::time_point time, bool roundUp) const;
+
+  // link/unlink node into the slot matching its expiry tick. Node is placed
+  // at least `minDelta` ticks ahead of the current tick.
+  void link(uint32_t id, int64_t minDelta);
+  void unlink(uint32_t id);
+
+  // re-link all nodes of given slot (used for cascading)
+  void cascade(uint32_t slot);
+
+  const std::chrono::steady_clock::time_point startTime_;
+
+  // last processed tick
+  int64_t currentTick_{0};
+
+  // nodes addressed by interned id. Deque never moves its elements, so
+  // `keyToId_` can refer to keys stored in place.
+  std::deque<Node> nodes_;
+  std::vector<uint32_t> freeIds_;
+  std::unordered_map<std::string_view, uint32_t> keyToId_;
+
+  // head of per slot doubly linked list, kLevels * kSlots of them
+  std::vector<uint32_t> slots_;
+
+  // number of entries per level
+  std::array<size_t, kLevels> levelSizes_{};
+};
 
 /**
  * Structure defining KvStore peer update event in one area.
@@ -0,0 +1,181 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <algorithm>
+
+#include <gflags/gflags.h>
+#include <glog/logging.h>
+#include <gtest/gtest.h>
+
+#include <folly/Random.h>
+
+#include <openr/common/PrefixTrie.h>
+
+using folly::IPAddress;
+
+namespace openr {
+
+namespace {
+
+folly::CIDRNetwork
+toNetwork(const std::string& str) {
+  return IPAddress::createNetwork(str, -1, false);
+}
+
+// Reference implementation scanning all prefixes
+std::optional<folly::CIDRNetwork>
+linearLongestPrefixMatch(
+    const folly::CIDRNetwork& input,
+    const std::vector<folly::CIDRNetwork>& prefixes) {
+  std::optional<folly::CIDRNetwork> match;
+  for (const auto& prefix : prefixes) {
+    if (prefix.first.family() != input.first.family() or
+        prefix.second > input.second or
+        input.first.mask(prefix.second) != prefix.first) {
+      continue;
+    }
+    if (not match.has_value() or match->second < prefix.second) {
+      match = prefix;
+    }
+  }
+  return match;
+}
+
+} // namespace
+
+TEST(PrefixTrieTest, InsertEraseTest) {
+  PrefixTrie trie;
+  EXPECT_TRUE(trie.empty());
+
+  EXPECT_TRUE(trie.insert(toNetwork("10.0.0.0/8")));
+  EXPECT_TRUE(trie.insert(toNetwork("10.1.0.0/16")));
+  EXPECT_TRUE(trie.insert(toNetwork("0.0.0.0/0")));
+  EXPECT_TRUE(trie.insert(toNetwork("fc00::/7")));
+  EXPECT_FALSE(trie.insert(toNetwork("10.1.0.0/16")));
+  EXPECT_EQ(4, trie.size());
+
+  EXPECT_TRUE(trie.contains(toNetwork("10.0.0.0/8")));
+  EXPECT_TRUE(trie.contains(toNetwork("0.0.0.0/0")));
+  EXPECT_FALSE(trie.contains(toNetwork("10.0.0.0/9")));
+  EXPECT_FALSE(trie.contains(toNetwork("::/0")));
+
+  EXPECT_TRUE(trie.erase(toNetwork("10.0.0.0/8")));
+  EXPECT_FALSE(trie.erase(toNetwork("10.0.0.0/8")));
+  EXPECT_FALSE(trie.erase(toNetwork("10.2.0.0/16")));
+  EXPECT_FALSE(trie.contains(toNetwork("10.0.0.0/8")));
+  EXPECT_TRUE(trie.contains(toNetwork("10.1.0.0/16")));
+  EXPECT_EQ(3, trie.size());
+
+  trie.clear();
+  EXPECT_TRUE(trie.empty());
+  EXPECT_FALSE(trie.contains(toNetwork("10.1.0.0/16")));
+}
+
+TEST(PrefixTrieTest, LongestPrefixMatchTest) {
+  PrefixTrie trie;
+  trie.insert(toNetwork("10.0.0.0/8"));
+  trie.insert(toNetwork("10.1.0.0/16"));
+  trie.insert(toNetwork("10.1.1.0/24"));
+  trie.insert(toNetwork("fc00:cafe::/32"));
+  trie.insert(toNetwork("fc00:cafe:1::/48"));
+
+  EXPECT_EQ(
+      toNetwork("10.1.1.0/24"),
+      trie.longestPrefixMatch(toNetwork("10.1.1.1/32")));
+  EXPECT_EQ(
+      toNetwork("10.1.0.0/16"),
+      trie.longestPrefixMatch(toNetwork("10.1.2.1/32")));
+  EXPECT_EQ(
+      toNetwork("10.1.0.0/16"),
+      trie.longestPrefixMatch(toNetwork("10.1.0.0/23")));
+  EXPECT_EQ(
+      toNetwork("10.0.0.0/8"),
+      trie.longestPrefixMatch(toNetwork("10.0.0.0/8")));
+  EXPECT_EQ(std::nullopt, trie.longestPrefixMatch(toNetwork("10.0.0.0/7")));
+  EXPECT_EQ(std::nullopt, trie.longestPrefixMatch(toNetwork("11.0.0.1/32")));
+
+  EXPECT_EQ(
+      toNetwork("fc00:cafe:1::/48"),
+      trie.longestPrefixMatch(toNetwork("fc00:cafe:1::1/128")));
+  EXPECT_EQ(
+      toNetwork("fc00:cafe::/32"),
+      trie.longestPrefixMatch(toNetwork("fc00:cafe:2::1/128")));
+  EXPECT_EQ(std::nullopt, trie.longestPrefixMatch(toNetwork("fc00::1/128")));
+
+  // Address families never match each other
+  trie.insert(toNetwork("::/0"));
+  EXPECT_EQ(std::nullopt, trie.longestPrefixMatch(toNetwork("11.0.0.1/32")));
+  EXPECT_EQ(
+      toNetwork("::/0"), trie.longestPrefixMatch(toNetwork("fc00::1/128")));
+
+  // Erase of covering prefix falls back to less specific one
+  trie.erase(toNetwork("10.1.0.0/16"));
+  EXPECT_EQ(
+      toNetwork("10.0.0.0/8"),
+      trie.longestPrefixMatch(toNetwork("10.1.2.1/32")));
+  EXPECT_EQ(
+      toNetwork("10.1.1.0/24"),
+      trie.longestPrefixMatch(toNetwork("10.1.1.1/32")));
+}
+
+/**
+ * Verify lookups against linear scan while randomly adding and removing
+ * prefixes
+ */
+TEST(PrefixTrieTest, RandomizedTest) {
+  PrefixTrie trie;
+  std::vector<folly::CIDRNetwork> prefixes;
+
+  auto randomV6 = []() {
+    std::array<uint8_t, 16> bytes{};
+    // Restrict address space to force overlapping prefixes
+    bytes[0] = 0xfc;
+    bytes[1] = folly::Random::rand32() % 4;
+    bytes[2] = folly::Random::rand32() % 256;
+    return IPAddress::fromBinary(folly::ByteRange(bytes.data(), bytes.size()));
+  };
+
+  for (int i = 0; i < 2000; ++i) {
+    const auto len = 8 + folly::Random::rand32() % 17;
+    const auto prefix =
+        folly::CIDRNetwork(randomV6().mask(len), static_cast<uint8_t>(len));
+
+    if (folly::Random::oneIn(3) and not prefixes.empty()) {
+      const auto index = folly::Random::rand32() % prefixes.size();
+      EXPECT_TRUE(trie.erase(prefixes.at(index)));
+      prefixes.erase(prefixes.begin() + index);
+    } else {
+      const bool exists =
+          std::find(prefixes.begin(), prefixes.end(), prefix) !=
+          prefixes.end();
+      EXPECT_EQ(not exists, trie.insert(prefix));
+      if (not exists) {
+        prefixes.emplace_back(prefix);
+      }
+    }
+    ASSERT_EQ(prefixes.size(), trie.size());
+
+    const auto input = folly::CIDRNetwork(randomV6(), 128);
+    EXPECT_EQ(
+        linearLongestPrefixMatch(input, prefixes),
+        trie.longestPrefixMatch(input));
+  }
+}
+
+} // namespace openr
+
+int
+main(int argc, char** argv) {
+  // Basic initialization
+  testing::InitGoogleTest(&argc, argv);
+  gflags::ParseCommandLineFlags(&argc, &argv, true);
+  google::InitGoogleLogging(argv[0]);
+  FLAGS_logtostderr = true;
+
+  // Run the tests
+  return RUN_ALL_TESTS();
+}
@@ -9,6 +9,7 @@
 #include <gtest/gtest.h>
 
 #include <openr/common/LsdbTypes.h>
+#include <openr/common/Types.h>
 
 using namespace openr;
 
@@ -54,6 +55,50 @@ TEST(TypesTest, fromStrTest) {
   EXPECT_TRUE(PrefixKey::fromStr(invalidStrWithBadPrefixV2, areaId).hasError());
 }
 
+TEST(TypesTest, PrefixShardKeyTest) {
+  const std::string nodeName{"node-1"};
+  const std::string areaId = "default-area";
+
+  const PrefixShardKey key(nodeName, 12, areaId);
+  EXPECT_EQ(
+      fmt::format(
+          "{}{}:shard:12", Constants::kPrefixDbMarker.toString(), nodeName),
+      key.getPrefixShardKey());
+
+  auto maybeShardKey = PrefixShardKey::fromStr(key.getPrefixShardKey(), areaId);
+  ASSERT_FALSE(maybeShardKey.hasError());
+  EXPECT_EQ(key, maybeShardKey.value());
+  EXPECT_EQ(nodeName, maybeShardKey->getNodeName());
+  EXPECT_EQ(areaId, maybeShardKey->getPrefixArea());
+  EXPECT_EQ(12, maybeShardKey->getShardId());
+  EXPECT_TRUE(PrefixShardKey::isPrefixShardKey(key.getPrefixShardKey()));
+
+  // per prefix keys are not shard keys and vice versa
+  const auto prefixKeyStr =
+      PrefixKey(nodeName, folly::IPAddress::createNetwork("1.1.1.1/32"), areaId)
+          .getPrefixKeyV2();
+  EXPECT_FALSE(PrefixShardKey::isPrefixShardKey(prefixKeyStr));
+  EXPECT_TRUE(PrefixShardKey::fromStr(prefixKeyStr, areaId).hasError());
+  EXPECT_TRUE(PrefixKey::fromStr(key.getPrefixShardKey(), areaId).hasError());
+  EXPECT_TRUE(PrefixShardKey::fromStr(
+                  fmt::format("{}:shard:1", nodeName), areaId)
+                  .hasError());
+  EXPECT_TRUE(PrefixShardKey::fromStr(
+                  fmt::format(
+                      "{}{}:shard:99999999999",
+                      Constants::kPrefixDbMarker.toString(),
+                      nodeName),
+                  areaId)
+                  .hasError());
+
+  // shard of prefix is stable and within range
+  const auto prefix = folly::IPAddress::createNetwork("fc00:cafe::/64");
+  const auto shardId = PrefixShardKey::getShardOf(prefix, 16);
+  EXPECT_LT(shardId, 16);
+  EXPECT_EQ(shardId, PrefixShardKey::getShardOf(prefix, 16));
+  EXPECT_EQ(0, PrefixShardKey::getShardOf(prefix, 1));
+}
+
 TEST(TypesTest, RegexSetTest) {
   EXPECT_NO_THROW(RegexSet{{"prefix:good"}});
 
@@ -61,6 +106,66 @@ TEST(TypesTest, RegexSetTest) {
       RegexSet{{"prefix:[addr_without_right_bracket"}}, RegexSetException);
 }
 
+TEST(TypesTest, TtlCountdownQueueTest) {
+  const auto start = std::chrono::steady_clock::now();
+  TtlCountdownQueue queue(start);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.getNextExpiryTime().has_value());
+
+  auto makeEntry = [&](std::string const& key,
+                       std::chrono::milliseconds ttl,
+                       int64_t ttlVersion = 0) {
+    TtlCountdownQueueEntry entry;
+    entry.expiryTime = start + ttl;
+    entry.key = key;
+    entry.version = 1;
+    entry.ttlVersion = ttlVersion;
+    entry.originatorId = "node1";
+    return entry;
+  };
+
+  // keys spread over different levels of the wheel
+  queue.push(makeEntry("key1", std::chrono::milliseconds(10)));
+  queue.push(makeEntry("key2", std::chrono::milliseconds(1000)));
+  queue.push(makeEntry("key3", std::chrono::milliseconds(100000)));
+  queue.push(makeEntry("key4", std::chrono::hours(24 * 100)));
+  EXPECT_EQ(4, queue.size());
+  EXPECT_EQ(start + std::chrono::milliseconds(10), queue.getNextExpiryTime());
+
+  // refresh replaces the existing entry instead of adding one
+  queue.push(makeEntry("key1", std::chrono::milliseconds(5000), 1));
+  EXPECT_EQ(4, queue.size());
+  ASSERT_NE(nullptr, queue.find("key1"));
+  EXPECT_EQ(1, queue.find("key1")->ttlVersion);
+
+  // erase
+  EXPECT_TRUE(queue.erase("key2"));
+  EXPECT_FALSE(queue.erase("key2"));
+  EXPECT_EQ(nullptr, queue.find("key2"));
+  EXPECT_EQ(3, queue.size());
+
+  // nothing expires before its time
+  EXPECT_TRUE(
+      queue.popExpired(start + std::chrono::milliseconds(4999)).empty());
+
+  auto expired = queue.popExpired(start + std::chrono::milliseconds(5000));
+  ASSERT_EQ(1, expired.size());
+  EXPECT_EQ("key1", expired.front().key);
+  EXPECT_EQ(1, expired.front().ttlVersion);
+
+  expired = queue.popExpired(start + std::chrono::milliseconds(100000));
+  ASSERT_EQ(1, expired.size());
+  EXPECT_EQ("key3", expired.front().key);
+
+  // entry beyond the range of the wheel
+  EXPECT_TRUE(queue.popExpired(start + std::chrono::hours(24 * 50)).empty());
+  expired = queue.popExpired(start + std::chrono::hours(24 * 100));
+  ASSERT_EQ(1, expired.size());
+  EXPECT_EQ("key4", expired.front().key);
+  EXPECT_TRUE(queue.empty());
+  EXPECT_FALSE(queue.getNextExpiryTime().has_value());
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
@@ -352,6 +352,11 @@ Config::populateInternalDb() {
     throw std::invalid_argument("Route delete duration must be >= 0ms");
   }
 
+  // Check prefix shard count
+  if (*config_.prefix_db_num_shards() < 0) {
+    throw std::invalid_argument("prefix_db_num_shards must be >= 0");
+  }
+
   // validate KvStore config (e.g. ttl/flood-rate/etc.)
   checkKvStoreConfig();
 
@@ -146,6 +146,12 @@ class Config {
     return config_.dryrun().value_or(false);
   }
 
+  // Number of shard keys prefixes are packed into. 0 for per prefix keys
+  uint32_t
+  getPrefixDbNumShards() const {
+    return *config_.prefix_db_num_shards();
+  }
+
   //
   // area
   //
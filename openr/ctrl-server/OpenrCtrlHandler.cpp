@@ -582,6 +582,13 @@ OpenrCtrlHandler::semifuture_getUnicastRoutes() {
   return fib_->getUnicastRoutes({});
 }
 
+folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::UnicastRoute>>>
+OpenrCtrlHandler::semifuture_longestPrefixMatchUnicastRoutes(
+    std::unique_ptr<std::vector<std::string>> addresses) {
+  CHECK(fib_);
+  return fib_->longestPrefixMatchUnicastRoutes(std::move(*addresses));
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
 OpenrCtrlHandler::semifuture_getMplsRoutes() {
   CHECK(fib_);
@@ -764,6 +771,63 @@ OpenrCtrlHandler::semifuture_getKvStoreHashFilteredArea(
       std::move(*area), std::move(*filter));
 }
 
+folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+OpenrCtrlHandler::semifuture_getKvStoreHashTreeArea(
+    std::unique_ptr<thrift::KvStoreHashTreeParams> params,
+    std::unique_ptr<std::string> area) {
+  XLOG(DBG5) << fmt::format(
+      "{} for level: {}, {} nodes; area: {}",
+      __FUNCTION__,
+      *params->level(),
+      params->nodes()->size(),
+      *area);
+
+  XCHECK(kvStore_);
+
+  return kvStore_->semifuture_getKvStoreHashTree(
+      std::move(*area), std::move(*params));
+}
+
+folly::SemiFuture<folly::Unit>
+OpenrCtrlHandler::semifuture_processKvStoreDualMessage(
+    std::unique_ptr<thrift::DualMessages> messages,
+    std::unique_ptr<std::string> area) {
+  XLOG(DBG5) << fmt::format(
+      "{} from: {}; area: {}", __FUNCTION__, *messages->srcId(), *area);
+
+  XCHECK(kvStore_);
+
+  return kvStore_->semifuture_processKvStoreDualMessage(
+      std::move(*area), std::move(*messages));
+}
+
+folly::SemiFuture<folly::Unit>
+OpenrCtrlHandler::semifuture_updateFloodTopologyChild(
+    std::unique_ptr<thrift::FloodTopoSetParams> params,
+    std::unique_ptr<std::string> area) {
+  XLOG(DBG5) << fmt::format(
+      "{} for root: {}, child: {}; area: {}",
+      __FUNCTION__,
+      *params->rootId(),
+      *params->srcId(),
+      *area);
+
+  XCHECK(kvStore_);
+
+  return kvStore_->semifuture_updateFloodTopologyChild(
+      std::move(*area), std::move(*params));
+}
+
+folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+OpenrCtrlHandler::semifuture_getSpanningTreeInfos(
+    std::unique_ptr<std::string> area) {
+  XLOG(DBG5) << fmt::format("{} for area: {}", __FUNCTION__, *area);
+
+  XCHECK(kvStore_);
+
+  return kvStore_->semifuture_getSpanningTreeInfos(std::move(*area));
+}
+
 folly::SemiFuture<folly::Unit>
 OpenrCtrlHandler::semifuture_setKvStoreKeyVals(
     std::unique_ptr<thrift::KeySetParams> setParams,
@@ -780,6 +844,29 @@ OpenrCtrlHandler::semifuture_setKvStoreKeyVals(
       std::move(*area), std::move(*setParams));
 }
 
+folly::SemiFuture<folly::Unit>
+OpenrCtrlHandler::semifuture_setKvStoreKeyValsSerialized(
+    std::unique_ptr<folly::IOBuf> setParamsPayload,
+    std::unique_ptr<std::string> area) {
+  thrift::KeySetParams setParams;
+  try {
+    setParams =
+        apache::thrift::CompactSerializer::deserialize<thrift::KeySetParams>(
+            setParamsPayload.get());
+  } catch (std::exception const& e) {
+    return folly::makeSemiFuture<folly::Unit>(
+        folly::make_exception_wrapper<thrift::KvStoreError>(fmt::format(
+            "Malformed KeySetParams payload: {}", e.what())));
+  }
+  XLOG(DBG5) << fmt::format(
+      "{} for keys: {}; area: {}", __FUNCTION__, toString(setParams), *area);
+
+  XCHECK(kvStore_) << "no kvstore initialized";
+
+  return kvStore_->semifuture_setKvStoreKeyVals(
+      std::move(*area), std::move(setParams));
+}
+
 folly::SemiFuture<std::unique_ptr<thrift::SetKeyValsResult>>
 OpenrCtrlHandler::semifuture_setKvStoreKeyValues(
     std::unique_ptr<thrift::KeySetParams> setParams,
@@ -180,6 +180,11 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
   semifuture_getUnicastRoutes() override;
 
+  folly::SemiFuture<
+      std::unique_ptr<std::map<std::string, thrift::UnicastRoute>>>
+  semifuture_longestPrefixMatchUnicastRoutes(
+      std::unique_ptr<std::vector<std::string>> addresses) override;
+
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
   semifuture_getMplsRoutesFiltered(
       std::unique_ptr<std::vector<int32_t>> labels) override;
@@ -305,6 +310,33 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
   semifuture_getKvStoreHashFiltered(
       std::unique_ptr<thrift::KeyDumpParams> filter) override;
 
+  /*
+   * API to return children digests of KvStore hash tree nodes by given:
+   *  - thrift::KvStoreHashTreeParams;
+   *  - a specific area;
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+  semifuture_getKvStoreHashTreeArea(
+      std::unique_ptr<thrift::KvStoreHashTreeParams> params,
+      std::unique_ptr<std::string> area) override;
+
+  /*
+   * APIs to build and inspect flooding spanning tree for flood optimization:
+   *  - process DUAL messages from peer;
+   *  - set/unset peer as SPT child;
+   *  - dump SPT information of a specific area;
+   */
+  folly::SemiFuture<folly::Unit> semifuture_processKvStoreDualMessage(
+      std::unique_ptr<thrift::DualMessages> messages,
+      std::unique_ptr<std::string> area) override;
+
+  folly::SemiFuture<folly::Unit> semifuture_updateFloodTopologyChild(
+      std::unique_ptr<thrift::FloodTopoSetParams> params,
+      std::unique_ptr<std::string> area) override;
+
+  folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+  semifuture_getSpanningTreeInfos(std::unique_ptr<std::string> area) override;
+
   /*
    * API to set key-val pairs by given:
    *  - thrift::KeySetParams;
@@ -333,6 +365,15 @@ class OpenrCtrlHandler final : public thrift::OpenrCtrlCppSvIf,
       std::unique_ptr<thrift::KeySetParams> setParams,
       std::unique_ptr<std::string> area) override;
 
+  /*
+   * Same as `setKvStoreKeyVals` but with thrift::KeySetParams already
+   * compact-serialized by the sender. Used for flooding so that a
+   * publication is encoded once for all peers.
+   */
+  folly::SemiFuture<folly::Unit> semifuture_setKvStoreKeyValsSerialized(
+      std::unique_ptr<folly::IOBuf> setParamsPayload,
+      std::unique_ptr<std::string> area) override;
+
   /*
    * API to dump existing peers in a specified area
    */
@@ -5,10 +5,12 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <algorithm>
 #include <fstream>
 
 #include <fb303/ServiceData.h>
 #include <folly/futures/Future.h>
+#include <folly/hash/SpookyHashV2.h>
 #include <folly/logging/xlog.h>
 #include <utility>
 
@@ -34,10 +36,19 @@ namespace detail {
 void
 DecisionPendingUpdates::applyLinkStateChange(
     std::string const& nodeName,
+    std::string const& area,
     LinkState::LinkStateChange const& change,
     apache::thrift::optional_field_ref<thrift::PerfEvents const&> perfEvents) {
+  if (change.topologyChanged) {
+    // remote topology change only affects prefixes of nodes whose SPF result
+    // changed, these are resolved when routes get rebuilt
+    updatedNodes_[area].emplace(nodeName);
+  }
   needsFullRebuild_ |=
-      (change.topologyChanged || change.nodeLabelChanged ||
+      (change.nodeLabelChanged ||
+       // local links carry nexthops of every route
+       (change.topologyChanged &&
+        (change.localLinksChanged || nodeName == myNodeName_)) ||
        // we only need a full rebuild if link attributes change locally
        // this would be a nexthop or link label change
        (change.linkAttributesChanged && nodeName == myNodeName_));
@@ -52,12 +63,31 @@ DecisionPendingUpdates::applyPrefixStateChange(
   addUpdate(perfEvents);
 }
 
+void
+DecisionPendingUpdates::applyPrefixStateBatch(
+    PrefixState& prefixState,
+    std::vector<PrefixState::PrefixUpdate>&& updates,
+    std::vector<thrift::PerfEvents> const& perfEvents) {
+  if (updates.empty()) {
+    return;
+  }
+  count_ += updates.size();
+  for (auto const& events : perfEvents) {
+    updatePerfEvents(&events);
+  }
+  if (not perfEvents_) {
+    updatePerfEvents(nullptr);
+  }
+  prefixState.applyBatch(std::move(updates), updatedPrefixes_);
+}
+
 void
 DecisionPendingUpdates::reset() {
   count_ = 0;
   perfEvents_ = std::nullopt;
   needsFullRebuild_ = false;
   updatedPrefixes_.clear();
+  updatedNodes_.clear();
 }
 
 void
@@ -78,7 +108,11 @@ void
 DecisionPendingUpdates::addUpdate(
     apache::thrift::optional_field_ref<thrift::PerfEvents const&> perfEvents) {
   ++count_;
+  updatePerfEvents(perfEvents ? &*perfEvents : nullptr);
+}
 
+void
+DecisionPendingUpdates::updatePerfEvents(thrift::PerfEvents const* perfEvents) {
   // Update local copy of perf evens if it is newer than the one to be added
   // We do debounce (batch updates) for recomputing routes and in order to
   // measure convergence performance, it is better to use event which is
@@ -134,7 +168,8 @@ Decision::Decision(
       config->isV4Enabled(),
       config->isSegmentRoutingEnabled(),
       config->isBestRouteSelectionEnabled(),
-      config->isV4OverV6NexthopEnabled());
+      config->isV4OverV6NexthopEnabled(),
+      *config->getConfig().decision_config()->route_build_threads());
 
   if (config->isVipServiceEnabled()) {
     // Static unicast routes will be generated by PrefixManager for received
@@ -287,6 +322,8 @@ Decision::Decision(
   // Initialize some stat keys
   fb303::fbData->addStatExportType(
       "decision.rib_policy_processing.time_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "decision.skipped_deserializations", fb303::SUM);
 }
 
 Decision::~Decision() {
@@ -712,7 +749,9 @@ Decision::updateKeyInLsdb(
     const std::string& area,
     LinkState& areaLinkState,
     const std::string& key,
-    const thrift::Value& rawVal) {
+    const thrift::Value& rawVal,
+    std::vector<PrefixState::PrefixUpdate>& prefixUpdates,
+    std::vector<thrift::PerfEvents>& prefixPerfEvents) {
   if (not rawVal.value().has_value()) {
     // skip TTL update
     DCHECK(*rawVal.ttlVersion() > 0);
@@ -732,6 +771,7 @@ Decision::updateKeyInLsdb(
       adjacencyDb.area() = area;
       pendingUpdates_.applyLinkStateChange(
           nodeName,
+          area,
           areaLinkState.updateAdjacencyDatabase(
               adjacencyDb,
               area,
@@ -745,6 +785,12 @@ Decision::updateKeyInLsdb(
       auto prefixDb = readThriftObjStr<thrift::PrefixDatabase>(
           rawVal.value().value(), serializer_);
 
+      // Packed prefix database carries all prefixes of one shard
+      if (PrefixShardKey::isPrefixShardKey(key)) {
+        updatePrefixShardInLsdb(area, key, std::move(prefixDb));
+        return;
+      }
+
       // We expect per prefix key, ignore if publication is still in old
       // format.
       if (1 != prefixDb.prefixEntries()->size()) {
@@ -772,21 +818,117 @@ Decision::updateKeyInLsdb(
       PrefixKey prefixKey(
           *prefixDb.thisNodeName(), toIPNetwork(*entry.prefix()), area);
 
-      pendingUpdates_.applyPrefixStateChange(
-          *prefixDb.deletePrefix()
-              ? prefixState_.deletePrefix(prefixKey)
-              : prefixState_.updatePrefix(prefixKey, entry),
-          prefixDb.perfEvents());
+      // applied along with other prefix keys of the publication
+      auto& update = prefixUpdates.emplace_back(
+          PrefixState::PrefixUpdate{std::move(prefixKey), std::nullopt});
+      if (not *prefixDb.deletePrefix()) {
+        update.entry = std::move(prefixDb.prefixEntries()->front());
+      }
+      if (auto perfEvents = prefixDb.perfEvents()) {
+        prefixPerfEvents.emplace_back(std::move(*perfEvents));
+      }
     }
   } catch (const std::exception& e) {
     XLOG(ERR) << "Failed to deserialize info for key " << key
               << ". Exception: " << folly::exceptionStr(e);
+    // Forget the value, so that it is not taken as processed
+    auto it = keyFingerprints_.find(area);
+    if (it != keyFingerprints_.end()) {
+      it->second.erase(key);
+    }
   }
 }
 
+bool
+Decision::updateKeyFingerprint(
+    const std::string& area,
+    const std::string& key,
+    const thrift::Value& rawVal) {
+  if (not rawVal.value().has_value()) {
+    // TTL update. Nothing to deserialize
+    return false;
+  }
+  // Only adjacency and prefix values are deserialized. Don't track other keys
+  const bool isAdjKey = key.find(Constants::kAdjDbMarker.toString()) == 0;
+  if (not isAdjKey and key.find(Constants::kPrefixDbMarker.toString()) != 0) {
+    return false;
+  }
+  // ATTN: keep processing adjacencies of areas with pending adjacencies, since
+  // initialization relies on each adjacency database received
+  if (isAdjKey and areaToPendingAdjacency_.count(area)) {
+    return false;
+  }
+
+  auto& fingerprint = keyFingerprints_[area][key];
+  // Same hash is same version, originator and value
+  if (rawVal.hash().has_value() and fingerprint.hash == *rawVal.hash()) {
+    return true;
+  }
+  fingerprint.hash = rawVal.hash().to_optional();
+
+  const auto& value = *rawVal.value();
+  uint64_t contentHash1{0};
+  uint64_t contentHash2{0};
+  folly::hash::SpookyHashV2::Hash128(
+      value.data(), value.size(), &contentHash1, &contentHash2);
+  if (contentHash1 == fingerprint.contentHash1 and
+      contentHash2 == fingerprint.contentHash2) {
+    return true;
+  }
+  fingerprint.contentHash1 = contentHash1;
+  fingerprint.contentHash2 = contentHash2;
+  return false;
+}
+
+void
+Decision::updatePrefixShardInLsdb(
+    const std::string& area,
+    const std::string& key,
+    thrift::PrefixDatabase&& prefixDb) {
+  auto maybeShardKey = PrefixShardKey::fromStr(key, area);
+  if (maybeShardKey.hasError()) {
+    XLOG(ERR) << fmt::format(
+        "Unable to parse prefix shard key: {} with error: {}",
+        key,
+        maybeShardKey.error());
+    return;
+  }
+  auto const& shardKey = maybeShardKey.value();
+
+  if (*prefixDb.deletePrefix()) {
+    pendingUpdates_.applyPrefixStateChange(
+        prefixState_.deletePrefixShard(shardKey), prefixDb.perfEvents());
+    return;
+  }
+
+  // Ignore self redistributed route reflection
+  // These routes are programmed by Decision,
+  // re-origintaed by me to areas that do not have the best prefix entry
+  auto& entries = *prefixDb.prefixEntries();
+  if (*prefixDb.thisNodeName() == myNodeName_) {
+    entries.erase(
+        std::remove_if(
+            entries.begin(),
+            entries.end(),
+            [this](thrift::PrefixEntry const& entry) {
+              auto const& areaStack = *entry.area_stack();
+              return areaStack.size() > 0 and
+                  areaLinkStates_.count(areaStack.back());
+            }),
+        entries.end());
+  }
+
+  pendingUpdates_.applyPrefixStateChange(
+      prefixState_.updatePrefixShard(shardKey, entries),
+      prefixDb.perfEvents());
+}
+
 void
 Decision::deleteKeyFromLsdb(
-    const std::string& area, LinkState& areaLinkState, const std::string& key) {
+    const std::string& area,
+    LinkState& areaLinkState,
+    const std::string& key,
+    std::vector<PrefixState::PrefixUpdate>& prefixUpdates) {
   // TODO: avoid decoding from string by injecting data-structures
   // instead of raw strings into `expiredKeys` collection
 
@@ -796,6 +938,7 @@ Decision::deleteKeyFromLsdb(
     // adjacencyDb: delete keys starting with "adj:"
     pendingUpdates_.applyLinkStateChange(
         nodeName,
+        area,
         areaLinkState.deleteAdjacencyDatabase(nodeName),
         thrift::PrefixDatabase().perfEvents()); // Empty perf events
     return;
@@ -803,6 +946,12 @@ Decision::deleteKeyFromLsdb(
 
   if (key.find(Constants::kPrefixDbMarker.toString()) == 0) {
     // prefixDb: delete keys starting with "prefix:"
+    if (auto maybeShardKey = PrefixShardKey::fromStr(key, area)) {
+      pendingUpdates_.applyPrefixStateChange(
+          prefixState_.deletePrefixShard(maybeShardKey.value()),
+          thrift::PrefixDatabase().perfEvents()); // Empty perf events
+      return;
+    }
     auto maybePrefixKey = PrefixKey::fromStr(key, area);
     if (maybePrefixKey.hasError()) {
       // this is bad format of key.
@@ -812,9 +961,8 @@ Decision::deleteKeyFromLsdb(
           maybePrefixKey.error());
       return;
     }
-    pendingUpdates_.applyPrefixStateChange(
-        prefixState_.deletePrefix(maybePrefixKey.value()),
-        thrift::PrefixDatabase().perfEvents()); // Empty perf events
+    prefixUpdates.emplace_back(PrefixState::PrefixUpdate{
+        std::move(maybePrefixKey).value(), std::nullopt});
   }
 }
 
@@ -825,7 +973,16 @@ Decision::processPublication(thrift::Publication&& thriftPub) {
 
   auto it = areaLinkStates_.find(area);
   if (it == areaLinkStates_.end()) {
-    it = areaLinkStates_.emplace(area, LinkState(area, myNodeName_)).first;
+    auto const& decisionConfig = *config_->getConfig().decision_config();
+    it = areaLinkStates_
+             .emplace(
+                 area,
+                 LinkState(
+                     area,
+                     myNodeName_,
+                     *decisionConfig.enable_incremental_spf(),
+                     *decisionConfig.spf_queue_type()))
+             .first;
   }
   auto& areaLinkState = it->second;
 
@@ -834,15 +991,60 @@ Decision::processPublication(thrift::Publication&& thriftPub) {
     return;
   }
 
+  // Updates of per prefix keys, applied to PrefixState at once
+  std::vector<PrefixState::PrefixUpdate> prefixUpdates;
+  std::vector<thrift::PerfEvents> prefixPerfEvents;
+  prefixUpdates.reserve(
+      thriftPub.keyVals()->size() + thriftPub.expiredKeys()->size());
+
+  // Per prefix key and shard key of same originator may carry same prefix,
+  // and the one applied last owns it. Apply pending per prefix updates ahead
+  // of a shard key to preserve order of the publication.
+  auto applyPrefixUpdates = [&](const std::string& key) {
+    if (prefixUpdates.empty() or not PrefixShardKey::isPrefixShardKey(key)) {
+      return;
+    }
+    pendingUpdates_.applyPrefixStateBatch(
+        prefixState_, std::move(prefixUpdates), prefixPerfEvents);
+    prefixUpdates.clear();
+    prefixPerfEvents.clear();
+  };
+
   // LSDB addition/update
+  size_t numSkippedDeserializations{0};
   for (const auto& [key, rawVal] : *thriftPub.keyVals()) {
-    updateKeyInLsdb(area, areaLinkState, key, rawVal);
+    if (updateKeyFingerprint(area, key, rawVal)) {
+      ++numSkippedDeserializations;
+      continue;
+    }
+    applyPrefixUpdates(key);
+    updateKeyInLsdb(
+        area, areaLinkState, key, rawVal, prefixUpdates, prefixPerfEvents);
+  }
+  if (numSkippedDeserializations) {
+    fb303::fbData->addStatValue(
+        "decision.skipped_deserializations",
+        numSkippedDeserializations,
+        fb303::SUM);
   }
 
   // LSDB deletion
+  auto fingerprintsIt = keyFingerprints_.find(area);
   for (const auto& key : *thriftPub.expiredKeys()) {
-    deleteKeyFromLsdb(area, areaLinkState, key);
+    if (fingerprintsIt != keyFingerprints_.end()) {
+      fingerprintsIt->second.erase(key);
+    }
+    applyPrefixUpdates(key);
+    deleteKeyFromLsdb(area, areaLinkState, key, prefixUpdates);
+  }
+  // Forget area once all of its keys are gone
+  if (fingerprintsIt != keyFingerprints_.end() and
+      fingerprintsIt->second.empty()) {
+    keyFingerprints_.erase(fingerprintsIt);
   }
+
+  pendingUpdates_.applyPrefixStateBatch(
+      prefixState_, std::move(prefixUpdates), prefixPerfEvents);
 }
 
 void
@@ -905,6 +1107,29 @@ Decision::rebuildRoutes(std::string const& event) {
     }
   }
 
+  // Resolve nodes whose SPF result changed since the last route build. This
+  // also refreshes SPF snapshots ahead of a full rebuild.
+  std::unordered_set<NodeAndArea> spfChangedNodes;
+  for (auto const& [area, updatedNodes] : pendingUpdates_.updatedNodes()) {
+    auto it = areaLinkStates_.find(area);
+    if (it == areaLinkStates_.end()) {
+      continue;
+    }
+    auto& linkState = it->second;
+    auto changedNodes = linkState.getSpfChangedNodes(myNodeName_);
+    for (auto const& link : linkState.linksFromNode(myNodeName_)) {
+      // distance to a neighbor is part of nexthop metric of any route. A
+      // neighbor merely republishing its adjacencies doesn't change it
+      if (changedNodes.count(link->getOtherNodeName(myNodeName_))) {
+        pendingUpdates_.setNeedsFullRebuild();
+      }
+    }
+    changedNodes.insert(updatedNodes.begin(), updatedNodes.end());
+    for (auto const& nodeName : changedNodes) {
+      spfChangedNodes.emplace(nodeName, area);
+    }
+  }
+
   DecisionRouteUpdate update;
   if (pendingUpdates_.needsFullRebuild()) {
     // if only static routes gets updated, we still need to update routes
@@ -927,14 +1152,59 @@ Decision::rebuildRoutes(std::string const& event) {
     update = routeDb_.calculateUpdate(std::move(db));
     update.type = DecisionRouteUpdate::FULL_SYNC;
   } else {
-    // process prefixes update from `prefixState_`
-    for (auto const& prefix : pendingUpdates_.updatedPrefixes()) {
+    auto updateRouteForPrefix = [&](folly::CIDRNetwork const& prefix,
+                                    bool skipUnchanged) {
       if (auto maybeRibEntry = spfSolver_->createRouteForPrefixOrGetStaticRoute(
               myNodeName_, areaLinkStates_, prefixState_, prefix)) {
+        auto search = routeDb_.unicastRoutes.find(prefix);
+        if (skipUnchanged and search != routeDb_.unicastRoutes.end() and
+            search->second == maybeRibEntry.value()) {
+          return;
+        }
         update.addRouteToUpdate(std::move(maybeRibEntry).value());
       } else if (routeDb_.unicastRoutes.count(prefix) > 0) {
         update.unicastRoutesToDelete.emplace_back(prefix);
       }
+    };
+
+    // process prefixes update from `prefixState_`
+    auto const& updatedPrefixes = pendingUpdates_.updatedPrefixes();
+    for (auto const& prefix : updatedPrefixes) {
+      updateRouteForPrefix(prefix, false /* skipUnchanged */);
+    }
+
+    // process prefixes originated by nodes with changed SPF result
+    std::unordered_set<folly::CIDRNetwork> spfChangedPrefixes;
+    for (auto const& nodeAndArea : spfChangedNodes) {
+      for (auto const& prefix : prefixState_.getPrefixesFromNode(nodeAndArea)) {
+        if (not updatedPrefixes.count(prefix)) {
+          spfChangedPrefixes.emplace(prefix);
+        }
+      }
+    }
+    for (auto const& prefix : spfChangedPrefixes) {
+      updateRouteForPrefix(prefix, true /* skipUnchanged */);
+    }
+    fb303::fbData->addStatValue(
+        "decision.spf_changed_prefixes",
+        spfChangedPrefixes.size(),
+        fb303::SUM);
+
+    // node label routes follow SPF result of every node
+    if (not spfChangedNodes.empty()) {
+      auto mplsRoutes =
+          spfSolver_->buildNodeLabelRoutes(myNodeName_, areaLinkStates_);
+      for (auto const& [label, _] : routeDb_.mplsRoutes) {
+        if (not mplsRoutes.count(label)) {
+          update.mplsRoutesToDelete.emplace_back(label);
+        }
+      }
+      for (auto& [label, entry] : mplsRoutes) {
+        auto search = routeDb_.mplsRoutes.find(label);
+        if (search == routeDb_.mplsRoutes.end() or search->second != entry) {
+          update.addMplsRouteToUpdate(std::move(entry));
+        }
+      }
     }
     if (ribPolicy_) {
       auto start = std::chrono::steady_clock::now();
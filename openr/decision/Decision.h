@@ -54,7 +54,8 @@ class DecisionPendingUpdates {
 
   bool
   needsRouteUpdate() const {
-    return needsFullRebuild() || !updatedPrefixes_.empty();
+    return needsFullRebuild() || !updatedPrefixes_.empty() ||
+        !updatedNodes_.empty();
   }
 
   std::unordered_set<folly::CIDRNetwork> const&
@@ -62,8 +63,14 @@ class DecisionPendingUpdates {
     return updatedPrefixes_;
   }
 
+  std::unordered_map<std::string, std::unordered_set<std::string>> const&
+  updatedNodes() const {
+    return updatedNodes_;
+  }
+
   void applyLinkStateChange(
       std::string const& nodeName,
+      std::string const& area,
       LinkState::LinkStateChange const& change,
       apache::thrift::optional_field_ref<thrift::PerfEvents const&> perfEvents);
 
@@ -71,6 +78,14 @@ class DecisionPendingUpdates {
       std::unordered_set<folly::CIDRNetwork>&& change,
       apache::thrift::optional_field_ref<thrift::PerfEvents const&> perfEvents);
 
+  // Apply prefix updates of one publication to `prefixState` in bulk, adding
+  // changed prefixes directly to this batch. `perfEvents` holds perf events
+  // carried by the updated prefix databases, if any.
+  void applyPrefixStateBatch(
+      PrefixState& prefixState,
+      std::vector<PrefixState::PrefixUpdate>&& updates,
+      std::vector<thrift::PerfEvents> const& perfEvents);
+
   void reset();
 
   void addEvent(std::string const& eventDescription);
@@ -91,6 +106,8 @@ class DecisionPendingUpdates {
   void addUpdate(
       apache::thrift::optional_field_ref<thrift::PerfEvents const&> perfEvents);
 
+  void updatePerfEvents(thrift::PerfEvents const* perfEvents);
+
   // tracks how many updates are part of this batch
   uint32_t count_{0};
 
@@ -103,6 +120,10 @@ class DecisionPendingUpdates {
   // track prefixes that have changed in this batch
   std::unordered_set<folly::CIDRNetwork> updatedPrefixes_;
 
+  // track nodes that changed topology in this batch, per area
+  std::unordered_map<std::string /* area */, std::unordered_set<std::string>>
+      updatedNodes_;
+
   // local node name to determine action on linkAttributes change
   std::string myNodeName_;
 };
@@ -229,16 +250,35 @@ class Decision : public OpenrEventBase {
    */
   void processPublication(thrift::Publication&& thriftPub);
 
+  // Updates of per prefix keys are appended to `prefixUpdates` and applied
+  // once for the whole publication
   void updateKeyInLsdb(
       const std::string& area,
       LinkState& areaLinkState,
       const std::string& key,
-      const thrift::Value& rawVal);
+      const thrift::Value& rawVal,
+      std::vector<PrefixState::PrefixUpdate>& prefixUpdates,
+      std::vector<thrift::PerfEvents>& prefixPerfEvents);
 
   void deleteKeyFromLsdb(
       const std::string& area,
       LinkState& areaLinkState,
-      const std::string& key);
+      const std::string& key,
+      std::vector<PrefixState::PrefixUpdate>& prefixUpdates);
+
+  // Record fingerprint of key's value. Returns true if value content is same
+  // as the last one processed for the key, i.e. deserialization and LSDB
+  // update can be skipped (e.g. re-flood of same value with higher version)
+  bool updateKeyFingerprint(
+      const std::string& area,
+      const std::string& key,
+      const thrift::Value& rawVal);
+
+  // Diff prefixes of packed prefix database (shard key) against last update
+  void updatePrefixShardInLsdb(
+      const std::string& area,
+      const std::string& key,
+      thrift::PrefixDatabase&& prefixDb);
 
   // Process publication from PrefixManager
   void processStaticRoutesUpdate(DecisionRouteUpdate&& routeUpdate);
@@ -303,6 +343,21 @@ class Decision : public OpenrEventBase {
   // Global prefix state
   PrefixState prefixState_;
 
+  // Fingerprint of the value last processed for every adjacency and prefix
+  // key. Entries are dropped along with expired keys, and areas along with
+  // their last key, hence it is bounded by the LSDB size.
+  struct ValueFingerprint {
+    // `thrift::Value.hash`, covering version and originator besides value
+    std::optional<int64_t> hash;
+    // 128-bit hash of serialized value
+    uint64_t contentHash1{0};
+    uint64_t contentHash2{0};
+  };
+  std::unordered_map<
+      std::string /* area */,
+      std::unordered_map<std::string /* key */, ValueFingerprint>>
+      keyFingerprints_;
+
   apache::thrift::CompactSerializer serializer_;
 
   // Base interval to submit to monitor with (jitter will be added)
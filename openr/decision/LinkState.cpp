@@ -47,6 +47,19 @@ std::hash<openr::LinkState::LinkSet>::operator()(
 
 namespace openr {
 
+namespace {
+
+// SPF cost of a link, std::nullopt if link can't be used by SPF
+std::optional<LinkStateMetric>
+getSpfMetric(const Link& link) {
+  if (not link.isUp()) {
+    return std::nullopt;
+  }
+  return link.getMaxMetric();
+}
+
+} // namespace
+
 Link::Link(
     const std::string& area,
     const std::string& nodeName1,
@@ -203,8 +216,15 @@ Link::directionalToString(const std::string& fromNode) const {
       getIfaceFromNode(getOtherNodeName(fromNode)));
 }
 
-LinkState::LinkState(const std::string& area, const std::string& myNodeName)
-    : area_(area), myNodeName_(myNodeName) {}
+LinkState::LinkState(
+    const std::string& area,
+    const std::string& myNodeName,
+    bool enableIncrementalSpf,
+    thrift::SpfQueueType spfQueueType)
+    : area_(area),
+      myNodeName_(myNodeName),
+      enableIncrementalSpf_(enableIncrementalSpf),
+      spfQueueType_(spfQueueType) {}
 
 size_t
 LinkState::LinkPtrHash::operator()(const std::shared_ptr<Link>& l) const {
@@ -251,6 +271,7 @@ LinkState::addLink(std::shared_ptr<Link> link) {
   CHECK(linkMap_[link->firstNodeName()].insert(link).second);
   CHECK(linkMap_[link->secondNodeName()].insert(link).second);
   CHECK(allLinks_.insert(link).second);
+  spfGraphDirty_ = true;
 }
 
 // throws std::out_of_range if links are not present
@@ -259,6 +280,7 @@ LinkState::removeLink(std::shared_ptr<Link> link) {
   CHECK(linkMap_.at(link->firstNodeName()).erase(link));
   CHECK(linkMap_.at(link->secondNodeName()).erase(link));
   CHECK(allLinks_.erase(link));
+  spfGraphDirty_ = true;
 }
 
 void
@@ -280,6 +302,7 @@ LinkState::removeNode(const std::string& nodeName) {
   }
   linkMap_.erase(search);
   nodeOverloads_.erase(nodeName);
+  spfGraphDirty_ = true;
 }
 
 const LinkState::LinkSet&
@@ -328,6 +351,7 @@ LinkState::updateNodeOverloaded(
 
   const auto [_, inserted] =
       nodeOverloads_.insert_or_assign(nodeName, isOverloaded);
+  spfGraphDirty_ = true;
   // don't indicate LinkState changed if this is a new node
   return not inserted;
 }
@@ -476,8 +500,12 @@ LinkState::updateAdjacencyDatabase(
   std::unordered_set<Link> linksDown;
 
   // topology changed if a node is overloaded / un-overloaded
-  change.topologyChanged |=
-      updateNodeOverloaded(nodeName, *newAdjacencyDb.isOverloaded());
+  if (updateNodeOverloaded(nodeName, *newAdjacencyDb.isOverloaded())) {
+    change.topologyChanged = true;
+    // transit through this node changed, memoized SPF results can't be
+    // repaired link by link
+    spfResults_.clear();
+  }
 
   // topology is changed if softdrain value is changed.
   change.topologyChanged |= *priorAdjacencyDb.nodeMetricIncrementVal() !=
@@ -488,6 +516,12 @@ LinkState::updateAdjacencyDatabase(
   change.nodeLabelChanged =
       *priorAdjacencyDb.nodeLabel() != *newAdjacencyDb.nodeLabel();
 
+  // whether topology changed on a link of this node (myNodeName_)
+  auto isLocalLink = [this](Link const& link) {
+    return link.firstNodeName() == myNodeName_ or
+        link.secondNodeName() == myNodeName_;
+  };
+
   auto newIter = newLinks.begin();
   auto oldIter = oldLinks.begin();
   while (newIter != newLinks.end() || oldIter != oldLinks.end()) {
@@ -496,10 +530,13 @@ LinkState::updateAdjacencyDatabase(
       // newIter is pointing at a Link not currently present, record this as a
       // link to add and advance newIter
       change.topologyChanged |= (*newIter)->isUp();
+      change.localLinksChanged |=
+          (*newIter)->isUp() and isLocalLink(**newIter);
       // even if we are holding a change, we apply the change to our link state
       // and check for holds when running spf. this ensures we don't add the
       // same hold twice
       addLink(*newIter);
+      updateSpfResults(*newIter, std::nullopt, getSpfMetric(**newIter));
       change.addedLinks.emplace_back(*newIter);
       std::string propagationTimeStr = mayHaveLinkEventPropagationTime(
           newAdjacencyDb,
@@ -522,7 +559,10 @@ LinkState::updateAdjacencyDatabase(
       // If this link was previously overloaded or had a hold up, this does not
       // change the topology.
       change.topologyChanged |= (*oldIter)->isUp();
+      change.localLinksChanged |=
+          (*oldIter)->isUp() and isLocalLink(**oldIter);
       removeLink(*oldIter);
+      updateSpfResults(*oldIter, getSpfMetric(**oldIter), std::nullopt);
       std::string propagationTimeStr = mayHaveLinkEventPropagationTime(
           newAdjacencyDb,
           (*oldIter)->getIfaceFromNode(*newAdjacencyDb.thisNodeName()),
@@ -542,6 +582,7 @@ LinkState::updateAdjacencyDatabase(
     // or metric changed
     auto& newLink = **newIter;
     auto& oldLink = **oldIter;
+    bool linkTopologyChanged{false};
 
     // change the metric on the link object we already have
     if (newLink.getMetricFromNode(nodeName) !=
@@ -551,8 +592,11 @@ LinkState::updateAdjacencyDatabase(
           newLink.directionalToString(nodeName),
           oldLink.getMetricFromNode(nodeName),
           newLink.getMetricFromNode(nodeName));
-      change.topologyChanged |= oldLink.setMetricFromNode(
+      const auto oldMetric = getSpfMetric(oldLink);
+      linkTopologyChanged |= oldLink.setMetricFromNode(
           nodeName, newLink.getMetricFromNode(nodeName));
+      spfGraphDirty_ = true;
+      updateSpfResults(*oldIter, oldMetric, getSpfMetric(oldLink));
     }
 
     // Check if link is now usable / unusable
@@ -561,7 +605,10 @@ LinkState::updateAdjacencyDatabase(
     if (isUp != wasUp) {
       XLOG(DBG1)
           << fmt::format("[LINK UPDATE] Link usability: {} -> {}", wasUp, isUp);
-      change.topologyChanged |= oldLink.setLinkUsability(newLink);
+      const auto oldMetric = getSpfMetric(oldLink);
+      linkTopologyChanged |= oldLink.setLinkUsability(newLink);
+      spfGraphDirty_ = true;
+      updateSpfResults(*oldIter, oldMetric, getSpfMetric(oldLink));
     }
 
     if (newLink.getOverloadFromNode(nodeName) !=
@@ -571,10 +618,16 @@ LinkState::updateAdjacencyDatabase(
           newLink.directionalToString(nodeName),
           oldLink.getOverloadFromNode(nodeName),
           newLink.getOverloadFromNode(nodeName));
-      change.topologyChanged |= oldLink.setOverloadFromNode(
+      const auto oldMetric = getSpfMetric(oldLink);
+      linkTopologyChanged |= oldLink.setOverloadFromNode(
           nodeName, newLink.getOverloadFromNode(nodeName));
+      spfGraphDirty_ = true;
+      updateSpfResults(*oldIter, oldMetric, getSpfMetric(oldLink));
     }
 
+    change.topologyChanged |= linkTopologyChanged;
+    change.localLinksChanged |= linkTopologyChanged and isLocalLink(oldLink);
+
     // Check if adjacency label has changed
     if (newLink.getAdjLabelFromNode(nodeName) !=
         oldLink.getAdjLabelFromNode(nodeName)) {
@@ -633,7 +686,10 @@ LinkState::updateAdjacencyDatabase(
     ++oldIter;
   }
   if (change.topologyChanged) {
-    spfResults_.clear();
+    // with incremental SPF, memoized SPF results are already up to date
+    if (not enableIncrementalSpf_) {
+      spfResults_.clear();
+    }
     kthPathResults_.clear();
   }
   return change;
@@ -646,9 +702,22 @@ LinkState::deleteAdjacencyDatabase(const std::string& nodeName) {
   auto search = adjacencyDatabases_.find(nodeName);
 
   if (search != adjacencyDatabases_.end()) {
+    for (auto const& link : linksFromNode(nodeName)) {
+      change.localLinksChanged |= link->isUp() and
+          link->getOtherNodeName(nodeName) == myNodeName_;
+    }
+    if (enableIncrementalSpf_) {
+      // tear down links one by one so memoized SPF results can be repaired
+      for (auto const& link : orderedLinksFromNode(nodeName)) {
+        const auto oldMetric = getSpfMetric(*link);
+        removeLink(link);
+        updateSpfResults(link, oldMetric, std::nullopt);
+      }
+    } else {
+      spfResults_.clear();
+    }
     removeNode(nodeName);
     adjacencyDatabases_.erase(search);
-    spfResults_.clear();
     kthPathResults_.clear();
     change.topologyChanged = true;
   } else {
@@ -671,6 +740,33 @@ LinkState::getMetricFromAToB(
   return std::nullopt;
 }
 
+std::unordered_set<std::string>
+LinkState::getSpfChangedNodes(const std::string& src) {
+  std::unordered_set<std::string> changedNodes;
+  auto const& spfResult = getSpfResult(src);
+  auto& snapshot = spfSnapshots_[src];
+
+  for (auto const& [nodeName, nodeResult] : spfResult) {
+    auto it = snapshot.find(nodeName);
+    if (it != snapshot.end() and it->second.first == nodeResult.metric() and
+        it->second.second == nodeResult.nextHops()) {
+      continue;
+    }
+    snapshot[nodeName] =
+        std::make_pair(nodeResult.metric(), nodeResult.nextHops());
+    changedNodes.emplace(nodeName);
+  }
+  for (auto it = snapshot.begin(); it != snapshot.end();) {
+    if (spfResult.count(it->first)) {
+      ++it;
+    } else {
+      changedNodes.emplace(it->first);
+      it = snapshot.erase(it);
+    }
+  }
+  return changedNodes;
+}
+
 std::vector<LinkState::Path> const&
 LinkState::getKthPaths(
     const std::string& src, const std::string& dest, size_t k) const {
@@ -714,6 +810,304 @@ LinkState::getSpfResult(
   return entryIter->second;
 }
 
+bool
+LinkState::hasSpfResult(
+    const std::string& thisNodeName, bool useLinkMetric) const {
+  return spfResults_.count(std::make_pair(thisNodeName, useLinkMetric));
+}
+
+void
+LinkState::updateSpfResults(
+    std::shared_ptr<Link> const& link,
+    std::optional<LinkStateMetric> oldMetric,
+    std::optional<LinkStateMetric> newMetric) {
+  if (not enableIncrementalSpf_ or spfResults_.empty()) {
+    return;
+  }
+
+  const auto startTime = std::chrono::steady_clock::now();
+  size_t numRecomputedNodes = 0;
+  for (auto& [key, result] : spfResults_) {
+    auto const& [src, useLinkMetric] = key;
+    numRecomputedNodes += repairSpfResult(
+        src, useLinkMetric, result, link, oldMetric, newMetric);
+  }
+  auto deltaTime = std::chrono::duration_cast<std::chrono::microseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  XLOG(DBG3) << fmt::format(
+      "Incremental SPF for {} recomputed {} nodes in {}us.",
+      link->toString(),
+      numRecomputedNodes,
+      deltaTime.count());
+  fb303::fbData->addStatValue(
+      "decision.incremental_spf_runs", spfResults_.size(), fb303::COUNT);
+  fb303::fbData->addStatValue(
+      "decision.incremental_spf.recomputed_nodes",
+      numRecomputedNodes,
+      fb303::AVG);
+  fb303::fbData->addStatValue(
+      "decision.incremental_spf_us", deltaTime.count(), fb303::AVG);
+}
+
+size_t
+LinkState::repairSpfResult(
+    const std::string& src,
+    bool useLinkMetric,
+    SpfResult& result,
+    std::shared_ptr<Link> const& link,
+    std::optional<LinkStateMetric> oldMetric,
+    std::optional<LinkStateMetric> newMetric) const {
+  // metric is hop count if we don't respect link metric
+  if (not useLinkMetric) {
+    oldMetric = oldMetric.has_value() ? std::make_optional<LinkStateMetric>(1)
+                                      : std::nullopt;
+    newMetric = newMetric.has_value() ? std::make_optional<LinkStateMetric>(1)
+                                      : std::nullopt;
+  }
+  if (oldMetric == newMetric) {
+    // no change from this SPF run's point of view
+    return 0;
+  }
+  const auto kInf = std::numeric_limits<LinkStateMetric>::max();
+  const auto oldCost = oldMetric.value_or(kInf);
+  const auto newCost = newMetric.value_or(kInf);
+  auto linkMetric = [useLinkMetric](Link const& l) -> LinkStateMetric {
+    return useLinkMetric ? l.getMaxMetric() : 1;
+  };
+
+  // set of nodes whose NodeSpfResult may change
+  std::unordered_set<std::string> affected;
+
+  if (newCost > oldCost) {
+    /*
+     * [Cost Increase / Link Down]
+     *
+     * No node can get a better path. Only nodes having the link on one of
+     * their shortest paths, and everything downstream of them on the shortest
+     * path DAG, can be affected.
+     */
+    std::vector<std::string> toVisit;
+    for (auto const& nodeName :
+         {link->firstNodeName(), link->secondNodeName()}) {
+      auto it = result.find(nodeName);
+      if (it == result.end()) {
+        continue;
+      }
+      auto const& otherNodeName = link->getOtherNodeName(nodeName);
+      for (auto const& pathLink : it->second.pathLinks()) {
+        if (pathLink.prevNode == otherNodeName and *pathLink.link == *link) {
+          affected.emplace(nodeName);
+          toVisit.emplace_back(nodeName);
+          break;
+        }
+      }
+    }
+    while (not toVisit.empty()) {
+      auto const nodeName = std::move(toVisit.back());
+      toVisit.pop_back();
+      for (auto const& nodeLink : linksFromNode(nodeName)) {
+        auto const& otherNodeName = nodeLink->getOtherNodeName(nodeName);
+        auto it = result.find(otherNodeName);
+        if (it == result.end() or affected.count(otherNodeName)) {
+          continue;
+        }
+        for (auto const& pathLink : it->second.pathLinks()) {
+          if (pathLink.prevNode == nodeName) {
+            affected.emplace(otherNodeName);
+            toVisit.emplace_back(otherNodeName);
+            break;
+          }
+        }
+      }
+    }
+  } else {
+    /*
+     * [Cost Decrease / Link Up]
+     *
+     * Probe from the link with a Dijkstra run bounded by the current result.
+     * Any node reachable through the link at a cost less or equal to its
+     * current metric gets a new (or an additional equal cost) path.
+     */
+    DijkstraQ<DijkstraQSpfNode> q;
+    auto probe = [&](const std::string& nodeName, LinkStateMetric metric) {
+      if (nodeName == src or affected.count(nodeName)) {
+        return;
+      }
+      auto it = result.find(nodeName);
+      if (it != result.end() and it->second.metric() < metric) {
+        return;
+      }
+      auto node = q.get(nodeName);
+      if (not node) {
+        q.insertNode(nodeName, metric);
+      } else if (node->metric() > metric) {
+        node->result.reset(metric);
+        q.decreaseKey(nodeName);
+      }
+    };
+    for (auto const& nodeName :
+         {link->firstNodeName(), link->secondNodeName()}) {
+      auto it = result.find(nodeName);
+      if (it != result.end() and isTransitNode(src, nodeName)) {
+        probe(link->getOtherNodeName(nodeName), it->second.metric() + newCost);
+      }
+    }
+    while (auto node = q.extractMin()) {
+      affected.emplace(node->nodeName);
+      if (not isTransitNode(src, node->nodeName)) {
+        continue;
+      }
+      for (auto const& nodeLink : linksFromNode(node->nodeName)) {
+        if (nodeLink->isUp()) {
+          probe(
+              nodeLink->getOtherNodeName(node->nodeName),
+              node->metric() + linkMetric(*nodeLink));
+        }
+      }
+    }
+  }
+
+  if (affected.empty()) {
+    return 0;
+  }
+
+  /*
+   * Recompute affected nodes. Drop their results, seed them with the best
+   * metric offered by unaffected neighbors and run Dijkstra restricted to the
+   * affected nodes. Paths and nexthops are pulled from neighbors once a node
+   * is settled, same as runSpf() would have recorded them.
+   */
+  for (auto const& nodeName : affected) {
+    result.erase(nodeName);
+  }
+
+  DijkstraQ<DijkstraQSpfNode> q;
+  auto relax = [&](const std::string& nodeName, LinkStateMetric metric) {
+    auto node = q.get(nodeName);
+    if (not node) {
+      q.insertNode(nodeName, metric);
+    } else if (node->metric() > metric) {
+      node->result.reset(metric);
+      q.decreaseKey(nodeName);
+    }
+  };
+  for (auto const& nodeName : affected) {
+    for (auto const& nodeLink : linksFromNode(nodeName)) {
+      auto const& otherNodeName = nodeLink->getOtherNodeName(nodeName);
+      auto it = result.find(otherNodeName);
+      if (nodeLink->isUp() and it != result.end() and
+          isTransitNode(src, otherNodeName)) {
+        relax(nodeName, it->second.metric() + linkMetric(*nodeLink));
+      }
+    }
+  }
+
+  while (auto node = q.extractMin()) {
+    auto const& nodeName = node->nodeName;
+    auto const nodeMetric = node->metric();
+
+    // collect all shortest paths towards this node, ordered as runSpf() would
+    // have discovered them
+    std::vector<std::tuple<
+        LinkStateMetric,
+        std::string const*,
+        std::shared_ptr<Link> const*>>
+        paths;
+    for (auto const& nodeLink : linksFromNode(nodeName)) {
+      auto const& prevNodeName = nodeLink->getOtherNodeName(nodeName);
+      auto it = result.find(prevNodeName);
+      if (nodeLink->isUp() and it != result.end() and
+          isTransitNode(src, prevNodeName) and
+          it->second.metric() + linkMetric(*nodeLink) == nodeMetric) {
+        paths.emplace_back(it->second.metric(), &prevNodeName, &nodeLink);
+      }
+    }
+    std::sort(paths.begin(), paths.end(), [](auto const& a, auto const& b) {
+      return std::tie(std::get<0>(a), *std::get<1>(a)) <
+          std::tie(std::get<0>(b), *std::get<1>(b));
+    });
+
+    auto& nodeResult =
+        result.emplace(nodeName, NodeSpfResult(nodeMetric)).first->second;
+    for (auto const& [_, prevNodeName, nodeLink] : paths) {
+      nodeResult.addPath(*nodeLink, *prevNodeName);
+      auto const& prevNextHops = result.at(*prevNodeName).nextHops();
+      if (prevNextHops.empty()) {
+        // directly connected node
+        nodeResult.addNextHop(nodeName);
+      } else {
+        nodeResult.addNextHops(prevNextHops);
+      }
+    }
+
+    if (not isTransitNode(src, nodeName)) {
+      continue;
+    }
+    for (auto const& nodeLink : linksFromNode(nodeName)) {
+      auto const& otherNodeName = nodeLink->getOtherNodeName(nodeName);
+      if (nodeLink->isUp() and affected.count(otherNodeName) and
+          not result.count(otherNodeName)) {
+        relax(otherNodeName, nodeMetric + linkMetric(*nodeLink));
+      }
+    }
+  }
+  return affected.size();
+}
+
+void
+LinkState::buildSpfGraph() const {
+  // release ids of nodes removed from topology, e.g. on adjacency database
+  // deletion. Released ids are left without edges until reused.
+  for (NodeId id = 0; id < nodeNames_.size(); ++id) {
+    auto& nodeName = nodeNames_[id];
+    if (nodeName.empty() or linkMap_.count(nodeName)) {
+      continue;
+    }
+    nodeIds_.erase(nodeName);
+    nodeName.clear();
+    freeNodeIds_.emplace_back(id);
+  }
+
+  // intern names of nodes seen for the first time, existing ids are kept
+  for (auto const& [nodeName, _] : linkMap_) {
+    if (nodeIds_.count(nodeName)) {
+      continue;
+    }
+    if (freeNodeIds_.empty()) {
+      nodeIds_.emplace(nodeName, nodeNames_.size());
+      nodeNames_.emplace_back(nodeName);
+    } else {
+      nodeIds_.emplace(nodeName, freeNodeIds_.back());
+      nodeNames_[freeNodeIds_.back()] = nodeName;
+      freeNodeIds_.pop_back();
+    }
+  }
+
+  const auto numNodes = nodeNames_.size();
+  auto& graph = spfGraph_;
+  graph.offsets.assign(numNodes + 1, 0);
+  graph.edges.clear();
+  graph.links.clear();
+  graph.nodeOverloaded.assign(numNodes, false);
+
+  for (NodeId id = 0; id < numNodes; ++id) {
+    graph.offsets[id] = graph.edges.size();
+    auto const& nodeName = nodeNames_[id];
+    graph.nodeOverloaded[id] = isNodeOverloaded(nodeName);
+    for (auto const& link : linksFromNode(nodeName)) {
+      auto& edge = graph.edges.emplace_back();
+      edge.metric = link->getMaxMetric();
+      edge.neighbor = nodeIds_.at(link->getOtherNodeName(nodeName));
+      edge.overloaded = link->getOverloadFromNode(link->firstNodeName()) or
+          link->getOverloadFromNode(link->secondNodeName());
+      edge.usable = link->getUsability();
+      graph.links.emplace_back(link);
+    }
+  }
+  graph.offsets[numNodes] = graph.edges.size();
+  spfGraphDirty_ = false;
+}
+
 /**
  * Compute shortest-path routes from perspective of nodeName;
  */
@@ -722,24 +1116,70 @@ LinkState::runSpf(
     const std::string& thisNodeName,
     bool useLinkMetric,
     const LinkState::LinkSet& linksToIgnore) const {
+  switch (spfQueueType_) {
+  case thrift::SpfQueueType::RADIX_HEAP:
+    return runSpfWithQueue<RadixHeap>(
+        thisNodeName, useLinkMetric, linksToIgnore);
+  case thrift::SpfQueueType::DARY_HEAP:
+  default:
+    return runSpfWithQueue<IndexedDaryHeap<>>(
+        thisNodeName, useLinkMetric, linksToIgnore);
+  }
+}
+
+template <class Queue>
+LinkState::SpfResult
+LinkState::runSpfWithQueue(
+    const std::string& thisNodeName,
+    bool useLinkMetric,
+    const LinkState::LinkSet& linksToIgnore) const {
   LinkState::SpfResult result;
 
   fb303::fbData->addStatValue("decision.spf_runs", 1, fb303::COUNT);
   const auto startTime = std::chrono::steady_clock::now();
 
-  DijkstraQ<DijkstraQSpfNode> q;
-  q.insertNode(thisNodeName, 0);
-  while (auto node = q.extractMin()) {
+  if (spfGraphDirty_) {
+    buildSpfGraph();
+  }
+  auto const& graph = spfGraph_;
+
+  // Per node SPF state, indexed by NodeId. Paths are recorded as
+  // (edge index, previous node) and nexthops as sorted NodeIds; both are
+  // translated to names only once the node is reported in the result.
+  struct NodeState {
+    LinkStateMetric metric{std::numeric_limits<LinkStateMetric>::max()};
+    bool settled{false};
+    std::vector<std::pair<uint32_t /* edge */, NodeId /* prevNode */>>
+        pathLinks;
+    std::vector<NodeId> nextHops;
+  };
+
+  auto srcIt = nodeIds_.find(thisNodeName);
+  if (srcIt == nodeIds_.end()) {
+    // node without any links
+    result.emplace(thisNodeName, NodeSpfResult(0));
+    return result;
+  }
+  const NodeId src = srcIt->second;
+  std::vector<NodeState> states(nodeNames_.size());
+  std::vector<NodeId> settledNodes;
+
+  // queues without decrease-key (RadixHeap) hold stale entries for nodes
+  // whose metric got decreased, they are skipped once popped
+  Queue q(states.size());
+  states[src].metric = 0;
+  q.push(src, 0);
+  while (not q.empty()) {
+    const auto [recordedNodeMetric, recordedNode] = q.pop();
+    auto& recordedState = states[recordedNode];
+    if (recordedState.settled or recordedState.metric != recordedNodeMetric) {
+      continue;
+    }
     // we've found this node's shortest paths. record it
-    auto emplaceRc = result.emplace(node->nodeName, std::move(node->result));
-    CHECK(emplaceRc.second);
+    recordedState.settled = true;
+    settledNodes.emplace_back(recordedNode);
 
-    auto const& recordedNodeName = emplaceRc.first->first;
-    auto const recordedNodeMetric = emplaceRc.first->second.metric();
-    auto const& recordedNodeNextHops = emplaceRc.first->second.nextHops();
-
-    if (isNodeOverloaded(recordedNodeName) and
-        recordedNodeName != thisNodeName) {
+    if (graph.nodeOverloaded[recordedNode] and recordedNode != src) {
       /*
        * [Node Hard-Drain]
        *
@@ -751,24 +1191,24 @@ LinkState::runSpf(
       continue;
     }
     /*
-     * We have the shortest path nexthops for `recordedNodeName`. Use these
-     * nextHops for any node that is connected to `recordedNodeName` that
+     * We have the shortest path nexthops for `recordedNode`. Use these
+     * nextHops for any node that is connected to `recordedNode` that
      * doesn't already have a lower cost path from thisNodeName.
      *
      * This is the "relax" step in the Dijkstra Algorithm pseudocode in CLRS.
      */
-    for (const auto& link : linksFromNode(recordedNodeName)) {
-      auto& otherNodeName = link->getOtherNodeName(recordedNodeName);
-      if (!link->isUp() or result.count(otherNodeName) or
-          linksToIgnore.count(link)) {
+    for (auto e = graph.offsets[recordedNode];
+         e < graph.offsets[recordedNode + 1];
+         ++e) {
+      auto const& edge = graph.edges[e];
+      auto& otherState = states[edge.neighbor];
+      if (edge.overloaded or not edge.usable or otherState.settled or
+          (not linksToIgnore.empty() and linksToIgnore.count(graph.links[e]))) {
         /*
          * [Interface Hard-Drain]
          *
-         * When interface is hard-drained, aka, with overload bit set,
-         *
-         * link->isUp() returns false
-         *
-         * with either side of the adjacency marked as `overloaded`.
+         * When interface is hard-drained, aka, with overload bit set on
+         * either side of the adjacency, `edge.overloaded` is set.
          *
          * This prevents Dijkstra algorithm from considering this link.
          */
@@ -786,32 +1226,71 @@ LinkState::runSpf(
        * SPF should consider max metric of the bi-directional adj instead of
        * uni-directional one from "current node" to "other node".
        */
-      auto metric = useLinkMetric ? link->getMaxMetric() : 1;
-      auto otherNode = q.get(otherNodeName);
-      if (!otherNode) {
-        q.insertNode(otherNodeName, recordedNodeMetric + metric);
-        otherNode = q.get(otherNodeName);
+      const auto metric =
+          recordedNodeMetric + (useLinkMetric ? edge.metric : 1);
+      if (otherState.metric < metric) {
+        continue;
       }
-      if (otherNode->metric() >= recordedNodeMetric + metric) {
-        // recordedNodeName is either along an alternate shortest path towards
-        // otherNodeName or is along a new shorter path. In either case,
-        // otherNodeName should use recordedNodeName's nextHops until it finds
-        // some shorter path
-        if (otherNode->metric() > recordedNodeMetric + metric) {
-          // if this is strictly better, forget about any other paths
-          otherNode->result.reset(recordedNodeMetric + metric);
-          q.reMake();
-        }
-        auto& otherNodeResult = otherNode->result;
-        otherNodeResult.addPath(link, recordedNodeName);
-        otherNodeResult.addNextHops(recordedNodeNextHops);
-        if (otherNodeResult.nextHops().empty()) {
-          // directly connected node
-          otherNodeResult.addNextHop(otherNodeName);
-        }
+      // recordedNode is either along an alternate shortest path towards
+      // otherNode or is along a new shorter path. In either case, otherNode
+      // should use recordedNode's nextHops until it finds some shorter path
+      if (otherState.metric > metric) {
+        // if this is strictly better, forget about any other paths
+        otherState.metric = metric;
+        otherState.pathLinks.clear();
+        otherState.nextHops.clear();
+        q.push(edge.neighbor, metric);
       }
+      otherState.pathLinks.emplace_back(e, recordedNode);
+      if (otherState.nextHops.empty()) {
+        otherState.nextHops = recordedState.nextHops;
+      } else if (not recordedState.nextHops.empty()) {
+        std::vector<NodeId> nextHops;
+        std::set_union(
+            otherState.nextHops.begin(),
+            otherState.nextHops.end(),
+            recordedState.nextHops.begin(),
+            recordedState.nextHops.end(),
+            std::back_inserter(nextHops));
+        otherState.nextHops = std::move(nextHops);
+      }
+      if (otherState.nextHops.empty()) {
+        // directly connected node
+        otherState.nextHops.emplace_back(edge.neighbor);
+      }
+    }
+  }
+
+  // translate to string keyed result. paths are reported ordered by
+  // (metric, nodeName) of their previous node, regardless of the order in
+  // which the queue settled equal cost nodes
+  result.reserve(settledNodes.size());
+  for (auto const id : settledNodes) {
+    auto& state = states[id];
+    auto& nodeResult =
+        result.emplace(nodeNames_[id], NodeSpfResult(state.metric))
+            .first->second;
+    if (state.pathLinks.size() > 1) {
+      std::stable_sort(
+          state.pathLinks.begin(),
+          state.pathLinks.end(),
+          [&](auto const& a, auto const& b) {
+            auto const& aMetric = states[a.second].metric;
+            auto const& bMetric = states[b.second].metric;
+            if (aMetric != bMetric) {
+              return aMetric < bMetric;
+            }
+            return nodeNames_[a.second] < nodeNames_[b.second];
+          });
+    }
+    for (auto const& [e, prevNode] : state.pathLinks) {
+      nodeResult.addPath(graph.links[e], nodeNames_[prevNode]);
+    }
+    for (auto const nextHop : state.nextHops) {
+      nodeResult.addNextHop(nodeNames_[nextHop]);
     }
   }
+
   auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - startTime);
   XLOG(DBG3) << "SPF elapsed time: " << deltaTime.count() << "ms.";
@@ -7,8 +7,12 @@
 
 #pragma once
 
+#include <deque>
+
+#include <folly/lang/Bits.h>
 #include <openr/common/Constants.h>
 #include <openr/if/gen-cpp2/Network_types.h>
+#include <openr/if/gen-cpp2/OpenrConfig_types.h>
 #include <openr/if/gen-cpp2/Types_types.h>
 
 namespace openr {
@@ -263,7 +267,11 @@ class Link {
 
 class LinkState {
  public:
-  explicit LinkState(const std::string& area, const std::string& myNodeName);
+  explicit LinkState(
+      const std::string& area,
+      const std::string& myNodeName,
+      bool enableIncrementalSpf = false,
+      thrift::SpfQueueType spfQueueType = thrift::SpfQueueType::DARY_HEAP);
 
   struct LinkPtrHash {
     size_t operator()(const std::shared_ptr<Link>& l) const;
@@ -355,9 +363,18 @@ class LinkState {
   // each is memoized all params. memoization invalidated for any topolgy
   // altering calls, i.e. if pdateAdjacencyDatabase(), or
   // deleteAdjacencyDatabase() returns with LinkState::topologyChanged set true
+  //
+  // With incremental SPF enabled, memoized SpfResults are instead repaired in
+  // place on link events (metric change, link up/down). Only node level
+  // changes (node hard-drain) drop them.
   SpfResult const& getSpfResult(
       const std::string& nodeName, bool useLinkMetric = true) const;
 
+  // Whether SpfResult of the node is memoized, i.e. getSpfResult() is a
+  // read-only lookup
+  bool hasSpfResult(
+      const std::string& nodeName, bool useLinkMetric = true) const;
+
  private:
   // LinkState belongs to a unique area
   const std::string area_;
@@ -365,12 +382,29 @@ class LinkState {
   // Current node name
   const std::string myNodeName_;
 
+  // Repair memoized SPF results on link events instead of dropping them
+  const bool enableIncrementalSpf_{false};
+
+  // Priority queue implementation used by runSpf()
+  const thrift::SpfQueueType spfQueueType_{thrift::SpfQueueType::DARY_HEAP};
+
   // memoization structure for getSpfResult()
+  // ATTN: getSpfResult() inserts on a miss and is not thread safe. Concurrent
+  // callers (parallel route build) must only look up entries memoized before
+  // they start, see SpfSolver::buildUnicastRoutesParallel()
   mutable std::unordered_map<
       std::pair<std::string /* nodeName */, bool /* useLinkMetric */>,
       SpfResult>
       spfResults_;
 
+  // last reported metric and nexthops per node, see getSpfChangedNodes()
+  std::unordered_map<
+      std::string /* src */,
+      std::unordered_map<
+          std::string /* nodeName */,
+          std::pair<LinkStateMetric, std::unordered_set<std::string>>>>
+      spfSnapshots_;
+
  public:
   // Trace edge-disjoint paths from dest to src.
   // I.e., no two paths returned from this function can share any links
@@ -418,6 +452,9 @@ class LinkState {
     bool linkAttributesChanged{false};
     // Whehter node labels have changed
     bool nodeLabelChanged{false};
+    // Whether topology changed on any link of myNodeName, i.e. local nexthops
+    // may have changed. Not considered by operator==
+    bool localLinksChanged{false};
   };
 
   // update adjacencies for the given router
@@ -439,6 +476,11 @@ class LinkState {
       std::string const& b,
       bool useLinkMetric = true) const;
 
+  // returns nodes whose SPF metric or nexthops from `src` changed since the
+  // previous call for `src`. All reachable nodes are returned on first call.
+  // Nodes that became unreachable are reported as well.
+  std::unordered_set<std::string> getSpfChangedNodes(const std::string& src);
+
   const std::string&
   getArea() const {
     return area_;
@@ -465,6 +507,12 @@ class LinkState {
     return linkMap_.size();
   }
 
+  // node ids allocated for SPF, bounded by peak number of nodes
+  size_t
+  numSpfNodeIds() const {
+    return nodeNames_.size();
+  }
+
   bool
   linkUsable(
       const thrift::Adjacency& adj1, const thrift::Adjacency& adj2) const {
@@ -519,6 +567,48 @@ class LinkState {
 
   void removeNode(const std::string& nodeName);
 
+  /*
+   * [Incremental SPF]
+   *
+   * Repair every memoized SpfResult after a single link changed its SPF cost.
+   * Must be called right after the link change is applied to the graph, so
+   * that the graph differs from the one the results were computed on by this
+   * link only.
+   *
+   * @param: link - the changed link
+   * @param: oldMetric - max metric of the link before the change, std::nullopt
+   *                     if the link was down or not present
+   * @param: newMetric - max metric of the link after the change, std::nullopt
+   *                     if the link is down or removed
+   */
+  void updateSpfResults(
+      std::shared_ptr<Link> const& link,
+      std::optional<LinkStateMetric> oldMetric,
+      std::optional<LinkStateMetric> newMetric);
+
+  /*
+   * Repair a single SpfResult rooted at `src`. Nodes whose shortest paths can
+   * be affected by the link change are collected first:
+   *  - cost increase: nodes downstream of the link on the shortest path DAG
+   *  - cost decrease: nodes reachable through the link at a cost not worse
+   *                   than their current one
+   * Only those nodes are then recomputed, seeded from their unaffected
+   * neighbors. Returns number of nodes recomputed.
+   */
+  size_t repairSpfResult(
+      const std::string& src,
+      bool useLinkMetric,
+      SpfResult& result,
+      std::shared_ptr<Link> const& link,
+      std::optional<LinkStateMetric> oldMetric,
+      std::optional<LinkStateMetric> newMetric) const;
+
+  // whether paths through this node can be considered by SPF from `src`
+  bool
+  isTransitNode(const std::string& src, const std::string& nodeName) const {
+    return nodeName == src or not isNodeOverloaded(nodeName);
+  }
+
   bool updateNodeOverloaded(const std::string& nodeName, bool isOverloaded);
 
   std::string mayHaveLinkEventPropagationTime(
@@ -547,6 +637,13 @@ class LinkState {
       bool useLinkMetric,
       const LinkSet& linksToIgnore = {}) const;
 
+  // runSpf() body, parameterized by the priority queue implementation
+  template <class Queue>
+  SpfResult runSpfWithQueue(
+      const std::string& src,
+      bool useLinkMetric,
+      const LinkSet& linksToIgnore) const;
+
   /*
    * Util method to create Link object:
    *  - only if the bi-directional(reverse) adjacency is present
@@ -561,6 +658,56 @@ class LinkState {
   std::vector<std::shared_ptr<Link>> orderedLinksFromNode(
       const std::string& nodeName) const;
 
+  /*
+   * [SPF Graph]
+   *
+   * Compact, read-only view of the topology used by runSpf(). Node names are
+   * interned into dense NodeIds and links are laid out as a CSR adjacency
+   * array with SPF relevant attributes packed per edge. The SPF inner loop
+   * thus only walks contiguous memory and never hashes node names; string
+   * keyed SpfResult is produced once at the end of the run.
+   *
+   * The graph is rebuilt lazily from linkMap_ by the first SPF run after any
+   * topology change.
+   */
+  using NodeId = uint32_t;
+
+  struct SpfGraph {
+    struct Edge {
+      // max metric of both ends of the link
+      LinkStateMetric metric{1};
+      NodeId neighbor{0};
+      // either end of the link is hard-drained
+      bool overloaded{false};
+      // link usability due to device initialization state
+      bool usable{true};
+    };
+
+    // edges of node `id` are edges[offsets[id], offsets[id + 1])
+    std::vector<uint32_t> offsets;
+    std::vector<Edge> edges;
+
+    // link object of each edge, only touched when recording paths
+    std::vector<std::shared_ptr<Link>> links;
+
+    // [hard-drain] state of each node
+    std::vector<bool> nodeOverloaded;
+  };
+
+  void buildSpfGraph() const;
+
+  // interned node names. ids of removed nodes are released by the next graph
+  // build and reused for new nodes, thus nodeNames_ never outgrows the peak
+  // number of nodes. A released id maps to an empty name.
+  mutable std::unordered_map<std::string, NodeId> nodeIds_;
+  mutable std::vector<std::string> nodeNames_;
+  mutable std::vector<NodeId> freeNodeIds_;
+
+  mutable SpfGraph spfGraph_;
+
+  // set on any change in links or node hard-drain state
+  mutable bool spfGraphDirty_{true};
+
   // this stores the same link object accessible from either nodeName
   std::unordered_map<std::string /* nodeName */, LinkSet> linkMap_;
 
@@ -582,6 +729,179 @@ class LinkState {
 
 }; // class LinkState
 
+/*
+ * Indexed d-ary min-heap of dense ids ordered by (metric, id).
+ *
+ * Position and metric of every id are kept in flat vectors, so push() of an
+ * already queued id is a O(log n) decrease-key instead of a re-heapify, and
+ * no allocation happens once the queue has seen the largest id.
+ */
+template <size_t D = 4>
+class IndexedDaryHeap {
+ public:
+  using Id = uint32_t;
+
+  explicit IndexedDaryHeap(size_t numIds = 0)
+      : metrics_(numIds), positions_(numIds, kNotQueued) {}
+
+  bool
+  empty() const {
+    return heap_.empty();
+  }
+
+  // queue `id` with `metric` or lower its metric if already queued
+  void
+  push(Id id, LinkStateMetric metric) {
+    if (id >= positions_.size()) {
+      metrics_.resize(id + 1);
+      positions_.resize(id + 1, kNotQueued);
+    }
+    auto pos = positions_[id];
+    if (pos == kNotQueued) {
+      pos = heap_.size();
+      heap_.emplace_back(id);
+    } else if (metrics_[id] <= metric) {
+      return;
+    }
+    metrics_[id] = metric;
+    siftUp(pos);
+  }
+
+  std::pair<LinkStateMetric, Id>
+  pop() {
+    const auto id = heap_.front();
+    positions_[id] = kNotQueued;
+    const auto last = heap_.back();
+    heap_.pop_back();
+    if (not heap_.empty()) {
+      place(0, last);
+      siftDown(0);
+    }
+    return {metrics_[id], id};
+  }
+
+ private:
+  static constexpr size_t kNotQueued = std::numeric_limits<size_t>::max();
+
+  bool
+  less(Id a, Id b) const {
+    if (metrics_[a] != metrics_[b]) {
+      return metrics_[a] < metrics_[b];
+    }
+    return a < b;
+  }
+
+  void
+  place(size_t pos, Id id) {
+    heap_[pos] = id;
+    positions_[id] = pos;
+  }
+
+  void
+  siftUp(size_t pos) {
+    const auto id = heap_[pos];
+    while (pos > 0) {
+      const auto parent = (pos - 1) / D;
+      if (not less(id, heap_[parent])) {
+        break;
+      }
+      place(pos, heap_[parent]);
+      pos = parent;
+    }
+    place(pos, id);
+  }
+
+  void
+  siftDown(size_t pos) {
+    const auto id = heap_[pos];
+    const auto size = heap_.size();
+    while (true) {
+      const auto first = pos * D + 1;
+      if (first >= size) {
+        break;
+      }
+      auto best = first;
+      for (auto child = first + 1; child < std::min(first + D, size); ++child) {
+        if (less(heap_[child], heap_[best])) {
+          best = child;
+        }
+      }
+      if (not less(heap_[best], id)) {
+        break;
+      }
+      place(pos, heap_[best]);
+      pos = best;
+    }
+    place(pos, id);
+  }
+
+  std::vector<Id> heap_;
+  std::vector<LinkStateMetric> metrics_;
+  std::vector<size_t> positions_;
+};
+
+/*
+ * Monotone radix heap of dense ids for integer metrics.
+ *
+ * Entries are bucketed by the highest bit in which their metric differs from
+ * the last popped metric. Only valid when pushed metrics are never lower than
+ * the last popped one, which holds for Dijkstra with non-negative link
+ * metrics. There is no decrease-key: a decreased id is pushed again and the
+ * caller is expected to skip the stale entry once popped.
+ */
+class RadixHeap {
+ public:
+  using Id = uint32_t;
+
+  explicit RadixHeap(size_t /* numIds */ = 0) {}
+
+  bool
+  empty() const {
+    return size_ == 0;
+  }
+
+  void
+  push(Id id, LinkStateMetric metric) {
+    DCHECK_GE(metric, last_);
+    buckets_[bucketIndex(metric)].emplace_back(metric, id);
+    ++size_;
+  }
+
+  std::pair<LinkStateMetric, Id>
+  pop() {
+    if (buckets_[0].empty()) {
+      // redistribute the first non-empty bucket around its minimum. Every
+      // entry lands in a strictly lower bucket
+      size_t i = 1;
+      while (buckets_[i].empty()) {
+        ++i;
+      }
+      last_ = std::min_element(buckets_[i].begin(), buckets_[i].end())->first;
+      for (auto const& entry : buckets_[i]) {
+        buckets_[bucketIndex(entry.first)].emplace_back(entry);
+      }
+      buckets_[i].clear();
+    }
+    const auto top = buckets_[0].back();
+    buckets_[0].pop_back();
+    --size_;
+    return top;
+  }
+
+ private:
+  size_t
+  bucketIndex(LinkStateMetric metric) const {
+    return folly::findLastSet(metric ^ last_);
+  }
+
+  std::array<
+      std::vector<std::pair<LinkStateMetric, Id>>,
+      std::numeric_limits<LinkStateMetric>::digits + 1>
+      buckets_;
+  LinkStateMetric last_{0};
+  size_t size_{0};
+};
+
 // Classes needed for running Dijkstra to build an SPF graph starting at a root
 // node to all other nodes the link state topology. In addition to implementing
 // the priority queue element at the heart of Dijkstra's algorithm, this
@@ -603,7 +923,8 @@ class DijkstraQSpfNode {
 /*
  * Dijkstra Q template class.
  *
- * Implements a priority queue using a heap.
+ * Implements a name keyed priority queue on top of an IndexedDaryHeap. Queued
+ * elements are pooled for the lifetime of the queue.
  *
  * Template object must have the following elements
  *  - metric
@@ -611,55 +932,45 @@ class DijkstraQSpfNode {
  */
 template <class T>
 class DijkstraQ {
- private:
-  std::vector<std::shared_ptr<T>> heap_;
-  std::unordered_map<std::string, std::shared_ptr<T>> nameToNode_;
-
-  struct {
-    bool
-    operator()(std::shared_ptr<T> a, std::shared_ptr<T> b) const {
-      if (a->metric() != b->metric()) {
-        return a->metric() > b->metric();
-      }
-      return a->nodeName > b->nodeName;
-    }
-  } DijkstraQNodeGreater;
-
  public:
   void
   insertNode(const std::string& nodeName, LinkStateMetric d) {
-    heap_.emplace_back(std::make_shared<T>(nodeName, d));
-    nameToNode_[nodeName] = heap_.back();
-    std::push_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
+    const auto slot = nodes_.size();
+    nodes_.emplace_back(nodeName, d);
+    CHECK(nameToSlot_.emplace(nodeName, slot).second);
+    heap_.push(slot, d);
   }
 
-  std::shared_ptr<T>
+  T*
   get(const std::string& nodeName) {
-    if (nameToNode_.count(nodeName)) {
-      return nameToNode_.at(nodeName);
+    auto it = nameToSlot_.find(nodeName);
+    if (it != nameToSlot_.end()) {
+      return &nodes_[it->second];
     }
     return nullptr;
   }
 
-  std::shared_ptr<T>
+  std::optional<T>
   extractMin() {
     if (heap_.empty()) {
-      return nullptr;
+      return std::nullopt;
     }
-    auto min = heap_.at(0);
-    CHECK(nameToNode_.erase(min->nodeName));
-    std::pop_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
-    heap_.pop_back();
-    return min;
+    auto& node = nodes_[heap_.pop().second];
+    CHECK(nameToSlot_.erase(node.nodeName));
+    return std::move(node);
   }
 
+  // restore queue order after metric of a queued node got decreased
   void
-  reMake() {
-    // this is a bit slow but is rarely called in our application. In fact,
-    // in networks where the metric is hop count, this will never be called
-    // and the Dijkstra run is no different than BFS
-    std::make_heap(heap_.begin(), heap_.end(), DijkstraQNodeGreater);
+  decreaseKey(const std::string& nodeName) {
+    const auto slot = nameToSlot_.at(nodeName);
+    heap_.push(slot, nodes_[slot].metric());
   }
+
+ private:
+  std::deque<T> nodes_;
+  std::unordered_map<std::string, uint32_t> nameToSlot_;
+  IndexedDaryHeap<> heap_;
 };
 } // namespace openr
 
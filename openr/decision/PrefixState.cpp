@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 
 #include <openr/common/LsdbUtil.h>
@@ -16,43 +17,239 @@ std::unordered_set<folly::CIDRNetwork>
 PrefixState::updatePrefix(
     PrefixKey const& key, thrift::PrefixEntry const& entry) {
   std::unordered_set<folly::CIDRNetwork> changed;
+  releaseShardOwnership(key);
+  if (addPrefixEntry(key, entry)) {
+    changed.insert(key.getCIDRNetwork());
+  }
+  return changed;
+}
 
-  auto [it, inserted] = prefixes_[key.getCIDRNetwork()].emplace(
-      key.getNodeAndArea(), std::make_shared<thrift::PrefixEntry>(entry));
+std::unordered_set<folly::CIDRNetwork>
+PrefixState::deletePrefix(PrefixKey const& key) {
+  std::unordered_set<folly::CIDRNetwork> changed;
+  if (not isOwnedByShard(key) and removePrefixEntry(key)) {
+    changed.insert(key.getCIDRNetwork());
+  }
+  return changed;
+}
 
-  // Skip rest of code, if prefix exists and has no change
-  if (not inserted && *it->second == entry) {
-    return changed;
+void
+PrefixState::applyBatch(
+    std::vector<PrefixUpdate>&& updates,
+    std::unordered_set<folly::CIDRNetwork>& changed) {
+  // Avoid rehashing while absorbing initial dump of all keys
+  if (updates.size() > prefixes_.size()) {
+    prefixes_.reserve(prefixes_.size() + updates.size());
   }
-  // Update prefix
-  if (not inserted) {
-    it->second = std::make_shared<thrift::PrefixEntry>(entry);
+  changed.reserve(changed.size() + updates.size());
+
+  for (auto& update : updates) {
+    auto const& key = update.key;
+    if (update.entry.has_value()) {
+      releaseShardOwnership(key);
+      if (addPrefixEntry(key, std::move(update.entry).value())) {
+        changed.insert(key.getCIDRNetwork());
+      }
+    } else if (not isOwnedByShard(key) and removePrefixEntry(key)) {
+      changed.insert(key.getCIDRNetwork());
+    }
   }
-  changed.insert(key.getCIDRNetwork());
+}
 
-  XLOG(DBG1) << "[ROUTE ADVERTISEMENT] " << "Area: " << key.getPrefixArea()
-             << ", Node: " << key.getNodeName() << ", "
-             << toString(entry, VLOG_IS_ON(1));
+std::unordered_set<folly::CIDRNetwork>
+PrefixState::updatePrefixShard(
+    PrefixShardKey const& key,
+    std::vector<thrift::PrefixEntry> const& entries) {
+  std::unordered_set<folly::CIDRNetwork> changed;
+  std::unordered_set<folly::CIDRNetwork> newPrefixes;
+  auto& oldPrefixes = shardToPrefixes_[key];
+  auto& owners = prefixToShard_[key.getNodeAndArea()];
+
+  for (auto const& entry : entries) {
+    const auto network = toIPNetwork(*entry.prefix());
+    newPrefixes.emplace(network);
+
+    auto [ownerIt, inserted] = owners.emplace(network, key.getShardId());
+    if (not inserted and ownerIt->second != key.getShardId()) {
+      // Prefix moved across shards, e.g. originator changed number of shards
+      auto shardIt = shardToPrefixes_.find(PrefixShardKey(
+          key.getNodeName(), ownerIt->second, key.getPrefixArea()));
+      if (shardIt != shardToPrefixes_.end()) {
+        shardIt->second.erase(network);
+      }
+      ownerIt->second = key.getShardId();
+    }
+    if (addPrefixEntry(
+            PrefixKey(key.getNodeName(), network, key.getPrefixArea()),
+            entry)) {
+      changed.insert(network);
+    }
+  }
+
+  // Withdraw prefixes no longer carried by the shard
+  for (auto const& network : oldPrefixes) {
+    if (newPrefixes.count(network)) {
+      continue;
+    }
+    auto ownerIt = owners.find(network);
+    if (ownerIt == owners.end() or ownerIt->second != key.getShardId()) {
+      continue;
+    }
+    owners.erase(ownerIt);
+    if (removePrefixEntry(
+            PrefixKey(key.getNodeName(), network, key.getPrefixArea()))) {
+      changed.insert(network);
+    }
+  }
+  oldPrefixes = std::move(newPrefixes);
+
+  if (owners.empty()) {
+    prefixToShard_.erase(key.getNodeAndArea());
+  }
   return changed;
 }
 
 std::unordered_set<folly::CIDRNetwork>
-PrefixState::deletePrefix(PrefixKey const& key) {
-  std::unordered_set<folly::CIDRNetwork> changed;
+PrefixState::deletePrefixShard(PrefixShardKey const& key) {
+  auto changed = updatePrefixShard(key, {});
+  shardToPrefixes_.erase(key);
+  return changed;
+}
 
+void
+PrefixState::releaseShardOwnership(PrefixKey const& key) {
+  // Per prefix key takes over prefix from shard key of same originator
+  auto nodeIt = prefixToShard_.find(key.getNodeAndArea());
+  if (nodeIt == prefixToShard_.end()) {
+    return;
+  }
+  auto it = nodeIt->second.find(key.getCIDRNetwork());
+  if (it == nodeIt->second.end()) {
+    return;
+  }
+  shardToPrefixes_
+      .at(PrefixShardKey(key.getNodeName(), it->second, key.getPrefixArea()))
+      .erase(key.getCIDRNetwork());
+  nodeIt->second.erase(it);
+  if (nodeIt->second.empty()) {
+    prefixToShard_.erase(nodeIt);
+  }
+}
+
+bool
+PrefixState::isOwnedByShard(PrefixKey const& key) const {
+  // Withdraw of prefix owned by shard key of same originator is ignored (e.g.
+  // expiry of per prefix key after migrating to shard keys)
+  auto nodeIt = prefixToShard_.find(key.getNodeAndArea());
+  return nodeIt != prefixToShard_.end() and
+      nodeIt->second.count(key.getCIDRNetwork());
+}
+
+bool
+PrefixState::addPrefixEntry(PrefixKey const& key, thrift::PrefixEntry entry) {
+  auto& entries = prefixes_[key.getCIDRNetwork()];
+  auto it = entries.find(key.getNodeAndArea());
+
+  // Skip rest of code, if prefix exists and has no change. Stored entries
+  // don't carry prefix, it's the key of `prefixes_`
+  const auto prefix = std::exchange(*entry.prefix(), thrift::IpPrefix());
+  if (it != entries.end() and *it->second == entry) {
+    return false;
+  }
+
+  XLOG(DBG1) << "[ROUTE ADVERTISEMENT] " << "Area: " << key.getPrefixArea()
+             << ", Node: " << key.getNodeName() << ", Prefix: "
+             << toString(prefix) << ", " << toString(entry, VLOG_IS_ON(1));
+
+  // Update prefix
+  auto entryPtr = internEntry(std::move(entry));
+  if (it != entries.end()) {
+    releaseEntry(it->second);
+    it->second = std::move(entryPtr);
+  } else {
+    entries.emplace(key.getNodeAndArea(), std::move(entryPtr));
+    nodeToPrefixes_[key.getNodeAndArea()].insert(key.getCIDRNetwork());
+  }
+  return true;
+}
+
+bool
+PrefixState::removePrefixEntry(PrefixKey const& key) {
   auto search = prefixes_.find(key.getCIDRNetwork());
-  if (search != prefixes_.end() and
-      search->second.erase(key.getNodeAndArea())) {
-    changed.insert(key.getCIDRNetwork());
-    XLOG(DBG1) << "[ROUTE WITHDRAW] " << "Area: " << key.getPrefixArea()
-               << ", Node: " << key.getNodeName() << ", "
-               << folly::IPAddress::networkToString(key.getCIDRNetwork());
-    // clean up data structures
-    if (search->second.empty()) {
-      prefixes_.erase(search);
+  if (search == prefixes_.end()) {
+    return false;
+  }
+  auto entryIt = search->second.find(key.getNodeAndArea());
+  if (entryIt == search->second.end()) {
+    return false;
+  }
+  releaseEntry(entryIt->second);
+  search->second.erase(entryIt);
+
+  auto nodeIt = nodeToPrefixes_.find(key.getNodeAndArea());
+  if (nodeIt != nodeToPrefixes_.end()) {
+    nodeIt->second.erase(key.getCIDRNetwork());
+    if (nodeIt->second.empty()) {
+      nodeToPrefixes_.erase(nodeIt);
     }
   }
-  return changed;
+  XLOG(DBG1) << "[ROUTE WITHDRAW] " << "Area: " << key.getPrefixArea()
+             << ", Node: " << key.getNodeName() << ", "
+             << folly::IPAddress::networkToString(key.getCIDRNetwork());
+  // clean up data structures
+  if (search->second.empty()) {
+    prefixes_.erase(search);
+  }
+  return true;
+}
+
+std::shared_ptr<thrift::PrefixEntry>
+PrefixState::internEntry(thrift::PrefixEntry&& entry) {
+  auto it = internedEntries_.find(std::cref(entry));
+  if (it == internedEntries_.end()) {
+    auto entryPtr = std::make_shared<thrift::PrefixEntry>(std::move(entry));
+    it = internedEntries_
+             .emplace(std::cref(*entryPtr), InternedEntry{entryPtr, 0})
+             .first;
+  }
+  ++it->second.refCount;
+  return it->second.entry;
+}
+
+void
+PrefixState::releaseEntry(std::shared_ptr<thrift::PrefixEntry> const& entry) {
+  auto it = internedEntries_.find(std::cref(*entry));
+  CHECK(it != internedEntries_.end());
+  if (--it->second.refCount == 0) {
+    internedEntries_.erase(it);
+  }
+}
+
+size_t
+PrefixState::PrefixEntryHash::operator()(
+    thrift::PrefixEntry const& entry) const {
+  auto const& metrics = *entry.metrics();
+  return folly::hash::hash_combine(
+      *entry.type(),
+      *entry.forwardingType(),
+      *entry.forwardingAlgorithm(),
+      *metrics.path_preference(),
+      *metrics.source_preference(),
+      *metrics.distance(),
+      *metrics.drain_metric(),
+      folly::hash::hash_range(entry.tags()->begin(), entry.tags()->end()),
+      folly::hash::hash_range(
+          entry.area_stack()->begin(), entry.area_stack()->end()));
+}
+
+std::unordered_set<folly::CIDRNetwork> const&
+PrefixState::getPrefixesFromNode(NodeAndArea const& nodeAndArea) const {
+  static const std::unordered_set<folly::CIDRNetwork> defaultEmptySet;
+  auto search = nodeToPrefixes_.find(nodeAndArea);
+  if (search != nodeToPrefixes_.end()) {
+    return search->second;
+  }
+  return defaultEmptySet;
 }
 
 std::vector<thrift::ReceivedRouteDetail>
@@ -105,6 +302,7 @@ PrefixState::filterAndAddReceivedRoute(
     route.key()->node() = nodeAndArea.first;
     route.key()->area() = nodeAndArea.second;
     route.route() = *prefixEntry;
+    route.route()->prefix() = *routeDetail.prefix();
   }
 
   // Add detail if there are entries to return
@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include <functional>
+
 #include <openr/common/LsdbTypes.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/if/gen-cpp2/Network_types.h>
@@ -17,6 +19,9 @@ namespace openr {
 
 class PrefixState {
  public:
+  // ATTN: entries are stored without `prefix`, which is the key of the map.
+  // Identical entries (of any prefix and originator) share one object and
+  // must not be modified in place
   std::unordered_map<folly::CIDRNetwork, PrefixEntries> const&
   prefixes() const {
     return prefixes_;
@@ -31,6 +36,46 @@ class PrefixState {
   // empty if node/area did not previosuly advertise
   std::unordered_set<folly::CIDRNetwork> deletePrefix(PrefixKey const& key);
 
+  // Advertisement (or withdrawal, without entry) of a per prefix key
+  struct PrefixUpdate {
+    PrefixKey key;
+    std::optional<thrift::PrefixEntry> entry;
+  };
+
+  // Apply updates of per prefix keys in bulk (e.g. all prefix keys of one
+  // publication) and insert changed prefixes into `changed`. Same as calling
+  // updatePrefix()/deletePrefix() in order, without allocating a change set
+  // per key.
+  void applyBatch(
+      std::vector<PrefixUpdate>&& updates,
+      std::unordered_set<folly::CIDRNetwork>& changed);
+
+  // returns set of changed prefixes. Replaces all prefixes previously carried
+  // by shard key with `entries`, i.e. prefixes no longer in the shard are
+  // withdrawn and only new or modified entries are reported as changed.
+  //
+  // ATTN: a prefix carried by both per prefix key and shard key of the same
+  // [node, area] (e.g. while node migrates between formats) is owned by the
+  // key updated last, and only withdrawn by its owner
+  std::unordered_set<folly::CIDRNetwork> updatePrefixShard(
+      PrefixShardKey const& key,
+      std::vector<thrift::PrefixEntry> const& entries);
+
+  // returns set of changed prefixes (i.e. prefixes carried by the shard)
+  std::unordered_set<folly::CIDRNetwork> deletePrefixShard(
+      PrefixShardKey const& key);
+
+  // returns set of prefixes currently advertised by [node, area]. Lets a
+  // topology change recompute only the prefixes of affected originators
+  std::unordered_set<folly::CIDRNetwork> const& getPrefixesFromNode(
+      NodeAndArea const& nodeAndArea) const;
+
+  // returns number of distinct entry objects backing `prefixes()`
+  size_t
+  getNumInternedEntries() const {
+    return internedEntries_.size();
+  }
+
   std::vector<thrift::ReceivedRouteDetail> getReceivedRoutesFiltered(
       thrift::ReceivedRouteFilter const& filter) const;
 
@@ -53,5 +98,55 @@ class PrefixState {
   // Data structure to maintain mapping from:
   //  IpPrefix -> collection of originator(i.e. [node, area] combination)
   std::unordered_map<folly::CIDRNetwork, PrefixEntries> prefixes_;
+
+  // Reverse index of `prefixes_`, mapping from:
+  //  originator(i.e. [node, area] combination) -> advertised IpPrefixes
+  std::unordered_map<NodeAndArea, std::unordered_set<folly::CIDRNetwork>>
+      nodeToPrefixes_;
+
+  // Add/remove entry of [node, area] for a prefix regardless of key format.
+  // Returns true if entry changed
+  bool addPrefixEntry(PrefixKey const& key, thrift::PrefixEntry entry);
+  bool removePrefixEntry(PrefixKey const& key);
+
+  // Entries with identical attributes (e.g. all loopbacks of a fabric, or
+  // anycast prefix advertised by many originators) share one immutable
+  // prefix-less object, refcounted by the number of [prefix, node, area]
+  // records pointing at it
+  std::shared_ptr<thrift::PrefixEntry> internEntry(thrift::PrefixEntry&& entry);
+  void releaseEntry(std::shared_ptr<thrift::PrefixEntry> const& entry);
+
+  struct PrefixEntryHash {
+    size_t operator()(thrift::PrefixEntry const& entry) const;
+  };
+
+  struct InternedEntry {
+    std::shared_ptr<thrift::PrefixEntry> entry;
+    size_t refCount{0};
+  };
+
+  // Keyed by content of the interned object itself, so lookups don't need
+  // to allocate
+  std::unordered_map<
+      std::reference_wrapper<thrift::PrefixEntry const>,
+      InternedEntry,
+      PrefixEntryHash,
+      std::equal_to<thrift::PrefixEntry>>
+      internedEntries_;
+
+  // Per prefix key takes over prefix from shard key of same originator
+  void releaseShardOwnership(PrefixKey const& key);
+  bool isOwnedByShard(PrefixKey const& key) const;
+
+  // Prefixes carried by every shard key
+  std::unordered_map<PrefixShardKey, std::unordered_set<folly::CIDRNetwork>>
+      shardToPrefixes_;
+
+  // Reverse index of `shardToPrefixes_`, mapping from:
+  //  originator(i.e. [node, area] combination) -> IpPrefix -> owning shard
+  std::unordered_map<
+      NodeAndArea,
+      std::unordered_map<folly::CIDRNetwork, uint32_t>>
+      prefixToShard_;
 };
 } // namespace openr
@@ -111,7 +111,11 @@ RibPolicyStatement::applyAction(RibUnicastEntry& route) const {
   if (not match(route)) {
     return false;
   }
+  return transform(route);
+}
 
+bool
+RibPolicyStatement::transform(RibUnicastEntry& route) const {
   // Assign RibPolicyStatement route counter ID to the route
   route.counterID = counterID_;
 
@@ -178,6 +182,35 @@ RibPolicy::RibPolicy(thrift::RibPolicy const& policy)
   for (auto const& statement : *policy.statements()) {
     policyStatements_.emplace_back(statement);
   }
+
+  // Compile match criteria of all statements
+  const auto numStatements = policyStatements_.size();
+  anyPrefixStatements_.resize(numStatements);
+  anyTagStatements_.resize(numStatements);
+  tagMatchStatements_.resize(numStatements);
+  for (size_t i = 0; i < numStatements; ++i) {
+    auto const& prefixSet = policyStatements_.at(i).getPrefixSet();
+    auto const& tagSet = policyStatements_.at(i).getTagSet();
+    if (prefixSet.empty() and tagSet.empty()) {
+      continue;
+    }
+    if (prefixSet.empty()) {
+      anyPrefixStatements_.set(i);
+    }
+    for (auto const& prefix : prefixSet) {
+      auto [it, _] = prefixToStatements_.try_emplace(prefix, numStatements);
+      it->second.set(i);
+    }
+    if (tagSet.empty()) {
+      anyTagStatements_.set(i);
+    } else {
+      tagMatchStatements_.set(i);
+    }
+    for (auto const& tag : tagSet) {
+      auto [it, _] = tagToStatements_.try_emplace(tag, numStatements);
+      it->second.set(i);
+    }
+  }
 }
 
 thrift::RibPolicy
@@ -208,20 +241,55 @@ RibPolicy::isActive() const {
   return getTtlDuration().count() > 0;
 }
 
-bool
-RibPolicy::match(const RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.match(route)) {
-      return true;
+void
+RibPolicy::getMatchingStatements(
+    const RibUnicastEntry& route,
+    StatementSet& matched,
+    StatementSet& scratch) const {
+  matched = anyPrefixStatements_;
+  auto prefixIt = prefixToStatements_.find(route.prefix);
+  if (prefixIt != prefixToStatements_.end()) {
+    matched |= prefixIt->second;
+  }
+
+  // Skip lookup of route tags if none of remaining statements match on tags
+  if (not matched.intersects(tagMatchStatements_)) {
+    return;
+  }
+  scratch = anyTagStatements_;
+  for (auto const& tag : *route.bestPrefixEntry.tags()) {
+    auto tagIt = tagToStatements_.find(tag);
+    if (tagIt != tagToStatements_.end()) {
+      scratch |= tagIt->second;
     }
   }
-  return false;
+  matched &= scratch;
+}
+
+bool
+RibPolicy::match(const RibUnicastEntry& route) const {
+  StatementSet matched, scratch;
+  getMatchingStatements(route, matched, scratch);
+  return matched.any();
 }
 
 bool
 RibPolicy::applyAction(RibUnicastEntry& route) const {
-  for (auto const& statement : policyStatements_) {
-    if (statement.applyAction(route)) {
+  StatementSet matched, scratch;
+  return applyAction(route, matched, scratch);
+}
+
+bool
+RibPolicy::applyAction(
+    RibUnicastEntry& route,
+    StatementSet& matched,
+    StatementSet& scratch) const {
+  getMatchingStatements(route, matched, scratch);
+
+  // Statements are applied in order until one transforms the route
+  for (auto i = matched.find_first(); i != StatementSet::npos;
+       i = matched.find_next(i)) {
+    if (policyStatements_.at(i).transform(route)) {
       return true;
     }
   }
@@ -235,9 +303,10 @@ RibPolicy::applyPolicy(std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>&
   if (not isActive()) {
     return change;
   }
+  StatementSet matched, scratch;
   auto iter = unicastEntries.begin();
   while (iter != unicastEntries.end()) {
-    if (applyAction(iter->second)) {
+    if (applyAction(iter->second, matched, scratch)) {
       DCHECK(iter->second.nexthops.size()) << "Unexpected empty next-hops";
       change.updatedRoutes.push_back(iter->second.prefix);
       XLOG(DBG2) << "RibPolicy transformed the route "
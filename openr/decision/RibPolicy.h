@@ -7,6 +7,8 @@
 
 #include <chrono>
 
+#include <boost/dynamic_bitset.hpp>
+
 #include <openr/common/NetworkUtil.h>
 #include <openr/decision/RibEntry.h>
 #include <openr/if/gen-cpp2/Network_types.h>
@@ -42,6 +44,23 @@ class RibPolicyStatement {
    */
   bool applyAction(RibUnicastEntry& route) const;
 
+  /**
+   * Transform route without checking match criteria.
+   *
+   * @returns boolean indicating if route is transformed or not.
+   */
+  bool transform(RibUnicastEntry& route) const;
+
+  std::unordered_set<folly::CIDRNetwork> const&
+  getPrefixSet() const {
+    return prefixSet_;
+  }
+
+  std::unordered_set<std::string> const&
+  getTagSet() const {
+    return tagSet_;
+  }
+
  private:
   const std::string name_;
 
@@ -114,9 +133,39 @@ class RibPolicy {
       const;
 
  private:
+  // Set of policy statements, indexed by position in `policyStatements_`
+  using StatementSet = boost::dynamic_bitset<uint64_t>;
+
+  /**
+   * Compute statements matching the route into `matched`. Route prefix and
+   * each of its tags are looked up once for all statements. `scratch` is
+   * passed in to reuse its storage across routes.
+   */
+  void getMatchingStatements(
+      const RibUnicastEntry& route,
+      StatementSet& matched,
+      StatementSet& scratch) const;
+
+  bool applyAction(
+      RibUnicastEntry& route,
+      StatementSet& matched,
+      StatementSet& scratch) const;
+
   // List of policy statements
   std::vector<RibPolicyStatement> policyStatements_;
 
+  // Match criteria of all statements compiled into statement sets. Statements
+  // without prefix (or tag) matcher match on any prefix (or tags), while
+  // statements with neither never match
+  // NOTE: Route tags are looked up by string, hashing each tag of a route once
+  // per policy application. They are carried as strings in thrift PrefixEntry
+  // hence aren't interned to integer ids.
+  std::unordered_map<folly::CIDRNetwork, StatementSet> prefixToStatements_;
+  std::unordered_map<std::string, StatementSet> tagToStatements_;
+  StatementSet anyPrefixStatements_;
+  StatementSet anyTagStatements_;
+  StatementSet tagMatchStatements_;
+
   // Validity
   const std::chrono::steady_clock::time_point validUntilTs_;
 };
@@ -6,6 +6,7 @@
  */
 
 #include <fb303/ServiceData.h>
+#include <folly/futures/Future.h>
 #include <folly/logging/xlog.h>
 
 #include <openr/common/LsdbUtil.h>
@@ -76,12 +77,18 @@ SpfSolver::SpfSolver(
     bool enableV4,
     bool enableNodeSegmentLabel,
     bool enableBestRouteSelection,
-    bool v4OverV6Nexthop)
+    bool v4OverV6Nexthop,
+    uint32_t numRouteBuildThreads)
     : myNodeName_(myNodeName),
       enableV4_(enableV4),
       enableNodeSegmentLabel_(enableNodeSegmentLabel),
       enableBestRouteSelection_(enableBestRouteSelection),
       v4OverV6Nexthop_(v4OverV6Nexthop) {
+  if (numRouteBuildThreads > 1) {
+    routeBuildExecutor_ =
+        std::make_unique<folly::CPUThreadPoolExecutor>(numRouteBuildThreads);
+  }
+
   // Initialize stat keys
   fb303::fbData->addStatExportType("decision.adj_db_update", fb303::COUNT);
   fb303::fbData->addStatExportType(
@@ -163,6 +170,27 @@ SpfSolver::createRouteForPrefix(
     std::unordered_map<std::string, LinkState> const& areaLinkStates,
     PrefixState const& prefixState,
     folly::CIDRNetwork const& prefix) {
+  std::optional<RouteSelectionResult> routeSelection;
+  auto maybeRoute = computeRouteForPrefix(
+      myNodeName, areaLinkStates, prefixState, prefix, routeSelection);
+
+  // Update best route selection in prefix state
+  if (routeSelection.has_value()) {
+    bestRoutesCache_.insert_or_assign(
+        prefix, std::move(routeSelection).value());
+  } else {
+    bestRoutesCache_.erase(prefix);
+  }
+  return maybeRoute;
+}
+
+std::optional<RibUnicastEntry>
+SpfSolver::computeRouteForPrefix(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    folly::CIDRNetwork const& prefix,
+    std::optional<RouteSelectionResult>& routeSelection) const {
   fb303::fbData->addStatValue("decision.get_route_for_prefix", 1, fb303::COUNT);
 
   // Sanity check for V4 prefixes
@@ -181,9 +209,6 @@ SpfSolver::createRouteForPrefix(
   }
   auto const& allPrefixEntries = search->second;
 
-  // Clear best route selection in prefix state
-  bestRoutesCache_.erase(prefix);
-
   //
   // Create list of prefix-entries from reachable nodes only
   // NOTE: We're copying prefix-entries and it can be expensive. Using
@@ -243,8 +268,8 @@ SpfSolver::createRouteForPrefix(
     return std::nullopt;
   }
 
-  // Set best route selection in prefix state
-  bestRoutesCache_.insert_or_assign(prefix, routeSelectionResult);
+  // Report best route selection for prefix state
+  routeSelection = routeSelectionResult;
 
   /*
    * ATTN:
@@ -332,10 +357,15 @@ SpfSolver::buildRouteDb(
   bestRoutesCache_.clear();
 
   // Create IPv4, IPv6 routes (includes IP -> MPLS routes)
-  for (const auto& [prefix, _] : prefixState.prefixes()) {
-    if (auto maybeRoute = createRouteForPrefix(
-            myNodeName, areaLinkStates, prefixState, prefix)) {
-      routeDb.addUnicastRoute(std::move(maybeRoute).value());
+  if (routeBuildExecutor_) {
+    buildUnicastRoutesParallel(
+        myNodeName, areaLinkStates, prefixState, routeDb);
+  } else {
+    for (const auto& [prefix, _] : prefixState.prefixes()) {
+      if (auto maybeRoute = createRouteForPrefix(
+              myNodeName, areaLinkStates, prefixState, prefix)) {
+        routeDb.addUnicastRoute(std::move(maybeRoute).value());
+      }
     }
   }
 
@@ -351,113 +381,206 @@ SpfSolver::buildRouteDb(
   //
   // Create MPLS routes for all nodeLabel
   //
-  if (enableNodeSegmentLabel_) {
-    std::unordered_map<int32_t, std::pair<std::string, RibMplsEntry>>
-        labelToNode;
-    for (const auto& [area, linkState] : areaLinkStates) {
-      for (const auto& [_, adjDb] : linkState.getAdjacencyDatabases()) {
-        const auto topLabel = *adjDb.nodeLabel();
-        const auto& nodeName = *adjDb.thisNodeName();
-        // Top label is not set => Non-SR mode
-        if (topLabel == 0) {
-          XLOG(INFO) << "Ignoring node label " << topLabel << " of node "
-                     << nodeName << " in area " << area;
-          fb303::fbData->addStatValue(
-              "decision.skipped_mpls_route", 1, fb303::COUNT);
-          continue;
-        }
-        // If mpls label is not valid then ignore it
-        if (not isMplsLabelValid(topLabel)) {
-          XLOG(ERR) << "Ignoring invalid node label " << topLabel << " of node "
-                    << nodeName << " in area " << area;
-          fb303::fbData->addStatValue(
-              "decision.skipped_mpls_route", 1, fb303::COUNT);
-          continue;
-        }
+  for (auto& [_, entry] : buildNodeLabelRoutes(myNodeName, areaLinkStates)) {
+    routeDb.addMplsRoute(std::move(entry));
+  }
 
-        // There can be a temporary collision in node label allocation.
-        // Usually happens when two segmented networks allocating labels from
-        // the same range join together. In case of such conflict we respect
-        // the node label of bigger node-ID
-        auto iter = labelToNode.find(topLabel);
-        if (iter != labelToNode.end()) {
-          XLOG(INFO) << "Found duplicate label " << topLabel << "from "
-                     << iter->second.first << " " << nodeName << " in area "
-                     << area;
-          fb303::fbData->addStatValue(
-              "decision.duplicate_node_label", 1, fb303::COUNT);
-          if (iter->second.first < nodeName) {
-            continue;
-          }
-        }
+  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  XLOG(INFO) << "Decision::buildRouteDb took " << deltaTime.count() << "ms.";
+  fb303::fbData->addStatValue(
+      "decision.route_build_ms", deltaTime.count(), fb303::AVG);
+  return routeDb;
+} // buildRouteDb
 
-        // Install POP_AND_LOOKUP for next layer
-        if (*adjDb.thisNodeName() == myNodeName) {
-          thrift::NextHopThrift nh;
-          nh.address() = toBinaryAddress(folly::IPAddressV6("::"));
-          nh.area() = area;
-          nh.mplsAction() =
-              createMplsAction(thrift::MplsActionCode::POP_AND_LOOKUP);
-          labelToNode.erase(topLabel);
-          labelToNode.emplace(
-              topLabel,
-              std::make_pair(myNodeName, RibMplsEntry(topLabel, {nh})));
-          continue;
-        }
+std::unordered_map<int32_t, RibMplsEntry>
+SpfSolver::buildNodeLabelRoutes(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+  std::unordered_map<int32_t, RibMplsEntry> mplsRoutes;
+  if (not enableNodeSegmentLabel_) {
+    return mplsRoutes;
+  }
+
+  std::unordered_map<int32_t, std::pair<std::string, RibMplsEntry>> labelToNode;
+  for (const auto& [area, linkState] : areaLinkStates) {
+    for (const auto& [_, adjDb] : linkState.getAdjacencyDatabases()) {
+      const auto topLabel = *adjDb.nodeLabel();
+      const auto& nodeName = *adjDb.thisNodeName();
+      // Top label is not set => Non-SR mode
+      if (topLabel == 0) {
+        XLOG(INFO) << "Ignoring node label " << topLabel << " of node "
+                   << nodeName << " in area " << area;
+        fb303::fbData->addStatValue(
+            "decision.skipped_mpls_route", 1, fb303::COUNT);
+        continue;
+      }
+      // If mpls label is not valid then ignore it
+      if (not isMplsLabelValid(topLabel)) {
+        XLOG(ERR) << "Ignoring invalid node label " << topLabel << " of node "
+                  << nodeName << " in area " << area;
+        fb303::fbData->addStatValue(
+            "decision.skipped_mpls_route", 1, fb303::COUNT);
+        continue;
+      }
 
-        // Get best nexthop towards the node
-        auto metricNhs = getNextHopsWithMetric(
-            myNodeName, {{adjDb.thisNodeName().value(), area}}, linkState);
-        if (metricNhs.second.empty()) {
-          XLOG(WARNING) << "No route to nodeLabel " << std::to_string(topLabel)
-                        << " of node " << nodeName;
-          fb303::fbData->addStatValue(
-              "decision.no_route_to_label", 1, fb303::COUNT);
+      // There can be a temporary collision in node label allocation.
+      // Usually happens when two segmented networks allocating labels from
+      // the same range join together. In case of such conflict we respect
+      // the node label of bigger node-ID
+      auto iter = labelToNode.find(topLabel);
+      if (iter != labelToNode.end()) {
+        XLOG(INFO) << "Found duplicate label " << topLabel << "from "
+                   << iter->second.first << " " << nodeName << " in area "
+                   << area;
+        fb303::fbData->addStatValue(
+            "decision.duplicate_node_label", 1, fb303::COUNT);
+        if (iter->second.first < nodeName) {
           continue;
         }
+      }
 
-        // Create nexthops with appropriate MplsAction (PHP and SWAP). Note
-        // that all nexthops are valid for routing without loops. Fib is
-        // responsible for installing these routes by making sure it programs
-        // least cost nexthops first and of same action type (based on HW
-        // limitations)
+      // Install POP_AND_LOOKUP for next layer
+      if (*adjDb.thisNodeName() == myNodeName) {
+        thrift::NextHopThrift nh;
+        nh.address() = toBinaryAddress(folly::IPAddressV6("::"));
+        nh.area() = area;
+        nh.mplsAction() =
+            createMplsAction(thrift::MplsActionCode::POP_AND_LOOKUP);
         labelToNode.erase(topLabel);
         labelToNode.emplace(
-            topLabel,
-            std::make_pair(
-                adjDb.thisNodeName().value(),
-                RibMplsEntry(
-                    topLabel,
-                    getNextHopsThrift(
-                        myNodeName,
-                        {{adjDb.thisNodeName().value(), area}},
-                        false /* isV4 */,
-                        metricNhs,
-                        topLabel,
-                        area,
-                        linkState))));
+            topLabel, std::make_pair(myNodeName, RibMplsEntry(topLabel, {nh})));
+        continue;
       }
-    }
 
-    for (auto& [_, nodeToEntry] : labelToNode) {
-      routeDb.addMplsRoute(std::move(nodeToEntry.second));
+      // Get best nexthop towards the node
+      auto metricNhs = getNextHopsWithMetric(
+          myNodeName, {{adjDb.thisNodeName().value(), area}}, linkState);
+      if (metricNhs.second.empty()) {
+        XLOG(WARNING) << "No route to nodeLabel " << std::to_string(topLabel)
+                      << " of node " << nodeName;
+        fb303::fbData->addStatValue(
+            "decision.no_route_to_label", 1, fb303::COUNT);
+        continue;
+      }
+
+      // Create nexthops with appropriate MplsAction (PHP and SWAP). Note
+      // that all nexthops are valid for routing without loops. Fib is
+      // responsible for installing these routes by making sure it programs
+      // least cost nexthops first and of same action type (based on HW
+      // limitations)
+      labelToNode.erase(topLabel);
+      labelToNode.emplace(
+          topLabel,
+          std::make_pair(
+              adjDb.thisNodeName().value(),
+              RibMplsEntry(
+                  topLabel,
+                  getNextHopsThrift(
+                      myNodeName,
+                      {{adjDb.thisNodeName().value(), area}},
+                      false /* isV4 */,
+                      metricNhs,
+                      topLabel,
+                      area,
+                      linkState))));
     }
   }
 
-  auto deltaTime = std::chrono::duration_cast<std::chrono::milliseconds>(
-      std::chrono::steady_clock::now() - startTime);
-  XLOG(INFO) << "Decision::buildRouteDb took " << deltaTime.count() << "ms.";
-  fb303::fbData->addStatValue(
-      "decision.route_build_ms", deltaTime.count(), fb303::AVG);
-  return routeDb;
-} // buildRouteDb
+  for (auto& [label, nodeToEntry] : labelToNode) {
+    mplsRoutes.emplace(label, std::move(nodeToEntry.second));
+  }
+  return mplsRoutes;
+}
+
+void
+SpfSolver::buildUnicastRoutesParallel(
+    const std::string& myNodeName,
+    std::unordered_map<std::string, LinkState> const& areaLinkStates,
+    PrefixState const& prefixState,
+    DecisionRouteDb& routeDb) {
+  CHECK(routeBuildExecutor_);
+
+  // Memoize SPF results of myNodeName in every area, one task per area. Each
+  // task writes the cache of its own LinkState only. Route computation only
+  // looks these up afterwards, which makes LinkStates safe to share across
+  // workers
+  std::vector<folly::Future<folly::Unit>> spfRuns;
+  for (auto const& [_, linkState] : areaLinkStates) {
+    spfRuns.emplace_back(
+        folly::via(routeBuildExecutor_.get(), [&linkState, &myNodeName]() {
+          linkState.getSpfResult(myNodeName);
+        }));
+  }
+  for (auto& spfRun : folly::collectAll(std::move(spfRuns)).get()) {
+    spfRun.throwUnlessValue();
+  }
+  for (auto const& [_, linkState] : areaLinkStates) {
+    DCHECK(linkState.hasSpfResult(myNodeName));
+  }
+
+  struct Shard {
+    std::vector<RibUnicastEntry> routes;
+    std::vector<std::pair<folly::CIDRNetwork, RouteSelectionResult>>
+        bestRoutes;
+  };
+
+  std::vector<folly::CIDRNetwork const*> prefixes;
+  prefixes.reserve(prefixState.prefixes().size());
+  for (auto const& [prefix, _] : prefixState.prefixes()) {
+    prefixes.emplace_back(&prefix);
+  }
+  const size_t numShards = std::max<size_t>(
+      1, std::min<size_t>(routeBuildExecutor_->numThreads(), prefixes.size()));
+  const size_t shardSize = (prefixes.size() + numShards - 1) / numShards;
+
+  auto buildShard = [&](size_t begin, size_t end) {
+    Shard shard;
+    for (auto i = begin; i < end; ++i) {
+      auto const& prefix = *prefixes.at(i);
+      std::optional<RouteSelectionResult> routeSelection;
+      if (auto maybeRoute = computeRouteForPrefix(
+              myNodeName,
+              areaLinkStates,
+              prefixState,
+              prefix,
+              routeSelection)) {
+        shard.routes.emplace_back(std::move(maybeRoute).value());
+      }
+      if (routeSelection.has_value()) {
+        shard.bestRoutes.emplace_back(
+            prefix, std::move(routeSelection).value());
+      }
+    }
+    return shard;
+  };
+
+  std::vector<folly::Future<Shard>> shardRuns;
+  for (size_t begin = 0; begin < prefixes.size(); begin += shardSize) {
+    const auto end = std::min(begin + shardSize, prefixes.size());
+    shardRuns.emplace_back(folly::via(
+        routeBuildExecutor_.get(),
+        [&buildShard, begin, end]() { return buildShard(begin, end); }));
+  }
+
+  // Merge shards in prefix order, bestRoutesCache_ got cleared by caller
+  for (auto& shardRun : folly::collectAll(std::move(shardRuns)).get()) {
+    auto& shard = shardRun.value();
+    for (auto& route : shard.routes) {
+      routeDb.addUnicastRoute(std::move(route));
+    }
+    for (auto& [prefix, routeSelection] : shard.bestRoutes) {
+      bestRoutesCache_.insert_or_assign(prefix, std::move(routeSelection));
+    }
+  }
+}
 
 RouteSelectionResult
 SpfSolver::selectBestRoutes(
     std::string const& myNodeName,
     folly::CIDRNetwork const& prefix,
     PrefixEntries& prefixEntries,
-    std::unordered_map<std::string, LinkState> const& areaLinkStates) {
+    std::unordered_map<std::string, LinkState> const& areaLinkStates) const {
   CHECK(prefixEntries.size()) << "No prefixes for best route selection";
   RouteSelectionResult ret;
 
@@ -495,7 +618,7 @@ SpfSolver::selectBestRoutes(
 
 std::optional<int64_t>
 SpfSolver::getMinNextHopThreshold(
-    RouteSelectionResult nodes, PrefixEntries const& prefixEntries) {
+    RouteSelectionResult nodes, PrefixEntries const& prefixEntries) const {
   std::optional<int64_t> maxMinNexthopForPrefix = std::nullopt;
   for (const auto& nodeArea : nodes.allNodeAreas) {
     const auto& prefixEntry = prefixEntries.at(nodeArea);
@@ -556,7 +679,7 @@ SpfSolver::selectBestPathsSpf(
     folly::CIDRNetwork const& prefix,
     RouteSelectionResult const& routeSelectionResult,
     const std::string& area,
-    const LinkState& linkState) {
+    const LinkState& linkState) const {
   /*
    * [Next hop Calculation]
    *
@@ -600,7 +723,7 @@ SpfSolver::addBestPaths(
     const PrefixEntries& prefixEntries,
     std::unordered_set<thrift::NextHopThrift>&& nextHops,
     const Metric shortestMetric,
-    const bool localPrefixConsidered) {
+    const bool localPrefixConsidered) const {
   // Check if next-hop list is empty
   if (nextHops.empty()) {
     return std::nullopt;
@@ -621,7 +744,9 @@ SpfSolver::addBestPaths(
   auto entry =
       *(prefixEntries.at(routeSelectionResult.bestNodeArea)); // copy intended
   // We don't modify original prefixEntries (referenced from prefixState)
-  // because they reflect the prefix entries we received from others.
+  // because they reflect the prefix entries we received from others. They
+  // are stored without prefix.
+  entry.prefix() = toIpPrefix(prefix);
   if (routeSelectionResult.isBestNodeDrained) {
     *entry.metrics()->drain_metric() = 1;
   }
@@ -649,7 +774,7 @@ BestNextHopMetrics
 SpfSolver::getNextHopsWithMetric(
     const std::string& myNodeName,
     const std::set<NodeAndArea>& dstNodeAreas,
-    const LinkState& linkState) {
+    const LinkState& linkState) const {
   // build up next hop nodes that are along a shortest path to the prefix
   std::unordered_map<
       std::string /* nextHopNodeName */,
@@ -12,6 +12,8 @@
 #include <unordered_map>
 #include <unordered_set>
 
+#include <folly/executors/CPUThreadPoolExecutor.h>
+
 #include <openr/decision/LinkState.h>
 #include <openr/decision/PrefixState.h>
 #include <openr/decision/RibEntry.h>
@@ -118,7 +120,8 @@ class SpfSolver {
       bool enableV4,
       bool enableNodeSegmentLabel,
       bool enableBestRouteSelection = false,
-      bool v4OverV6Nexthop = false);
+      bool v4OverV6Nexthop = false,
+      uint32_t numRouteBuildThreads = 1);
   ~SpfSolver();
 
   //
@@ -138,6 +141,12 @@ class SpfSolver {
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
       PrefixState const& prefixState);
 
+  // Build MPLS routes towards node labels of every node in every area. Empty
+  // if node segment labels are disabled
+  std::unordered_map<int32_t, RibMplsEntry> buildNodeLabelRoutes(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+
   std::optional<RibUnicastEntry> createRouteForPrefixOrGetStaticRoute(
       const std::string& myNodeName,
       std::unordered_map<std::string, LinkState> const& areaLinkStates,
@@ -181,7 +190,7 @@ class SpfSolver {
       std::string const& myNodeName,
       folly::CIDRNetwork const& prefix,
       PrefixEntries& prefixEntries,
-      std::unordered_map<std::string, LinkState> const& areaLinkStates);
+      std::unordered_map<std::string, LinkState> const& areaLinkStates) const;
 
   /*
    * [Route Calculation]: shortest path forwarding
@@ -195,7 +204,7 @@ class SpfSolver {
       folly::CIDRNetwork const& prefix,
       RouteSelectionResult const& routeSelectionResult,
       const std::string& area,
-      const LinkState& linkState);
+      const LinkState& linkState) const;
 
   std::optional<RibUnicastEntry> addBestPaths(
       const std::string& myNodeName,
@@ -204,7 +213,7 @@ class SpfSolver {
       const PrefixEntries& prefixEntries,
       std::unordered_set<thrift::NextHopThrift>&& nextHops,
       const openr::LinkStateMetric shortestMetric,
-      const bool localPrefixConsidered);
+      const bool localPrefixConsidered) const;
 
   std::optional<RibUnicastEntry> createRouteForPrefix(
       const std::string& myNodeName,
@@ -212,9 +221,39 @@ class SpfSolver {
       PrefixState const& prefixState,
       folly::CIDRNetwork const& prefix);
 
+  /*
+   * Route computation for a single prefix without touching bestRoutesCache_.
+   * `routeSelection` is set if best route selection took place.
+   *
+   * Doesn't modify any SpfSolver state, hence can run concurrently for
+   * different prefixes as long as SPF results of myNodeName are memoized in
+   * every area beforehand.
+   */
+  std::optional<RibUnicastEntry> computeRouteForPrefix(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      folly::CIDRNetwork const& prefix,
+      std::optional<RouteSelectionResult>& routeSelection) const;
+
+  /*
+   * [Parallel Route Build]
+   *
+   * Build unicast routes of all prefixes using routeBuildExecutor_:
+   *  - SPF of myNodeName is run concurrently for all areas;
+   *  - prefixes are partitioned into contiguous shards, one task per shard;
+   *  - shards are merged in order, so the resulting routeDb and
+   *    bestRoutesCache_ are identical to a serial build.
+   */
+  void buildUnicastRoutesParallel(
+      const std::string& myNodeName,
+      std::unordered_map<std::string, LinkState> const& areaLinkStates,
+      PrefixState const& prefixState,
+      DecisionRouteDb& routeDb);
+
   // helper to get min nexthop for a prefix, used in selectKsp2
   std::optional<int64_t> getMinNextHopThreshold(
-      RouteSelectionResult nodes, PrefixEntries const& prefixEntries);
+      RouteSelectionResult nodes, PrefixEntries const& prefixEntries) const;
 
   // [hard-drain]
   PrefixEntries filterHardDrainedNodes(
@@ -235,7 +274,7 @@ class SpfSolver {
   BestNextHopMetrics getNextHopsWithMetric(
       const std::string& srcNodeName,
       const std::set<NodeAndArea>& dstNodeAreas,
-      const LinkState& linkState);
+      const LinkState& linkState) const;
 
   // This function converts best nexthop nodes to best nexthop adjacencies
   // which can then be passed to FIB for programming. It considers and
@@ -274,5 +313,9 @@ class SpfSolver {
   // prefixes with v6 nexthops to Fib module for programming. Else it will just
   // use v4 over v4 nexthop.
   const bool v4OverV6Nexthop_{false};
+
+  // Worker pool for parallel route build. Only created if more than one
+  // route build thread is configured
+  std::unique_ptr<folly::CPUThreadPoolExecutor> routeBuildExecutor_;
 };
 } // namespace openr
@@ -46,6 +46,116 @@ BENCHMARK_COUNTERS_PARAM(BM_DecisionGridAdjUpdates, counters, 1000, SP_ECMP, 1);
 BENCHMARK_COUNTERS_PARAM(
     BM_DecisionGridAdjUpdates, counters, 10000, SP_ECMP, 1);
 
+/*
+ * BM_DecisionGridLinkMetricUpdates:
+ * @first param - integer: num of nodes in a grid topology
+ * @second param - bool: whether incremental SPF is enabled
+ *
+ * Measures performance of processing link metric changes for a grid topology
+ * with full SPF recomputation vs. incremental SPF.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates, counters, 100_FULL_SPF, 100, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates, counters, 100_INCREMENTAL_SPF, 100, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates, counters, 1000_FULL_SPF, 1000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates,
+    counters,
+    1000_INCREMENTAL_SPF,
+    1000,
+    true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates, counters, 10000_FULL_SPF, 10000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridLinkMetricUpdates,
+    counters,
+    10000_INCREMENTAL_SPF,
+    10000,
+    true);
+
+/*
+ * BM_DecisionGridParallelRouteBuild:
+ * @first param - integer: num of nodes in a grid topology
+ * @second param - integer: num of prefixes per node
+ * @third param - integer: num of route build threads
+ *
+ * Measures performance of full route build of 100k prefixes with serial
+ * vs. parallel route build.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridParallelRouteBuild, counters, 100_1000_1, 100, 1000, 1);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridParallelRouteBuild, counters, 100_1000_4, 100, 1000, 4);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionGridParallelRouteBuild, counters, 100_1000_16, 100, 1000, 16);
+
+/*
+ * BM_LinkStateGridSpf:
+ * @first param - integer: num of nodes in a grid topology
+ * @second param - SpfQueueType: priority queue used by SPF
+ *
+ * Measures performance of a single SPF run over a grid topology with RTT based
+ * link metrics, using the indexed d-ary heap vs. the radix heap.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridSpf, counters, 1000_DARY_HEAP, 1000, DARY_HEAP);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridSpf, counters, 1000_RADIX_HEAP, 1000, RADIX_HEAP);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridSpf, counters, 10000_DARY_HEAP, 10000, DARY_HEAP);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_LinkStateGridSpf, counters, 10000_RADIX_HEAP, 10000, RADIX_HEAP);
+
+/*
+ * BM_PrefixStateGridIngestion:
+ * @first param - integer: num of nodes in a grid topology
+ * @second param - integer: num of prefixes per node
+ * @third param - bool: whether prefix keys are applied in one batch
+ *
+ * Measures time for PrefixState to absorb a full initial dump of per prefix
+ * keys, applied key by key vs. in a single batch.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateGridIngestion, counters, 100_1000_PER_KEY, 100, 1000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateGridIngestion, counters, 100_1000_BATCH, 100, 1000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateGridIngestion, counters, 100_5000_PER_KEY, 100, 5000, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateGridIngestion, counters, 100_5000_BATCH, 100, 5000, true);
+
+/*
+ * BM_PrefixStateMemory:
+ * @first param - integer: num of nodes advertising prefixes
+ * @second param - integer: num of prefixes per node
+ * @third param - bool: all nodes advertise same (anycast) prefixes, or
+ *                      unique ones
+ *
+ * Measures time and RSS growth of PrefixState holding 1M prefix entries
+ * sharing the same attributes.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateMemory, counters, 1000_1000_ANYCAST, 1000, 1000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateMemory, counters, 100_10000_ANYCAST, 100, 10000, true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_PrefixStateMemory, counters, 1000_1000, 1000, 1000, false);
+
+/*
+ * BM_RibPolicyApplyPolicy:
+ * @first param - integer: num of routes
+ * @second param - integer: num of policy statements
+ *
+ * Measures performance of applying RibPolicy over full route db, i.e. policy
+ * processing on every full route rebuild.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_RibPolicyApplyPolicy, counters, 100000_10, 100000, 10);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_RibPolicyApplyPolicy, counters, 100000_100, 100000, 100);
+
 /*
  * BM_DecisionGridPrefixUpdates:
  * @first param - integer: num of nodes in a grid topology
@@ -381,6 +491,34 @@ BENCHMARK_COUNTERS_PARAM3(
     100,
     100,
     SP_ECMP);
+
+/*
+ * BM_DecisionFabricLinkMetricUpdates:
+ * @first param - integer: num of pods in a fabric topology
+ * @second param - integer: num of planes in a fabric topology
+ * @third param - bool: whether incremental SPF is enabled
+ *
+ * Measures performance of processing rsw uplink metric changes for a fabric
+ * topology with full SPF recomputation vs. incremental SPF.
+ */
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionFabricLinkMetricUpdates, counters, 1_8_FULL_SPF, 1, 8, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionFabricLinkMetricUpdates,
+    counters,
+    1_8_INCREMENTAL_SPF,
+    1,
+    8,
+    true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionFabricLinkMetricUpdates, counters, 10_8_FULL_SPF, 10, 8, false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_DecisionFabricLinkMetricUpdates,
+    counters,
+    10_8_INCREMENTAL_SPF,
+    10,
+    8,
+    true);
 } // namespace openr
 
 int
@@ -2082,16 +2082,106 @@ TEST_F(DecisionTestFixture, NoSpfOnDuplicatePublication) {
   counters = fb303::fbData->getCounters();
   EXPECT_EQ(1, counters["decision.spf_runs.count"]);
 
+  const auto skipped = counters["decision.skipped_deserializations.sum"];
+
   // Send same publication again to Decision using pub socket
   sendKvPublication(publication);
 
+  // Re-flood same prefix values with higher version
+  sendKvPublication(createThriftPublication(
+      {createPrefixKeyValue("1", 2, addr1),
+       createPrefixKeyValue("2", 2, addr2)},
+      {},
+      {},
+      {}));
+
   // wait for SPF to finish
   /* sleep override */
   std::this_thread::sleep_for(3 * debounceTimeoutMax);
 
-  // make sure counter is not incremented
+  // make sure counter is not incremented, and unchanged prefix values are not
+  // even deserialized
   counters = fb303::fbData->getCounters();
   EXPECT_EQ(1, counters["decision.spf_runs.count"]);
+  EXPECT_LE(skipped + 4, counters["decision.skipped_deserializations.sum"]);
+
+  // Fingerprint of expired key is dropped, hence same value advertised again
+  // is applied
+  const auto prefixKeyValue2 = createPrefixKeyValue("2", 2, addr2);
+  sendKvPublication(
+      createThriftPublication({}, {prefixKeyValue2.first}, {}, {}));
+  auto routeDbDelta = recvRouteUpdates();
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToDelete.size());
+  EXPECT_EQ(addr2Cidr, routeDbDelta.unicastRoutesToDelete.front());
+
+  sendKvPublication(createThriftPublication({prefixKeyValue2}, {}, {}, {}));
+  routeDbDelta = recvRouteUpdates();
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(addr2Cidr, routeDbDelta.unicastRoutesToUpdate.begin()->first);
+}
+
+//
+// Per prefix key and shard key of same originator in one publication are
+// applied in publication order, and the one applied last owns the prefix.
+//
+TEST_F(DecisionTestFixture, PrefixShardKeyPublicationOrder) {
+  const auto shardKey =
+      PrefixShardKey("2", 0, kTestingAreaName).getPrefixShardKey();
+
+  // Per prefix key sorts ahead of shard key of same originator, hence shard
+  // key takes over addr2
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue(serializer, "1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue(serializer, "2", 1, {adj21}, false, 2)},
+       createPrefixKeyValue("2", 1, addr2),
+       {shardKey, createPrefixValue("2", 1, {addr2, addr3})}},
+      {},
+      {},
+      {}));
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(2, routeDbDelta.unicastRoutesToUpdate.size());
+
+  // Shard withdraws addr2. Per prefix key no longer holds it.
+  sendKvPublication(createThriftPublication(
+      {{shardKey, createPrefixValue("2", 2, {addr3})}}, {}, {}, {}));
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(0, routeDbDelta.unicastRoutesToUpdate.size());
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToDelete.size());
+  EXPECT_EQ(addr2Cidr, routeDbDelta.unicastRoutesToDelete.front());
+}
+
+/**
+ * Neighbor republishing its adjacencies without changing SPF result of the
+ * neighbor itself (e.g. link to a remote node comes up) must not trigger a
+ * full route rebuild.
+ *
+ *  node1 --- node2 --- node4
+ */
+TEST_F(DecisionTestFixture, NoFullRebuildOnNeighborRepublish) {
+  sendKvPublication(createThriftPublication(
+      {{"adj:1", createAdjValue(serializer, "1", 1, {adj12}, false, 1)},
+       {"adj:2", createAdjValue(serializer, "2", 1, {adj21}, false, 2)},
+       createPrefixKeyValue("1", 1, addr1),
+       createPrefixKeyValue("2", 1, addr2)},
+      {},
+      {},
+      {}));
+  auto routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+
+  sendKvPublication(createThriftPublication(
+      {{"adj:2", createAdjValue(serializer, "2", 2, {adj21, adj24}, false, 2)},
+       {"adj:4", createAdjValue(serializer, "4", 1, {adj42}, false, 4)},
+       createPrefixKeyValue("4", 1, addr4)},
+      {},
+      {},
+      {}));
+  routeDbDelta = recvRouteUpdates();
+  EXPECT_EQ(DecisionRouteUpdate::INCREMENTAL, routeDbDelta.type);
+  ASSERT_EQ(1, routeDbDelta.unicastRoutesToUpdate.size());
+  EXPECT_EQ(
+      toIPNetwork(addr4),
+      routeDbDelta.unicastRoutesToUpdate.begin()->second.prefix);
 }
 
 /**
@@ -3007,10 +3097,12 @@ TEST(DecisionPendingUpdates, needsFullRebuild) {
   LinkState::LinkStateChange linkStateChange;
 
   linkStateChange.linkAttributesChanged = true;
-  updates.applyLinkStateChange("node2", linkStateChange, kEmptyPerfEventRef);
+  updates.applyLinkStateChange(
+      "node2", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
   EXPECT_FALSE(updates.needsRouteUpdate());
   EXPECT_FALSE(updates.needsFullRebuild());
-  updates.applyLinkStateChange("node1", linkStateChange, kEmptyPerfEventRef);
+  updates.applyLinkStateChange(
+      "node1", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
   EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_TRUE(updates.needsFullRebuild());
 
@@ -3019,14 +3111,34 @@ TEST(DecisionPendingUpdates, needsFullRebuild) {
   EXPECT_FALSE(updates.needsFullRebuild());
   linkStateChange.linkAttributesChanged = false;
   linkStateChange.topologyChanged = true;
-  updates.applyLinkStateChange("node2", linkStateChange, kEmptyPerfEventRef);
+  // remote topology change only marks the originator as updated
+  updates.applyLinkStateChange(
+      "node2", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
+  EXPECT_TRUE(updates.needsRouteUpdate());
+  EXPECT_FALSE(updates.needsFullRebuild());
+  EXPECT_THAT(
+      updates.updatedNodes().at(kTestingAreaName),
+      testing::UnorderedElementsAre("node2"));
+  // topology change on local links
+  linkStateChange.localLinksChanged = true;
+  updates.applyLinkStateChange(
+      "node3", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
+  EXPECT_TRUE(updates.needsRouteUpdate());
+  EXPECT_TRUE(updates.needsFullRebuild());
+
+  updates.reset();
+  EXPECT_TRUE(updates.updatedNodes().empty());
+  linkStateChange.localLinksChanged = false;
+  updates.applyLinkStateChange(
+      "node1", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
   EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_TRUE(updates.needsFullRebuild());
 
   updates.reset();
   linkStateChange.topologyChanged = false;
   linkStateChange.nodeLabelChanged = true;
-  updates.applyLinkStateChange("node2", linkStateChange, kEmptyPerfEventRef);
+  updates.applyLinkStateChange(
+      "node2", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
   EXPECT_TRUE(updates.needsRouteUpdate());
   EXPECT_TRUE(updates.needsFullRebuild());
 }
@@ -3064,6 +3176,43 @@ TEST(DecisionPendingUpdates, updatedPrefixes) {
   EXPECT_TRUE(updates.updatedPrefixes().empty());
 }
 
+TEST(DecisionPendingUpdates, prefixStateBatch) {
+  openr::detail::DecisionPendingUpdates updates("node1");
+  PrefixState prefixState;
+
+  // empty batch no change
+  updates.applyPrefixStateBatch(prefixState, {}, {});
+  EXPECT_FALSE(updates.needsRouteUpdate());
+  EXPECT_TRUE(updates.updatedPrefixes().empty());
+
+  const auto entry1 = createPrefixEntry(addr1);
+  const auto entry2 = createPrefixEntry(addr2V4);
+  std::vector<PrefixState::PrefixUpdate> batch;
+  batch.emplace_back(PrefixState::PrefixUpdate{
+      PrefixKey("node2", addr1Cidr, kTestingAreaName), entry1});
+  batch.emplace_back(PrefixState::PrefixUpdate{
+      PrefixKey("node2", addr2V4Cidr, kTestingAreaName), entry2});
+  batch.emplace_back(PrefixState::PrefixUpdate{
+      PrefixKey("node3", addr1Cidr, kTestingAreaName), entry1});
+  updates.applyPrefixStateBatch(prefixState, std::move(batch), {});
+  EXPECT_TRUE(updates.needsRouteUpdate());
+  EXPECT_FALSE(updates.needsFullRebuild());
+  EXPECT_THAT(
+      updates.updatedPrefixes(),
+      testing::UnorderedElementsAre(addr1Cidr, addr2V4Cidr));
+  EXPECT_EQ(2, prefixState.prefixes().at(addr1Cidr).size());
+
+  // withdrawal is reported as well
+  updates.reset();
+  batch.clear();
+  batch.emplace_back(PrefixState::PrefixUpdate{
+      PrefixKey("node2", addr2V4Cidr, kTestingAreaName), std::nullopt});
+  updates.applyPrefixStateBatch(prefixState, std::move(batch), {});
+  EXPECT_THAT(
+      updates.updatedPrefixes(), testing::UnorderedElementsAre(addr2V4Cidr));
+  EXPECT_EQ(0, prefixState.prefixes().count(addr2V4Cidr));
+}
+
 /*
  * @brief  Verify that we report counters of link event propagation time
  *         correctly. Verification at the unit of updateAdjacencyDatabase
@@ -3282,7 +3431,8 @@ TEST_F(DecisionTestFixture, TestLinkPropagationWithFirstPubCall) {
 TEST(DecisionPendingUpdates, perfEvents) {
   openr::detail::DecisionPendingUpdates updates("node1");
   LinkState::LinkStateChange linkStateChange;
-  updates.applyLinkStateChange("node2", linkStateChange, kEmptyPerfEventRef);
+  updates.applyLinkStateChange(
+      "node2", kTestingAreaName, linkStateChange, kEmptyPerfEventRef);
   EXPECT_THAT(*updates.perfEvents()->events(), testing::SizeIs(1));
   EXPECT_EQ(
       *updates.perfEvents()->events()->front().eventDescr(),
@@ -305,6 +305,303 @@ TEST(LinkStateTest, getKthPaths) {
   }
 }
 
+namespace {
+
+void
+expectSameSpfResult(
+    openr::LinkState::SpfResult const& expected,
+    openr::LinkState::SpfResult const& actual) {
+  EXPECT_EQ(expected.size(), actual.size());
+  for (auto const& [nodeName, nodeResult] : expected) {
+    auto it = actual.find(nodeName);
+    ASSERT_NE(it, actual.end()) << nodeName;
+    EXPECT_EQ(nodeResult.metric(), it->second.metric()) << nodeName;
+    EXPECT_EQ(nodeResult.nextHops(), it->second.nextHops()) << nodeName;
+    EXPECT_EQ(nodeResult.pathLinks().size(), it->second.pathLinks().size())
+        << nodeName;
+  }
+}
+
+} // namespace
+
+TEST(LinkStateTest, IncrementalSpf) {
+  //      1
+  //   1------2
+  //   | \    |
+  //  1|  \3  |1
+  //   |   \  |
+  //   4------3
+  //      1
+  auto makeAdj = [](int other, int self, int metric) {
+    return openr::createAdjacency(
+        fmt::format("{}", other),
+        fmt::format("{}/{}", self, other),
+        fmt::format("{}/{}", other, self),
+        fmt::format("fe80::{}", other),
+        fmt::format("10.0.0.{}", other),
+        metric,
+        0);
+  };
+  std::unordered_map<int, std::unordered_map<int, int>> topo{
+      {1, {{2, 1}, {3, 3}, {4, 1}}},
+      {2, {{1, 1}, {3, 1}}},
+      {3, {{1, 3}, {2, 1}, {4, 1}}},
+      {4, {{1, 1}, {3, 1}}},
+  };
+  auto makeAdjDb = [&](int node) {
+    std::vector<openr::thrift::Adjacency> adjs;
+    for (auto const& [other, metric] : topo.at(node)) {
+      adjs.emplace_back(makeAdj(other, node, metric));
+    }
+    return openr::createAdjDb(fmt::format("{}", node), adjs, node);
+  };
+
+  openr::LinkState fullState{kTestingAreaName, "1"};
+  openr::LinkState incState{kTestingAreaName, "1", true};
+  auto updateNode = [&](int node) {
+    EXPECT_EQ(
+        fullState.updateAdjacencyDatabase(makeAdjDb(node), kTestingAreaName),
+        incState.updateAdjacencyDatabase(makeAdjDb(node), kTestingAreaName));
+  };
+  auto verify = [&]() {
+    for (auto const& src : {"1", "2", "3", "4"}) {
+      for (bool useLinkMetric : {true, false}) {
+        expectSameSpfResult(
+            fullState.getSpfResult(src, useLinkMetric),
+            incState.getSpfResult(src, useLinkMetric));
+      }
+    }
+  };
+
+  for (int node : {1, 2, 3, 4}) {
+    updateNode(node);
+  }
+  // memoize SPF results before any topology change
+  verify();
+
+  // metric increase on link in use: 1 -> 2 -> 3 is no longer equal cost to
+  // 1 -> 4 -> 3
+  EXPECT_EQ(2, incState.getSpfResult("1").at("3").nextHops().size());
+  topo[1][2] = 2;
+  updateNode(1);
+  verify();
+  EXPECT_THAT(
+      incState.getSpfResult("1").at("3").nextHops(), UnorderedElementsAre("4"));
+
+  // metric decrease on link not in use
+  topo[1][3] = 1;
+  topo[3][1] = 1;
+  updateNode(1);
+  updateNode(3);
+  verify();
+  EXPECT_EQ(1, incState.getSpfResult("1").at("3").metric());
+
+  // link down and back up
+  topo[2].erase(3);
+  updateNode(2);
+  verify();
+  topo[2][3] = 1;
+  updateNode(2);
+  verify();
+
+  // node hard-drain falls back to full SPF
+  auto adjDb3 = makeAdjDb(3);
+  adjDb3.isOverloaded() = true;
+  fullState.updateAdjacencyDatabase(adjDb3, kTestingAreaName);
+  incState.updateAdjacencyDatabase(adjDb3, kTestingAreaName);
+  verify();
+
+  // node removal
+  fullState.deleteAdjacencyDatabase("4");
+  incState.deleteAdjacencyDatabase("4");
+  verify();
+  EXPECT_EQ(0, incState.getSpfResult("1").count("4"));
+}
+
+TEST(LinkStateTest, SpfQueues) {
+  // Dijkstra like usage: metrics pushed are never lower than last popped one,
+  // queued ids may get their metric decreased
+  openr::IndexedDaryHeap<> daryHeap;
+  openr::RadixHeap radixHeap;
+  std::vector<openr::LinkStateMetric> metrics{7, 1000000, 42, 42, 3};
+  for (uint32_t id = 0; id < metrics.size(); ++id) {
+    daryHeap.push(id, metrics.at(id));
+    radixHeap.push(id, metrics.at(id));
+  }
+  // decrease-key; radix heap keeps the stale entry
+  metrics.at(1) = 5;
+  daryHeap.push(1, 5);
+  radixHeap.push(1, 5);
+  // higher metric for a queued id is ignored by the d-ary heap
+  daryHeap.push(0, 100);
+
+  std::vector<std::pair<openr::LinkStateMetric, uint32_t>> expected{
+      {3, 4}, {5, 1}, {7, 0}, {42, 2}, {42, 3}};
+  std::vector<std::pair<openr::LinkStateMetric, uint32_t>> daryOrder;
+  while (not daryHeap.empty()) {
+    daryOrder.emplace_back(daryHeap.pop());
+  }
+  EXPECT_EQ(expected, daryOrder);
+
+  std::vector<std::pair<openr::LinkStateMetric, uint32_t>> radixOrder;
+  while (not radixHeap.empty()) {
+    auto entry = radixHeap.pop();
+    if (entry.first == metrics.at(entry.second)) {
+      radixOrder.emplace_back(entry);
+    }
+  }
+  std::sort(radixOrder.begin(), radixOrder.end());
+  EXPECT_EQ(expected, radixOrder);
+
+  // Both queues yield the same SPF results
+  //      10
+  //   1------2
+  //   |      |
+  //  1|      |1
+  //   |      |
+  //   4------3
+  //      1
+  auto makeAdjDb = [](int node, std::vector<std::pair<int, int>> neighbors) {
+    std::vector<openr::thrift::Adjacency> adjs;
+    for (auto const& [other, metric] : neighbors) {
+      adjs.emplace_back(openr::createAdjacency(
+          fmt::format("{}", other),
+          fmt::format("{}/{}", node, other),
+          fmt::format("{}/{}", other, node),
+          fmt::format("fe80::{}", other),
+          fmt::format("10.0.0.{}", other),
+          metric,
+          0));
+    }
+    return openr::createAdjDb(fmt::format("{}", node), adjs, node);
+  };
+  std::vector<openr::thrift::AdjacencyDatabase> adjDbs{
+      makeAdjDb(1, {{2, 10}, {4, 1}}),
+      makeAdjDb(2, {{1, 10}, {3, 1}}),
+      makeAdjDb(3, {{2, 1}, {4, 1}}),
+      makeAdjDb(4, {{1, 1}, {3, 1}}),
+  };
+
+  openr::LinkState daryState{
+      kTestingAreaName, "1", false, openr::thrift::SpfQueueType::DARY_HEAP};
+  openr::LinkState radixState{
+      kTestingAreaName, "1", false, openr::thrift::SpfQueueType::RADIX_HEAP};
+  for (auto const& adjDb : adjDbs) {
+    daryState.updateAdjacencyDatabase(adjDb, kTestingAreaName);
+    radixState.updateAdjacencyDatabase(adjDb, kTestingAreaName);
+  }
+  for (auto const& src : {"1", "2", "3", "4"}) {
+    expectSameSpfResult(
+        daryState.getSpfResult(src), radixState.getSpfResult(src));
+  }
+  // 2 is first reached over the direct link, then through 4 and 3
+  EXPECT_EQ(3, radixState.getSpfResult("1").at("2").metric());
+  EXPECT_THAT(
+      radixState.getSpfResult("1").at("2").nextHops(),
+      UnorderedElementsAre("4"));
+}
+
+TEST(LinkStateTest, SpfChangedNodes) {
+  //      1
+  //   1------2
+  //   |      |
+  //  1|      |1
+  //   |      |
+  //   4------3
+  //      1
+  std::unordered_map<int, std::unordered_map<int, int>> topo{
+      {1, {{2, 1}, {4, 1}}},
+      {2, {{1, 1}, {3, 1}}},
+      {3, {{2, 1}, {4, 1}}},
+      {4, {{1, 1}, {3, 1}}},
+  };
+  auto makeAdjDb = [&](int node) {
+    std::vector<openr::thrift::Adjacency> adjs;
+    for (auto const& [other, metric] : topo.at(node)) {
+      adjs.emplace_back(openr::createAdjacency(
+          fmt::format("{}", other),
+          fmt::format("{}/{}", node, other),
+          fmt::format("{}/{}", other, node),
+          fmt::format("fe80::{}", other),
+          fmt::format("10.0.0.{}", other),
+          metric,
+          0));
+    }
+    return openr::createAdjDb(fmt::format("{}", node), adjs, node);
+  };
+
+  openr::LinkState state{kTestingAreaName, "1"};
+  for (int node : {1, 2, 3, 4}) {
+    state.updateAdjacencyDatabase(makeAdjDb(node), kTestingAreaName);
+  }
+  EXPECT_FALSE(state.hasSpfResult("1"));
+  // every node is reported once, then nothing until SPF changes
+  EXPECT_THAT(
+      state.getSpfChangedNodes("1"), UnorderedElementsAre("1", "2", "3", "4"));
+  EXPECT_TRUE(state.hasSpfResult("1"));
+  EXPECT_FALSE(state.hasSpfResult("1", false /* useLinkMetric */));
+  EXPECT_THAT(state.getSpfChangedNodes("1"), testing::IsEmpty());
+
+  // remote metric change: only 3 loses the nexthop through 2
+  topo[2][3] = 5;
+  auto change = state.updateAdjacencyDatabase(makeAdjDb(2), kTestingAreaName);
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_FALSE(change.localLinksChanged);
+  EXPECT_THAT(state.getSpfChangedNodes("1"), UnorderedElementsAre("3"));
+
+  // metric change on a link of node 1
+  topo[1][2] = 2;
+  change = state.updateAdjacencyDatabase(makeAdjDb(1), kTestingAreaName);
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_TRUE(change.localLinksChanged);
+  EXPECT_THAT(state.getSpfChangedNodes("1"), UnorderedElementsAre("2"));
+
+  // removing a neighbor of node 1 reroutes 3 through 2
+  change = state.deleteAdjacencyDatabase("4");
+  EXPECT_TRUE(change.topologyChanged);
+  EXPECT_TRUE(change.localLinksChanged);
+  EXPECT_THAT(state.getSpfChangedNodes("1"), UnorderedElementsAre("3", "4"));
+  EXPECT_EQ(7, state.getSpfResult("1").at("3").metric());
+}
+
+TEST(LinkStateTest, SpfNodeIdsReused) {
+  // 1 - 2 - <n>, where node <n> is replaced by a new node every round
+  auto makeAdjDb = [](const std::string& node,
+                      const std::vector<std::string>& others) {
+    std::vector<openr::thrift::Adjacency> adjs;
+    for (auto const& other : others) {
+      adjs.emplace_back(openr::createAdjacency(
+          other,
+          fmt::format("{}/{}", node, other),
+          fmt::format("{}/{}", other, node),
+          "fe80::1",
+          "10.0.0.1",
+          1,
+          0));
+    }
+    return openr::createAdjDb(node, adjs, 0);
+  };
+
+  openr::LinkState state{kTestingAreaName, "1"};
+  state.updateAdjacencyDatabase(makeAdjDb("1", {"2"}), kTestingAreaName);
+  for (int round = 0; round < 10; ++round) {
+    const auto node = fmt::format("leaf-{}", round);
+    state.updateAdjacencyDatabase(
+        makeAdjDb("2", {"1", node}), kTestingAreaName);
+    state.updateAdjacencyDatabase(makeAdjDb(node, {"2"}), kTestingAreaName);
+
+    auto const& spfResult = state.getSpfResult("1");
+    ASSERT_EQ(1, spfResult.count(node));
+    EXPECT_EQ(2, spfResult.at(node).metric());
+    EXPECT_THAT(spfResult.at(node).nextHops(), UnorderedElementsAre("2"));
+    // id of node deleted in previous round is reused
+    EXPECT_EQ(3, state.numSpfNodeIds());
+
+    state.deleteAdjacencyDatabase(node);
+    EXPECT_EQ(0, state.getSpfResult("1").count(node));
+  }
+}
+
 int
 main(int argc, char* argv[]) {
   // Parse command line flags
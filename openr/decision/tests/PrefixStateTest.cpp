@@ -14,6 +14,15 @@
 
 using namespace openr;
 
+namespace {
+// PrefixState stores entries without prefix, which is the key of prefixes()
+thrift::PrefixEntry
+withoutPrefix(thrift::PrefixEntry entry) {
+  entry.prefix() = thrift::IpPrefix();
+  return entry;
+}
+} // namespace
+
 class PrefixStateTestFixture : public ::testing::Test {
  protected:
   static thrift::IpPrefix
@@ -74,7 +83,7 @@ class PrefixStateTestFixture : public ::testing::Test {
         if (innerIter == innerMap2.end()) {
           continue;
         }
-        EXPECT_EQ(*innerIter->second, *v);
+        EXPECT_EQ(*innerIter->second, withoutPrefix(*v));
       }
     }
   }
@@ -93,7 +102,7 @@ TEST_F(PrefixStateTestFixture, BasicOperation) {
   EXPECT_TRUE(state_.updatePrefix(key, *entry).empty());
   EXPECT_EQ(
       *state_.prefixes().at(toIPNetwork(*entry->prefix())).at(nodeArea),
-      *entry);
+      withoutPrefix(*entry));
 
   entry->forwardingType() = thrift::PrefixForwardingType::SR_MPLS;
   EXPECT_THAT(
@@ -102,7 +111,248 @@ TEST_F(PrefixStateTestFixture, BasicOperation) {
   EXPECT_TRUE(state_.updatePrefix(key, *entry).empty());
   EXPECT_EQ(
       *state_.prefixes().at(toIPNetwork(*entry->prefix())).at(nodeArea),
-      *entry);
+      withoutPrefix(*entry));
+}
+
+/**
+ * Verifies `getPrefixesFromNode` tracks advertisements and withdrawals
+ */
+TEST(PrefixState, GetPrefixesFromNode) {
+  PrefixState state;
+
+  const auto entry1 = createPrefixEntry(toIpPrefix("10.0.0.0/8"));
+  const auto entry2 = createPrefixEntry(toIpPrefix("fd00::/64"));
+  const auto prefix1 = toIPNetwork(*entry1.prefix());
+  const auto prefix2 = toIPNetwork(*entry2.prefix());
+  const NodeAndArea node0Area0{"node0", "area0"};
+  const NodeAndArea node0Area1{"node0", "area1"};
+
+  EXPECT_TRUE(state.getPrefixesFromNode(node0Area0).empty());
+
+  PrefixKey k1("node0", prefix1, "area0");
+  PrefixKey k2("node0", prefix2, "area0");
+  PrefixKey k3("node0", prefix1, "area1");
+  state.updatePrefix(k1, entry1);
+  state.updatePrefix(k2, entry2);
+  state.updatePrefix(k3, entry1);
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area0),
+      testing::UnorderedElementsAre(prefix1, prefix2));
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area1),
+      testing::UnorderedElementsAre(prefix1));
+
+  // attribute update keeps the index untouched
+  auto entry1Breeze = entry1;
+  entry1Breeze.type() = thrift::PrefixType::BREEZE;
+  EXPECT_FALSE(state.updatePrefix(k1, entry1Breeze).empty());
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area0),
+      testing::UnorderedElementsAre(prefix1, prefix2));
+
+  // withdrawals are per [node, area]
+  EXPECT_FALSE(state.deletePrefix(k1).empty());
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area0),
+      testing::UnorderedElementsAre(prefix2));
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area1),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_FALSE(state.deletePrefix(k2).empty());
+  EXPECT_TRUE(state.getPrefixesFromNode(node0Area0).empty());
+  EXPECT_TRUE(state.deletePrefix(k2).empty());
+}
+
+/**
+ * Verifies shard keys are diffed against their previous update, and ownership
+ * of prefixes carried by both per prefix key and shard key
+ */
+TEST(PrefixState, PrefixShard) {
+  PrefixState state;
+
+  const auto entry1 = createPrefixEntry(toIpPrefix("10.0.0.0/8"));
+  const auto entry2 = createPrefixEntry(toIpPrefix("fd00::/64"));
+  const auto entry3 = createPrefixEntry(toIpPrefix("fd01::/64"));
+  const auto prefix1 = toIPNetwork(*entry1.prefix());
+  const auto prefix2 = toIPNetwork(*entry2.prefix());
+  const auto prefix3 = toIPNetwork(*entry3.prefix());
+  const NodeAndArea node0Area0{"node0", "area0"};
+  const PrefixShardKey shard0("node0", 0, "area0");
+  const PrefixShardKey shard1("node0", 1, "area0");
+
+  EXPECT_THAT(
+      state.updatePrefixShard(shard0, {entry1, entry2}),
+      testing::UnorderedElementsAre(prefix1, prefix2));
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area0),
+      testing::UnorderedElementsAre(prefix1, prefix2));
+
+  // unchanged shard reports no change
+  EXPECT_TRUE(state.updatePrefixShard(shard0, {entry1, entry2}).empty());
+
+  // only modified, added and removed prefixes are reported
+  auto entry1Breeze = entry1;
+  entry1Breeze.type() = thrift::PrefixType::BREEZE;
+  EXPECT_THAT(
+      state.updatePrefixShard(shard0, {entry1Breeze, entry3}),
+      testing::UnorderedElementsAre(prefix1, prefix2, prefix3));
+  EXPECT_EQ(
+      withoutPrefix(entry1Breeze),
+      *state.prefixes().at(prefix1).at(node0Area0));
+  EXPECT_EQ(0, state.prefixes().count(prefix2));
+
+  // prefix moving to another shard is not withdrawn by its previous shard
+  EXPECT_TRUE(state.updatePrefixShard(shard1, {entry3}).empty());
+  EXPECT_TRUE(state.updatePrefixShard(shard0, {entry1Breeze}).empty());
+  EXPECT_EQ(1, state.prefixes().count(prefix3));
+
+  // per prefix key takes over prefix from shard
+  const PrefixKey key1("node0", prefix1, "area0");
+  EXPECT_THAT(
+      state.updatePrefix(key1, entry1),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_TRUE(state.deletePrefixShard(shard0).empty());
+  EXPECT_EQ(
+      withoutPrefix(entry1), *state.prefixes().at(prefix1).at(node0Area0));
+
+  // per prefix key doesn't withdraw prefix owned by shard
+  const PrefixKey key3("node0", prefix3, "area0");
+  EXPECT_TRUE(state.deletePrefix(key3).empty());
+  EXPECT_EQ(1, state.prefixes().count(prefix3));
+
+  EXPECT_THAT(
+      state.deletePrefixShard(shard1), testing::UnorderedElementsAre(prefix3));
+  EXPECT_THAT(
+      state.getPrefixesFromNode(node0Area0),
+      testing::UnorderedElementsAre(prefix1));
+  EXPECT_THAT(state.deletePrefix(key1), testing::UnorderedElementsAre(prefix1));
+  EXPECT_TRUE(state.prefixes().empty());
+}
+
+TEST(PrefixState, ApplyBatch) {
+  PrefixState batchState;
+  PrefixState sequentialState;
+
+  const auto entry1 = createPrefixEntry(toIpPrefix("10.0.0.0/8"));
+  const auto entry2 = createPrefixEntry(toIpPrefix("fd00::/64"));
+  const auto prefix1 = toIPNetwork(*entry1.prefix());
+  const auto prefix2 = toIPNetwork(*entry2.prefix());
+  auto entry1Breeze = entry1;
+  entry1Breeze.type() = thrift::PrefixType::BREEZE;
+
+  const PrefixKey k1("node0", prefix1, "area0");
+  const PrefixKey k2("node0", prefix2, "area0");
+  const PrefixKey k3("node1", prefix1, "area0");
+
+  // same prefix updated several times, then withdrawn, within one batch
+  std::vector<PrefixState::PrefixUpdate> updates;
+  updates.emplace_back(PrefixState::PrefixUpdate{k1, entry1});
+  updates.emplace_back(PrefixState::PrefixUpdate{k2, entry2});
+  updates.emplace_back(PrefixState::PrefixUpdate{k3, entry1});
+  updates.emplace_back(PrefixState::PrefixUpdate{k1, entry1Breeze});
+  updates.emplace_back(PrefixState::PrefixUpdate{k2, std::nullopt});
+
+  std::unordered_set<folly::CIDRNetwork> sequentialChanged;
+  for (auto const& update : updates) {
+    auto changed = update.entry.has_value()
+        ? sequentialState.updatePrefix(update.key, *update.entry)
+        : sequentialState.deletePrefix(update.key);
+    sequentialChanged.merge(changed);
+  }
+
+  std::unordered_set<folly::CIDRNetwork> batchChanged;
+  batchState.applyBatch(std::move(updates), batchChanged);
+  EXPECT_EQ(sequentialChanged, batchChanged);
+  EXPECT_THAT(batchChanged, testing::UnorderedElementsAre(prefix1, prefix2));
+  for (auto const& [prefix, entries] : sequentialState.prefixes()) {
+    ASSERT_EQ(1, batchState.prefixes().count(prefix));
+    auto const& batchEntries = batchState.prefixes().at(prefix);
+    ASSERT_EQ(entries.size(), batchEntries.size());
+    for (auto const& [nodeArea, entry] : entries) {
+      EXPECT_EQ(*entry, *batchEntries.at(nodeArea));
+    }
+  }
+  EXPECT_EQ(sequentialState.prefixes().size(), batchState.prefixes().size());
+  EXPECT_EQ(
+      withoutPrefix(entry1Breeze),
+      *batchState.prefixes().at(prefix1).at({"node0", "area0"}));
+  EXPECT_EQ(0, batchState.prefixes().count(prefix2));
+
+  // unchanged entries and withdrawal of unknown keys are not reported
+  updates.clear();
+  updates.emplace_back(PrefixState::PrefixUpdate{k3, entry1});
+  updates.emplace_back(PrefixState::PrefixUpdate{k2, std::nullopt});
+  batchChanged.clear();
+  batchState.applyBatch(std::move(updates), batchChanged);
+  EXPECT_TRUE(batchChanged.empty());
+
+  // withdrawal of prefix owned by shard key is ignored
+  const PrefixShardKey shard0("node1", 0, "area0");
+  batchState.updatePrefixShard(shard0, {entry2});
+  updates.clear();
+  updates.emplace_back(
+      PrefixState::PrefixUpdate{PrefixKey("node1", prefix2, "area0"), {}});
+  batchState.applyBatch(std::move(updates), batchChanged);
+  EXPECT_TRUE(batchChanged.empty());
+  EXPECT_EQ(1, batchState.prefixes().count(prefix2));
+}
+
+TEST(PrefixState, InternedEntries) {
+  PrefixState state;
+
+  const auto entry1 = createPrefixEntry(toIpPrefix("10.0.0.0/8"));
+  const auto entry2 = createPrefixEntry(toIpPrefix("fd00::/64"));
+  const auto prefix1 = toIPNetwork(*entry1.prefix());
+  const auto prefix2 = toIPNetwork(*entry2.prefix());
+  auto entry1Breeze = entry1;
+  entry1Breeze.type() = thrift::PrefixType::BREEZE;
+
+  const PrefixKey k1("node0", prefix1, "area0");
+  const PrefixKey k2("node1", prefix1, "area0");
+  const PrefixKey k3("node1", prefix1, "area1");
+  const PrefixKey k4("node1", prefix2, "area0");
+
+  // entries with same attributes share one object, of anycast prefix as well
+  // as of different prefixes
+  state.updatePrefix(k1, entry1);
+  state.updatePrefix(k2, entry1);
+  state.updatePrefix(k3, entry1);
+  state.updatePrefix(k4, entry2);
+  EXPECT_EQ(1, state.getNumInternedEntries());
+  auto const& entries = state.prefixes().at(prefix1);
+  EXPECT_EQ(entries.at({"node0", "area0"}), entries.at({"node1", "area0"}));
+  EXPECT_EQ(entries.at({"node0", "area0"}), entries.at({"node1", "area1"}));
+  EXPECT_EQ(
+      entries.at({"node0", "area0"}),
+      state.prefixes().at(prefix2).at({"node1", "area0"}));
+  EXPECT_FALSE(entries.at({"node0", "area0"})->prefix()->prefixLength());
+
+  // modified entry no longer shared
+  state.updatePrefix(k2, entry1Breeze);
+  EXPECT_EQ(2, state.getNumInternedEntries());
+  EXPECT_EQ(
+      withoutPrefix(entry1Breeze),
+      *state.prefixes().at(prefix1).at({"node1", "area0"}));
+  EXPECT_EQ(
+      withoutPrefix(entry1),
+      *state.prefixes().at(prefix1).at({"node0", "area0"}));
+
+  // entries of shard keys are interned as well
+  const PrefixShardKey shard0("node2", 0, "area0");
+  state.updatePrefixShard(shard0, {entry1, entry2});
+  EXPECT_EQ(2, state.getNumInternedEntries());
+
+  // entry is released with its last reference
+  state.updatePrefix(k2, entry1);
+  EXPECT_EQ(1, state.getNumInternedEntries());
+  state.deletePrefixShard(shard0);
+  state.deletePrefix(k1);
+  state.deletePrefix(k2);
+  state.deletePrefix(k3);
+  EXPECT_EQ(1, state.getNumInternedEntries());
+  state.deletePrefix(k4);
+  EXPECT_EQ(0, state.getNumInternedEntries());
+  EXPECT_TRUE(state.prefixes().empty());
 }
 
 /**
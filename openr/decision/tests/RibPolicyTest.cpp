@@ -328,6 +328,48 @@ TEST(RibPolicy, ApplyAction) {
   }
 }
 
+/**
+ * Test intends to verify matching of routes across statements with prefix,
+ * tag and combined matchers. Statements are evaluated in order and a
+ * statement invalidating all next-hops falls through to the next one.
+ */
+TEST(RibPolicy, MatchStatements) {
+  std::vector<thrift::IpPrefix> prefixes1{toIpPrefix("fc01::/64")};
+  std::vector<std::string> tags1{"TAG1"};
+  const auto stmt0 = createPolicyStatement(prefixes1, tags1, 0, {});
+  std::vector<std::string> tags2{"TAG1", "TAG2"};
+  const auto stmt1 = createPolicyStatement(std::nullopt, tags2, 2, {});
+  std::vector<thrift::IpPrefix> prefixes2{toIpPrefix("fc02::/64")};
+  const auto stmt2 = createPolicyStatement(prefixes2, std::nullopt, 3, {});
+  const auto stmt3 = createPolicyStatement(
+      std::vector<thrift::IpPrefix>{}, std::vector<std::string>{}, 4, {});
+  auto policy = RibPolicy(createPolicy({stmt0, stmt1, stmt2, stmt3}, 10));
+
+  const auto nh = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, "area1");
+  auto expectWeight = [&](std::string const& prefix,
+                          std::vector<std::string> const& tags,
+                          std::optional<int32_t> weight) {
+    RibUnicastEntry entry(folly::IPAddress::createNetwork(prefix), {nh});
+    for (auto const& tag : tags) {
+      entry.bestPrefixEntry.tags()->insert(tag);
+    }
+    EXPECT_EQ(weight.has_value(), policy.match(entry));
+    EXPECT_EQ(weight.has_value(), policy.applyAction(entry));
+    ASSERT_EQ(1, entry.nexthops.size());
+    EXPECT_EQ(weight.value_or(0), *entry.nexthops.begin()->weight());
+  };
+
+  // stmt0 matches, but drops all next-hops. stmt1 gets applied
+  expectWeight("fc01::/64", {"TAG1"}, 2);
+  // stmt1 gets applied before stmt2
+  expectWeight("fc02::/64", {"TAG3", "TAG2"}, 2);
+  expectWeight("fc02::/64", {}, 3);
+  // stmt3 has no matcher and never matches
+  expectWeight("fc01::/64", {}, std::nullopt);
+  expectWeight("fc03::/64", {"TAG3"}, std::nullopt);
+}
+
 TEST(RibPolicy, ApplyPolicy) {
   std::vector<thrift::IpPrefix> prefixes1{toIpPrefix("fc01::/64")};
   const auto stmt1 = createPolicyStatement(
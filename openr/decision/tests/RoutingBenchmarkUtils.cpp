@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <random>
+
 #include <openr/decision/tests/RoutingBenchmarkUtils.h>
 #include <openr/if/gen-cpp2/OpenrConfig_types.h>
 #include <openr/tests/mocks/PrefixGenerator.h>
@@ -515,6 +517,44 @@ updateRandomFabricAdjs(
   sendRecvAdjUpdate(decisionWrapper, rwsNodeName, adjsRsw, overloadBit);
 }
 
+//
+// Randomly choose one rsw from a random pod, or revert the last updated rsw:
+// toggle the metric of all its uplinks
+//
+void
+updateRandomFabricLinkMetric(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<std::pair<int, int>>& selectedNode,
+    const int numOfPods,
+    const int numOfFswsPerPod,
+    const int numOfRswsPerPod) {
+  auto podId = selectedNode.has_value() ? selectedNode.value().first
+                                        : folly::Random::rand32() % numOfPods;
+  auto rswIdInPod = selectedNode.has_value()
+      ? selectedNode.value().second
+      : folly::Random::rand32() % numOfRswsPerPod;
+
+  auto rwsNodeName = getNodeName(kRswMarker, podId, rswIdInPod);
+
+  std::vector<thrift::Adjacency> adjsRsw;
+  for (int otherId = 0; otherId < numOfFswsPerPod; otherId += 1) {
+    createFabricAdjacency(rwsNodeName, kFswMarker, podId, otherId, adjsRsw);
+  }
+  if (not selectedNode.has_value()) {
+    for (auto& adj : adjsRsw) {
+      adj.metric() = 10;
+    }
+  }
+
+  // Record the updated rsw
+  selectedNode = (selectedNode.has_value())
+      ? std::nullopt
+      : std::optional<std::pair<int, int>>(std::make_pair(podId, rswIdInPod));
+
+  // Send the update to decision and receive the routes
+  sendRecvAdjUpdate(decisionWrapper, rwsNodeName, adjsRsw, false);
+}
+
 //
 // Choose a random nodeId for update or revert the last updated nodeId:
 // toggle it's overload bit in AdjacencyDb
@@ -543,6 +583,36 @@ updateRandomGridAdjs(
   sendRecvAdjUpdate(decisionWrapper, nodeName, adjs, overloadBit);
 }
 
+//
+// Choose a random nodeId for update or revert the last updated nodeId:
+// toggle the metric of all its links
+//
+void
+updateRandomGridLinkMetric(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<std::pair<int, int>>& selectedNode,
+    const int n) {
+  auto row = selectedNode.has_value() ? selectedNode.value().first
+                                      : folly::Random::rand32() % n;
+  auto col = selectedNode.has_value() ? selectedNode.value().second
+                                      : folly::Random::rand32() % n;
+
+  auto nodeName = fmt::format("{}", row * n + col);
+  auto adjs = createGridAdjacencys(row, col, n);
+  if (not selectedNode.has_value()) {
+    for (auto& adj : adjs) {
+      adj.metric() = 10;
+    }
+  }
+  // Record the updated nodeId
+  selectedNode = selectedNode.has_value()
+      ? std::nullopt
+      : std::optional<std::pair<int, int>>(std::make_pair(row, col));
+
+  // Send the update to decision and receive the routes
+  sendRecvAdjUpdate(decisionWrapper, nodeName, adjs, false);
+}
+
 //
 // Choose a random nodeId for update or revert the last updated nodeId:
 // toggle it's advertisement of default route
@@ -687,6 +757,265 @@ BM_DecisionGridAdjUpdates(
   suspender.rehire(); // Stop measuring time again
 }
 
+void
+BM_DecisionGridLinkMetricUpdates(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    bool enableIncrementalSpf) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  auto decisionWrapper =
+      std::make_shared<DecisionWrapper>(nodeName, enableIncrementalSpf);
+  int n = std::sqrt(numOfSws);
+  auto [adjs, prefixes] = createGrid(n, 1);
+
+  sendRecvInitialUpdate(
+      decisionWrapper, nodeName, std::move(adjs), std::move(prefixes));
+
+  // Record the updated nodeId
+  std::optional<std::pair<int, int>> selectedNode = std::nullopt;
+
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Advertise link metric change. This should trigger the SPF run.
+    updateRandomGridLinkMetric(decisionWrapper, selectedNode, n);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+}
+
+void
+BM_DecisionGridParallelRouteBuild(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    uint32_t routeBuildThreads) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  int n = std::sqrt(numOfSws);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto decisionWrapper =
+        std::make_shared<DecisionWrapper>(nodeName, false, routeBuildThreads);
+    auto [adjs, prefixes] = createGrid(n, numberOfPrefixes);
+
+    suspender.dismiss(); // Start measuring benchmark time
+    sendRecvInitialUpdate(
+        decisionWrapper, nodeName, std::move(adjs), std::move(prefixes));
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+void
+BM_LinkStateGridSpf(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    thrift::SpfQueueType spfQueueType) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName{"1"};
+  LinkState linkState(kTestingAreaName, nodeName, false, spfQueueType);
+  int n = std::sqrt(numOfSws);
+  auto [adjDbs, prefixes] = createGrid(n, 1);
+
+  // RTT based link metrics. Nodes get reached through longer paths first and
+  // have their metric decreased while still queued
+  for (auto& [_, adjDb] : adjDbs) {
+    for (auto& adj : *adjDb.adjacencies()) {
+      adj.metric() = 100 + folly::Random::rand32() % 100000;
+    }
+    linkState.updateAdjacencyDatabase(adjDb, kTestingAreaName);
+  }
+  auto& myAdjDb = adjDbs.at(fmt::format("adj:{}", nodeName));
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Metric change on one of my links drops memoized SPF results
+    auto& metric = *myAdjDb.adjacencies()->front().metric();
+    metric += (i % 2) ? -1 : 1;
+    linkState.updateAdjacencyDatabase(myAdjDb, kTestingAreaName);
+
+    suspender.dismiss(); // Start measuring benchmark time
+    linkState.getSpfResult(nodeName);
+    suspender.rehire(); // Stop measuring time again
+  }
+}
+
+void
+BM_PrefixStateGridIngestion(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    bool batched) {
+  auto suspender = folly::BenchmarkSuspender();
+  int n = std::sqrt(numOfSws);
+  auto [adjDbs, prefixDbs] = createGrid(n, numberOfPrefixes);
+
+  // Full initial dump, as absorbed by Decision on first publication
+  std::vector<PrefixState::PrefixUpdate> initialUpdates;
+  initialUpdates.reserve(prefixDbs.size());
+  for (auto& [_, prefixDb] : prefixDbs) {
+    auto& entry = prefixDb.prefixEntries()->front();
+    initialUpdates.emplace_back(PrefixState::PrefixUpdate{
+        PrefixKey(
+            *prefixDb.thisNodeName(),
+            toIPNetwork(*entry.prefix()),
+            kTestingAreaName),
+        entry});
+  }
+  counters["num_prefix_keys"] = initialUpdates.size();
+
+  for (uint32_t i = 0; i < iters; i++) {
+    PrefixState prefixState;
+    auto updates = initialUpdates;
+    std::unordered_set<folly::CIDRNetwork> changed;
+
+    suspender.dismiss(); // Start measuring benchmark time
+    if (batched) {
+      prefixState.applyBatch(std::move(updates), changed);
+    } else {
+      // One change set per key, merged by caller
+      for (auto& update : updates) {
+        auto keyChanged =
+            prefixState.updatePrefix(update.key, update.entry.value());
+        changed.merge(keyChanged);
+      }
+    }
+    suspender.rehire(); // Stop measuring time again
+    CHECK_EQ(initialUpdates.size(), changed.size());
+  }
+}
+
+void
+BM_PrefixStateMemory(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfNodes,
+    uint32_t numberOfPrefixes,
+    bool anycast) {
+  auto suspender = folly::BenchmarkSuspender();
+  SystemMetrics sysMetrics;
+  bool record = true;
+
+  // Every node advertises prefixes with same attributes. Prefixes are either
+  // the same anycast ones or unique per node.
+  PrefixGenerator prefixGenerator;
+  std::vector<thrift::PrefixEntry> entries;
+  for (auto const& prefix : prefixGenerator.ipv6PrefixGenerator(
+           anycast ? numberOfPrefixes : numOfNodes * numberOfPrefixes,
+           kBitMaskLen)) {
+    entries.emplace_back(createPrefixEntry(
+        prefix,
+        thrift::PrefixType::LOOPBACK,
+        "",
+        thrift::PrefixForwardingType::IP,
+        thrift::PrefixForwardingAlgorithm::SP_ECMP));
+    entries.back().tags()->emplace("COMMODITY:EGRESS");
+    entries.back().area_stack()->emplace_back("65000");
+  }
+
+  for (uint32_t i = 0; i < iters; i++) {
+    PrefixState prefixState;
+    std::unordered_set<folly::CIDRNetwork> changed;
+    auto rssBefore = sysMetrics.getRSSMemBytes();
+
+    for (uint32_t node = 0; node < numOfNodes; node++) {
+      std::vector<PrefixState::PrefixUpdate> updates;
+      updates.reserve(numberOfPrefixes);
+      const auto offset = anycast ? 0 : node * numberOfPrefixes;
+      for (uint32_t j = 0; j < numberOfPrefixes; j++) {
+        auto const& entry = entries.at(offset + j);
+        updates.emplace_back(PrefixState::PrefixUpdate{
+            PrefixKey(
+                fmt::format("{}", node),
+                toIPNetwork(*entry.prefix()),
+                kTestingAreaName),
+            entry});
+      }
+      suspender.dismiss(); // Start measuring benchmark time
+      prefixState.applyBatch(std::move(updates), changed);
+      suspender.rehire(); // Stop measuring time again
+    }
+
+    auto rssAfter = sysMetrics.getRSSMemBytes();
+    if (record and rssBefore.has_value() and rssAfter.has_value()) {
+      counters["num_prefix_entries"] = numOfNodes * numberOfPrefixes;
+      counters["num_entry_objects"] = prefixState.getNumInternedEntries();
+      counters["rss_before_operation(MB)"] = rssBefore.value() / 1024 / 1024;
+      counters["rss_after_operation(MB)"] = rssAfter.value() / 1024 / 1024;
+      record = false;
+    }
+  }
+}
+
+void
+BM_RibPolicyApplyPolicy(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numberOfRoutes,
+    uint32_t numOfStatements) {
+  auto suspender = folly::BenchmarkSuspender();
+  const uint32_t kNumTags{64};
+  const uint32_t kNumTagsPerRoute{4};
+  auto getTag = [](uint32_t id) { return fmt::format("COMMODITY:POD{}", id); };
+  // Fixed seed keeps tags of routes, hence matched statements, same across runs
+  std::mt19937 rng(0x5eed);
+
+  // Routes carrying a few tags out of a shared pool
+  PrefixGenerator prefixGenerator;
+  const auto nh = createNextHop(
+      toBinaryAddress("fe80::1"), "iface1", 0, std::nullopt, "area1");
+  std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> routes;
+  std::vector<folly::CIDRNetwork> prefixes;
+  for (auto const& prefix :
+       prefixGenerator.ipv6PrefixGenerator(numberOfRoutes, kBitMaskLen)) {
+    auto network = toIPNetwork(prefix);
+    RibUnicastEntry route(network, {nh});
+    for (uint32_t i = 0; i < kNumTagsPerRoute; i++) {
+      route.bestPrefixEntry.tags()->emplace(
+          getTag(folly::Random::rand32(kNumTags, rng)));
+    }
+    routes.emplace(network, std::move(route));
+    prefixes.emplace_back(network);
+  }
+
+  // Statements selecting on prefixes, tags or both
+  thrift::RibPolicy tPolicy;
+  tPolicy.ttl_secs() = 3600;
+  for (uint32_t i = 0; i < numOfStatements; i++) {
+    thrift::RibPolicyStatement stmt;
+    stmt.name() = fmt::format("stmt{}", i);
+    if (i % 3 != 1) {
+      stmt.matcher()->prefixes() = std::vector<thrift::IpPrefix>();
+      for (size_t j = i; j < prefixes.size(); j += 10 * numOfStatements) {
+        stmt.matcher()->prefixes()->emplace_back(toIpPrefix(prefixes.at(j)));
+      }
+    }
+    if (i % 3 != 0) {
+      stmt.matcher()->tags() = std::vector<std::string>{
+          getTag(i % kNumTags), getTag((i + 1) % kNumTags)};
+    }
+    stmt.action()->set_weight() = thrift::RibRouteActionWeight{};
+    stmt.action()->set_weight()->default_weight() = 1;
+    stmt.action()->set_weight()->area_to_weight()->emplace("area1", 2);
+    tPolicy.statements()->emplace_back(std::move(stmt));
+  }
+  const RibPolicy policy(tPolicy);
+
+  for (uint32_t i = 0; i < iters; i++) {
+    auto unicastRoutes = routes;
+
+    suspender.dismiss(); // Start measuring benchmark time
+    auto change = policy.applyPolicy(unicastRoutes);
+    suspender.rehire(); // Stop measuring time again
+
+    counters["num_updated_routes"] = change.updatedRoutes.size();
+  }
+}
+
 void
 BM_DecisionGridPrefixUpdates(
     folly::UserCounters& counters,
@@ -862,4 +1191,49 @@ BM_DecisionFabricPrefixUpdates(
     }
   }
 }
+
+void
+BM_DecisionFabricLinkMetricUpdates(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfPods,
+    uint32_t numOfPlanes,
+    bool enableIncrementalSpf) {
+  auto suspender = folly::BenchmarkSuspender();
+  const std::string nodeName = getNodeName(kFswMarker, 0, 0);
+  auto decisionWrapper =
+      std::make_shared<DecisionWrapper>(nodeName, enableIncrementalSpf);
+  std::unordered_map<std::string, std::vector<std::string>> listOfNodenames;
+
+  auto initialPub = createFabric(
+      decisionWrapper,
+      numOfPods,
+      numOfPlanes,
+      kNumOfSswsPerPlane,
+      numOfPlanes, // numOfFswsPerPod == numOfPlanes
+      kNumOfRswsPerPod,
+      listOfNodenames);
+  generatePrefixUpdatePublication(1, listOfNodenames, initialPub);
+
+  decisionWrapper->sendKvPublication(initialPub);
+  decisionWrapper->sendKvStoreSyncedEvent();
+  decisionWrapper->recvMyRouteDb();
+
+  // Record the updated rsw
+  std::optional<std::pair<int, int>> selectedNode = std::nullopt;
+
+  suspender.dismiss(); // Start measuring benchmark time
+
+  for (uint32_t i = 0; i < iters; i++) {
+    // Advertise link metric change. This should trigger the SPF run.
+    updateRandomFabricLinkMetric(
+        decisionWrapper,
+        selectedNode,
+        numOfPods,
+        numOfPlanes,
+        kNumOfRswsPerPod);
+  }
+
+  suspender.rehire(); // Stop measuring time again
+}
 } // namespace openr
@@ -110,11 +110,16 @@ using apache::thrift::CompactSerializer;
 //
 class DecisionWrapper {
  public:
-  explicit DecisionWrapper(const std::string& nodeName) {
+  explicit DecisionWrapper(
+      const std::string& nodeName,
+      bool enableIncrementalSpf = false,
+      uint32_t routeBuildThreads = 1) {
     auto tConfig = getBasicOpenrConfig(nodeName);
     // decision config
     tConfig.decision_config()->debounce_min_ms() = 10;
     tConfig.decision_config()->debounce_max_ms() = 500;
+    tConfig.decision_config()->enable_incremental_spf() = enableIncrementalSpf;
+    tConfig.decision_config()->route_build_threads() = routeBuildThreads;
     config = std::make_shared<Config>(tConfig);
 
     decision = std::make_shared<Decision>(
@@ -373,6 +378,17 @@ void updateRandomFabricAdjs(
     const int numOfFswsPerPod,
     const int numOfRswsPerPod);
 
+//
+// Randomly choose one rsw from a random pod, or revert the last updated rsw:
+// toggle the metric of all its uplinks
+//
+void updateRandomFabricLinkMetric(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<std::pair<int, int>>& selectedNode,
+    const int numOfPods,
+    const int numOfFswsPerPod,
+    const int numOfRswsPerPod);
+
 //
 // Choose a random nodeId for update or revert the last updated nodeId:
 // toggle it's advertisement of default route
@@ -392,6 +408,15 @@ void updateRandomGridAdjs(
     std::optional<std::pair<int, int>>& selectedNode,
     const int n);
 
+//
+// Choose a random nodeId for update or revert the last updated nodeId:
+// toggle the metric of all its links
+//
+void updateRandomGridLinkMetric(
+    const std::shared_ptr<DecisionWrapper>& decisionWrapper,
+    std::optional<std::pair<int, int>>& selectedNode,
+    const int n);
+
 // Generate prefix updates for nodes and add into thrift::Publication
 void generatePrefixUpdatePublication(
     const uint32_t& numOfPrefixes,
@@ -424,6 +449,45 @@ void BM_DecisionGridAdjUpdates(
     thrift::PrefixForwardingAlgorithm forwardingAlgorithm,
     uint32_t numberOfPrefixes);
 
+void BM_DecisionGridLinkMetricUpdates(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    bool enableIncrementalSpf);
+
+void BM_DecisionGridParallelRouteBuild(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    uint32_t routeBuildThreads);
+
+void BM_LinkStateGridSpf(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    thrift::SpfQueueType spfQueueType);
+
+void BM_PrefixStateGridIngestion(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfSws,
+    uint32_t numberOfPrefixes,
+    bool batched);
+
+void BM_PrefixStateMemory(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfNodes,
+    uint32_t numberOfPrefixes,
+    bool anycast);
+
+void BM_RibPolicyApplyPolicy(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numberOfRoutes,
+    uint32_t numOfStatements);
+
 //
 // Benchmark test for fabric topology.
 //
@@ -445,5 +509,14 @@ void BM_DecisionFabricPrefixUpdates(
     uint32_t numOfUpdatePrefixes,
     thrift::PrefixForwardingAlgorithm forwardingAlgorithm);
 
+void BM_DecisionFabricLinkMetricUpdates(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfPods,
+    uint32_t numOfPlanes,
+    bool enableIncrementalSpf);
+
 const auto SP_ECMP = thrift::PrefixForwardingAlgorithm::SP_ECMP;
+const auto DARY_HEAP = thrift::SpfQueueType::DARY_HEAP;
+const auto RADIX_HEAP = thrift::SpfQueueType::RADIX_HEAP;
 } // namespace openr
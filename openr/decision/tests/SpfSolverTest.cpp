@@ -2854,6 +2854,40 @@ TEST_P(GridTopologyFixture, ShortestPathTest) {
   EXPECT_EQ(gridDistance(src, dst, n), *nextHops.begin()->metric());
 }
 
+// parallel route build must produce the same routes as serial build
+TEST_P(GridTopologyFixture, ParallelRouteBuildTest) {
+  SpfSolver parallelSpfSolver(
+      nodeName,
+      false,
+      true /* enable node segment label */,
+      false,
+      false,
+      4 /* route build threads */);
+
+  for (int i = 0; i < n * n; i += n + 1) {
+    const auto node = fmt::format("{}", i);
+    auto serialRouteDb =
+        spfSolver.buildRouteDb(node, areaLinkStates, prefixState);
+    auto parallelRouteDb =
+        parallelSpfSolver.buildRouteDb(node, areaLinkStates, prefixState);
+    ASSERT_TRUE(serialRouteDb.has_value());
+    ASSERT_TRUE(parallelRouteDb.has_value());
+    EXPECT_EQ(n * n - 1, parallelRouteDb->unicastRoutes.size());
+    EXPECT_TRUE(serialRouteDb->unicastRoutes == parallelRouteDb->unicastRoutes);
+    EXPECT_TRUE(serialRouteDb->mplsRoutes == parallelRouteDb->mplsRoutes);
+
+    auto const& serialCache = spfSolver.getBestRoutesCache();
+    auto const& parallelCache = parallelSpfSolver.getBestRoutesCache();
+    EXPECT_EQ(serialCache.size(), parallelCache.size());
+    for (auto const& [prefix, routeSelection] : serialCache) {
+      ASSERT_EQ(1, parallelCache.count(prefix));
+      EXPECT_EQ(
+          routeSelection.allNodeAreas,
+          parallelCache.at(prefix).allNodeAreas);
+    }
+  }
+}
+
 // measure SPF execution time for large networks
 TEST(GridTopology, StressTest) {
   if (!FLAGS_stress_test) {
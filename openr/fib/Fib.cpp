@@ -14,6 +14,7 @@
 #include <openr/common/LsdbUtil.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/fib/Fib.h>
+#include <openr/if/gen-cpp2/OpenrCtrl_types.h>
 
 namespace fb303 = facebook::fb303;
 
@@ -44,6 +45,32 @@ logFibUpdateError(thrift::PlatformFibUpdateError const& error) {
   }
 }
 
+/**
+ * Order routes so that routes with the same nexthops are adjacent. Platform
+ * can then update a shared nexthop group of all such routes in place, which
+ * is possible only if they are programmed in the same call. Routes of a group
+ * larger than a chunk are still programmed over several calls, and platform
+ * moves them to the new nexthops route by route.
+ */
+void
+groupByNextHops(std::vector<thrift::UnicastRoute>& routes) {
+  for (auto& route : routes) {
+    std::sort(route.nextHops()->begin(), route.nextHops()->end());
+  }
+  std::stable_sort(
+      routes.begin(),
+      routes.end(),
+      [](const thrift::UnicastRoute& lhs, const thrift::UnicastRoute& rhs) {
+        return *lhs.nextHops() < *rhs.nextHops();
+      });
+}
+
+bool
+haveSameNextHops(
+    const thrift::UnicastRoute& lhs, const thrift::UnicastRoute& rhs) {
+  return *lhs.nextHops() == *rhs.nextHops();
+}
+
 } // namespace
 
 Fib::Fib(
@@ -55,6 +82,7 @@ Fib::Fib(
       dryrun_(config->isDryrun()),
       enableSegmentRouting_(
           config->getConfig().enable_segment_routing().value_or(false)),
+      enableNexthopGroups_(*config->getConfig().enable_fib_nexthop_groups()),
       enableClearFibState_(*config->getConfig().enable_clear_fib_state()),
       routeDeleteDelay_(*config->getConfig().route_delete_delay_ms()),
       retryRoutesExpBackoff_(
@@ -237,6 +265,39 @@ Fib::getUnicastRoutes(std::vector<std::string> prefixes) {
   return sf;
 }
 
+folly::SemiFuture<std::unique_ptr<std::map<std::string, thrift::UnicastRoute>>>
+Fib::longestPrefixMatchUnicastRoutes(std::vector<std::string> addresses) {
+  folly::Promise<std::unique_ptr<std::map<std::string, thrift::UnicastRoute>>>
+      p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [p = std::move(p), addresses = std::move(addresses), this]() mutable {
+        auto matchedRoutes =
+            std::make_unique<std::map<std::string, thrift::UnicastRoute>>();
+        for (auto& address : addresses) {
+          const auto maybePrefix =
+              folly::IPAddress::tryCreateNetwork(address, -1, true);
+          if (maybePrefix.hasError()) {
+            thrift::OpenrError error;
+            error.message() =
+                fmt::format("Invalid IP address or prefix: {}", address);
+            p.setException(error);
+            return;
+          }
+          const auto matchedPrefix =
+              routeState_.unicastPrefixes.longestPrefixMatch(
+                  maybePrefix.value());
+          if (matchedPrefix.has_value()) {
+            matchedRoutes->emplace(
+                std::move(address),
+                routeState_.unicastRoutes.at(*matchedPrefix).toThrift());
+          }
+        }
+        p.setValue(std::move(matchedRoutes));
+      });
+  return sf;
+}
+
 folly::SemiFuture<std::unique_ptr<std::vector<thrift::MplsRoute>>>
 Fib::getMplsRoutes(std::vector<int32_t> labels) {
   folly::Promise<std::unique_ptr<std::vector<thrift::MplsRoute>>> p;
@@ -287,7 +348,7 @@ Fib::getUnicastRoutesFiltered(std::vector<std::string> prefixes) {
 
     // do longest prefix match, add the matched prefix to the result set
     const auto& matchedPrefix =
-        Fib::longestPrefixMatch(inputPrefix, routeState_.unicastRoutes);
+        routeState_.unicastPrefixes.longestPrefixMatch(inputPrefix);
     if (matchedPrefix.has_value()) {
       matchPrefixSet.insert(matchedPrefix.value());
     }
@@ -340,6 +401,7 @@ Fib::RouteState::update(const DecisionRouteUpdate& routeUpdate) {
   // Add/Update unicast routes to update
   for (const auto& [prefix, route] : routeUpdate.unicastRoutesToUpdate) {
     unicastRoutes.insert_or_assign(prefix, route);
+    unicastPrefixes.insert(prefix);
   }
 
   // Add mpls routes to update
@@ -349,7 +411,9 @@ Fib::RouteState::update(const DecisionRouteUpdate& routeUpdate) {
 
   // Delete unicast routes
   for (const auto& dest : routeUpdate.unicastRoutesToDelete) {
-    unicastRoutes.erase(dest);
+    if (unicastRoutes.erase(dest)) {
+      unicastPrefixes.erase(dest);
+    }
   }
 
   // Delete mpls routes
@@ -524,6 +588,38 @@ Fib::dumpPerfDb() const {
   return perfDb;
 }
 
+void
+Fib::recordHighPriorityRoutesProgrammed(
+    thrift::PerfEvents perfEvents,
+    const std::chrono::time_point<std::chrono::steady_clock>& startTime) {
+  const auto elapsedTime = std::chrono::ceil<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - startTime);
+  XLOG(INFO) << fmt::format(
+      "It took {} ms to program high priority routes in FIB",
+      elapsedTime.count());
+  fb303::fbData->addStatValue(
+      "fib.high_priority_route_programming.time_ms",
+      elapsedTime.count(),
+      fb303::AVG);
+
+  addPerfEvent(perfEvents, myNodeName_, "FIB_HIGH_PRIORITY_ROUTES_PROGRAMMED");
+  perfDb_.emplace_back(std::move(perfEvents));
+  while (perfDb_.size() > Constants::kPerfBufferSize) {
+    perfDb_.pop_front();
+  }
+}
+
+Fib::RoutePriority
+Fib::getRoutePriority(const RibUnicastEntry& route) {
+  switch (*route.bestPrefixEntry.type()) {
+  case thrift::PrefixType::LOOPBACK:
+  case thrift::PrefixType::PREFIX_ALLOCATOR:
+    return RoutePriority::HIGH;
+  default:
+    return RoutePriority::LOW;
+  }
+}
+
 void
 Fib::printUnicastRoutesAddUpdate(
     const std::vector<thrift::UnicastRoute>& unicastRoutesToUpdate) {
@@ -558,6 +654,76 @@ Fib::printMplsRoutesAddUpdate(
   }
 }
 
+template <typename T>
+typename std::vector<T>::iterator
+Fib::getChunkEnd(
+    typename std::vector<T>::iterator begin,
+    typename std::vector<T>::iterator end,
+    folly::FunctionRef<bool(const T&, const T&)> inSameChunk) {
+  auto chunkEnd = begin +
+      std::min<size_t>(
+          Constants::kFibProgrammingChunkSize, std::distance(begin, end));
+  if (not inSameChunk) {
+    return chunkEnd;
+  }
+
+  // Cut chunk ahead of a run of items crossing the chunk boundary. Run longer
+  // than a chunk is split into full chunks, so that chunks never exceed
+  // `kFibProgrammingChunkSize`
+  auto runBegin = chunkEnd;
+  while (runBegin != begin and runBegin != end and
+         inSameChunk(*(runBegin - 1), *runBegin)) {
+    --runBegin;
+  }
+  return runBegin != begin ? runBegin : chunkEnd;
+}
+
+template <typename T>
+void
+Fib::programInChunks(
+    std::vector<T>&& items,
+    folly::FunctionRef<folly::SemiFuture<folly::Unit>(const std::vector<T>&)>
+        program,
+    folly::FunctionRef<void(const std::vector<T>&, folly::Try<folly::Unit>&&)>
+        onChunkDone,
+    folly::FunctionRef<bool(const T&, const T&)> inSameChunk) {
+  // Chunks in flight, in the order they're sent
+  std::deque<std::pair<std::vector<T>, folly::Future<folly::Unit>>> inflight;
+  auto awaitOldestChunk = [&]() {
+    auto& [chunk, future] = inflight.front();
+    // NOTE: Blocks only the calling fiber. EventBase keeps processing
+    // responses of other chunks in flight
+    future.wait();
+    onChunkDone(chunk, std::move(future.result()));
+    inflight.pop_front();
+  };
+
+  for (auto it = items.begin(); it != items.end();) {
+    if (inflight.size() >= Constants::kFibMaxInflightChunks) {
+      awaitOldestChunk();
+    }
+
+    const auto chunkEnd = getChunkEnd<T>(it, items.end(), inSameChunk);
+    std::vector<T> chunk(
+        std::make_move_iterator(it), std::make_move_iterator(chunkEnd));
+    it = chunkEnd;
+
+    auto future = folly::makeFuture();
+    try {
+      createFibClient(*getEvb(), client_, thriftPort_);
+      future = program(chunk).via(getEvb());
+    } catch (std::exception const& e) {
+      future = folly::makeFuture<folly::Unit>(
+          folly::exception_wrapper(std::current_exception(), e));
+    }
+    inflight.emplace_back(std::move(chunk), std::move(future));
+  }
+
+  while (not inflight.empty()) {
+    awaitOldestChunk();
+  }
+}
+
 bool
 Fib::updateUnicastRoutes(
     const bool useDeleteDelay,
@@ -596,30 +762,37 @@ Fib::updateUnicastRoutes(
     if (dryrun_) {
       XLOG(INFO) << "Skipping deletion of unicast routes in dryrun ... ";
     } else {
-      try {
-        createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_deleteUnicastRoutes(kFibId_, unicastRoutesToDelete);
-      } catch (std::exception& e) {
-        success = false;
-        client_.reset();
-        fb303::fbData->addStatValue(
-            "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-        XLOG(ERR) << "Failed to delete unicast routes from FIB. Error: "
-                  << folly::exceptionStr(e);
-        // Marked all routes to be deleted as dirty. So we try to remove them
-        // again from FIB.
-        for (const auto& prefix : routeUpdate.unicastRoutesToDelete) {
-          routeState_.dirtyPrefixes.insert_or_assign(prefix, retryAt);
-        }
-        // NOTE: We still want to advertise these prefixes as deleted
-      }
+      programInChunks<thrift::IpPrefix>(
+          std::move(unicastRoutesToDelete),
+          [this](const std::vector<thrift::IpPrefix>& prefixes) {
+            return client_->semifuture_deleteUnicastRoutes(kFibId_, prefixes);
+          },
+          [&](const std::vector<thrift::IpPrefix>& prefixes,
+              folly::Try<folly::Unit>&& result) {
+            if (not result.hasException()) {
+              return;
+            }
+            success = false;
+            client_.reset();
+            fb303::fbData->addStatValue(
+                "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
+            XLOG(ERR) << "Failed to delete unicast routes from FIB. Error: "
+                      << folly::exceptionStr(result.exception());
+            // Marked routes to be deleted as dirty. So we try to remove them
+            // again from FIB.
+            for (const auto& prefix : prefixes) {
+              routeState_.dirtyPrefixes.insert_or_assign(
+                  toIPNetwork(prefix), retryAt);
+            }
+            // NOTE: We still want to advertise these prefixes as deleted
+          });
     }
   }
 
   //
   // Update Unicast routes
   //
-  auto const& unicastRoutesToUpdate = *routeDbDelta.unicastRoutesToUpdate();
+  auto& unicastRoutesToUpdate = *routeDbDelta.unicastRoutesToUpdate();
   if (unicastRoutesToUpdate.size()) {
     XLOG(INFO) << "Adding/Updating " << unicastRoutesToUpdate.size()
                << " unicast routes in FIB";
@@ -627,35 +800,122 @@ Fib::updateUnicastRoutes(
     if (dryrun_) {
       XLOG(INFO) << "Skipping add/update of unicast routes in dryrun ... ";
     } else {
-      try {
-        createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_addUnicastRoutes(kFibId_, unicastRoutesToUpdate);
-      } catch (thrift::PlatformFibUpdateError const& fibUpdateError) {
-        success = false;
-        logFibUpdateError(fibUpdateError);
-        // Remove failed routes from fibRouteUpdates
-        routeUpdate.processFibUpdateError(fibUpdateError);
-        // Mark failed routes as dirty in route state
-        routeState_.processFibUpdateError(fibUpdateError, retryAt);
-      } catch (std::exception const& e) {
-        success = false;
-        client_.reset();
-        fb303::fbData->addStatValue(
-            "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-        XLOG(ERR) << "Failed to add/update unicast routes in FIB. Error: "
-                  << folly::exceptionStr(e);
-        // Mark routes we failed to update as dirty for retry. Also declare
-        // these routes as deleted to client, because we failed to update them
-        // Next retry should restore, but meanwhile clients can take appropriate
-        // action because FIB state is unclear e.g. withdraw route from KvStore
-        for (auto& [prefix, _] : routeUpdate.unicastRoutesToUpdate) {
-          routeState_.dirtyPrefixes.insert_or_assign(prefix, retryAt);
-          routeUpdate.unicastRoutesToDelete.emplace_back(prefix);
+      // High priority routes are programmed on their own, ahead of the rest
+      auto bulkBegin = std::stable_partition(
+          unicastRoutesToUpdate.begin(),
+          unicastRoutesToUpdate.end(),
+          [&](const thrift::UnicastRoute& route) {
+            auto it = routeUpdate.unicastRoutesToUpdate.find(
+                toIPNetwork(*route.dest()));
+            return it != routeUpdate.unicastRoutesToUpdate.end() and
+                getRoutePriority(it->second) == RoutePriority::HIGH;
+          });
+      std::vector<thrift::UnicastRoute> highPriorityRoutes(
+          std::make_move_iterator(unicastRoutesToUpdate.begin()),
+          std::make_move_iterator(bulkBegin));
+      unicastRoutesToUpdate.erase(unicastRoutesToUpdate.begin(), bulkBegin);
+
+      // Routes with the same nexthops are kept in the same chunk, if platform
+      // shares nexthop groups among them
+      folly::FunctionRef<bool(
+          const thrift::UnicastRoute&, const thrift::UnicastRoute&)>
+          inSameChunk;
+      if (enableNexthopGroups_) {
+        groupByNextHops(highPriorityRoutes);
+        groupByNextHops(unicastRoutesToUpdate);
+        inSameChunk = haveSameNextHops;
+      }
+
+      // Publish programmed routes chunk by chunk, instead of waiting for the
+      // whole update, if it spans more than one chunk. Last chunk is published
+      // along with rest of the update.
+      // NOTE: Only unicast adds are published per chunk. Unicast deletes and
+      // MPLS routes are programmed in pipelined chunks too, but published
+      // along with rest of the update.
+      auto getNumChunks = [&](std::vector<thrift::UnicastRoute>& routes) {
+        size_t numChunks{0};
+        for (auto it = routes.begin(); it != routes.end();
+             it = getChunkEnd<thrift::UnicastRoute>(
+                 it, routes.end(), inSameChunk)) {
+          ++numChunks;
+        }
+        return numChunks;
+      };
+      const size_t numChunks = getNumChunks(highPriorityRoutes) +
+          getNumChunks(unicastRoutesToUpdate);
+      size_t numChunksDone{0};
+      auto addRoutes = [this](const std::vector<thrift::UnicastRoute>& routes) {
+        return client_->semifuture_addUnicastRoutes(kFibId_, routes);
+      };
+      auto onChunkDone = [&](const std::vector<thrift::UnicastRoute>& routes,
+                             folly::Try<folly::Unit>&& result) {
+        if (auto fibUpdateError = result.tryGetExceptionObject<
+                thrift::PlatformFibUpdateError>()) {
+          success = false;
+          logFibUpdateError(*fibUpdateError);
+          // Remove failed routes from fibRouteUpdates
+          routeUpdate.processFibUpdateError(*fibUpdateError);
+          // Mark failed routes as dirty in route state
+          routeState_.processFibUpdateError(*fibUpdateError, retryAt);
+        } else if (result.hasException()) {
+          success = false;
+          client_.reset();
+          fb303::fbData->addStatValue(
+              "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
+          XLOG(ERR) << "Failed to add/update unicast routes in FIB. Error: "
+                    << folly::exceptionStr(result.exception());
+          // Mark routes we failed to update as dirty for retry. Also declare
+          // these routes as deleted to client, because we failed to update
+          // them. Next retry should restore, but meanwhile clients can take
+          // appropriate action because FIB state is unclear e.g. withdraw
+          // route from KvStore
+          for (const auto& route : routes) {
+            const auto prefix = toIPNetwork(*route.dest());
+            routeState_.dirtyPrefixes.insert_or_assign(prefix, retryAt);
+            routeUpdate.unicastRoutesToUpdate.erase(prefix);
+            routeUpdate.unicastRoutesToDelete.emplace_back(prefix);
+          }
         }
 
-        // We don't want to advertise failed route add/updates
-        routeUpdate.unicastRoutesToUpdate.clear();
+        if (++numChunksDone == numChunks) {
+          return;
+        }
+        // Move programmed routes of this chunk out of the update and publish
+        // them right away
+        DecisionRouteUpdate chunkUpdate;
+        chunkUpdate.prefixType = routeUpdate.prefixType;
+        for (const auto& route : routes) {
+          auto it = routeUpdate.unicastRoutesToUpdate.find(
+              toIPNetwork(*route.dest()));
+          if (it == routeUpdate.unicastRoutesToUpdate.end()) {
+            continue; // Failed to program
+          }
+          chunkUpdate.addRouteToUpdate(std::move(it->second));
+          routeUpdate.unicastRoutesToUpdate.erase(it);
+        }
+        if (not chunkUpdate.empty()) {
+          fibRouteUpdatesQueue_.push(std::move(chunkUpdate));
+        }
+      };
+
+      if (not highPriorityRoutes.empty()) {
+        XLOG(INFO) << "Adding/Updating " << highPriorityRoutes.size()
+                   << " high priority unicast routes in FIB";
+        programInChunks<thrift::UnicastRoute>(
+            std::move(highPriorityRoutes),
+            addRoutes,
+            onChunkDone,
+            inSameChunk);
+        if (success and routeUpdate.perfEvents.has_value()) {
+          recordHighPriorityRoutesProgrammed(
+              routeUpdate.perfEvents.value(), currentTime);
+        }
       }
+      programInChunks<thrift::UnicastRoute>(
+          std::move(unicastRoutesToUpdate),
+          addRoutes,
+          onChunkDone,
+          inSameChunk);
     }
   }
 
@@ -699,30 +959,36 @@ Fib::updateMplsRoutes(
     if (dryrun_) {
       XLOG(INFO) << "Skipping deletion of mpls routes in dryrun ... ";
     } else {
-      try {
-        createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_deleteMplsRoutes(kFibId_, mplsRoutesToDelete);
-      } catch (std::exception const& e) {
-        success = false;
-        client_.reset();
-        fb303::fbData->addStatValue(
-            "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-        XLOG(ERR) << "Failed to delete mpls routes from FIB. Error: "
-                  << folly::exceptionStr(e);
-        // Marked all routes to be deleted as dirty. So we try to remove them
-        // again from FIB.
-        for (const auto& label : routeUpdate.mplsRoutesToDelete) {
-          routeState_.dirtyLabels.insert_or_assign(label, retryAt);
-        }
-        // NOTE: We still want to advertise these labels as deleted
-      }
+      programInChunks<int32_t>(
+          std::move(mplsRoutesToDelete),
+          [this](const std::vector<int32_t>& labels) {
+            return client_->semifuture_deleteMplsRoutes(kFibId_, labels);
+          },
+          [&](const std::vector<int32_t>& labels,
+              folly::Try<folly::Unit>&& result) {
+            if (not result.hasException()) {
+              return;
+            }
+            success = false;
+            client_.reset();
+            fb303::fbData->addStatValue(
+                "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
+            XLOG(ERR) << "Failed to delete mpls routes from FIB. Error: "
+                      << folly::exceptionStr(result.exception());
+            // Marked routes to be deleted as dirty. So we try to remove them
+            // again from FIB.
+            for (const auto& label : labels) {
+              routeState_.dirtyLabels.insert_or_assign(label, retryAt);
+            }
+            // NOTE: We still want to advertise these labels as deleted
+          });
     }
   }
 
   //
   // Update Mpls routes
   //
-  auto const& mplsRoutesToUpdate = *routeDbDelta.mplsRoutesToUpdate();
+  auto& mplsRoutesToUpdate = *routeDbDelta.mplsRoutesToUpdate();
   if (mplsRoutesToUpdate.size()) {
     XLOG(INFO) << "Adding/Updating " << mplsRoutesToUpdate.size()
                << " mpls routes in FIB";
@@ -730,36 +996,42 @@ Fib::updateMplsRoutes(
     if (dryrun_) {
       XLOG(INFO) << "Skipping add/update of mpls routes in dryrun ... ";
     } else {
-      try {
-        createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_addMplsRoutes(kFibId_, mplsRoutesToUpdate);
-      } catch (thrift::PlatformFibUpdateError const& fibUpdateError) {
-        success = false;
-        logFibUpdateError(fibUpdateError);
-        // Remove failed routes from fibRouteUpdates
-        routeUpdate.processFibUpdateError(fibUpdateError);
-        // Mark failed routes as dirty in route state
-        routeState_.processFibUpdateError(fibUpdateError, retryAt);
-      } catch (std::exception const& e) {
-        success = false;
-        client_.reset();
-        fb303::fbData->addStatValue(
-            "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
-        XLOG(ERR) << "Failed to add/update mpls routes in FIB. Error: "
-                  << folly::exceptionStr(e);
-        // Mark routes we failed to update as dirty for retry. Also declare
-        // these routes as deleted to client, because we failed to update them
-        // Next retry should restore, but meanwhile clients can take
-        // appropriate action because FIB state is unclear e.g. withdraw route
-        // from KvStore
-        for (auto& [label, _] : routeUpdate.mplsRoutesToUpdate) {
-          routeState_.dirtyLabels.insert_or_assign(label, retryAt);
-          routeUpdate.mplsRoutesToDelete.emplace_back(label);
-        }
-
-        // We don't want to advertise failed route add/updates
-        routeUpdate.mplsRoutesToUpdate.clear();
-      }
+      programInChunks<thrift::MplsRoute>(
+          std::move(mplsRoutesToUpdate),
+          [this](const std::vector<thrift::MplsRoute>& routes) {
+            return client_->semifuture_addMplsRoutes(kFibId_, routes);
+          },
+          [&](const std::vector<thrift::MplsRoute>& routes,
+              folly::Try<folly::Unit>&& result) {
+            if (auto fibUpdateError =
+                    result.tryGetExceptionObject<
+                        thrift::PlatformFibUpdateError>()) {
+              success = false;
+              logFibUpdateError(*fibUpdateError);
+              // Remove failed routes from fibRouteUpdates
+              routeUpdate.processFibUpdateError(*fibUpdateError);
+              // Mark failed routes as dirty in route state
+              routeState_.processFibUpdateError(*fibUpdateError, retryAt);
+            } else if (result.hasException()) {
+              success = false;
+              client_.reset();
+              fb303::fbData->addStatValue(
+                  "fib.thrift.failure.add_del_route", 1, fb303::COUNT);
+              XLOG(ERR) << "Failed to add/update mpls routes in FIB. Error: "
+                        << folly::exceptionStr(result.exception());
+              // Mark routes we failed to update as dirty for retry. Also
+              // declare these routes as deleted to client, because we failed
+              // to update them. Next retry should restore, but meanwhile
+              // clients can take appropriate action because FIB state is
+              // unclear e.g. withdraw route from KvStore
+              for (const auto& route : routes) {
+                const auto label = *route.topLabel();
+                routeState_.dirtyLabels.insert_or_assign(label, retryAt);
+                routeUpdate.mplsRoutesToUpdate.erase(label);
+                routeUpdate.mplsRoutesToDelete.emplace_back(label);
+              }
+            }
+          });
     }
   }
 
@@ -815,13 +1087,15 @@ Fib::updateRoutes(
   // and MplsRoute with the FibService client APIs
   auto routeDbDelta = routeUpdate.toThrift();
 
-  success &= updateUnicastRoutes(
-      useDeleteDelay, currentTime, retryAt, routeUpdate, routeDbDelta);
-
+  // NOTE: MPLS routes are node segment label routes, which other nodes rely
+  // on to reach us. Program them ahead of unicast routes.
   if (enableSegmentRouting_) {
     success &= updateMplsRoutes(
         useDeleteDelay, currentTime, retryAt, routeUpdate, routeDbDelta);
   }
+
+  success &= updateUnicastRoutes(
+      useDeleteDelay, currentTime, retryAt, routeUpdate, routeDbDelta);
   // Log statistics
   const auto elapsedTime = std::chrono::ceil<std::chrono::milliseconds>(
       std::chrono::steady_clock::now() - currentTime);
@@ -850,9 +1124,26 @@ Fib::syncRoutes() {
   };
   updateRoutesSemaphore_.wait();
 
-  // Create set of routes to sync in thrift format
-  const auto& unicastRoutes =
-      createUnicastRoutesFromMap(routeState_.unicastRoutes);
+  // Perf events of this sync, to measure time taken to program high priority
+  // routes
+  thrift::PerfEvents perfEvents;
+  addPerfEvent(perfEvents, myNodeName_, "FIB_SYNC_STARTED");
+
+  // Create set of routes to sync in thrift format. High priority routes lead
+  // the list of unicast routes, as FibService programs them in order.
+  std::vector<thrift::UnicastRoute> highPriorityRoutes;
+  std::vector<thrift::UnicastRoute> unicastRoutes;
+  for (const auto& [_, route] : routeState_.unicastRoutes) {
+    if (getRoutePriority(route) == RoutePriority::HIGH) {
+      highPriorityRoutes.emplace_back(route.toThrift());
+    } else {
+      unicastRoutes.emplace_back(route.toThrift());
+    }
+  }
+  unicastRoutes.insert(
+      unicastRoutes.begin(),
+      highPriorityRoutes.begin(),
+      highPriorityRoutes.end());
   const auto& mplsRoutes = createMplsRoutesFromMap(routeState_.mplsRoutes);
   const auto currentTime = std::chrono::steady_clock::now();
   const auto retryAt =
@@ -866,6 +1157,75 @@ Fib::syncRoutes() {
   // update flat counters here as they depend on routeState_ and its change
   updateGlobalCounters();
 
+  //
+  // Program high priority routes
+  // NOTE: High priority unicast routes are added ahead of the full sync, which
+  // then finds them programmed already. Failures are left to the sync below.
+  // The handler learns objects of its previous instance before the first
+  // programming call of any kind, thus adding ahead of sync is safe with
+  // kernel nexthop groups too.
+  // MPLS routes are all node segment label routes and are synced before the
+  // unicast routes as well.
+  //
+  bool isHighPriorityRoutesProgrammed{not dryrun_};
+  if (not highPriorityRoutes.empty() and not dryrun_) {
+    XLOG(INFO) << fmt::format(
+        "Adding {} high priority unicast routes in FIB",
+        highPriorityRoutes.size());
+    try {
+      createFibClient(*getEvb(), client_, thriftPort_);
+      client_->semifuture_addUnicastRoutes(kFibId_, highPriorityRoutes)
+          .via(getEvb())
+          .get();
+    } catch (std::exception const& e) {
+      client_.reset();
+      isHighPriorityRoutesProgrammed = false;
+      XLOG(WARNING) << "Failed to add high priority unicast routes in FIB. "
+                    << "Error: " << folly::exceptionStr(e);
+    }
+  }
+
+  //
+  // Sync Mpls routes
+  // NOTE: Failure to sync MPLS routes doesn't hold back the unicast sync. Sync
+  // is reported failed after programming unicast routes.
+  //
+  bool isMplsSyncFailed{false};
+  if (enableSegmentRouting_) {
+    XLOG(INFO) << "Syncing " << mplsRoutes.size() << " mpls routes in FIB";
+    printMplsRoutesAddUpdate(mplsRoutes);
+    if (dryrun_) {
+      XLOG(INFO) << "Skipping programming of mpls routes in dryrun ...";
+    } else {
+      try {
+        createFibClient(*getEvb(), client_, thriftPort_);
+        client_->semifuture_syncMplsFib(kFibId_, mplsRoutes)
+            .via(getEvb())
+            .get();
+      } catch (thrift::PlatformFibUpdateError const& fibUpdateError) {
+        logFibUpdateError(fibUpdateError);
+        // Remove failed routes from fibRouteUpdates
+        fibRouteUpdates.processFibUpdateError(fibUpdateError);
+        // Mark failed routes as dirty in route state
+        routeState_.processFibUpdateError(fibUpdateError, retryAt);
+      } catch (std::exception const& e) {
+        client_.reset();
+        isMplsSyncFailed = true;
+        isHighPriorityRoutesProgrammed = false;
+        fb303::fbData->addStatValue(
+            "fib.thrift.failure.sync_fib", 1, fb303::COUNT);
+        XLOG(ERR) << "Failed to sync mpls routes in FIB. Error: "
+                  << folly::exceptionStr(e);
+      }
+    } // else
+  } // if enableSegmentRouting_
+
+  if (isHighPriorityRoutesProgrammed and
+      (not highPriorityRoutes.empty() or
+       (enableSegmentRouting_ and not mplsRoutes.empty()))) {
+    recordHighPriorityRoutesProgrammed(std::move(perfEvents), currentTime);
+  }
+
   //
   // Sync Unicast routes
   //
@@ -884,7 +1244,7 @@ Fib::syncRoutes() {
       try {
         auto emptyRoutes = std::vector<thrift::UnicastRoute>{};
         createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_syncFib(kFibId_, emptyRoutes);
+        client_->semifuture_syncFib(kFibId_, emptyRoutes).via(getEvb()).get();
       } catch (std::exception const& e) {
         client_.reset();
         fb303::fbData->addStatValue(
@@ -907,7 +1267,7 @@ Fib::syncRoutes() {
 
     try {
       createFibClient(*getEvb(), client_, thriftPort_);
-      client_->sync_syncFib(kFibId_, unicastRoutes);
+      client_->semifuture_syncFib(kFibId_, unicastRoutes).via(getEvb()).get();
     } catch (thrift::PlatformFibUpdateError const& fibUpdateError) {
       logFibUpdateError(fibUpdateError);
       // Remove failed routes from fibRouteUpdates
@@ -924,34 +1284,10 @@ Fib::syncRoutes() {
     }
   }
 
-  //
-  // Sync Mpls routes
-  //
-  if (enableSegmentRouting_) {
-    XLOG(INFO) << "Syncing " << mplsRoutes.size() << " mpls routes in FIB";
-    printMplsRoutesAddUpdate(mplsRoutes);
-    if (dryrun_) {
-      XLOG(INFO) << "Skipping programming of mpls routes in dryrun ...";
-    } else {
-      try {
-        createFibClient(*getEvb(), client_, thriftPort_);
-        client_->sync_syncMplsFib(kFibId_, mplsRoutes);
-      } catch (thrift::PlatformFibUpdateError const& fibUpdateError) {
-        logFibUpdateError(fibUpdateError);
-        // Remove failed routes from fibRouteUpdates
-        fibRouteUpdates.processFibUpdateError(fibUpdateError);
-        // Mark failed routes as dirty in route state
-        routeState_.processFibUpdateError(fibUpdateError, retryAt);
-      } catch (std::exception const& e) {
-        client_.reset();
-        fb303::fbData->addStatValue(
-            "fib.thrift.failure.sync_fib", 1, fb303::COUNT);
-        XLOG(ERR) << "Failed to sync unicast routes in FIB. Error: "
-                  << folly::exceptionStr(e);
-        return false;
-      }
-    } // else
-  } // if enableSegmentRouting_
+  // Report sync failure of MPLS routes after programming unicast routes
+  if (isMplsSyncFailed) {
+    return false;
+  }
 
   // Some statistics
   // NOTE: We set counter for sync time as it is one time event. We report the
@@ -1072,7 +1408,7 @@ Fib::keepAlive() noexcept {
   if (not dryrun_) {
     try {
       createFibClient(*getEvb(), client_, thriftPort_);
-      aliveSince = client_->sync_aliveSince();
+      aliveSince = client_->semifuture_aliveSince().via(getEvb()).get();
     } catch (const std::exception& e) {
       fb303::fbData->addStatValue(
           "fib.thrift.failure.keepalive", 1, fb303::COUNT);
@@ -1205,6 +1541,7 @@ Fib::transitionRouteState(const RouteState::Event event) {
   // previously installed static route should be ignored.
   if (prevState == RouteState::AWAITING && nextState == RouteState::SYNCING) {
     routeState_.unicastRoutes.clear();
+    routeState_.unicastPrefixes.clear();
     routeState_.mplsRoutes.clear();
   }
 }
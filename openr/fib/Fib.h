@@ -7,12 +7,14 @@
 
 #pragma once
 
+#include <folly/Function.h>
 #include <folly/fibers/Semaphore.h>
 #include <folly/io/async/AsyncSocket.h>
 #include <folly/io/async/AsyncTimeout.h>
 
 #include <openr/common/ExponentialBackoff.h>
 #include <openr/common/OpenrEventBase.h>
+#include <openr/common/PrefixTrie.h>
 #include <openr/config/Config.h>
 #include <openr/decision/RibEntry.h>
 #include <openr/decision/RouteUpdate.h>
@@ -69,6 +71,21 @@ class Fib final : public OpenrEventBase {
       const std::unordered_map<folly::CIDRNetwork, RibUnicastEntry>&
           unicastRoutes);
 
+  /**
+   * Priority class of a route. High priority routes are the ones other nodes
+   * need to reach us, e.g. loopbacks. These are programmed, and acknowledged,
+   * ahead of the rest on FIB sync and on bulk route updates.
+   */
+  enum class RoutePriority {
+    HIGH = 1,
+    LOW = 2,
+  };
+
+  /**
+   * Derive priority class of unicast route from its best prefix type
+   */
+  static RoutePriority getRoutePriority(const RibUnicastEntry& route);
+
   /**
    * Show unicast routes which are to be added or updated
    */
@@ -96,6 +113,15 @@ class Fib final : public OpenrEventBase {
   folly::SemiFuture<std::unique_ptr<std::vector<thrift::UnicastRoute>>>
   getUnicastRoutes(std::vector<std::string> prefixes);
 
+  /**
+   * Perform longest prefix match of each specified IP or prefix among unicast
+   * routes. Returns matched route keyed by input string. Inputs without any
+   * matching route are omitted. Fails with OpenrError on malformed input.
+   */
+  folly::SemiFuture<
+      std::unique_ptr<std::map<std::string, thrift::UnicastRoute>>>
+  longestPrefixMatchUnicastRoutes(std::vector<std::string> addresses);
+
   /**
    * Retrieve mpls routes for specified labels. Returns all if no label is
    * specified in filter list.
@@ -128,6 +154,14 @@ class Fib final : public OpenrEventBase {
    */
   thrift::PerfDatabase dumpPerfDb() const;
 
+  /**
+   * Record programming of high priority routes, started at `startTime`, as
+   * `FIB_HIGH_PRIORITY_ROUTES_PROGRAMMED` event of `perfEvents` in perfDb_
+   */
+  void recordHighPriorityRoutesProgrammed(
+      thrift::PerfEvents perfEvents,
+      const std::chrono::time_point<std::chrono::steady_clock>& startTime);
+
   /**
    * Retrieve unicast routes with specified filters
    */
@@ -164,7 +198,9 @@ class Fib final : public OpenrEventBase {
    * programming failure, prefixes are marked dirty and retryRoutesSignal is
    * invoked. If useDeleteDelay is false, delete routes without putting them in
    * dirtyPrefixes (i.e., don't delay programming). Otherwise, delay deletion
-   * based on configured duration.
+   * based on configured duration. When routes to add/update span multiple
+   * chunks, each chunk but the last is published to `fibRouteUpdatesQueue_`
+   * as soon as it is programmed.
    * @return true if all routes are successfully programmed
    */
   bool updateUnicastRoutes(
@@ -189,6 +225,33 @@ class Fib final : public OpenrEventBase {
       DecisionRouteUpdate& routeUpdate,
       thrift::RouteDatabaseDelta& routeDbDelta);
 
+  /**
+   * Program items (routes or route keys) in chunks of
+   * `Constants::kFibProgrammingChunkSize` via asynchronous FibService calls,
+   * keeping up to `Constants::kFibMaxInflightChunks` calls in flight. Only the
+   * calling fiber is suspended while awaiting responses, hence event base
+   * keeps serving other requests. `onChunkDone` is invoked for every chunk, in
+   * order, with the result of its call. Adjacent items for which
+   * `inSameChunk` holds are never split across chunks.
+   */
+  template <typename T>
+  void programInChunks(
+      std::vector<T>&& items,
+      folly::FunctionRef<folly::SemiFuture<folly::Unit>(
+          const std::vector<T>&)> program,
+      folly::FunctionRef<void(
+          const std::vector<T>&, folly::Try<folly::Unit>&&)> onChunkDone,
+      folly::FunctionRef<bool(const T&, const T&)> inSameChunk = {});
+
+  /**
+   * End of the chunk starting at `begin`, as programmed by programInChunks()
+   */
+  template <typename T>
+  static typename std::vector<T>::iterator getChunkEnd(
+      typename std::vector<T>::iterator begin,
+      typename std::vector<T>::iterator end,
+      folly::FunctionRef<bool(const T&, const T&)> inSameChunk);
+
   /**
    * Sync the current RouteState with the switch agent.
    * - On complete failure retry is scheduled
@@ -231,6 +294,10 @@ class Fib final : public OpenrEventBase {
     std::unordered_map<folly::CIDRNetwork, RibUnicastEntry> unicastRoutes;
     std::unordered_map<int32_t, RibMplsEntry> mplsRoutes;
 
+    // Longest prefix match index over keys of `unicastRoutes`. Kept in sync
+    // with it on every update.
+    PrefixTrie unicastPrefixes;
+
     /**
      * Set of route keys (prefixes & labels) that needs to be updated in HW. Two
      * reasons for dirty marking
@@ -355,6 +422,10 @@ class Fib final : public OpenrEventBase {
   // routes will be programmed only if segment routing is enabled.
   const bool enableSegmentRouting_{false};
 
+  // Config Knob - Platform shares nexthop groups among unicast routes. Routes
+  // with the same nexthops are then programmed together.
+  const bool enableNexthopGroups_{false};
+
   /*
    * Special flag handling dryrun_ case to clean up routes programmed
    * by previous incarnation.
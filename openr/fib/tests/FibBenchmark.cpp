@@ -141,6 +141,20 @@ class FibWrapper {
     return nextHops;
   }
 
+  /*
+   * Fib publishes programmed unicast routes of a large update in chunks.
+   * Consume published updates until all `numOfRoutes` routes are accounted
+   * for.
+   */
+  void
+  waitForUnicastRoutes(size_t numOfRoutes) {
+    size_t numOfPublishedRoutes{0};
+    do {
+      auto update = fibRouteUpdatesQueueReader.get().value();
+      numOfPublishedRoutes += update.unicastRoutesToUpdate.size();
+    } while (numOfPublishedRoutes < numOfRoutes);
+  }
+
   std::shared_ptr<ThriftServer> server;
   ScopedServerThread fibThriftThread;
 
@@ -202,8 +216,9 @@ BM_FibAddUnicastRoute(
             toIPNetwork(prefix), RibUnicastEntry(toIPNetwork(prefix), nhsSet));
       }
       // Send routeDB to Fib and wait for updating completing
+      const auto numOfUpdates = routeUpdate.unicastRoutesToUpdate.size();
       fibWrapper->routeUpdatesQueue.push(std::move(routeUpdate));
-      fibWrapper->fibRouteUpdatesQueueReader.get().value();
+      fibWrapper->waitForUnicastRoutes(numOfUpdates);
     }
     if (record) {
       auto mem = sysMetrics.getVirtualMemBytes();
@@ -229,8 +244,9 @@ BM_FibAddUnicastRoute(
 
       suspender.dismiss(); // Start measuring benchmark time
       // Send routeDB to Fib for updates
+      const auto numOfUpdates = routeUpdate.unicastRoutesToUpdate.size();
       fibWrapper->routeUpdatesQueue.push(std::move(routeUpdate));
-      fibWrapper->fibRouteUpdatesQueueReader.get().value();
+      fibWrapper->waitForUnicastRoutes(numOfUpdates);
       suspender.rehire(); // Stop measuring time again
     }
   }
@@ -278,8 +294,9 @@ BM_FibDeleteUnicastRoute(
             toIPNetwork(prefix), RibUnicastEntry(toIPNetwork(prefix), nhsSet));
       }
       // Send routeDB to Fib and wait for updating completing
+      const auto numOfUpdates = routeUpdate.unicastRoutesToUpdate.size();
       fibWrapper->routeUpdatesQueue.push(std::move(routeUpdate));
-      fibWrapper->fibRouteUpdatesQueueReader.get().value();
+      fibWrapper->waitForUnicastRoutes(numOfUpdates);
     }
 
     // Profile memory before the routeUpdate is generated
@@ -475,6 +492,66 @@ BM_FibDeleteMplsRoute(
   }
 }
 
+/**
+ * Benchmark for longest prefix match of unicast routes
+ * 1. Create a fib and program `numOfRoutes` /64 routes
+ * 2. Generate `numOfLookups` addresses covered by programmed routes
+ * 3. Measure bulk longest prefix match of addresses
+ */
+static void
+BM_FibLongestPrefixMatch(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    unsigned numOfRoutes,
+    unsigned numOfLookups) {
+  auto suspender = folly::BenchmarkSuspender();
+  for (uint32_t i = 0; i < iters; i++) {
+    auto fibWrapper = std::make_unique<FibWrapper>();
+
+    // Initial syncFib debounce
+    fibWrapper->routeUpdatesQueue.push(DecisionRouteUpdate());
+    fibWrapper->fibRouteUpdatesQueueReader.get().value();
+
+    auto prefixes =
+        fibWrapper->prefixGenerator.ipv6PrefixGenerator(numOfRoutes, 64);
+    {
+      DecisionRouteUpdate routeUpdate;
+      for (auto& prefix : prefixes) {
+        auto nhs = fibWrapper->prefixGenerator.getRandomNextHopsUnicast(
+            1, kVethNameY);
+        auto nhsSet =
+            std::unordered_set<thrift::NextHopThrift>(nhs.begin(), nhs.end());
+        routeUpdate.unicastRoutesToUpdate.emplace(
+            toIPNetwork(prefix), RibUnicastEntry(toIPNetwork(prefix), nhsSet));
+      }
+      const auto numOfUpdates = routeUpdate.unicastRoutesToUpdate.size();
+      fibWrapper->routeUpdatesQueue.push(std::move(routeUpdate));
+      fibWrapper->waitForUnicastRoutes(numOfUpdates);
+    }
+
+    // Host addresses within programmed prefixes
+    std::vector<std::string> addresses;
+    addresses.reserve(numOfLookups);
+    for (uint32_t index = 0; index < numOfLookups; index++) {
+      auto bytes = toIPNetwork(prefixes.at(index % prefixes.size()))
+                       .first.asV6()
+                       .toByteArray();
+      bytes.at(13) = static_cast<uint8_t>(index >> 16);
+      bytes.at(14) = static_cast<uint8_t>(index >> 8);
+      bytes.at(15) = static_cast<uint8_t>(index);
+      addresses.emplace_back(folly::IPAddressV6(bytes).str());
+    }
+
+    suspender.dismiss(); // Start measuring benchmark time
+    auto matchedRoutes =
+        fibWrapper->fib->longestPrefixMatchUnicastRoutes(std::move(addresses))
+            .get();
+    suspender.rehire(); // Stop measuring time again
+
+    counters["num_matched_routes"] = matchedRoutes->size();
+  }
+}
+
 /*
  * @params counters: reserved counter for customized profile
  * @params first integer: num of existing routes
@@ -535,6 +612,14 @@ BENCHMARK_COUNTERS_PARAM(BM_FibDeleteMplsRoute, counters, 100000, 1000);
 BENCHMARK_COUNTERS_PARAM(BM_FibDeleteMplsRoute, counters, 100000, 10000);
 BENCHMARK_COUNTERS_PARAM(BM_FibDeleteMplsRoute, counters, 100000, 100000);
 
+/*
+ * @params counters: reserved counter for customized profile
+ * @params first integer: num of existing routes
+ * @params second integer: num of addresses to look up
+ */
+BENCHMARK_COUNTERS_PARAM(BM_FibLongestPrefixMatch, counters, 1000, 1000000);
+BENCHMARK_COUNTERS_PARAM(BM_FibLongestPrefixMatch, counters, 100000, 1000000);
+
 } // namespace openr
 
 int
@@ -12,6 +12,7 @@
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 #include <thrift/lib/cpp2/util/ScopedServerThread.h>
 
+#include <openr/common/Constants.h>
 #include <openr/common/NetworkUtil.h>
 #include <openr/config/Config.h>
 #include <openr/ctrl-server/OpenrCtrlHandler.h>
@@ -313,8 +314,10 @@ checkEqualDecisionRouteUpdate(
 
 class FibTestFixture : public ::testing::Test {
  public:
-  explicit FibTestFixture(int32_t routeDeleteDelayMs = 1000)
-      : routeDeleteDelay_(routeDeleteDelayMs) {}
+  explicit FibTestFixture(
+      int32_t routeDeleteDelayMs = 1000, bool enableNexthopGroups = false)
+      : routeDeleteDelay_(routeDeleteDelayMs),
+        enableNexthopGroups_(enableNexthopGroups) {}
   void
   SetUp() override {
     mockFibHandler_ = std::make_shared<MockNetlinkFibHandler>();
@@ -334,6 +337,7 @@ class FibTestFixture : public ::testing::Test {
         true, /* enableSegmentRouting */
         false /* dryrun */);
     tConfig.route_delete_delay_ms() = routeDeleteDelay_;
+    tConfig.enable_fib_nexthop_groups() = enableNexthopGroups_;
     tConfig.fib_port() = fibThriftThread.getAddress()->getPort();
 
     config_ = std::make_shared<Config>(tConfig);
@@ -418,6 +422,17 @@ class FibTestFixture : public ::testing::Test {
     return *resp;
   }
 
+  std::map<std::string, thrift::UnicastRoute>
+  longestPrefixMatchUnicastRoutes(std::vector<std::string> addresses) {
+    auto resp = handler_
+                    ->semifuture_longestPrefixMatchUnicastRoutes(
+                        std::make_unique<std::vector<std::string>>(
+                            std::move(addresses)))
+                    .get();
+    EXPECT_TRUE(resp);
+    return *resp;
+  }
+
   std::vector<thrift::UnicastRoute>
   getUnicastRoutes() {
     auto resp = handler_->semifuture_getUnicastRoutes().get();
@@ -535,6 +550,13 @@ class FibTestFixture : public ::testing::Test {
 
  private:
   const int32_t routeDeleteDelay_{0};
+  const bool enableNexthopGroups_{false};
+};
+
+class FibNexthopGroupsTestFixture : public FibTestFixture {
+ public:
+  FibNexthopGroupsTestFixture()
+      : FibTestFixture(1000, true /* enableNexthopGroups */) {}
 };
 
 class FibDryRunTestFixture : public ::testing::Test {
@@ -1280,6 +1302,18 @@ TEST_F(FibTestFixture, getUnicastRoutesFilteredTest) {
   const auto& notFoundResp =
       getUnicastRoutesFiltered(std::move(notFoundFilter));
   EXPECT_EQ(notFoundResp.size(), 0);
+
+  // check bulk longest prefix match API - matched routes keyed by input
+  const auto& matchedRoutes = longestPrefixMatchUnicastRoutes(
+      {"192.168.20.19", "192.168.0.0/18", "fd00::48:2:1", "10.46.8.0"});
+  EXPECT_EQ(matchedRoutes.size(), 3);
+  EXPECT_EQ(matchedRoutes.at("192.168.20.19"), tRoute1);
+  EXPECT_EQ(matchedRoutes.at("192.168.0.0/18"), tRoute2);
+  EXPECT_EQ(matchedRoutes.at("fd00::48:2:1"), tRoute4);
+
+  // check invalid input is rejected
+  EXPECT_THROW(
+      longestPrefixMatchUnicastRoutes({"192.168.0.0/33"}), thrift::OpenrError);
 }
 
 TEST_F(FibTestFixture, longestPrefixMatchTest) {
@@ -1418,6 +1452,176 @@ TEST_F(FibTestFixture, doNotInstall) {
   EXPECT_EQ(routes.size(), 2);
 }
 
+/**
+ * Validates route update larger than a chunk is programmed in multiple calls
+ * and programmed chunks are published as they complete. Last chunk is
+ * published along with the rest of the update.
+ */
+TEST_F(FibTestFixture, ChunkedRouteProgramming) {
+  // initial syncFib debounce
+  routeUpdatesQueue.push(DecisionRouteUpdate());
+  mockFibHandler_->waitForSyncFib();
+  EXPECT_EQ(
+      DecisionRouteUpdate::FULL_SYNC,
+      fibRouteUpdatesQueueReader.get().value().type);
+
+  // Route update spanning three chunks
+  const auto kChunkSize = Constants::kFibProgrammingChunkSize;
+  const size_t numRoutes = 2 * kChunkSize + 1;
+  DecisionRouteUpdate routeUpdate;
+  for (size_t i = 0; i < numRoutes; ++i) {
+    const auto prefix =
+        toIpPrefix(fmt::format("10.{}.{}.0/24", i / 256, i % 256));
+    const auto nexthop = createNextHop(
+        toBinaryAddress(folly::IPAddress(fmt::format("fe80::{:x}", i + 1))),
+        std::string("iface_1_2_1"),
+        1);
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix), {nexthop}));
+  }
+  routeUpdatesQueue.push(routeUpdate);
+
+  // First two chunks are published as they're programmed
+  std::unordered_set<folly::CIDRNetwork> publishedPrefixes;
+  for (size_t i = 0; i < 3; ++i) {
+    auto update = fibRouteUpdatesQueueReader.get().value();
+    EXPECT_EQ(DecisionRouteUpdate::INCREMENTAL, update.type);
+    EXPECT_EQ(i < 2 ? kChunkSize : 1, update.unicastRoutesToUpdate.size());
+    EXPECT_TRUE(update.unicastRoutesToDelete.empty());
+    for (const auto& [prefix, route] : update.unicastRoutesToUpdate) {
+      EXPECT_EQ(routeUpdate.unicastRoutesToUpdate.at(prefix), route);
+      publishedPrefixes.emplace(prefix);
+    }
+  }
+  EXPECT_EQ(numRoutes, publishedPrefixes.size());
+
+  std::vector<thrift::UnicastRoute> routes;
+  mockFibHandler_->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(numRoutes, routes.size());
+  EXPECT_EQ(numRoutes, mockFibHandler_->getAddRoutesCount());
+}
+
+/**
+ * Validates routes sharing nexthops are programmed in the same call, if they
+ * fit in a chunk, so platform can update their nexthop group in place.
+ */
+TEST_F(FibNexthopGroupsTestFixture, ChunkedRouteProgrammingKeepsNexthopGroups) {
+  // initial syncFib debounce
+  routeUpdatesQueue.push(DecisionRouteUpdate());
+  mockFibHandler_->waitForSyncFib();
+  EXPECT_EQ(
+      DecisionRouteUpdate::FULL_SYNC,
+      fibRouteUpdatesQueueReader.get().value().type);
+
+  // Two groups of routes, each larger than half a chunk, interleaved
+  const auto kChunkSize = Constants::kFibProgrammingChunkSize;
+  const size_t numGroupRoutes = kChunkSize / 2 + 100;
+  DecisionRouteUpdate routeUpdate;
+  for (size_t i = 0; i < 2 * numGroupRoutes; ++i) {
+    const auto prefix =
+        toIpPrefix(fmt::format("10.{}.{}.0/24", i / 256, i % 256));
+    if (i % 2) {
+      routeUpdate.addRouteToUpdate(
+          RibUnicastEntry(toIPNetwork(prefix), {path1_2_3}));
+    } else {
+      routeUpdate.addRouteToUpdate(
+          RibUnicastEntry(toIPNetwork(prefix), {path1_2_1, path1_2_2}));
+    }
+  }
+  routeUpdatesQueue.push(routeUpdate);
+
+  // Every group is programmed in a single call of its own
+  size_t numPublished{0};
+  while (numPublished < 2 * numGroupRoutes) {
+    numPublished +=
+        fibRouteUpdatesQueueReader.get().value().unicastRoutesToUpdate.size();
+  }
+  EXPECT_THAT(
+      mockFibHandler_->getAddRoutesBatchSizes(),
+      testing::UnorderedElementsAre(numGroupRoutes, numGroupRoutes));
+  EXPECT_EQ(2 * numGroupRoutes, mockFibHandler_->getAddRoutesCount());
+}
+
+/**
+ * Validates routes sharing nexthops are still programmed and published in
+ * chunks if they exceed a chunk, e.g. bulk of ECMP routes in a fabric.
+ */
+TEST_F(FibNexthopGroupsTestFixture, ChunkedRouteProgrammingSplitsLargeGroup) {
+  // initial syncFib debounce
+  routeUpdatesQueue.push(DecisionRouteUpdate());
+  mockFibHandler_->waitForSyncFib();
+  EXPECT_EQ(
+      DecisionRouteUpdate::FULL_SYNC,
+      fibRouteUpdatesQueueReader.get().value().type);
+
+  // Route update spanning three chunks, all routes via the same nexthops
+  const auto kChunkSize = Constants::kFibProgrammingChunkSize;
+  const size_t numRoutes = 2 * kChunkSize + 1;
+  DecisionRouteUpdate routeUpdate;
+  for (size_t i = 0; i < numRoutes; ++i) {
+    const auto prefix =
+        toIpPrefix(fmt::format("10.{}.{}.0/24", i / 256, i % 256));
+    routeUpdate.addRouteToUpdate(
+        RibUnicastEntry(toIPNetwork(prefix), {path1_2_1, path1_2_2}));
+  }
+  routeUpdatesQueue.push(routeUpdate);
+
+  // First two chunks are published as they're programmed
+  for (size_t i = 0; i < 3; ++i) {
+    auto update = fibRouteUpdatesQueueReader.get().value();
+    EXPECT_EQ(i < 2 ? kChunkSize : 1, update.unicastRoutesToUpdate.size());
+  }
+  EXPECT_THAT(
+      mockFibHandler_->getAddRoutesBatchSizes(),
+      testing::UnorderedElementsAre(kChunkSize, kChunkSize, 1));
+  EXPECT_EQ(numRoutes, mockFibHandler_->getAddRoutesCount());
+}
+
+TEST_F(FibTestFixture, HighPriorityRouteProgramming) {
+  // initial syncFib debounce
+  routeUpdatesQueue.push(DecisionRouteUpdate());
+  mockFibHandler_->waitForSyncFib();
+  EXPECT_EQ(
+      DecisionRouteUpdate::FULL_SYNC,
+      fibRouteUpdatesQueueReader.get().value().type);
+
+  // Route update with a loopback prefix among bulk BGP prefixes
+  DecisionRouteUpdate routeUpdate;
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1}, bestRoute1, "0"));
+  routeUpdate.addRouteToUpdate(RibUnicastEntry(
+      toIPNetwork(prefix2),
+      {path1_2_1},
+      createPrefixEntry(prefix2, thrift::PrefixType::BGP),
+      "0"));
+  routeUpdate.addRouteToUpdate(RibUnicastEntry(
+      toIPNetwork(prefix3),
+      {path1_2_2},
+      createPrefixEntry(prefix3, thrift::PrefixType::BGP),
+      "0"));
+  routeUpdate.perfEvents = thrift::PerfEvents();
+  addPerfEvent(*routeUpdate.perfEvents, "node-1", "DECISION_RECEIVED");
+  routeUpdatesQueue.push(routeUpdate);
+
+  // Loopback route is programmed and published ahead of the rest
+  auto update = fibRouteUpdatesQueueReader.get().value();
+  EXPECT_EQ(1, update.unicastRoutesToUpdate.size());
+  EXPECT_EQ(1, update.unicastRoutesToUpdate.count(toIPNetwork(prefix1)));
+  update = fibRouteUpdatesQueueReader.get().value();
+  EXPECT_EQ(2, update.unicastRoutesToUpdate.size());
+  EXPECT_EQ(0, update.unicastRoutesToUpdate.count(toIPNetwork(prefix1)));
+  EXPECT_EQ(3, mockFibHandler_->getAddRoutesCount());
+
+  // Time to program it is recorded in perf database
+  auto perfDb = handler_->semifuture_getPerfDb().get();
+  ASSERT_EQ(1, perfDb->eventInfo()->size());
+  const auto& events = *perfDb->eventInfo()->back().events();
+  ASSERT_EQ(3, events.size());
+  EXPECT_EQ("FIB_ROUTE_DB_RECVD", *events.at(1).eventDescr());
+  EXPECT_EQ(
+      "FIB_HIGH_PRIORITY_ROUTES_PROGRAMMED", *events.at(2).eventDescr());
+}
+
 /**
  * Validates FIB synchronization logic and its error handling. This handles
  * re-sync logic of FIB as well.
@@ -1577,6 +1781,48 @@ TEST_F(FibTestFixture, SyncFibProgramming) {
   EXPECT_EQ(0, fibRouteUpdatesQueueReader.size());
 }
 
+/**
+ * Failure to sync MPLS routes doesn't hold back unicast routes. Sync is
+ * reported failed (no publication) and retried until MPLS routes are synced.
+ */
+TEST_F(FibTestFixture, SyncFibWithMplsFailure) {
+  std::vector<thrift::UnicastRoute> routes;
+  std::vector<thrift::MplsRoute> mplsRoutes;
+
+  // Reject MPLS route sync before the first RIB update
+  mockFibHandler_->setMplsSyncHealthyState(false);
+
+  DecisionRouteUpdate routeUpdate;
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix1), {path1_2_1}));
+  routeUpdate.addRouteToUpdate(
+      RibUnicastEntry(toIPNetwork(prefix2), {path1_2_1}));
+  routeUpdate.addMplsRouteToUpdate(RibMplsEntry(label1, {mpls_path1_2_1}));
+  routeUpdate.addMplsRouteToUpdate(RibMplsEntry(label2, {mpls_path1_2_1}));
+  routeUpdatesQueue.push(routeUpdate);
+
+  // Unicast routes get programmed, MPLS routes and publication don't
+  mockFibHandler_->waitForSyncFib();
+  mockFibHandler_->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(2, routes.size());
+  mockFibHandler_->getMplsRouteTableByClient(mplsRoutes, kFibId);
+  EXPECT_EQ(0, mplsRoutes.size());
+  EXPECT_EQ(0, fibRouteUpdatesQueueReader.size());
+
+  // Accept MPLS route sync & wait for retry to program MPLS routes
+  mockFibHandler_->setMplsSyncHealthyState(true);
+  mockFibHandler_->waitForSyncMplsFib();
+  mockFibHandler_->getRouteTableByClient(routes, kFibId);
+  EXPECT_EQ(2, routes.size());
+  mockFibHandler_->getMplsRouteTableByClient(mplsRoutes, kFibId);
+  EXPECT_EQ(2, mplsRoutes.size());
+
+  // Fib should produce a publication once sync succeeds
+  routeUpdate.type = DecisionRouteUpdate::FULL_SYNC;
+  checkEqualDecisionRouteUpdate(
+      routeUpdate, fibRouteUpdatesQueueReader.get().value());
+}
+
 /**
  * Validates incremental route programming and its error handling.
  * - Add P1/L1
@@ -15,6 +15,7 @@ namespace hack OpenrKvStore
 namespace rust openr_kvstore_thrift
 
 include "fb303/thrift/fb303_core.thrift"
+include "openr/if/Dual.thrift"
 include "thrift/annotation/cpp.thrift"
 include "thrift/annotation/thrift.thrift"
 
@@ -156,6 +157,13 @@ struct Value {
 @cpp.Type{name = "std::unordered_map<std::string, openr::thrift::Value>"}
 typedef map<string, Value> KeyVals
 
+/**
+ * KeySetParams serialized with compact protocol. Using `folly::IOBuf` in C++
+ * so that one encoded buffer can be shared by requests to many peers.
+ */
+@cpp.Type{name = "std::unique_ptr<folly::IOBuf>"}
+typedef binary KeySetParamsPayload
+
 /**
  * Map of key to reason for not merging.
  */
@@ -214,6 +222,12 @@ struct KeySetParams {
    */
   5: optional list<string> nodeIds;
 
+  /**
+   * Optional attribute. Root-id of the flooding spanning tree along which
+   * this publication is flooded. Unset means flooding to all peers.
+   */
+  6: optional string floodRootId;
+
   /**
    * Optional attribute to indicate timestamp when request is sent. This is
    * system timestamp in milliseconds since epoch
@@ -282,6 +296,54 @@ struct KeyDumpParams {
    * ID representing sender of the request.
    */
   8: optional string senderId;
+
+  /**
+   * Optional attribute to restrict the response to keys falling into these
+   * leaves of the KvStore hash tree. Set along with `keyValHashes` as the last
+   * step of a hash tree full-sync.
+   */
+  9: optional list<i64> hashTreeLeaves;
+}
+
+/**
+ * Request object for walking the KvStore hash tree of a peer.
+ *
+ * Every key falls into one leaf of a fixed shape tree, picked by the hash of
+ * the key. Each tree node carries a digest of all key-vals underneath it, so
+ * full-sync initiator only needs to descend into nodes whose digest differs.
+ */
+struct KvStoreHashTreeParams {
+  /**
+   * Level of the requested tree nodes, root being level 0
+   */
+  1: i32 level;
+
+  /**
+   * Index of tree nodes within `level` whose children digests are requested
+   */
+  2: list<i64> nodes;
+
+  /**
+   * ID representing sender of the request.
+   */
+  3: optional string senderId;
+}
+
+/**
+ * Response object for walking the KvStore hash tree of a peer
+ */
+struct KvStoreHashTreeResult {
+  /**
+   * Shape of the hash tree. Initiator falls back to plain full-sync if this
+   * differs from its own.
+   */
+  1: i32 fanout;
+  2: i32 depth;
+
+  /**
+   * `fanout` children digests for each requested node, in request order
+   */
+  3: list<i64> childHashes;
 }
 
 /**
@@ -373,6 +435,12 @@ struct Publication {
    */
   5: optional list<string> tobeUpdatedKeys;
 
+  /**
+   * Optional attribute. Root-id of the flooding spanning tree along which
+   * this publication is flooded. Unset means flooding to all peers.
+   */
+  6: optional string floodRootId;
+
   /**
    * KvStore Area to which this publication belongs
    */
@@ -385,6 +453,78 @@ struct Publication {
   8: optional i64 timestamp_ms;
 }
 
+/**
+ * Request object to set/unset sender as a child of the flooding spanning tree
+ * rooted at `rootId`. Sent by a node to its old and new SPT parent upon
+ * nexthop change.
+ */
+struct FloodTopoSetParams {
+  /**
+   * Root-id of the spanning tree
+   */
+  1: string rootId;
+
+  /**
+   * Sender node-id, aka, the child
+   */
+  2: string srcId;
+
+  /**
+   * Set or unset the child
+   */
+  3: bool setChild;
+}
+
+/**
+ * Flooding spanning tree information for a single root
+ */
+struct SptInfo {
+  /**
+   * DUAL state is PASSIVE(converged) or not
+   */
+  1: bool passive;
+
+  /**
+   * Distance towards the root
+   */
+  2: i64 cost;
+
+  /**
+   * SPT parent, aka, DUAL nexthop towards the root
+   */
+  3: optional string parent;
+
+  /**
+   * SPT children
+   */
+  4: set<string> children;
+}
+
+/**
+ * Flooding spanning tree information of a KvStoreDb
+ */
+struct SptInfos {
+  /**
+   * map<root-id: SptInfo> for all discovered roots
+   */
+  1: map<string, SptInfo> infos;
+
+  /**
+   * DUAL message counters
+   */
+  2: Dual.DualCounters counters;
+
+  /**
+   * Root-id picked for publications originated by this node
+   */
+  3: optional string floodRootId;
+
+  /**
+   * Peers this node currently floods its own publications to
+   */
+  4: set<string> floodPeers;
+}
+
 /**
  * Struct summarizing KvStoreDB for a given area. This is currently used for
  * sending responses to 'breeze kvstore summary'
@@ -464,6 +604,45 @@ struct KvStoreConfig {
   15: i32 sync_initial_backoff_ms = 4000;
   16: i32 sync_max_backoff_ms = 256000;
   17: optional i32 self_adjacency_timeout_ms;
+
+  /**
+   * Knob to enable hash tree based full-sync. Instead of sending hashes of
+   * all keys, initiator walks down peer's KvStore hash tree and exchanges
+   * key-vals only for leaves that differ. Falls back to plain full-sync with
+   * peers not supporting it.
+   */
+  18: bool enable_hash_tree_sync = false;
+
+  /**
+   * Knob to serialize flooded publications once and share the encoded buffer
+   * among all peers, instead of letting thrift client re-serialize the same
+   * key-vals for every peer. Falls back to per-peer serialization with peers
+   * not supporting it.
+   */
+  19: bool enable_serialized_flooding = false;
+
+  /**
+   * Knob to run DUAL over peer adjacencies and flood publications along the
+   * resulting spanning tree only, instead of over every peer. Falls back to
+   * flooding to all peers while DUAL is not converged and for peers not
+   * supporting it.
+   */
+  20: bool enable_flood_optimization = false;
+
+  /**
+   * Whether this node is a candidate root of the flooding spanning tree. The
+   * smallest node-id among reachable roots is used.
+   */
+  21: bool is_flood_root = false;
+
+  /**
+   * Knob to enable per-peer flood control. Number of in-flight flooding
+   * requests towards each peer is bounded by a window adapted on the peer's
+   * response latency. Updates to a backlogged peer are coalesced per key and
+   * sent as soon as the peer returns credit, without holding back flooding to
+   * other peers.
+   */
+  22: bool enable_peer_flood_control = false;
 }
 
 /**
@@ -517,6 +696,15 @@ service KvStoreService extends fb303_core.BaseService {
     2: string area,
   ) throws (1: KvStoreError error);
 
+  /**
+   * Get children digests of KvStore hash tree nodes in given area. Used by
+   * hash tree full-sync to walk down mismatching subtrees only
+   */
+  KvStoreHashTreeResult getKvStoreHashTreeArea(
+    1: KvStoreHashTreeParams params,
+    2: string area,
+  ) throws (1: KvStoreError error);
+
   /**
    * Set/Update key-values in KvStore.
    */
@@ -524,6 +712,37 @@ service KvStoreService extends fb303_core.BaseService {
     1: KvStoreError error,
   );
 
+  /**
+   * Same as setKvStoreKeyVals, but with KeySetParams already serialized with
+   * compact protocol. Used by flooding to encode a publication only once.
+   */
+  void setKvStoreKeyValsSerialized(
+    1: KeySetParamsPayload setParamsPayload,
+    2: string area,
+  ) throws (1: KvStoreError error);
+
+  /**
+   * Process DUAL messages from a peer. Used by flood optimization to build
+   * the flooding spanning tree.
+   */
+  void processKvStoreDualMessage(
+    1: Dual.DualMessages messages,
+    2: string area,
+  ) throws (1: KvStoreError error);
+
+  /**
+   * Set/unset sender as a child of the flooding spanning tree
+   */
+  void updateFloodTopologyChild(
+    1: FloodTopoSetParams params,
+    2: string area,
+  ) throws (1: KvStoreError error);
+
+  /**
+   * Get flooding spanning tree information of given area
+   */
+  SptInfos getSpanningTreeInfos(1: string area) throws (1: KvStoreError error);
+
   /**
    * Set/Update key-values in KvStore.
    * Return information on why the key is not merged
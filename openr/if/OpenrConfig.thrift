@@ -99,6 +99,19 @@ enum RouteSelectionAlgorithm {
   PER_AREA_SHORTEST_DISTANCE = 2,
 }
 
+/**
+ * Priority queue used by Decision's SPF computation
+ */
+enum SpfQueueType {
+  /** Indexed 4-ary heap with in place decrease-key. */
+  DARY_HEAP = 0,
+  /**
+   * Monotone radix heap. Amortized cheaper operations for integer metrics,
+   * especially with large metric values such as RTT based metrics.
+   */
+  RADIX_HEAP = 1,
+}
+
 struct DecisionConfig {
   /** Fast reaction time to update decision SPF upon receiving adj db update
   (in milliseconds). */
@@ -114,6 +127,20 @@ struct DecisionConfig {
   4: i32 save_rib_policy_max_ms = 60000;
   /** After initial KV store sync completes, wait for this timeout. If initial route computation is still blocked when the timeout expires, force initial route computation. */
   5: i32 unblock_initial_routes_ms = 120000;
+  /**
+   * Repair memoized SPF results in place on link events (metric change, link
+   * up/down) instead of re-running SPF from scratch on any topology change.
+   * Node hard-drain changes still invalidate all SPF results.
+   */
+  6: bool enable_incremental_spf = false;
+  /** Priority queue implementation used to run SPF. */
+  7: SpfQueueType spf_queue_type = SpfQueueType.DARY_HEAP;
+  /**
+   * Number of threads used to build routes on a full route rebuild. With more
+   * than one thread, SPF of each area runs concurrently and prefixes are
+   * partitioned across the threads. 1 builds routes on the Decision thread.
+   */
+  8: i32 route_build_threads = 1;
 }
 
 struct LinkMonitorConfig {
@@ -645,4 +672,30 @@ struct OpenrConfig {
  * ATTN: All of the temp config knobs serving for gradual rollout purpose use
  * id range of 200 - 300
  */
+
+  /**
+   * Number of shard keys PrefixManager packs advertised prefixes into, per
+   * area. Each prefix is hashed into one of the shards, and each shard is
+   * advertised as a single `prefix:<node>:shard:<id>` key carrying all of its
+   * prefix entries. This cuts number of keys (and their TTL refreshes) for
+   * nodes advertising many prefixes. 0 advertises one key per prefix.
+   *
+   * Number of shards is fixed and shards are never split, so prefixes per
+   * shard grow linearly with advertised prefixes. A change to any prefix
+   * re-serializes and re-floods its whole shard, and a shard value must fit
+   * into a single KvStore key-value. Size it to keep shards at or below
+   * ~1000 prefixes, i.e. ceil(max advertised prefixes per area / 1000), and
+   * watch `prefix_manager.max_shard_prefixes` for the largest shard.
+   *
+   * Decision always understands both formats.
+   */
+  200: i32 prefix_db_num_shards = 0;
+
+  /**
+   * Set if platform programs unicast routes via shared nexthop groups, e.g.
+   * Linux platform with `--enable_nexthop_groups`. Fib then programs routes
+   * with the same nexthops in the same call, up to a programming chunk, so
+   * that platform can update their shared group in place.
+   */
+  201: bool enable_fib_nexthop_groups = false;
 }
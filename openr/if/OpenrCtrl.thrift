@@ -433,6 +433,15 @@ service OpenrCtrl extends KvStore.KvStoreService {
    */
   list<Network.UnicastRoute> getUnicastRoutes() throws (1: OpenrError error);
 
+  /**
+   * Bulk longest prefix match of IP addresses (or prefixes) among unicast
+   * routes from FIB module. Returns matched route keyed by the input string.
+   * Inputs without any matching route are not present in the result.
+   */
+  map<string, Network.UnicastRoute> longestPrefixMatchUnicastRoutes(
+    1: list<string> addresses,
+  ) throws (1: OpenrError error);
+
   /**
    * Get Mpls routes after applying a list of prefix filter.
    * Return all Mpls routes if the input list is empty.
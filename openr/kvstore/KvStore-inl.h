@@ -8,6 +8,7 @@
 #include <fb303/ServiceData.h>
 #include <folly/io/async/SSLContext.h>
 #include <folly/logging/xlog.h>
+#include <thrift/lib/cpp/TApplicationException.h>
 
 #include <openr/common/Constants.h>
 #include <openr/common/EventLogger.h>
@@ -390,26 +391,34 @@ KvStore<ClientType>::dumpKvStoreKeysImpl(
         oper = *keyDumpParams.oper();
       }
 
-      thrift::Publication thriftPub;
-      try {
-        const auto keyPrefixMatch = KvStoreFilters(
-            *keyDumpParams.keys(), *keyDumpParams.originatorIds(), oper);
-        thriftPub = dumpAllWithFilters(
+      // dump all keys or only keys in given hash tree leaves
+      auto dumpKeys = [&](KvStoreFilters const& keyPrefixMatch) {
+        if (keyDumpParams.hashTreeLeaves().has_value()) {
+          return dumpAllWithLeaves(
+              area,
+              kvStoreDb.getKeyValueMap(),
+              kvStoreDb.getHashTree(),
+              *keyDumpParams.hashTreeLeaves(),
+              keyPrefixMatch,
+              *keyDumpParams.doNotPublishValue());
+        }
+        return dumpAllWithFilters(
             area,
             kvStoreDb.getKeyValueMap(),
             keyPrefixMatch,
             *keyDumpParams.doNotPublishValue());
+      };
+
+      thrift::Publication thriftPub;
+      try {
+        thriftPub = dumpKeys(KvStoreFilters(
+            *keyDumpParams.keys(), *keyDumpParams.originatorIds(), oper));
       } catch (RegexSetException const& err) {
         XLOG(ERR) << fmt::format(
             "Fail to create KvStoreFilters with exception: {}. Dump without filter",
             folly::exceptionStr(err));
-        const auto keyPrefixMatch =
-            KvStoreFilters({}, *keyDumpParams.originatorIds(), oper);
-        thriftPub = dumpAllWithFilters(
-            area,
-            kvStoreDb.getKeyValueMap(),
-            keyPrefixMatch,
-            *keyDumpParams.doNotPublishValue());
+        thriftPub =
+            dumpKeys(KvStoreFilters({}, *keyDumpParams.originatorIds(), oper));
       }
 
       if (keyDumpParams.keyValHashes().has_value()) {
@@ -523,6 +532,125 @@ KvStore<ClientType>::semifuture_dumpKvStoreHashes(
   return sf;
 }
 
+template <class ClientType>
+thrift::KvStoreHashTreeResult
+KvStore<ClientType>::getKvStoreHashTreeImpl(
+    std::string area, thrift::KvStoreHashTreeParams params) {
+  const auto senderStr =
+      (params.senderId().has_value() ? params.senderId().value() : "");
+  XLOG(DBG3) << fmt::format(
+      "Hash tree level: {} with {} nodes requested for AREA: {}, by sender: {}",
+      *params.level(),
+      params.nodes()->size(),
+      area,
+      senderStr);
+  auto& kvStoreDb = getAreaDbOrThrow(area, "getKvStoreHashTreeImpl");
+  fb303::fbData->addStatValue("kvstore.cmd_hash_tree_dump", 1, fb303::COUNT);
+
+  thrift::KvStoreHashTreeResult result;
+  result.fanout() = KvStoreHashTree::kFanout;
+  result.depth() = KvStoreHashTree::kDepth;
+  try {
+    result.childHashes() = kvStoreDb.getHashTree().getChildHashes(
+        *params.level(), *params.nodes());
+  } catch (std::out_of_range const& e) {
+    throw thrift::KvStoreError(e.what());
+  }
+  return result;
+}
+
+template <class ClientType>
+folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+KvStore<ClientType>::semifuture_getKvStoreHashTree(
+    std::string area, thrift::KvStoreHashTreeParams params) {
+  folly::Promise<std::unique_ptr<thrift::KvStoreHashTreeResult>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [this, p = std::move(p), params = std::move(params), area]() mutable {
+        try {
+          auto result =
+              getKvStoreHashTreeImpl(std::move(area), std::move(params));
+          p.setValue(std::make_unique<thrift::KvStoreHashTreeResult>(
+              std::move(result)));
+        } catch (thrift::KvStoreError const& e) {
+          p.setException(e);
+        }
+      });
+  return sf;
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStore<ClientType>::semifuture_processKvStoreDualMessage(
+    std::string area, thrift::DualMessages messages) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [this, p = std::move(p), messages = std::move(messages), area]() mutable {
+        XLOG(DBG3) << fmt::format(
+            "Dual messages received for AREA: {}, from: {}",
+            area,
+            *messages.srcId());
+        try {
+          auto& kvStoreDb = getAreaDbOrThrow(area, "processKvStoreDualMessage");
+          if (not kvParams_.enableFloodOptimization) {
+            // let peer know that we don't participate in flooding SPT
+            throw thrift::KvStoreError("Flood optimization is not enabled");
+          }
+          fb303::fbData->addStatValue(
+              "kvstore.cmd_dual_messages", 1, fb303::COUNT);
+          kvStoreDb.processDualMessages(messages);
+          p.setValue();
+        } catch (thrift::KvStoreError const& e) {
+          p.setException(e);
+        }
+      });
+  return sf;
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStore<ClientType>::semifuture_updateFloodTopologyChild(
+    std::string area, thrift::FloodTopoSetParams params) {
+  folly::Promise<folly::Unit> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread(
+      [this, p = std::move(p), params = std::move(params), area]() mutable {
+        try {
+          auto& kvStoreDb = getAreaDbOrThrow(area, "updateFloodTopologyChild");
+          if (not kvParams_.enableFloodOptimization) {
+            throw thrift::KvStoreError("Flood optimization is not enabled");
+          }
+          fb303::fbData->addStatValue(
+              "kvstore.cmd_flood_topo_set", 1, fb303::COUNT);
+          kvStoreDb.processFloodTopoSet(params);
+          p.setValue();
+        } catch (thrift::KvStoreError const& e) {
+          p.setException(e);
+        }
+      });
+  return sf;
+}
+
+template <class ClientType>
+folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+KvStore<ClientType>::semifuture_getSpanningTreeInfos(std::string area) {
+  folly::Promise<std::unique_ptr<thrift::SptInfos>> p;
+  auto sf = p.getSemiFuture();
+  runInEventBaseThread([this, p = std::move(p), area]() mutable {
+    try {
+      auto& kvStoreDb = getAreaDbOrThrow(area, "getSpanningTreeInfos");
+      fb303::fbData->addStatValue(
+          "kvstore.cmd_flood_topo_get", 1, fb303::COUNT);
+      p.setValue(std::make_unique<thrift::SptInfos>(
+          kvStoreDb.processFloodTopoGet()));
+    } catch (thrift::KvStoreError const& e) {
+      p.setException(e);
+    }
+  });
+  return sf;
+}
+
 template <class ClientType>
 folly::SemiFuture<folly::Unit>
 KvStore<ClientType>::semifuture_setKvStoreKeyVals(
@@ -961,6 +1089,8 @@ KvStore<ClientType>::initGlobalCounters() {
       "kvstore.thrift.num_flood_pub_success", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_flood_pub_failure", fb303::COUNT);
+  fb303::fbData->addStatExportType(
+      "kvstore.thrift.num_flood_pub_backlogged", fb303::COUNT);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_finalized_sync", fb303::COUNT);
   fb303::fbData->addStatExportType(
@@ -972,6 +1102,8 @@ KvStore<ClientType>::initGlobalCounters() {
       "kvstore.thrift.full_sync_duration_ms", fb303::AVG);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.flood_pub_duration_ms", fb303::AVG);
+  fb303::fbData->addStatExportType(
+      "kvstore.thrift.flood_window", fb303::AVG);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.finalized_sync_duration_ms", fb303::AVG);
 
@@ -979,6 +1111,8 @@ KvStore<ClientType>::initGlobalCounters() {
       "kvstore.thrift.num_missing_keys", fb303::SUM);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_flood_key_vals", fb303::SUM);
+  fb303::fbData->addStatExportType(
+      "kvstore.thrift.num_flood_backlog_key_vals", fb303::SUM);
   fb303::fbData->addStatExportType(
       "kvstore.thrift.num_keyvals_update", fb303::SUM);
 
@@ -1288,6 +1422,30 @@ KvStoreDb<ClientType>::KvStorePeer::setKvStoreKeyValsWrapper(
   }
 }
 
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreDb<ClientType>::KvStorePeer::setKvStoreKeyValsSerializedWrapper(
+    const std::string& area,
+    const std::unique_ptr<folly::IOBuf>& setParamsPayload) {
+  if (not kvParams_.enable_secure_thrift_client) {
+    return plainTextClient->semifuture_setKvStoreKeyValsSerialized(
+        setParamsPayload, area);
+  }
+  // TLS fallback
+  try {
+    return secureClient->semifuture_setKvStoreKeyValsSerialized(
+        setParamsPayload, area);
+  } catch (const folly::AsyncSocketException& ex) {
+    XLOG(ERR) << fmt::format("{} got exception: {}", __FUNCTION__, ex.what());
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.semifuture_setKvStoreKeyValsSerialized.secure_client.failure",
+        1,
+        fb303::COUNT);
+    return plainTextClient->semifuture_setKvStoreKeyValsSerialized(
+        setParamsPayload, area);
+  }
+}
+
 template <class ClientType>
 folly::SemiFuture<thrift::Publication>
 KvStoreDb<ClientType>::KvStorePeer::getKvStoreKeyValsFilteredAreaWrapper(
@@ -1310,6 +1468,68 @@ KvStoreDb<ClientType>::KvStorePeer::getKvStoreKeyValsFilteredAreaWrapper(
   }
 }
 
+template <class ClientType>
+folly::SemiFuture<thrift::KvStoreHashTreeResult>
+KvStoreDb<ClientType>::KvStorePeer::getKvStoreHashTreeAreaWrapper(
+    const thrift::KvStoreHashTreeParams& params, const std::string& area) {
+  if (not kvParams_.enable_secure_thrift_client) {
+    return plainTextClient->semifuture_getKvStoreHashTreeArea(params, area);
+  }
+  // TLS fallback
+  try {
+    return secureClient->semifuture_getKvStoreHashTreeArea(params, area);
+  } catch (const folly::AsyncSocketException& ex) {
+    XLOG(ERR) << fmt::format("{} got exception: {}", __FUNCTION__, ex.what());
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.semifuture_getKvStoreHashTreeArea.secure_client.failure",
+        1,
+        fb303::COUNT);
+    return plainTextClient->semifuture_getKvStoreHashTreeArea(params, area);
+  }
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreDb<ClientType>::KvStorePeer::processKvStoreDualMessageWrapper(
+    const thrift::DualMessages& messages, const std::string& area) {
+  if (not kvParams_.enable_secure_thrift_client) {
+    return plainTextClient->semifuture_processKvStoreDualMessage(
+        messages, area);
+  }
+  // TLS fallback
+  try {
+    return secureClient->semifuture_processKvStoreDualMessage(messages, area);
+  } catch (const folly::AsyncSocketException& ex) {
+    XLOG(ERR) << fmt::format("{} got exception: {}", __FUNCTION__, ex.what());
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.semifuture_processKvStoreDualMessage.secure_client.failure",
+        1,
+        fb303::COUNT);
+    return plainTextClient->semifuture_processKvStoreDualMessage(
+        messages, area);
+  }
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreDb<ClientType>::KvStorePeer::updateFloodTopologyChildWrapper(
+    const thrift::FloodTopoSetParams& params, const std::string& area) {
+  if (not kvParams_.enable_secure_thrift_client) {
+    return plainTextClient->semifuture_updateFloodTopologyChild(params, area);
+  }
+  // TLS fallback
+  try {
+    return secureClient->semifuture_updateFloodTopologyChild(params, area);
+  } catch (const folly::AsyncSocketException& ex) {
+    XLOG(ERR) << fmt::format("{} got exception: {}", __FUNCTION__, ex.what());
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.semifuture_updateFloodTopologyChild.secure_client.failure",
+        1,
+        fb303::COUNT);
+    return plainTextClient->semifuture_updateFloodTopologyChild(params, area);
+  }
+}
+
 template <class ClientType>
 bool
 KvStoreDb<ClientType>::KvStorePeer::getOrCreateThriftClient(
@@ -1424,6 +1644,12 @@ KvStoreDb<ClientType>::KvStorePeer::getOrCreateThriftClient(
  * kvstore.thrift.flood_pub_duration_ms: avg time elapsed for a
  * flooding req;
  *
+ * kvstore.thrift.num_flood_pub_backlogged: # of flooding req held back for
+ * peers out of flood window;
+ * kvstore.thrift.num_flood_backlog_key_vals: # of backlogged keyVals sent
+ * once peer has credit;
+ * kvstore.thrift.flood_window: avg per-peer flood window;
+ *
  * kvstore.thrift.num_finalized_sync: # of finalized finalized-sync performed;
  * kvstore.thrift.num_finalized_sync_success: # of successful finalized-sync;
  * kvstore.thrift.num_finalized_sync_failure: # of failed finalized-sync;
@@ -1437,7 +1663,9 @@ KvStoreDb<ClientType>::KvStoreDb(
     const std::string& nodeId,
     std::function<void()> initialKvStoreSyncedCallback,
     std::function<void()> initialSelfOriginatedKeysSyncedCallback)
-    : kvParams_(kvParams),
+    : DualNode(
+          nodeId, kvParams.enableFloodOptimization and kvParams.isFloodRoot),
+      kvParams_(kvParams),
       area_(area),
       areaTag_(fmt::format("[Area {}] ", area)),
       initialKvStoreSyncedCallback_(initialKvStoreSyncedCallback),
@@ -1451,8 +1679,7 @@ KvStoreDb<ClientType>::KvStoreDb(
     pendingPublicationTimer_ =
         folly::AsyncTimeout::make(*evb_->getEvb(), [this]() noexcept {
           if (!floodLimiter_->consume(1)) {
-            pendingPublicationTimer_->scheduleTimeout(
-                Constants::kFloodPendingPublication);
+            pendingPublicationTimer_->scheduleTimeout(getFloodLimiterWait());
             return;
           }
           floodBufferedUpdates();
@@ -1604,12 +1831,14 @@ KvStoreDb<ClientType>::floodTopoDumpTask() noexcept {
 template <class ClientType>
 void
 KvStoreDb<ClientType>::floodTopoDump() noexcept {
-  const auto& floodPeers = getFloodPeers();
+  const auto floodRootId = getSptRootId();
+  const auto& floodPeers = getFloodPeers(floodRootId);
 
   XLOG(INFO) << AreaTag()
              << fmt::format(
-                    "[Flood Topo] NodeId: {}, flooding peers: [{}]",
+                    "[Flood Topo] NodeId: {}, flood root: {}, flooding peers: [{}]",
                     kvParams_.nodeId,
+                    floodRootId.value_or("none"),
                     folly::join(",", floodPeers));
 
   // Expose number of flood peers into ODS counter
@@ -2066,6 +2295,7 @@ KvStoreDb<ClientType>::setKeyVals(
   thrift::Publication rcvdPublication;
   rcvdPublication.keyVals() = std::move(*setParams.keyVals());
   rcvdPublication.nodeIds().move_from(setParams.nodeIds());
+  rcvdPublication.floodRootId().move_from(setParams.floodRootId());
   auto pub = mergePublication(rcvdPublication, isSelfOriginatedUpdate);
   thrift::SetKeyValsResult result;
   result.noMergeReasons() = std::move(*pub.noMergeKeyVals());
@@ -2092,14 +2322,16 @@ KvStoreDb<ClientType>::updateTtlCountdownQueue(
       queueEntry.ttlVersion = *value.ttlVersion();
       queueEntry.originatorId = *value.originatorId();
 
-      if ((ttlCountdownQueue_.empty() or
-           (queueEntry.expiryTime <= ttlCountdownQueue_.top().expiryTime)) and
-          ttlCountdownTimer_) {
+      if (ttlCountdownTimer_ and
+          (not ttlCountdownTimer_->isScheduled() or
+           queueEntry.expiryTime < ttlCountdownTimerExpiry_)) {
         // Reschedule the shorter timeout
+        ttlCountdownTimerExpiry_ = queueEntry.expiryTime;
         ttlCountdownTimer_->scheduleTimeout(
             std::chrono::milliseconds(*value.ttl()));
       }
 
+      // replaces pending entry of the same key if any
       ttlCountdownQueue_.push(std::move(queueEntry));
     }
   }
@@ -2190,55 +2422,28 @@ KvStoreDb<ClientType>::requestThriftPeerSync() {
     // mark peer from IDLE -> SYNCING
     numThriftPeersInSync += 1;
 
-    // build KeyDumpParam
-    thrift::KeyDumpParams params;
-    KvStoreFilters kvFilters(
-        std::vector<std::string>{}, /* keyPrefix list */
-        std::set<std::string>{} /* originatorId list */);
-    // ATTN: dump hashes instead of full key-val pairs with values
-    auto thriftPub = dumpHashWithFilters(area_, kvStore_, kvFilters);
-    params.keyValHashes() = *thriftPub.keyVals();
-    params.senderId() = kvParams_.nodeId;
-
     // record telemetry for initial full-sync
     fb303::fbData->addStatValue(
         "kvstore.thrift.num_full_sync", 1, fb303::COUNT);
 
-    XLOG(INFO) << AreaTag()
-               << fmt::format(
-                      "[Thrift Sync] Initiating full-sync request for peer: {}",
-                      peerName);
-
-    // send request over thrift client and attach callback
     auto startTime = std::chrono::steady_clock::now();
-    auto sf = thriftPeer.getKvStoreKeyValsFilteredAreaWrapper(params, area_);
-    std::move(sf)
-        .via(evb_->getEvb())
-        .thenValue(
-            [this, peer = peerName, startTime](thrift::Publication&& pub) {
-              // state transition to INITIALIZED
-              auto endTime = std::chrono::steady_clock::now();
-              auto timeDelta =
-                  std::chrono::duration_cast<std::chrono::milliseconds>(
-                      endTime - startTime);
-              processThriftSuccess(peer, std::move(pub), timeDelta);
-            })
-        .thenError([this, peer = peerName, startTime](
-                       const folly::exception_wrapper& ew) {
-          // state transition to IDLE
-          auto endTime = std::chrono::steady_clock::now();
-          auto timeDelta =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  endTime - startTime);
-          processThriftFailure(
-              peer,
-              fmt::format("FULL_SYNC failure with {}, {}", peer, ew.what()),
-              timeDelta);
+    if (kvParams_.enableHashTreeSync and thriftPeer.hashTreeSyncSupported) {
+      XLOG(INFO)
+          << AreaTag()
+          << fmt::format(
+                 "[Thrift Sync] Initiating hash tree full-sync request for peer: {}",
+                 peerName);
 
-          // record telemetry for thrift calls
-          fb303::fbData->addStatValue(
-              "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
-        });
+      // start from the root
+      walkPeerHashTree(peerName, 0, {0}, startTime);
+    } else {
+      XLOG(INFO) << AreaTag()
+                 << fmt::format(
+                        "[Thrift Sync] Initiating full-sync request for peer: {}",
+                        peerName);
+
+      requestPlainFullSync(peerName, startTime);
+    }
 
     // in case pending peer size is over parallelSyncLimit,
     // wait until syncInitialBackoff before sending next round of sync
@@ -2269,6 +2474,190 @@ KvStoreDb<ClientType>::requestThriftPeerSync() {
   }
 }
 
+template <class ClientType>
+void
+KvStoreDb<ClientType>::requestPlainFullSync(
+    std::string const& peerName,
+    std::chrono::steady_clock::time_point startTime) {
+  // build KeyDumpParam
+  thrift::KeyDumpParams params;
+  KvStoreFilters kvFilters(
+      std::vector<std::string>{}, /* keyPrefix list */
+      std::set<std::string>{} /* originatorId list */);
+  // ATTN: dump hashes instead of full key-val pairs with values
+  auto thriftPub = dumpHashWithFilters(area_, kvStore_, kvFilters);
+  params.keyValHashes() = std::move(*thriftPub.keyVals());
+  params.senderId() = kvParams_.nodeId;
+
+  sendFullSyncRequest(peerName, std::move(params), startTime);
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::sendFullSyncRequest(
+    std::string const& peerName,
+    thrift::KeyDumpParams&& params,
+    std::chrono::steady_clock::time_point startTime) {
+  // send request over thrift client and attach callback
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  auto sf = thriftPeer.getKvStoreKeyValsFilteredAreaWrapper(params, area_);
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this, peer = peerName, startTime](thrift::Publication&& pub) {
+        // state transition to INITIALIZED
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+        processThriftSuccess(peer, std::move(pub), timeDelta);
+      })
+      .thenError([this, peer = peerName, startTime](
+                     const folly::exception_wrapper& ew) {
+        // state transition to IDLE
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+        processThriftFailure(
+            peer,
+            fmt::format("FULL_SYNC failure with {}, {}", peer, ew.what()),
+            timeDelta);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
+      });
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::walkPeerHashTree(
+    std::string const& peerName,
+    int32_t level,
+    std::vector<int64_t>&& nodes,
+    std::chrono::steady_clock::time_point startTime) {
+  thrift::KvStoreHashTreeParams params;
+  params.level() = level;
+  params.nodes() = std::move(nodes);
+  params.senderId() = kvParams_.nodeId;
+
+  fb303::fbData->addStatValue(
+      "kvstore.thrift.num_hash_tree_nodes",
+      params.nodes()->size(),
+      fb303::SUM);
+
+  auto sf =
+      thriftPeers_.at(peerName).getKvStoreHashTreeAreaWrapper(params, area_);
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this, peer = peerName, params, startTime](
+                     thrift::KvStoreHashTreeResult&& result) {
+        // peer might be gone or restarted syncing in the meantime
+        if (isStopped_ or not thriftPeers_.count(peer) or
+            *thriftPeers_.at(peer).peerSpec.state() !=
+                thrift::KvStorePeerState::SYNCING) {
+          return;
+        }
+
+        const auto& reqNodes = *params.nodes();
+        const auto& peerHashes = *result.childHashes();
+        if (*result.fanout() != KvStoreHashTree::kFanout or
+            *result.depth() != KvStoreHashTree::kDepth or
+            peerHashes.size() != reqNodes.size() * KvStoreHashTree::kFanout) {
+          XLOG(WARNING)
+              << AreaTag()
+              << fmt::format(
+                     "[Thrift Sync] Hash tree shape mismatch with peer: {}. "
+                     "Fall back to full-sync.",
+                     peer);
+          thriftPeers_.at(peer).hashTreeSyncSupported = false;
+          requestPlainFullSync(peer, startTime);
+          return;
+        }
+
+        // children of `reqNodes` whose digest differs from peer's
+        const auto myHashes =
+            hashTree_.getChildHashes(*params.level(), reqNodes);
+        std::vector<int64_t> mismatched;
+        for (size_t i = 0; i < myHashes.size(); ++i) {
+          if (myHashes.at(i) != peerHashes.at(i)) {
+            mismatched.emplace_back(
+                (reqNodes.at(i / KvStoreHashTree::kFanout)
+                 << KvStoreHashTree::kFanoutBits) +
+                i % KvStoreHashTree::kFanout);
+          }
+        }
+
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        if (mismatched.empty()) {
+          // already in sync
+          thrift::Publication pub;
+          pub.area() = area_;
+          processThriftSuccess(peer, std::move(pub), timeDelta);
+          return;
+        }
+
+        if (*params.level() + 1 < KvStoreHashTree::kDepth) {
+          walkPeerHashTree(
+              peer, *params.level() + 1, std::move(mismatched), startTime);
+          return;
+        }
+
+        // reached the leaves, exchange key-vals of mismatched leaves only
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_hash_tree_leaves_mismatched",
+            mismatched.size(),
+            fb303::SUM);
+
+        thrift::KeyDumpParams dumpParams;
+        auto thriftPub =
+            dumpHashWithLeaves(area_, kvStore_, hashTree_, mismatched);
+        dumpParams.keyValHashes() = std::move(*thriftPub.keyVals());
+        dumpParams.hashTreeLeaves() = std::move(mismatched);
+        dumpParams.senderId() = kvParams_.nodeId;
+
+        XLOG(INFO) << AreaTag()
+                   << fmt::format(
+                          "[Thrift Sync] Hash tree full-sync with peer: {} "
+                          "found {} mismatched leaves.",
+                          peer,
+                          dumpParams.hashTreeLeaves()->size());
+
+        sendFullSyncRequest(peer, std::move(dumpParams), startTime);
+      })
+      .thenError([this, peer = peerName, startTime](
+                     const folly::exception_wrapper& ew) {
+        if (isStopped_ or not thriftPeers_.count(peer) or
+            *thriftPeers_.at(peer).peerSpec.state() !=
+                thrift::KvStorePeerState::SYNCING) {
+          return;
+        }
+
+        // peer running older version without the API or not implementing it
+        if (ew.is_compatible_with<apache::thrift::TApplicationException>()) {
+          XLOG(INFO)
+              << AreaTag()
+              << fmt::format(
+                     "[Thrift Sync] Peer: {} doesn't support hash tree full-sync. "
+                     "Fall back to full-sync.",
+                     peer);
+          thriftPeers_.at(peer).hashTreeSyncSupported = false;
+          requestPlainFullSync(peer, startTime);
+          return;
+        }
+
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - startTime);
+        processThriftFailure(
+            peer,
+            fmt::format("FULL_SYNC failure with {}, {}", peer, ew.what()),
+            timeDelta);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_full_sync_failure", 1, fb303::COUNT);
+      });
+}
+
 // This function will process the full-dump response from peers:
 //  1) Merge peer's publication with local KvStoreDb;
 //  2) Send a finalized full-sync to peer for missing keys;
@@ -2357,6 +2746,7 @@ KvStoreDb<ClientType>::processThriftSuccess(
   }
   logStateTransitionWithCounterPublication(
       peerName, oldState, *peer.peerSpec.state());
+  updateDualPeerState(peerName, oldState, *peer.peerSpec.state());
 
   // Log full-sync event via replicate queue
   logSyncEvent(peerName, timeDelta);
@@ -2465,6 +2855,9 @@ KvStoreDb<ClientType>::disconnectPeer(
     peer.secureClient.reset();
   }
 
+  // keys backlogged by flood control are covered by next full-sync
+  peer.floodBacklog.clear();
+
   // state transition
   auto oldState = *peer.peerSpec.state();
   peer.peerSpec.state() = getNextState(oldState, event);
@@ -2477,6 +2870,7 @@ KvStoreDb<ClientType>::disconnectPeer(
   }
   logStateTransitionWithCounterPublication(
       peer.nodeName, oldState, *peer.peerSpec.state());
+  updateDualPeerState(peer.nodeName, oldState, *peer.peerSpec.state());
 
   // Thrift error is treated as a completion signal of syncing with peer.
   // Check whether initial sync is completed.
@@ -2525,10 +2919,9 @@ KvStoreDb<ClientType>::addThriftPeers(
                    "[Peer Update] new peer {} comes up. Previously shutdown non-gracefully",
                    peerName);
       }
+      const auto oldState = *peerIter->second.peerSpec.state();
       logStateTransitionWithCounterPublication(
-          peerName,
-          *peerIter->second.peerSpec.state(),
-          thrift::KvStorePeerState::IDLE);
+          peerName, oldState, thrift::KvStorePeerState::IDLE);
 
       peerIter->second.peerSpec = newPeerSpec; // update peerSpec
       peerIter->second.peerSpec.state() =
@@ -2541,6 +2934,7 @@ KvStoreDb<ClientType>::addThriftPeers(
       if (kvParams_.enable_secure_thrift_client) {
         peerIter->second.secureClient.reset();
       }
+      updateDualPeerState(peerName, oldState, thrift::KvStorePeerState::IDLE);
     } else {
       // case 3: found a new peer coming up
       XLOG(INFO) << AreaTag()
@@ -2625,11 +3019,13 @@ KvStoreDb<ClientType>::delThriftPeers(std::vector<std::string> const& peers) {
                       *peerSpec.peerAddr());
 
     // destroy peer info
+    const auto oldState = *peerSpec.state();
     peerIter->second.plainTextClient.reset();
     if (kvParams_.enable_secure_thrift_client) {
       peerIter->second.secureClient.reset();
     }
     thriftPeers_.erase(peerIter);
+    updateDualPeerState(peerName, oldState, thrift::KvStorePeerState::IDLE);
   }
 }
 
@@ -2654,40 +3050,37 @@ KvStoreDb<ClientType>::cleanupTtlCountdownQueue() {
   std::vector<std::string> expiredKeys;
   auto now = std::chrono::steady_clock::now();
 
-  // Iterate through ttlCountdownQueue_ until the top expires in the future
-  while (not ttlCountdownQueue_.empty()) {
-    auto top = ttlCountdownQueue_.top();
-    if (top.expiryTime > now) {
-      // Nothing in queue worth evicting
-      break;
-    }
-    auto it = kvStore_.find(top.key);
-    if (it != kvStore_.end() and *it->second.version() == top.version and
-        *it->second.originatorId() == top.originatorId and
-        *it->second.ttlVersion() == top.ttlVersion) {
-      expiredKeys.emplace_back(top.key);
+  // Advance the timing wheel and check all entries expired by now
+  for (auto const& entry : ttlCountdownQueue_.popExpired(now)) {
+    auto it = kvStore_.find(entry.key);
+    if (it != kvStore_.end() and *it->second.version() == entry.version and
+        *it->second.originatorId() == entry.originatorId and
+        *it->second.ttlVersion() == entry.ttlVersion) {
+      expiredKeys.emplace_back(entry.key);
       XLOG(WARNING)
           << AreaTag()
           << "Delete expired (key, version, originatorId, ttlVersion, ttl, node) "
           << fmt::format(
                  "({}, {}, {}, {}, {}, {})",
-                 top.key,
+                 entry.key,
                  *it->second.version(),
                  *it->second.originatorId(),
                  *it->second.ttlVersion(),
                  *it->second.ttl(),
                  kvParams_.nodeId);
-      logKvEvent("KEY_EXPIRE", top.key);
+      logKvEvent("KEY_EXPIRE", entry.key);
+      hashTree_.erase(it->first, it->second);
       kvStore_.erase(it);
     }
-    ttlCountdownQueue_.pop();
   }
 
-  // Reschedule based on most recent timeout
-  if (not ttlCountdownQueue_.empty()) {
-    ttlCountdownTimer_->scheduleTimeout(
-        std::chrono::duration_cast<std::chrono::milliseconds>(
-            ttlCountdownQueue_.top().expiryTime - now));
+  // Reschedule for the next tick having entries to expire or cascade. Clamp
+  // to zero in case that tick is already behind `now`.
+  if (auto nextExpiryTime = ttlCountdownQueue_.getNextExpiryTime()) {
+    ttlCountdownTimerExpiry_ = *nextExpiryTime;
+    ttlCountdownTimer_->scheduleTimeout(std::max(
+        std::chrono::ceil<std::chrono::milliseconds>(*nextExpiryTime - now),
+        std::chrono::milliseconds(0)));
   }
 
   if (expiredKeys.empty()) {
@@ -2713,7 +3106,7 @@ KvStoreDb<ClientType>::bufferPublication(thrift::Publication&& publication) {
   fb303::fbData->addStatValue("kvstore.rate_limit_suppress", 1, fb303::COUNT);
   fb303::fbData->addStatValue(
       "kvstore.rate_limit_keys", publication.keyVals()->size(), fb303::AVG);
-  std::optional<std::string> floodRootId{std::nullopt};
+  const auto floodRootId = publication.floodRootId().to_optional();
   // update or add keys
   for (auto const& [key, _] : *publication.keyVals()) {
     publicationBuffer_[floodRootId].emplace(key);
@@ -2723,6 +3116,16 @@ KvStoreDb<ClientType>::bufferPublication(thrift::Publication&& publication) {
   }
 }
 
+template <class ClientType>
+std::chrono::milliseconds
+KvStoreDb<ClientType>::getFloodLimiterWait() const {
+  // round up so token is there once timer fires
+  const double deficit = 1.0 - floodLimiter_->available();
+  const auto waitMs =
+      static_cast<int64_t>(deficit * 1000.0 / floodLimiter_->rate()) + 1;
+  return std::chrono::milliseconds(std::max<int64_t>(1, waitMs));
+}
+
 template <class ClientType>
 void
 KvStoreDb<ClientType>::floodBufferedUpdates() {
@@ -2736,6 +3139,7 @@ KvStoreDb<ClientType>::floodBufferedUpdates() {
   // merge publication per root-id
   for (const auto& [rootId, keys] : publicationBuffer_) {
     thrift::Publication publication{};
+    publication.floodRootId().from_optional(rootId);
     for (const auto& key : keys) {
       auto kvStoreIt = kvStore_.find(key);
       if (kvStoreIt != kvStore_.end()) {
@@ -2858,15 +3262,279 @@ KvStoreDb<ClientType>::finalizeFullSync(
       });
 }
 
+template <class ClientType>
+void
+KvStoreDb<ClientType>::updateDualPeerState(
+    std::string const& peerName,
+    thrift::KvStorePeerState oldState,
+    thrift::KvStorePeerState newState) {
+  if (not kvParams_.enableFloodOptimization or oldState == newState) {
+    return;
+  }
+
+  if (newState == thrift::KvStorePeerState::INITIALIZED) {
+    // peer might have been upgraded since last time. Give DUAL another try.
+    auto peerIt = thriftPeers_.find(peerName);
+    if (peerIt != thriftPeers_.end()) {
+      peerIt->second.dualSupported = true;
+    }
+    XLOG(INFO) << AreaTag()
+               << fmt::format(
+                      "[Flood Optimization] DUAL peer up: {}", peerName);
+    DualNode::peerUp(peerName, 1 /* link-cost */);
+  } else if (
+      oldState == thrift::KvStorePeerState::INITIALIZED and
+      DualNode::neighborUp(peerName)) {
+    XLOG(INFO) << AreaTag()
+               << fmt::format(
+                      "[Flood Optimization] DUAL peer down: {}", peerName);
+    DualNode::peerDown(peerName);
+  }
+}
+
+template <class ClientType>
+bool
+KvStoreDb<ClientType>::sendDualMessages(
+    const std::string& neighbor, const thrift::DualMessages& msgs) noexcept {
+  auto peerIt = thriftPeers_.find(neighbor);
+  if (peerIt == thriftPeers_.end()) {
+    XLOG(ERR) << AreaTag()
+              << fmt::format(
+                     "[Flood Optimization] Invalid peer: {} to send DUAL messages to.",
+                     neighbor);
+    return false;
+  }
+
+  auto& thriftPeer = peerIt->second;
+  if (*thriftPeer.peerSpec.state() != thrift::KvStorePeerState::INITIALIZED or
+      not thriftPeer.dualSupported) {
+    return false;
+  }
+
+  // record telemetry for thrift calls
+  fb303::fbData->addStatValue("kvstore.thrift.num_dual_msg", 1, fb303::COUNT);
+
+  auto startTime = std::chrono::steady_clock::now();
+  try {
+    auto sf = thriftPeer.processKvStoreDualMessageWrapper(msgs, area_);
+    std::move(sf)
+        .via(evb_->getEvb())
+        .thenValue([](folly::Unit&&) {
+          fb303::fbData->addStatValue(
+              "kvstore.thrift.num_dual_msg_success", 1, fb303::COUNT);
+        })
+        .thenError([this, neighbor, startTime](
+                       const folly::exception_wrapper& ew) {
+          fb303::fbData->addStatValue(
+              "kvstore.thrift.num_dual_msg_failure", 1, fb303::COUNT);
+          if (isStopped_ or not thriftPeers_.count(neighbor)) {
+            return;
+          }
+
+          // peer running older version or with flood optimization disabled.
+          // Exclude it from DUAL and always flood to it.
+          if (ew.is_compatible_with<apache::thrift::TApplicationException>() or
+              ew.is_compatible_with<thrift::KvStoreError>()) {
+            XLOG(INFO) << AreaTag()
+                       << fmt::format(
+                              "[Flood Optimization] Peer: {} doesn't run DUAL. "
+                              "Always flood to it.",
+                              neighbor);
+            thriftPeers_.at(neighbor).dualSupported = false;
+            if (DualNode::neighborUp(neighbor)) {
+              DualNode::peerDown(neighbor);
+            }
+            return;
+          }
+
+          // state transition to IDLE
+          auto endTime = std::chrono::steady_clock::now();
+          auto timeDelta =
+              std::chrono::duration_cast<std::chrono::milliseconds>(
+                  endTime - startTime);
+          processThriftFailure(
+              neighbor,
+              fmt::format("DUAL_MSG failure with {}, {}", neighbor, ew.what()),
+              timeDelta);
+        });
+  } catch (std::exception const& ex) {
+    XLOG(ERR) << AreaTag()
+              << fmt::format(
+                     "[Flood Optimization] Failed to send DUAL messages to: {}, {}",
+                     neighbor,
+                     ex.what());
+    return false;
+  }
+  return true;
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::processNexthopChange(
+    const std::string& rootId,
+    const std::optional<std::string>& oldNh,
+    const std::optional<std::string>& newNh) noexcept {
+  XLOG(INFO) << AreaTag()
+             << fmt::format(
+                    "[Flood Optimization] SPT root: {} parent change: {} -> {}",
+                    rootId,
+                    oldNh.value_or("none"),
+                    newNh.value_or("none"));
+  fb303::fbData->addStatValue(
+      "kvstore.flood_optimization.num_parent_change", 1, fb303::COUNT);
+
+  // make-before-break: register as child of the new parent first and leave
+  // the old parent only after that, so that no flooded publication falls
+  // into the gap between the two.
+  auto unsetOldParent = [this, rootId, oldNh]() {
+    if (oldNh.has_value() and *oldNh != kvParams_.nodeId) {
+      sendFloodTopoSet(*oldNh, rootId, false /* unset child */);
+    }
+  };
+  if (newNh.has_value() and *newNh != kvParams_.nodeId) {
+    sendFloodTopoSet(
+        *newNh, rootId, true /* set child */, std::move(unsetOldParent));
+  } else {
+    unsetOldParent();
+  }
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::sendFloodTopoSet(
+    std::string const& peerName,
+    std::string const& rootId,
+    bool setChild,
+    std::function<void()> onSuccess) {
+  if (isStopped_) {
+    return;
+  }
+
+  auto peerIt = thriftPeers_.find(peerName);
+  if (peerIt == thriftPeers_.end() or
+      *peerIt->second.peerSpec.state() !=
+          thrift::KvStorePeerState::INITIALIZED or
+      not peerIt->second.dualSupported) {
+    // peer is gone. It drops us as child on its own upon peer down.
+    return;
+  }
+
+  thrift::FloodTopoSetParams params;
+  params.rootId() = rootId;
+  params.srcId() = kvParams_.nodeId;
+  params.setChild() = setChild;
+
+  // record telemetry for thrift calls
+  fb303::fbData->addStatValue(
+      "kvstore.thrift.num_flood_topo_set", 1, fb303::COUNT);
+
+  auto startTime = std::chrono::steady_clock::now();
+  auto sf = peerIt->second.updateFloodTopologyChildWrapper(params, area_);
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this, onSuccess = std::move(onSuccess)](folly::Unit&&) {
+        if (onSuccess and not isStopped_) {
+          onSuccess();
+        }
+      })
+      .thenError([this, peerName, startTime](
+                     const folly::exception_wrapper& ew) {
+        // state transition to IDLE
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+        processThriftFailure(
+            peerName,
+            fmt::format(
+                "FLOOD_TOPO_SET failure with {}, {}", peerName, ew.what()),
+            timeDelta);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_flood_topo_set_failure", 1, fb303::COUNT);
+      });
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::processFloodTopoSet(
+    const thrift::FloodTopoSetParams& setParams) {
+  const auto& rootId = *setParams.rootId();
+  const auto& child = *setParams.srcId();
+  if (not hasDual(rootId)) {
+    XLOG(ERR) << AreaTag()
+              << fmt::format(
+                     "[Flood Optimization] Unknown SPT root: {} to {} child: {}",
+                     rootId,
+                     *setParams.setChild() ? "set" : "unset",
+                     child);
+    return;
+  }
+
+  auto& dual = getDual(rootId);
+  if (*setParams.setChild()) {
+    dual.addChild(child);
+  } else {
+    dual.removeChild(child);
+  }
+}
+
+template <class ClientType>
+thrift::SptInfos
+KvStoreDb<ClientType>::processFloodTopoGet() {
+  thrift::SptInfos sptInfos;
+  for (auto& [rootId, dual] : getDuals()) {
+    const auto& info = dual.getInfo();
+    const auto children = dual.children();
+
+    thrift::SptInfo sptInfo;
+    sptInfo.passive() = info.sm.state == DualState::PASSIVE;
+    sptInfo.cost() = info.distance;
+    sptInfo.parent().from_optional(info.nexthop);
+    sptInfo.children()->insert(children.begin(), children.end());
+    sptInfos.infos()->emplace(rootId, std::move(sptInfo));
+  }
+  sptInfos.counters() = DualNode::getCounters();
+
+  const auto floodRootId = getSptRootId();
+  const auto floodPeers = getFloodPeers(floodRootId);
+  sptInfos.floodRootId().from_optional(floodRootId);
+  sptInfos.floodPeers()->insert(floodPeers.begin(), floodPeers.end());
+  return sptInfos;
+}
+
 template <class ClientType>
 std::unordered_set<std::string>
-KvStoreDb<ClientType>::getFloodPeers() {
+KvStoreDb<ClientType>::getFloodPeers(const std::optional<std::string>& rootId) {
+  const Dual* dual{nullptr};
+  std::unordered_set<std::string> sptPeers;
+  if (kvParams_.enableFloodOptimization and rootId.has_value() and
+      hasDual(*rootId)) {
+    dual = &getDual(*rootId);
+    sptPeers = dual->sptPeers();
+  }
+
+  // fall back to flooding to all peers if SPT is not ready, e.g. DUAL is in
+  // the middle of a diffusing computation
+  const bool floodToAll = sptPeers.empty();
+
   // flood-peers:
   //  1) SPT-peers;
   //  2) peers-who-does-not-support-DUAL;
+  //  3) peers-without-route-to-root. They are not part of SPT yet, e.g.
+  //     just came up, and can't be reached via any other SPT-peer.
   std::unordered_set<std::string> floodPeers;
   for (const auto& [peerName, peer] : thriftPeers_) {
-    floodPeers.emplace(peerName);
+    if (floodToAll or sptPeers.count(peerName) or not peer.dualSupported) {
+      floodPeers.emplace(peerName);
+      continue;
+    }
+    const auto& neighborInfos = dual->getInfo().neighborInfos;
+    const auto it = neighborInfos.find(peerName);
+    if (it == neighborInfos.end() or
+        it->second.reportDistance == std::numeric_limits<int64_t>::max()) {
+      floodPeers.emplace(peerName);
+    }
   }
   return floodPeers;
 }
@@ -2878,8 +3546,11 @@ KvStoreDb<ClientType>::floodPublication(
   // rate limit if configured
   if (floodLimiter_ && rateLimit && !floodLimiter_->consume(1)) {
     bufferPublication(std::move(publication));
-    pendingPublicationTimer_->scheduleTimeout(
-        Constants::kFloodPendingPublication);
+    // flush as soon as limiter has credit. Don't push out already scheduled
+    // flush, it would starve buffered updates under sustained churn.
+    if (not pendingPublicationTimer_->isScheduled()) {
+      pendingPublicationTimer_->scheduleTimeout(getFloodLimiterWait());
+    }
     return;
   }
   // merge with buffered publication and flood
@@ -2896,6 +3567,12 @@ KvStoreDb<ClientType>::floodPublication(
     return;
   }
 
+  // Pick the spanning tree to flood along if we're initiating the flooding.
+  // Forwarders keep flooding along the tree publication was received on.
+  if (not publication.floodRootId().has_value()) {
+    publication.floodRootId().from_optional(getSptRootId());
+  }
+
   // Find from whom we might have got this publication. Last entry is our ID
   // and hence second last entry is the node from whom we get this
   // publication
@@ -2932,12 +3609,29 @@ KvStoreDb<ClientType>::floodPublication(
              << fmt::format("Updated keys: {}", folly::join(",", keysToUpdate));
 
   // prepare thrift structure for flooding purpose
-  thrift::KeySetParams params;
-  params.keyVals() = *publication.keyVals();
-  params.nodeIds().copy_from(publication.nodeIds());
-  params.timestamp_ms() = getUnixTimeStampMs();
-  params.senderId() = kvParams_.nodeId;
+  auto params = std::make_shared<thrift::KeySetParams>();
+  params->keyVals() = *publication.keyVals();
+  params->nodeIds().copy_from(publication.nodeIds());
+  params->timestamp_ms() = getUnixTimeStampMs();
+  params->senderId() = kvParams_.nodeId;
+  params->floodRootId().copy_from(publication.floodRootId());
+
+  // encode once and share the encoded buffer among all peers
+  std::unique_ptr<folly::IOBuf> setParamsPayload{nullptr};
+  if (kvParams_.enableSerializedFlooding) {
+    setParamsPayload =
+        apache::thrift::CompactSerializer::serialize<folly::IOBufQueue>(
+            *params)
+            .move();
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.flood_bytes_encoded",
+        setParamsPayload->computeChainDataLength(),
+        fb303::SUM);
+  }
 
+  const auto floodRootId = publication.floodRootId().to_optional();
+  const auto floodPeers = getFloodPeers(floodRootId);
+  size_t numPrunedPeers{0};
   for (auto& [peerName, thriftPeer] : thriftPeers_) {
     if (senderId.has_value() and senderId.value() == peerName) {
       // Do not flood towards senderId from whom we received this
@@ -2949,12 +3643,32 @@ KvStoreDb<ClientType>::floodPublication(
       // Skip flooding to those peers if peer has NOT finished
       // initial sync(i.e. promoted to `INITIALIZED`)
       // store key for flooding after intialized
-      for (auto const& [key, _] : *params.keyVals()) {
+      for (auto const& [key, _] : *params->keyVals()) {
         thriftPeer.pendingKeysDuringInitialization.insert(key);
       }
       continue;
     }
 
+    if (not floodPeers.count(peerName)) {
+      // Not on flooding spanning tree. Peer will get it via SPT.
+      ++numPrunedPeers;
+      continue;
+    }
+
+    if (kvParams_.enablePeerFloodControl and
+        (thriftPeer.numPendingFloodPubs >= thriftPeer.floodWindow or
+         not thriftPeer.floodBacklog.empty())) {
+      // Peer is out of credit. Hold keys back without blocking other peers,
+      // they will be sent with latest value once peer catches up.
+      auto& backlog = thriftPeer.floodBacklog[floodRootId];
+      for (auto const& [key, _] : *params->keyVals()) {
+        backlog.insert_or_assign(key, params->nodeIds().to_optional());
+      }
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_flood_pub_backlogged", 1, fb303::COUNT);
+      continue;
+    }
+
     // record telemetry for flooding publications
     fb303::fbData->addStatValue(
         "kvstore.thrift.num_flood_pub", 1, fb303::COUNT);
@@ -2963,41 +3677,211 @@ KvStoreDb<ClientType>::floodPublication(
         publication.keyVals()->size(),
         fb303::SUM);
 
-    auto startTime = std::chrono::steady_clock::now();
-    auto sf = thriftPeer.setKvStoreKeyValsWrapper(area_, params);
-    std::move(sf)
-        .via(evb_->getEvb())
-        .thenValue([startTime](folly::Unit&&) {
-          auto endTime = std::chrono::steady_clock::now();
-          auto timeDelta =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  endTime - startTime);
+    sendFloodPublication(peerName, params, setParamsPayload);
+  }
 
-          // record telemetry for thrift calls
-          fb303::fbData->addStatValue(
-              "kvstore.thrift.num_flood_pub_success", 1, fb303::COUNT);
-          fb303::fbData->addStatValue(
-              "kvstore.thrift.flood_pub_duration_ms",
-              timeDelta.count(),
-              fb303::AVG);
-        })
-        .thenError([this, peerNameStr = peerName, startTime](
-                       const folly::exception_wrapper& ew) {
-          // state transition to IDLE
-          auto endTime = std::chrono::steady_clock::now();
-          auto timeDelta =
-              std::chrono::duration_cast<std::chrono::milliseconds>(
-                  endTime - startTime);
-          processThriftFailure(
-              peerNameStr,
-              fmt::format(
-                  "FLOOD_PUB failure with {}, {}", peerNameStr, ew.what()),
-              timeDelta);
+  if (kvParams_.enableFloodOptimization) {
+    fb303::fbData->addStatValue(
+        "kvstore.flood_optimization.num_pruned_peers",
+        numPrunedPeers,
+        fb303::SUM);
+    if (getSptPeers(floodRootId).empty()) {
+      fb303::fbData->addStatValue(
+          "kvstore.flood_optimization.num_full_flood", 1, fb303::COUNT);
+    }
+  }
+}
 
-          // record telemetry for thrift calls
-          fb303::fbData->addStatValue(
-              "kvstore.thrift.num_flood_pub_failure", 1, fb303::COUNT);
-        });
+template <class ClientType>
+void
+KvStoreDb<ClientType>::sendFloodPublication(
+    std::string const& peerName,
+    std::shared_ptr<const thrift::KeySetParams> const& params,
+    std::unique_ptr<folly::IOBuf> const& setParamsPayload) {
+  auto& thriftPeer = thriftPeers_.at(peerName);
+  const bool serialized =
+      setParamsPayload and thriftPeer.serializedFloodingSupported;
+  if (setParamsPayload) {
+    const auto numBytes = setParamsPayload->computeChainDataLength();
+    fb303::fbData->addStatValue(
+        "kvstore.thrift.flood_bytes_sent", numBytes, fb303::SUM);
+    if (not serialized) {
+      // thrift client encodes params once more for this peer
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.flood_bytes_reencoded", numBytes, fb303::SUM);
+    }
+  }
+
+  auto startTime = std::chrono::steady_clock::now();
+  auto sf = serialized
+      ? thriftPeer.setKvStoreKeyValsSerializedWrapper(area_, setParamsPayload)
+      : thriftPeer.setKvStoreKeyValsWrapper(area_, *params);
+  ++thriftPeer.numPendingFloodPubs;
+  std::move(sf)
+      .via(evb_->getEvb())
+      .thenValue([this, peerNameStr = peerName, startTime](folly::Unit&&) {
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_flood_pub_success", 1, fb303::COUNT);
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.flood_pub_duration_ms",
+            timeDelta.count(),
+            fb303::AVG);
+
+        processFloodPublicationDone(peerNameStr, timeDelta, true);
+      })
+      .thenError([this, peerNameStr = peerName, params, serialized, startTime](
+                     const folly::exception_wrapper& ew) {
+        auto endTime = std::chrono::steady_clock::now();
+        auto timeDelta = std::chrono::duration_cast<std::chrono::milliseconds>(
+            endTime - startTime);
+
+        // peer running older version without the API, resend the
+        // publication the old way
+        if (serialized and not isStopped_ and
+            thriftPeers_.count(peerNameStr) and
+            ew.is_compatible_with<apache::thrift::TApplicationException>()) {
+          XLOG(INFO) << AreaTag()
+                     << fmt::format(
+                            "Peer: {} doesn't support serialized flooding. "
+                            "Fall back to plain flooding.",
+                            peerNameStr);
+          auto& peer = thriftPeers_.at(peerNameStr);
+          peer.serializedFloodingSupported = false;
+          // not a failure of peer, hence flood window is left as is
+          if (peer.numPendingFloodPubs) {
+            --peer.numPendingFloodPubs;
+          }
+          sendFloodPublication(peerNameStr, params, nullptr);
+          return;
+        }
+        processFloodPublicationDone(peerNameStr, timeDelta, false);
+
+        // state transition to IDLE
+        processThriftFailure(
+            peerNameStr,
+            fmt::format(
+                "FLOOD_PUB failure with {}, {}", peerNameStr, ew.what()),
+            timeDelta);
+
+        // record telemetry for thrift calls
+        fb303::fbData->addStatValue(
+            "kvstore.thrift.num_flood_pub_failure", 1, fb303::COUNT);
+      });
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::processFloodPublicationDone(
+    std::string const& peerName,
+    std::chrono::milliseconds latency,
+    bool success) {
+  // check if this kvStore is destructed and stop processing callbacks
+  if (isStopped_) {
+    return;
+  }
+
+  // check if it is valid peer(i.e. peer removed in process of flooding)
+  auto it = thriftPeers_.find(peerName);
+  if (it == thriftPeers_.end()) {
+    return;
+  }
+
+  auto& peer = it->second;
+  if (peer.numPendingFloodPubs) {
+    --peer.numPendingFloodPubs;
+  }
+  if (not kvParams_.enablePeerFloodControl) {
+    return;
+  }
+
+  // AIMD on smoothed latency: grow window by one per timely response, halve
+  // it once peer falls behind or fails.
+  peer.floodLatencyMs = peer.floodLatencyMs
+      ? 0.8 * peer.floodLatencyMs + 0.2 * latency.count()
+      : latency.count();
+  if (success and
+      peer.floodLatencyMs <= Constants::kFloodPeerLatencyTarget.count()) {
+    peer.floodWindow =
+        std::min(peer.floodWindow + 1, Constants::kFloodPeerMaxWindow);
+  } else {
+    peer.floodWindow =
+        std::max(peer.floodWindow / 2, Constants::kFloodPeerMinWindow);
+  }
+  fb303::fbData->addStatValue(
+      "kvstore.thrift.flood_window", peer.floodWindow, fb303::AVG);
+
+  // failed peer goes through full-sync, which covers backlogged keys
+  if (success) {
+    floodPeerBacklog(peerName);
+  }
+}
+
+template <class ClientType>
+void
+KvStoreDb<ClientType>::floodPeerBacklog(std::string const& peerName) {
+  auto& peer = thriftPeers_.at(peerName);
+  if (peer.floodBacklog.empty() or
+      peer.numPendingFloodPubs >= peer.floodWindow or
+      *peer.peerSpec.state() != thrift::KvStorePeerState::INITIALIZED) {
+    return;
+  }
+
+  auto backlog = std::move(peer.floodBacklog);
+  peer.floodBacklog.clear();
+
+  for (auto& [rootId, keys] : backlog) {
+    // send latest value of each key. Keys expired meanwhile are dropped,
+    // peer expires them on its own. Keys are grouped by their flood path, so
+    // that each publication carries the path of its keys for loop detection.
+    std::map<std::optional<std::vector<std::string>>, thrift::Publication>
+        publications;
+    for (auto const& [key, nodeIds] : keys) {
+      auto kvStoreIt = kvStore_.find(key);
+      if (kvStoreIt != kvStore_.end()) {
+        publications[nodeIds].keyVals()->emplace(key, kvStoreIt->second);
+      }
+    }
+
+    for (auto& [nodeIds, publication] : publications) {
+      if (peer.numPendingFloodPubs >= peer.floodWindow) {
+        // Peer is out of credit again. Hold the rest back till next response
+        auto& pendingKeys = peer.floodBacklog[rootId];
+        for (auto const& [key, _] : *publication.keyVals()) {
+          pendingKeys.emplace(key, nodeIds);
+        }
+        continue;
+      }
+
+      updatePublicationTtl(ttlCountdownQueue_, kvParams_.ttlDecr, publication);
+      if (publication.keyVals()->empty()) {
+        continue;
+      }
+
+      auto params = std::make_shared<thrift::KeySetParams>();
+      params->keyVals() = std::move(*publication.keyVals());
+      params->nodeIds().from_optional(nodeIds);
+      params->timestamp_ms() = getUnixTimeStampMs();
+      params->senderId() = kvParams_.nodeId;
+      params->floodRootId().from_optional(rootId);
+
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_flood_pub", 1, fb303::COUNT);
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_flood_key_vals",
+          params->keyVals()->size(),
+          fb303::SUM);
+      fb303::fbData->addStatValue(
+          "kvstore.thrift.num_flood_backlog_key_vals",
+          params->keyVals()->size(),
+          fb303::SUM);
+
+      sendFloodPublication(peerName, params, nullptr);
+    }
   }
 }
 
@@ -3194,7 +4078,7 @@ KvStoreDb<ClientType>::mergePublication(
       : (nodeIds.has_value() ? std::optional(nodeIds->back()) : std::nullopt);
 
   const auto result =
-      mergeKeyValues(kvStore_, keyVals, kvParams_.filters, sender);
+      mergeKeyValues(kvStore_, keyVals, kvParams_.filters, sender, &hashTree_);
   const auto& mergedKeyVals = *result.keyVals();
   if (*result.inconsistencyDetetectedWithOriginator()) {
     // inconsistency detected: Received a TTL update from originator
@@ -3228,6 +4112,9 @@ KvStoreDb<ClientType>::mergePublication(
     deltaPublication.nodeIds().copy_from(rcvdPublication.nodeIds());
   }
 
+  // Keep flooding along the same spanning tree as we received it
+  deltaPublication.floodRootId().copy_from(rcvdPublication.floodRootId());
+
   // Update ttl values of keys
   updateTtlCountdownQueue(deltaPublication, isSelfOriginatedUpdate);
 
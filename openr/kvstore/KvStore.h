@@ -19,6 +19,7 @@
 #include <openr/common/OpenrEventBase.h>
 #include <openr/common/Types.h>
 #include <openr/if/gen-cpp2/KvStore_types.h>
+#include <openr/kvstore/Dual.h>
 #include <openr/kvstore/KvStoreParams.h>
 #include <openr/kvstore/KvStoreUtil.h>
 #include <openr/messaging/ReplicateQueue.h>
@@ -31,9 +32,13 @@ namespace openr {
  *
  * This class processes messages received from KvStore peer. The configuration
  * is passed via KvStoreParams from constructor.
+ *
+ * With flood optimization enabled, KvStoreDb runs DUAL over its INITIALIZED
+ * peers to build flooding spanning tree(s) and floods publications along the
+ * tree instead of to all peers.
  */
 template <class ClientType>
-class KvStoreDb {
+class KvStoreDb : public DualNode {
  public:
   KvStoreDb(
       OpenrEventBase* evb,
@@ -43,7 +48,7 @@ class KvStoreDb {
       std::function<void()> initialKvStoreSyncedCallback,
       std::function<void()> initialSelfOriginatedKeysSyncedCallback);
 
-  ~KvStoreDb() = default;
+  ~KvStoreDb() override = default;
 
   // shutdown fiber/timer/etc.
   void stop();
@@ -89,6 +94,11 @@ class KvStoreDb {
     return kvStore_;
   }
 
+  KvStoreHashTree const&
+  getHashTree() const {
+    return hashTree_;
+  }
+
   inline TtlCountdownQueue const&
   getTtlCountdownQueue() const {
     return ttlCountdownQueue_;
@@ -133,6 +143,27 @@ class KvStoreDb {
       bool isSelfOriginatedUpdate,
       std::optional<std::string> senderId = std::nullopt);
 
+  /*
+   * [Flood Optimization]
+   *
+   * DualNode overrides to send DUAL messages over thrift and to register
+   * with new SPT parent upon nexthop change.
+   */
+  bool sendDualMessages(
+      const std::string& neighbor,
+      const thrift::DualMessages& msgs) noexcept override;
+
+  void processNexthopChange(
+      const std::string& rootId,
+      const std::optional<std::string>& oldNh,
+      const std::optional<std::string>& newNh) noexcept override;
+
+  // set/unset a SPT child for a given root
+  void processFloodTopoSet(const thrift::FloodTopoSetParams& setParams);
+
+  // get current snapshot of SPT(s) information
+  thrift::SptInfos processFloodTopoGet();
+
   /*
    * [Peer Management]
    *
@@ -264,6 +295,42 @@ class KvStoreDb {
    */
   void requestThriftPeerSync();
 
+  /*
+   * [Initial Sync]
+   *
+   * plain full-sync, send hashes of all keys to peer
+   */
+  void requestPlainFullSync(
+      std::string const& peerName,
+      std::chrono::steady_clock::time_point startTime);
+
+  /*
+   * [Initial Sync]
+   *
+   * send full-sync request with given params to peer and process the
+   * response. With hash tree full-sync, params carry only keys falling into
+   * mismatched leaves.
+   */
+  void sendFullSyncRequest(
+      std::string const& peerName,
+      thrift::KeyDumpParams&& params,
+      std::chrono::steady_clock::time_point startTime);
+
+  /*
+   * [Initial Sync]
+   *
+   * hash tree full-sync. Compare children digests of `nodes` at `level` with
+   * peer's and descend into mismatched ones only. Once leaves are reached,
+   * send full-sync request restricted to the mismatched leaves.
+   *
+   * Falls back to plain full-sync if peer doesn't support it.
+   */
+  void walkPeerHashTree(
+      std::string const& peerName,
+      int32_t level,
+      std::vector<int64_t>&& nodes,
+      std::chrono::steady_clock::time_point startTime);
+
   /*
    * [Initial Sync]
    *
@@ -276,6 +343,29 @@ class KvStoreDb {
   void finalizeFullSync(
       const std::unordered_set<std::string>& keys, const std::string& senderId);
 
+  /*
+   * [Flood Optimization]
+   *
+   * util method to feed peer up/down event into DUAL upon peer state change.
+   * Peer is considered up only in INITIALIZED state.
+   */
+  void updateDualPeerState(
+      std::string const& peerName,
+      thrift::KvStorePeerState oldState,
+      thrift::KvStorePeerState newState);
+
+  /*
+   * [Flood Optimization]
+   *
+   * util method to set/unset ourselves as SPT child of `peerName` for a given
+   * root. `onSuccess` is invoked once peer acknowledged the request.
+   */
+  void sendFloodTopoSet(
+      std::string const& peerName,
+      std::string const& rootId,
+      bool setChild,
+      std::function<void()> onSuccess = nullptr);
+
   /*
    * [Version Inconsistency Mitigation]
    */
@@ -298,9 +388,36 @@ class KvStoreDb {
   /*
    * [Incremental flooding]
    *
-   * util method to get flooding peers for a given spt-root-id.
+   * util method to send flooded key-vals to a single peer. If
+   * `setParamsPayload` is set, the already encoded params are sent as is.
+   */
+  void sendFloodPublication(
+      std::string const& peerName,
+      std::shared_ptr<const thrift::KeySetParams> const& params,
+      std::unique_ptr<folly::IOBuf> const& setParamsPayload);
+
+  /*
+   * [Incremental flooding]
+   *
+   * Per-peer flood control. Account completion of a flooding request towards
+   * peer, adapt peer's flood window on `latency` and flush backlogged keys
+   * once peer has credit again.
+   */
+  void processFloodPublicationDone(
+      std::string const& peerName,
+      std::chrono::milliseconds latency,
+      bool success);
+  void floodPeerBacklog(std::string const& peerName);
+
+  /*
+   * [Incremental flooding]
+   *
+   * util method to get flooding peers for a given spt-root-id. Returns all
+   * peers unless flood optimization is enabled and SPT for `rootId` is
+   * converged.
    */
-  std::unordered_set<std::string> getFloodPeers();
+  std::unordered_set<std::string> getFloodPeers(
+      const std::optional<std::string>& rootId);
 
   /*
    * [Incremental flooding]
@@ -311,6 +428,13 @@ class KvStoreDb {
   void bufferPublication(thrift::Publication&& publication);
   void floodBufferedUpdates();
 
+  /*
+   * [Incremental flooding]
+   *
+   * time until rate limiter has credit for the next publication
+   */
+  std::chrono::milliseconds getFloodLimiterWait() const;
+
   /*
    * [Ttl Management]
    *
@@ -434,9 +558,23 @@ class KvStoreDb {
     folly::SemiFuture<folly::Unit> setKvStoreKeyValsWrapper(
         const std::string& area, const thrift::KeySetParams& keySetParams);
 
+    folly::SemiFuture<folly::Unit> setKvStoreKeyValsSerializedWrapper(
+        const std::string& area,
+        const std::unique_ptr<folly::IOBuf>& setParamsPayload);
+
     folly::SemiFuture<thrift::Publication> getKvStoreKeyValsFilteredAreaWrapper(
         const thrift::KeyDumpParams& filter, const std::string& area);
 
+    folly::SemiFuture<thrift::KvStoreHashTreeResult>
+    getKvStoreHashTreeAreaWrapper(
+        const thrift::KvStoreHashTreeParams& params, const std::string& area);
+
+    folly::SemiFuture<folly::Unit> processKvStoreDualMessageWrapper(
+        const thrift::DualMessages& messages, const std::string& area);
+
+    folly::SemiFuture<folly::Unit> updateFloodTopologyChildWrapper(
+        const thrift::FloodTopoSetParams& params, const std::string& area);
+
 #if FOLLY_HAS_COROUTINES
     folly::coro::Task<thrift::Publication>
     getKvStoreKeyValsFilteredAreaCoroWrapper(
@@ -473,6 +611,39 @@ class KvStoreDb {
     // peer.
     int64_t numThriftApiErrors{0};
 
+    // Whether peer serves hash tree full-sync. Reset upon learning peer
+    // doesn't support the API.
+    bool hashTreeSyncSupported{true};
+
+    // Whether peer accepts serialized flooding. Reset upon learning peer
+    // doesn't support the API.
+    bool serializedFloodingSupported{true};
+
+    // Whether peer runs DUAL for flood optimization. Peers not running it
+    // are always flooded to. Reset upon learning peer rejects DUAL messages.
+    bool dualSupported{true};
+
+    // [Per-peer flood control]
+    // Number of in-flight flooding requests towards peer
+    size_t numPendingFloodPubs{0};
+
+    // Max number of in-flight flooding requests, adapted on peer latency
+    size_t floodWindow{Constants::kFloodPeerInitWindow};
+
+    // Smoothed latency of flooding requests towards peer
+    double floodLatencyMs{0};
+
+    // Keys held back while peer is out of flood window. Updates to the same
+    // key are coalesced and latest value is sent when peer has credit, along
+    // with flood path (nodeIds) of the latest update for loop detection.
+    // map<flood-root-id: map<key: nodeIds>>
+    std::unordered_map<
+        std::optional<std::string>,
+        std::unordered_map<
+            std::string,
+            std::optional<std::vector<std::string>>>>
+        floodBacklog{};
+
     // Kv store parameters
     const KvStoreParams& kvParams_;
   };
@@ -488,12 +659,18 @@ class KvStoreDb {
   // store keys mapped to (version, originatoId, value)
   thrift::KeyVals kvStore_{};
 
+  // digests of kvStore_ for hash tree full-sync, updated along with kvStore_
+  KvStoreHashTree hashTree_{};
+
   // TTL count down queue
   TtlCountdownQueue ttlCountdownQueue_;
 
   // TTL count down timer
   std::unique_ptr<folly::AsyncTimeout> ttlCountdownTimer_{nullptr};
 
+  // time ttlCountdownTimer_ is scheduled to fire at
+  std::chrono::steady_clock::time_point ttlCountdownTimerExpiry_{};
+
   // Kvstore rate limiter
   std::unique_ptr<folly::BasicTokenBucket<>> floodLimiter_{nullptr};
 
@@ -666,6 +843,24 @@ class KvStore final : public OpenrEventBase {
   semifuture_dumpKvStoreHashes(
       std::string area, thrift::KeyDumpParams keyDumpParams);
 
+  folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+  semifuture_getKvStoreHashTree(
+      std::string area, thrift::KvStoreHashTreeParams params);
+
+  /*
+   * [Public APIs]
+   *
+   * Set of APIs to build and inspect flooding spanning tree
+   */
+  folly::SemiFuture<folly::Unit> semifuture_processKvStoreDualMessage(
+      std::string area, thrift::DualMessages messages);
+
+  folly::SemiFuture<folly::Unit> semifuture_updateFloodTopologyChild(
+      std::string area, thrift::FloodTopoSetParams params);
+
+  folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+  semifuture_getSpanningTreeInfos(std::string area);
+
   /*
    * [Public APIs]
    *
@@ -802,6 +997,9 @@ class KvStore final : public OpenrEventBase {
   thrift::Publication dumpKvStoreHashesImpl(
       std::string area, thrift::KeyDumpParams keyDumpParams);
 
+  thrift::KvStoreHashTreeResult getKvStoreHashTreeImpl(
+      std::string area, thrift::KvStoreHashTreeParams params);
+
   std::vector<thrift::KvStoreAreaSummary> getKvStoreAreaSummaryImpl(
       std::set<std::string> selectAreas);
 
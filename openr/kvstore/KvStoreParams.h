@@ -43,6 +43,16 @@ struct KvStoreParams {
   std::chrono::milliseconds syncMaxBackoff{Constants::kKvstoreSyncMaxBackoff};
   // Locally adjacency learning timeout
   std::chrono::milliseconds selfAdjSyncTimeout;
+  // Hash tree based full-sync knob
+  bool enableHashTreeSync{false};
+  // Serialize flooded publications once for all peers
+  bool enableSerializedFlooding{false};
+  // Flood along DUAL spanning tree instead of to all peers
+  bool enableFloodOptimization{false};
+  // Candidate root of flooding spanning tree
+  bool isFloodRoot{false};
+  // Per-peer adaptive flood control
+  bool enablePeerFloodControl{false};
 
   // TLS knob
   bool enable_secure_thrift_client{false};
@@ -69,6 +79,11 @@ struct KvStoreParams {
             *kvStoreConfig.sync_initial_backoff_ms())),
         syncMaxBackoff(
             std::chrono::milliseconds(*kvStoreConfig.sync_max_backoff_ms())),
+        enableHashTreeSync(*kvStoreConfig.enable_hash_tree_sync()),
+        enableSerializedFlooding(*kvStoreConfig.enable_serialized_flooding()),
+        enableFloodOptimization(*kvStoreConfig.enable_flood_optimization()),
+        isFloodRoot(*kvStoreConfig.is_flood_root()),
+        enablePeerFloodControl(*kvStoreConfig.enable_peer_flood_control()),
         enable_secure_thrift_client(
             *kvStoreConfig.enable_secure_thrift_client()),
         x509_cert_path(kvStoreConfig.x509_cert_path().to_optional()),
@@ -59,6 +59,40 @@ KvStoreServiceHandler<ClientType>::semifuture_getKvStoreHashFilteredArea(
       std::move(*area), std::move(*filter));
 }
 
+template <class ClientType>
+folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+KvStoreServiceHandler<ClientType>::semifuture_getKvStoreHashTreeArea(
+    std::unique_ptr<thrift::KvStoreHashTreeParams> params,
+    std::unique_ptr<std::string> area) {
+  return kvStore_->semifuture_getKvStoreHashTree(
+      std::move(*area), std::move(*params));
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreServiceHandler<ClientType>::semifuture_processKvStoreDualMessage(
+    std::unique_ptr<thrift::DualMessages> messages,
+    std::unique_ptr<std::string> area) {
+  return kvStore_->semifuture_processKvStoreDualMessage(
+      std::move(*area), std::move(*messages));
+}
+
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreServiceHandler<ClientType>::semifuture_updateFloodTopologyChild(
+    std::unique_ptr<thrift::FloodTopoSetParams> params,
+    std::unique_ptr<std::string> area) {
+  return kvStore_->semifuture_updateFloodTopologyChild(
+      std::move(*area), std::move(*params));
+}
+
+template <class ClientType>
+folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+KvStoreServiceHandler<ClientType>::semifuture_getSpanningTreeInfos(
+    std::unique_ptr<std::string> area) {
+  return kvStore_->semifuture_getSpanningTreeInfos(std::move(*area));
+}
+
 template <class ClientType>
 folly::SemiFuture<folly::Unit>
 KvStoreServiceHandler<ClientType>::semifuture_setKvStoreKeyVals(
@@ -68,6 +102,25 @@ KvStoreServiceHandler<ClientType>::semifuture_setKvStoreKeyVals(
       std::move(*area), std::move(*setParams));
 }
 
+template <class ClientType>
+folly::SemiFuture<folly::Unit>
+KvStoreServiceHandler<ClientType>::semifuture_setKvStoreKeyValsSerialized(
+    std::unique_ptr<folly::IOBuf> setParamsPayload,
+    std::unique_ptr<std::string> area) {
+  thrift::KeySetParams setParams;
+  try {
+    setParams =
+        apache::thrift::CompactSerializer::deserialize<thrift::KeySetParams>(
+            setParamsPayload.get());
+  } catch (std::exception const& e) {
+    return folly::makeSemiFuture<folly::Unit>(
+        folly::make_exception_wrapper<thrift::KvStoreError>(fmt::format(
+            "Malformed KeySetParams payload: {}", e.what())));
+  }
+  return kvStore_->semifuture_setKvStoreKeyVals(
+      std::move(*area), std::move(setParams));
+}
+
 template <class ClientType>
 folly::SemiFuture<std::unique_ptr<thrift::SetKeyValsResult>>
 KvStoreServiceHandler<ClientType>::semifuture_setKvStoreKeyValues(
@@ -75,6 +75,33 @@ class KvStoreServiceHandler final : public thrift::KvStoreServiceSvIf,
       std::unique_ptr<thrift::KeyDumpParams> filter,
       std::unique_ptr<std::string> area) override;
 
+  /*
+   * API to return children digests of KvStore hash tree nodes by given:
+   *  - thrift::KvStoreHashTreeParams;
+   *  - a specific area;
+   */
+  folly::SemiFuture<std::unique_ptr<thrift::KvStoreHashTreeResult>>
+  semifuture_getKvStoreHashTreeArea(
+      std::unique_ptr<thrift::KvStoreHashTreeParams> params,
+      std::unique_ptr<std::string> area) override;
+
+  /*
+   * APIs to build and inspect flooding spanning tree for flood optimization:
+   *  - process DUAL messages from peer;
+   *  - set/unset peer as SPT child;
+   *  - dump SPT information of a specific area;
+   */
+  folly::SemiFuture<folly::Unit> semifuture_processKvStoreDualMessage(
+      std::unique_ptr<thrift::DualMessages> messages,
+      std::unique_ptr<std::string> area) override;
+
+  folly::SemiFuture<folly::Unit> semifuture_updateFloodTopologyChild(
+      std::unique_ptr<thrift::FloodTopoSetParams> params,
+      std::unique_ptr<std::string> area) override;
+
+  folly::SemiFuture<std::unique_ptr<thrift::SptInfos>>
+  semifuture_getSpanningTreeInfos(std::unique_ptr<std::string> area) override;
+
   /*
    * API to set key-val pairs by given:
    *  - thrift::KeySetParams;
@@ -88,6 +115,15 @@ class KvStoreServiceHandler final : public thrift::KvStoreServiceSvIf,
       std::unique_ptr<thrift::KeySetParams> setParams,
       std::unique_ptr<std::string> area) override;
 
+  /*
+   * Same as `setKvStoreKeyVals` but with thrift::KeySetParams already
+   * compact-serialized by the sender. Used for flooding so that a
+   * publication is encoded once for all peers.
+   */
+  folly::SemiFuture<folly::Unit> semifuture_setKvStoreKeyValsSerialized(
+      std::unique_ptr<folly::IOBuf> setParamsPayload,
+      std::unique_ptr<std::string> area) override;
+
   /*
    * API to set key-val pairs by given:
    *  - thrift::KeySetParams;
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 #include <re2/re2.h>
 
@@ -392,7 +393,8 @@ mergeKeyValues(
     thrift::KeyVals& kvStore,
     thrift::KeyVals const& keyVals,
     std::optional<KvStoreFilters> const& filters,
-    std::optional<std::string> const& sender) {
+    std::optional<std::string> const& sender,
+    KvStoreHashTree* hashTree) {
   thrift::KvStoreMergeResult result;
   size_t nValUpdate{0};
   size_t nTtlUpdate{0};
@@ -442,6 +444,11 @@ mergeKeyValues(
         localTtl,
         *value.ttl());
 
+    // take the old digest out of the hash tree before updating in place
+    if (hashTree and kvStoreIt != kvStore.end()) {
+      hashTree->toggle(key, kvStoreIt->second);
+    }
+
     if (mergeType == MergeType::UPDATE_ALL_NEEDED) {
       nValUpdate++;
       util::updateKvStoreValue(kvStore, key, value);
@@ -449,6 +456,14 @@ mergeKeyValues(
       nTtlUpdate++;
       util::updateKvStoreTtl(kvStore, key, value);
     }
+
+    if (hashTree) {
+      if (kvStoreIt == kvStore.end()) {
+        hashTree->insert(key, kvStore.at(key));
+      } else {
+        hashTree->toggle(key, kvStore.at(key));
+      }
+    }
     // announce the update
     result.keyVals()->emplace(key, value);
   }
@@ -698,6 +713,159 @@ dumpHashWithFilters(
   }
   return thriftPub;
 }
+
+// dump the entries of my KV store falling into given hash tree leaves
+thrift::Publication
+dumpAllWithLeaves(
+    const std::string& area,
+    const thrift::KeyVals& kvStore,
+    const KvStoreHashTree& hashTree,
+    const std::vector<int64_t>& leaves,
+    const KvStoreFilters& kvFilters,
+    bool doNotPublishValue) {
+  thrift::Publication thriftPub;
+  thriftPub.area() = area;
+
+  for (auto const& leaf : leaves) {
+    for (auto const& key : hashTree.getLeafKeys(leaf)) {
+      auto it = kvStore.find(key);
+      if (it == kvStore.end() or not kvFilters.keyMatch(key, it->second)) {
+        continue;
+      }
+      if (not doNotPublishValue) {
+        thriftPub.keyVals()[key] = it->second;
+      } else {
+        thriftPub.keyVals()[key] =
+            createThriftValueWithoutBinaryValue(it->second);
+      }
+    }
+  }
+
+  return thriftPub;
+}
+
+// dump the hashes of my KV store falling into given hash tree leaves
+thrift::Publication
+dumpHashWithLeaves(
+    const std::string& area,
+    const thrift::KeyVals& kvStore,
+    const KvStoreHashTree& hashTree,
+    const std::vector<int64_t>& leaves) {
+  thrift::Publication thriftPub;
+  thriftPub.area() = area;
+  for (auto const& leaf : leaves) {
+    for (auto const& key : hashTree.getLeafKeys(leaf)) {
+      auto it = kvStore.find(key);
+      if (it == kvStore.end()) {
+        continue;
+      }
+      auto const& val = it->second;
+      DCHECK(val.hash().has_value());
+      auto& value = thriftPub.keyVals()[key];
+      value.version() = *val.version();
+      value.originatorId() = *val.originatorId();
+      value.hash().copy_from(val.hash());
+      value.ttl() = *val.ttl();
+      value.ttlVersion() = *val.ttlVersion();
+    }
+  }
+  return thriftPub;
+}
+
+namespace {
+
+// digest of everything `compareValues` looks at to declare two values TIED
+uint64_t
+hashTreeDigest(std::string const& key, thrift::Value const& value) {
+  uint64_t digest = folly::hash::fnv64(key);
+  digest = folly::hash::hash_128_to_64(digest, *value.version());
+  digest = folly::hash::hash_128_to_64(
+      digest, folly::hash::fnv64(*value.originatorId()));
+  digest = folly::hash::hash_128_to_64(digest, value.hash().value_or(0));
+  digest = folly::hash::hash_128_to_64(digest, *value.ttlVersion());
+  return digest;
+}
+
+} // namespace
+
+KvStoreHashTree::KvStoreHashTree() {
+  size_t numNodes = 1;
+  for (int32_t level = 0; level <= kDepth; ++level) {
+    levels_.emplace_back(numNodes, 0);
+    numNodes *= kFanout;
+  }
+  leafKeys_.resize(levels_.back().size());
+}
+
+int64_t
+KvStoreHashTree::getLeaf(std::string const& key) {
+  // use the top bits, low bits of fnv are poorly mixed
+  return folly::hash::twang_mix64(folly::hash::fnv64(key)) >>
+      (64 - kFanoutBits * kDepth);
+}
+
+void
+KvStoreHashTree::toggle(std::string const& key, thrift::Value const& value) {
+  const auto digest = hashTreeDigest(key, value);
+  auto node = getLeaf(key);
+  for (int32_t level = kDepth; level >= 0; --level) {
+    levels_[level][node] ^= digest;
+    node >>= kFanoutBits;
+  }
+}
+
+void
+KvStoreHashTree::insert(std::string const& key, thrift::Value const& value) {
+  toggle(key, value);
+  leafKeys_[getLeaf(key)].emplace_back(key);
+}
+
+void
+KvStoreHashTree::erase(std::string const& key, thrift::Value const& value) {
+  toggle(key, value);
+  auto& keys = leafKeys_[getLeaf(key)];
+  auto it = std::find(keys.begin(), keys.end(), key);
+  if (it != keys.end()) {
+    // order within a leaf doesn't matter
+    *it = std::move(keys.back());
+    keys.pop_back();
+  }
+}
+
+int64_t
+KvStoreHashTree::getHash(int32_t level, int64_t node) const {
+  return levels_.at(level).at(node);
+}
+
+std::vector<int64_t>
+KvStoreHashTree::getChildHashes(
+    int32_t level, std::vector<int64_t> const& nodes) const {
+  if (level < 0 or level >= kDepth) {
+    throw std::out_of_range(fmt::format("Invalid hash tree level: {}", level));
+  }
+  auto const& children = levels_.at(level + 1);
+  std::vector<int64_t> hashes;
+  hashes.reserve(nodes.size() * kFanout);
+  for (auto const& node : nodes) {
+    if (node < 0 or node >= static_cast<int64_t>(levels_.at(level).size())) {
+      throw std::out_of_range(fmt::format(
+          "Invalid hash tree node: {} at level: {}", node, level));
+    }
+    for (int64_t i = 0; i < kFanout; ++i) {
+      hashes.emplace_back(children.at((node << kFanoutBits) + i));
+    }
+  }
+  return hashes;
+}
+
+std::vector<std::string> const&
+KvStoreHashTree::getLeafKeys(int64_t leaf) const {
+  static const std::vector<std::string> kEmpty;
+  if (leaf < 0 or leaf >= static_cast<int64_t>(leafKeys_.size())) {
+    return kEmpty;
+  }
+  return leafKeys_.at(leaf);
+}
 // update TTL with remainng time to expire, TTL version remains
 // same so existing keys will not be updated with this TTL
 void
@@ -707,27 +875,28 @@ updatePublicationTtl(
     thrift::Publication& thriftPub,
     const bool removeAboutToExpire) {
   auto timeNow = std::chrono::steady_clock::now();
-  for (const auto& qE : ttlCountdownQueue) {
+  auto& keyVals = *thriftPub.keyVals();
+  for (auto kv = keyVals.begin(); kv != keyVals.end();) {
     // Find key and ensure we are taking time from right entry from queue
-    auto kv = thriftPub.keyVals()->find(qE.key);
-    if (kv == thriftPub.keyVals()->end() or
-        *kv->second.version() != qE.version or
-        *kv->second.originatorId() != qE.originatorId or
-        *kv->second.ttlVersion() != qE.ttlVersion) {
+    const auto* qE = ttlCountdownQueue.find(kv->first);
+    if (not qE or *kv->second.version() != qE->version or
+        *kv->second.originatorId() != qE->originatorId or
+        *kv->second.ttlVersion() != qE->ttlVersion) {
+      ++kv;
       continue;
     }
 
     // Compute timeLeft and do sanity check on it
     auto timeLeft = std::chrono::duration_cast<std::chrono::milliseconds>(
-        qE.expiryTime - timeNow);
+        qE->expiryTime - timeNow);
     if (timeLeft <= ttlDecr) {
-      thriftPub.keyVals()->erase(kv);
+      kv = keyVals.erase(kv);
       continue;
     }
 
     // filter key from publication if time left is below ttl threshold
     if (removeAboutToExpire and (timeLeft < Constants::kTtlThreshold)) {
-      thriftPub.keyVals()->erase(kv);
+      kv = keyVals.erase(kv);
       continue;
     }
 
@@ -735,6 +904,7 @@ updatePublicationTtl(
     // deterministically whenever it is exchanged between KvStores. This
     // will avoid looping of updates between stores.
     kv->second.ttl() = timeLeft.count() - ttlDecr.count();
+    ++kv;
   }
 }
 
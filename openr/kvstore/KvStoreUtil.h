@@ -103,6 +103,56 @@ class KvStoreFilters {
   thrift::FilterOperator filterOperator_;
 };
 
+/*
+ * Summary of a KvStore as a fixed shape hash tree, used for hash tree
+ * full-sync.
+ *
+ * Every key falls into one leaf picked by the hash of the key. Each tree node
+ * holds the XOR of digests of (key, version, originatorId, hash, ttlVersion)
+ * underneath it. XOR keeps updates O(depth) and independent of update order,
+ * so stores with the same content always end up with the same tree.
+ */
+class KvStoreHashTree {
+ public:
+  static constexpr int32_t kFanoutBits{4};
+  static constexpr int32_t kFanout{1 << kFanoutBits};
+  // 4096 leaves, i.e. ~50 keys per leaf with 200k keys
+  static constexpr int32_t kDepth{3};
+
+  KvStoreHashTree();
+
+  // add new key-val to the tree
+  void insert(std::string const& key, thrift::Value const& value);
+
+  // remove key-val from the tree
+  void erase(std::string const& key, thrift::Value const& value);
+
+  // flip digest of key-val already in the tree. An in-place value update is
+  // done by toggling the old value out and the new value in
+  void toggle(std::string const& key, thrift::Value const& value);
+
+  // digest of the tree node, root is (level = 0, node = 0)
+  int64_t getHash(int32_t level, int64_t node) const;
+
+  // digests of children of given nodes at `level`, `kFanout` per node.
+  // throws std::out_of_range on invalid level/node
+  std::vector<int64_t> getChildHashes(
+      int32_t level, std::vector<int64_t> const& nodes) const;
+
+  // keys under the leaf, empty for invalid leaf
+  std::vector<std::string> const& getLeafKeys(int64_t leaf) const;
+
+  // leaf the key falls into
+  static int64_t getLeaf(std::string const& key);
+
+ private:
+  // digests per level, level `l` holds kFanout^l nodes
+  std::vector<std::vector<uint64_t>> levels_;
+
+  // keys per leaf
+  std::vector<std::vector<std::string>> leafKeys_;
+};
+
 // helper for deserialization
 template <typename ThriftType>
 static ThriftType parseThriftValue(thrift::Value const& value);
@@ -236,7 +286,8 @@ thrift::KvStoreMergeResult mergeKeyValues(
     thrift::KeyVals& kvStore,
     const thrift::KeyVals& keyVals,
     std::optional<KvStoreFilters> const& filters = std::nullopt,
-    std::optional<std::string> const& senderName = std::nullopt);
+    std::optional<std::string> const& senderName = std::nullopt,
+    KvStoreHashTree* hashTree = nullptr);
 
 /*
  * Compare two thrift::Values to figure out which value is better to
@@ -277,6 +328,23 @@ thrift::Publication dumpHashWithFilters(
     const thrift::KeyVals& kvStore,
     const KvStoreFilters& kvFilters);
 
+// Dump the entries of my KV store falling into given hash tree leaves and
+// matching the filter
+thrift::Publication dumpAllWithLeaves(
+    const std::string& area,
+    const thrift::KeyVals& kvStore,
+    const KvStoreHashTree& hashTree,
+    const std::vector<int64_t>& leaves,
+    const KvStoreFilters& kvFilters,
+    bool doNotPublishValue = false);
+
+// Dump the hashes of my KV store falling into given hash tree leaves
+thrift::Publication dumpHashWithLeaves(
+    const std::string& area,
+    const thrift::KeyVals& kvStore,
+    const KvStoreHashTree& hashTree,
+    const std::vector<int64_t>& leaves);
+
 // Update Time to expire filed in Publication
 // If timeleft is below Constants::kTtlThreshold and removeAboutToExpire is
 // true, erase keyVals
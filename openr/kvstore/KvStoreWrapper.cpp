@@ -422,6 +422,12 @@ KvStoreWrapper<ClientType>::getPeers(AreaId const& area) {
   return peers;
 }
 
+template <class ClientType>
+thrift::SptInfos
+KvStoreWrapper<ClientType>::getFloodTopo(AreaId const& area) {
+  return *(kvStore_->semifuture_getSpanningTreeInfos(area).get());
+}
+
 template <class ClientType>
 std::vector<thrift::KvStoreAreaSummary>
 KvStoreWrapper<ClientType>::getSummary(std::set<std::string> selectAreas) {
@@ -195,6 +195,11 @@ class KvStoreWrapper {
   std::unordered_map<std::string /* peerName */, thrift::PeerSpec> getPeers(
       AreaId const& area);
 
+  /**
+   * API to get flooding spanning tree information of a KvStore area.
+   */
+  thrift::SptInfos getFloodTopo(AreaId const& area);
+
   /**
    * API to get summary of each KvStore area provided as input.
    */
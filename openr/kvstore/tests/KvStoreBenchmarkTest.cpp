@@ -519,6 +519,73 @@ BM_KvStoreUpdatePubTtl(
   }
 }
 
+/*
+ * Benchmark test for ttl refreshing:
+ * Tech setup:
+ *  - Push `numOfKeys` entries into ttlCountdownQueue
+ * Benchmark:
+ *  - Refresh ttl of every key once per `kTtlDecrement` for `numOfRefreshes`
+ *    rounds and expire due entries after each round, as the ttl countdown
+ *    timer does
+ */
+static void
+BM_KvStoreTtlRefresh(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    uint32_t numOfKeys,
+    uint32_t numOfRefreshes) {
+  // Spawn suspender object to NOT calculating setup time into benchmark
+  auto suspender = folly::BenchmarkSuspender();
+  SystemMetrics sysMetrics;
+  bool record = true;
+
+  for (int i = 0; i < iters; ++i) {
+    const auto startTime = std::chrono::steady_clock::now();
+    TtlCountdownQueue ttlCountdownQueue(startTime);
+    std::vector<TtlCountdownQueueEntry> queueEntries;
+    for (uint32_t j = 0; j < numOfKeys; ++j) {
+      TtlCountdownQueueEntry queueEntry;
+      queueEntry.expiryTime = startTime + std::chrono::milliseconds(kTtl);
+      queueEntry.key = genRandomStr(kKeyLen);
+      queueEntry.version = 1;
+      queueEntry.originatorId = "originator";
+      ttlCountdownQueue.push(queueEntry);
+      queueEntries.emplace_back(std::move(queueEntry));
+    }
+
+    if (record) {
+      auto mem = sysMetrics.getVirtualMemBytes();
+      if (mem.has_value()) {
+        counters["memory_before_opertion(MB)"] = mem.value() / 1024 / 1024;
+      }
+    }
+    // Start measuring time
+    suspender.dismiss();
+
+    auto now = startTime;
+    for (uint32_t round = 0; round < numOfRefreshes; ++round) {
+      now += Constants::kTtlDecrement;
+      for (auto& queueEntry : queueEntries) {
+        queueEntry.expiryTime = now + std::chrono::milliseconds(kTtl);
+        queueEntry.ttlVersion += 1;
+        ttlCountdownQueue.push(queueEntry);
+      }
+      ttlCountdownQueue.popExpired(now);
+    }
+
+    // Stop measuring time
+    suspender.rehire();
+    if (record) {
+      counters["queue_size"] = ttlCountdownQueue.size();
+      auto mem = sysMetrics.getVirtualMemBytes();
+      if (mem.has_value()) {
+        counters["memory_after_operation(MB)"] = mem.value() / 1024 / 1024;
+      }
+      record = false;
+    }
+  }
+}
+
 /*
  * Benchmark test for dumpAllWithFilters:
  * Tech setup:
@@ -787,6 +854,16 @@ BENCHMARK_COUNTERS_PARAM(BM_KvStoreUpdatePubTtl, counters, 1000000, 100);
 BENCHMARK_COUNTERS_PARAM(BM_KvStoreUpdatePubTtl, counters, 1000000, 10000);
 BENCHMARK_COUNTERS_PARAM(BM_KvStoreUpdatePubTtl, counters, 1000000, 1000000);
 
+/*
+ * @first integer: num of keys in ttlCountdownQueue
+ * @second integer: num of rounds every key gets ttl refreshed
+ */
+
+BENCHMARK_COUNTERS_PARAM(BM_KvStoreTtlRefresh, counters, 1000, 10);
+BENCHMARK_COUNTERS_PARAM(BM_KvStoreTtlRefresh, counters, 10000, 10);
+BENCHMARK_COUNTERS_PARAM(BM_KvStoreTtlRefresh, counters, 100000, 10);
+BENCHMARK_COUNTERS_PARAM(BM_KvStoreTtlRefresh, counters, 100000, 100);
+
 /*
  * @first integer: num of existing keyVals in unordered_map
  * @second integer: num of keys to be matched in the filter setting
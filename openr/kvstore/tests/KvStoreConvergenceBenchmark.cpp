@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <fb303/ServiceData.h>
 #include <folly/Benchmark.h>
 
 #if FOLLY_HAS_COROUTINES
@@ -12,6 +13,7 @@
 #include <folly/init/Init.h>
 #include <folly/logging/Init.h>
 #include <folly/logging/xlog.h>
+#include <thread>
 
 #include "common/init/Init.h"
 
@@ -22,12 +24,30 @@
 
 using namespace openr;
 
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                            \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),            \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                       \
+      iters,                                                          \
+      unsigned,                                                       \
+      iters) {                                                        \
+    name(counters, iters, ##__VA_ARGS__);                             \
+  }
+
 FOLLY_INIT_LOGGING_CONFIG(
     ".=WARNING"
     ";default:async=true,sync_level=WARNING");
 
 namespace {
 const std::unordered_set<std::string> areaIds{kTestingAreaName};
+
+int64_t
+getCounter(const std::string& key) {
+  auto counters = fb303::fbData->getCounters();
+  auto it = counters.find(key);
+  return it == counters.end() ? 0 : it->second;
+}
 } // namespace
 
 void
@@ -142,6 +162,85 @@ runExperiment(
 #pragma endregion TearDown
 }
 
+/*
+ * Flood `n` new keys across a full-mesh cluster and report the number of
+ * flooded publications and DUAL messages exchanged to converge. With flood
+ * optimization enabled, node 0 is the flood root and publications only follow
+ * the flooding spanning tree instead of every adjacency.
+ */
+void
+runFloodOptimizationExperiment(
+    folly::UserCounters& counters,
+    uint32_t n,
+    size_t nNodes,
+    bool enableFloodOptimization) {
+  std::vector<std::unique_ptr<
+      KvStoreWrapper<::apache::thrift::Client<thrift::KvStoreService>>>>
+      kvStoreWrappers_;
+  thrift::KeyVals events_;
+  std::vector<std::pair<std::string, thrift::Value>> keyVals;
+  int64_t numFloodPub{0};
+  int64_t numDualMsg{0};
+
+  BENCHMARK_SUSPEND {
+    kvStoreWrappers_.reserve(nNodes);
+
+    for (size_t i = 0; i < nNodes; i++) {
+      thrift::KvStoreConfig kvStoreConfig;
+      kvStoreConfig.node_name() = genNodeName(i);
+      kvStoreConfig.enable_flood_optimization() = enableFloodOptimization;
+      kvStoreConfig.is_flood_root() = (i == 0);
+      kvStoreWrappers_.emplace_back(
+          std::make_unique<
+              KvStoreWrapper<::apache::thrift::Client<thrift::KvStoreService>>>(
+              areaIds, kvStoreConfig));
+      kvStoreWrappers_.at(i)->run();
+    }
+
+    generateTopo(kvStoreWrappers_, ClusterTopology::FULL_MESH);
+
+    // Wait for every node to attach to the flooding spanning tree
+    if (enableFloodOptimization) {
+      const auto rootId = kvStoreWrappers_.front()->getNodeId();
+      for (auto& store : kvStoreWrappers_) {
+        while (store->getFloodTopo(kTestingAreaName)
+                   .floodRootId()
+                   .value_or("") != rootId) {
+          /* sleep override */
+          std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+      }
+    }
+
+    auto nodeId = kvStoreWrappers_.back()->getNodeId();
+    keyVals.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+      auto key = genRandomStrWithPrefix("newKey-", kSizeOfKey);
+      auto val = createThriftValue(
+          1, nodeId, genRandomStrWithPrefix("newVal-", kSizeOfValue));
+      events_.emplace(key, val);
+      keyVals.emplace_back(std::move(key), std::move(val));
+    }
+
+    numFloodPub = getCounter("kvstore.thrift.num_flood_pub.count");
+    numDualMsg = getCounter("kvstore.thrift.num_dual_msg.count");
+  } // end of BENCHMARK_SUSPEND
+
+  kvStoreWrappers_.back()->setKeys(kTestingAreaName, keyVals);
+  folly::coro::blockingWait(co_waitForConvergence(events_, kvStoreWrappers_));
+
+  BENCHMARK_SUSPEND {
+    counters["flood_pub"] =
+        getCounter("kvstore.thrift.num_flood_pub.count") - numFloodPub;
+    counters["dual_msg"] =
+        getCounter("kvstore.thrift.num_dual_msg.count") - numDualMsg;
+
+    kvStoreWrappers_.clear();
+    events_.clear();
+    keyVals.clear();
+  }
+}
+
 #pragma region LINEAR
 BENCHMARK_NAMED_PARAM(
     runExperiment,
@@ -744,6 +843,47 @@ BENCHMARK_RELATIVE_NAMED_PARAM(
 
 BENCHMARK_DRAW_LINE();
 
+#pragma region FULL_MESH_FLOOD_OPTIMIZATION
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    10_NODE_FULL_MESH_FULL_FLOOD,
+    /* nNodes = */ 10,
+    /* enableFloodOptimization = */ false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    10_NODE_FULL_MESH_SPT_FLOOD,
+    /* nNodes = */ 10,
+    /* enableFloodOptimization = */ true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    20_NODE_FULL_MESH_FULL_FLOOD,
+    /* nNodes = */ 20,
+    /* enableFloodOptimization = */ false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    20_NODE_FULL_MESH_SPT_FLOOD,
+    /* nNodes = */ 20,
+    /* enableFloodOptimization = */ true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    50_NODE_FULL_MESH_FULL_FLOOD,
+    /* nNodes = */ 50,
+    /* enableFloodOptimization = */ false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    runFloodOptimizationExperiment,
+    counters,
+    50_NODE_FULL_MESH_SPT_FLOOD,
+    /* nNodes = */ 50,
+    /* enableFloodOptimization = */ true);
+#pragma endregion FULL_MESH_FLOOD_OPTIMIZATION
+
+BENCHMARK_DRAW_LINE();
+
 #endif
 
 int
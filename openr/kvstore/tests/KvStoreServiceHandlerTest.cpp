@@ -7,6 +7,7 @@
 
 #include <folly/init/Init.h>
 #include <gtest/gtest.h>
+#include <thrift/lib/cpp2/protocol/Serializer.h>
 
 #include <openr/common/Types.h>
 #include <openr/common/Util.h>
@@ -140,3 +141,29 @@ TEST_F(KvStoreServiceHandlerTestFixture, KvStoreApis) {
     EXPECT_EQ(0, keyVals.size());
   }
 }
+
+TEST_F(KvStoreServiceHandlerTestFixture, SetKeyValsSerialized) {
+  thrift::KeySetParams params;
+  params.keyVals() = {
+      {"key1", createThriftValue(1, nodeName_, std::string("value1"))}};
+  const auto payload =
+      apache::thrift::CompactSerializer::serialize<std::string>(params);
+
+  // corrupt (truncated) payload is rejected without touching the store
+  EXPECT_THROW(
+      handler_
+          ->semifuture_setKvStoreKeyValsSerialized(
+              folly::IOBuf::copyBuffer(payload.data(), payload.size() / 2),
+              std::make_unique<std::string>(kTestingAreaName))
+          .get(),
+      thrift::KvStoreError);
+  EXPECT_FALSE(kvStoreWrapper_->getKey(kTestingAreaName, "key1").has_value());
+
+  // valid payload is applied as setKvStoreKeyVals
+  handler_
+      ->semifuture_setKvStoreKeyValsSerialized(
+          folly::IOBuf::copyBuffer(payload),
+          std::make_unique<std::string>(kTestingAreaName))
+      .get();
+  EXPECT_TRUE(kvStoreWrapper_->getKey(kTestingAreaName, "key1").has_value());
+}
@@ -6,8 +6,10 @@
  */
 
 #include <fb303/ServiceData.h>
+#include <folly/ScopeGuard.h>
 #include <folly/experimental/coro/GtestHelpers.h>
 #include <folly/init/Init.h>
+#include <folly/synchronization/Baton.h>
 #include <gtest/gtest.h>
 #include <thrift/lib/cpp2/protocol/Serializer.h>
 
@@ -2368,6 +2370,221 @@ TEST_F(KvStoreTestFixture, RateLimiterFlood) {
   EXPECT_EQ(expectNumKeys, kv2.size());
 }
 
+/*
+ * s0 -- s1 (serialized flooding) -- s2
+ * let s1 set keys and make sure the publication is encoded once and sent to
+ * both peers as is.
+ */
+TEST_F(KvStoreTestFixture, SerializedFlooding) {
+  fb303::fbData->resetAllData();
+
+  auto serializedConf = getTestKvConf("store1");
+  serializedConf.enable_serialized_flooding() = true;
+
+  auto store0 = createKvStore(getTestKvConf("store0"));
+  auto store1 = createKvStore(serializedConf);
+  auto store2 = createKvStore(getTestKvConf("store2"));
+
+  store0->run();
+  store1->run();
+  store2->run();
+
+  store0->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+  store1->addPeer(kTestingAreaName, store0->getNodeId(), store0->getPeerSpec());
+
+  store1->addPeer(kTestingAreaName, store2->getNodeId(), store2->getPeerSpec());
+  store2->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+
+  const int numKeys{10};
+  for (int i = 0; i < numKeys; ++i) {
+    auto thriftVal = createThriftValue(
+        1 /* version */,
+        "store1" /* originatorId */,
+        "value" /* value */,
+        300000 /* ttl */,
+        1 /* ttl version */,
+        0 /* hash */);
+    thriftVal.hash() = generateHash(
+        *thriftVal.version(), *thriftVal.originatorId(), thriftVal.value());
+    EXPECT_TRUE(
+        store1->setKey(kTestingAreaName, fmt::format("key{}", i), thriftVal));
+  }
+
+  // wait for keys to reach both peers
+  auto startTime = steady_clock::now();
+  while (store0->dumpAll(kTestingAreaName).size() < numKeys or
+         store2->dumpAll(kTestingAreaName).size() < numKeys) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  for (int i = 0; i < numKeys; ++i) {
+    const auto key = fmt::format("key{}", i);
+    EXPECT_TRUE(store0->getKey(kTestingAreaName, key).has_value());
+    EXPECT_TRUE(store2->getKey(kTestingAreaName, key).has_value());
+  }
+
+  // every publication from store1 is encoded once and sent to both peers
+  auto counters = fb303::fbData->getCounters();
+  const auto bytesEncoded =
+      counters.at("kvstore.thrift.flood_bytes_encoded.sum");
+  const auto bytesSent = counters.at("kvstore.thrift.flood_bytes_sent.sum");
+  EXPECT_GT(bytesEncoded, 0);
+  EXPECT_EQ(2 * bytesEncoded, bytesSent);
+}
+
+/**
+ * Burst updates of the same key out of a store with per-peer flood control.
+ * Updates held back for peers out of flood window are coalesced and every
+ * peer converges to the latest version.
+ */
+TEST_F(KvStoreTestFixture, PeerFloodControl) {
+  fb303::fbData->resetAllData();
+
+  auto floodControlConf = getTestKvConf("store1");
+  floodControlConf.enable_peer_flood_control() = true;
+
+  auto store0 = createKvStore(getTestKvConf("store0"));
+  auto store1 = createKvStore(floodControlConf);
+  auto store2 = createKvStore(getTestKvConf("store2"));
+
+  store0->run();
+  store1->run();
+  store2->run();
+
+  store0->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+  store1->addPeer(kTestingAreaName, store0->getNodeId(), store0->getPeerSpec());
+
+  store1->addPeer(kTestingAreaName, store2->getNodeId(), store2->getPeerSpec());
+  store2->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+
+  // wait for initial sync with both peers to complete
+  auto startTime = steady_clock::now();
+  while (store1->getPeerState(kTestingAreaName, store0->getNodeId()) !=
+             thrift::KvStorePeerState::INITIALIZED or
+         store1->getPeerState(kTestingAreaName, store2->getNodeId()) !=
+             thrift::KvStorePeerState::INITIALIZED) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // updates are queued at once, hence peers fall behind the flood window
+  const int64_t numUpdates{200};
+  std::vector<folly::SemiFuture<folly::Unit>> updates;
+  for (int64_t version = 1; version <= numUpdates; ++version) {
+    thrift::KeySetParams params;
+    params.keyVals()->emplace(
+        "key",
+        createThriftValue(
+            version /* version */,
+            "store1" /* originatorId */,
+            fmt::format("value{}", version) /* value */,
+            Constants::kTtlInfinity /* ttl */));
+    updates.emplace_back(store1->getKvStore()->semifuture_setKvStoreKeyVals(
+        kTestingAreaName, std::move(params)));
+  }
+  folly::collectAll(std::move(updates)).get();
+
+  // both peers end up with the latest value
+  auto isConverged = [&](auto* store) {
+    auto val = store->getKey(kTestingAreaName, "key");
+    return val.has_value() and *val->version() == numUpdates;
+  };
+  startTime = steady_clock::now();
+  while (not isConverged(store0) or not isConverged(store2)) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // updates held back are coalesced, hence fewer publications than one per
+  // update and peer are sent
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_GT(counters.at("kvstore.thrift.num_flood_pub_backlogged.count"), 0);
+  EXPECT_LT(counters.at("kvstore.thrift.num_flood_pub.count"), 2 * numUpdates);
+}
+
+/**
+ * A stalled peer fills its flood window and gets updates held back, while a
+ * healthy peer keeps receiving them without delay. Held back updates reach
+ * the stalled peer once it resumes.
+ */
+TEST_F(KvStoreTestFixture, PeerFloodControlStalledPeer) {
+  fb303::fbData->resetAllData();
+
+  auto floodControlConf = getTestKvConf("store1");
+  floodControlConf.enable_peer_flood_control() = true;
+
+  auto store0 = createKvStore(getTestKvConf("store0"));
+  auto store1 = createKvStore(floodControlConf);
+  auto store2 = createKvStore(getTestKvConf("store2"));
+
+  store0->run();
+  store1->run();
+  store2->run();
+
+  store0->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+  store1->addPeer(kTestingAreaName, store0->getNodeId(), store0->getPeerSpec());
+
+  store1->addPeer(kTestingAreaName, store2->getNodeId(), store2->getPeerSpec());
+  store2->addPeer(kTestingAreaName, store1->getNodeId(), store1->getPeerSpec());
+
+  // wait for initial sync with both peers to complete
+  auto startTime = steady_clock::now();
+  while (store1->getPeerState(kTestingAreaName, store0->getNodeId()) !=
+             thrift::KvStorePeerState::INITIALIZED or
+         store1->getPeerState(kTestingAreaName, store2->getNodeId()) !=
+             thrift::KvStorePeerState::INITIALIZED) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // stall store2 from serving flooding requests. Baton is shared as stalled
+  // event base may still be waking up when test returns.
+  auto resumeBaton = std::make_shared<folly::Baton<>>();
+  store2->getKvStore()->runInEventBaseThread(
+      [resumeBaton]() noexcept { resumeBaton->wait(); });
+  SCOPE_EXIT {
+    if (not resumeBaton->ready()) {
+      resumeBaton->post();
+    }
+  };
+
+  // every update reaches store0 in time, well below thrift timeout of the
+  // requests store2 holds, while store2 runs out of flood window
+  const size_t numKeys{2 * Constants::kFloodPeerMaxWindow};
+  startTime = steady_clock::now();
+  for (size_t i = 0; i < numKeys; ++i) {
+    const auto key = fmt::format("key{}", i);
+    EXPECT_TRUE(store1->setKey(
+        kTestingAreaName,
+        key,
+        createThriftValue(
+            1 /* version */,
+            "store1" /* originatorId */,
+            "value" /* value */,
+            Constants::kTtlInfinity /* ttl */)));
+    while (not store0->getKey(kTestingAreaName, key).has_value()) {
+      ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(1));
+      std::this_thread::yield();
+    }
+  }
+  auto counters = fb303::fbData->getCounters();
+  EXPECT_GT(counters.at("kvstore.thrift.num_flood_pub_backlogged.count"), 0);
+
+  // store2 catches up with all updates once resumed
+  resumeBaton->post();
+  startTime = steady_clock::now();
+  while (store2->dumpAll(kTestingAreaName).size() < numKeys) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
 TEST_F(KvStoreTestFixture, RateLimiter) {
   fb303::fbData->resetAllData();
 
@@ -2661,6 +2878,216 @@ TEST_F(KvStoreTestFixture, FullSync) {
   evbThread.join();
 }
 
+/*
+ * Same as FullSync, but with hash tree full-sync enabled. Both stores share
+ * a large set of identical keys, only the differing leaves are exchanged.
+ */
+TEST_F(KvStoreTestFixture, HashTreeFullSync) {
+  auto confA = getTestKvConf("storeA");
+  confA.enable_hash_tree_sync() = true;
+  auto storeA = createKvStore(confA);
+  auto storeB = createKvStore(getTestKvConf("storeB"));
+  storeA->run();
+  storeB->run();
+
+  auto makeValue = [](int version,
+                      std::string const& originatorId,
+                      std::string const& value) {
+    thrift::Value val = createThriftValue(
+        version /* version */,
+        originatorId /* originatorId */,
+        value /* value */,
+        30000 /* ttl */,
+        99 /* ttl version */,
+        0 /* hash*/
+    );
+    val.hash() = generateHash(*val.version(), *val.originatorId(), val.value());
+    return val;
+  };
+
+  // keys in sync on both stores
+  for (int i = 0; i < 100; ++i) {
+    const auto val = makeValue(1, "storeC", "c");
+    const auto key = fmt::format("common-key{}", i);
+    EXPECT_TRUE(storeA->setKey(kTestingAreaName, key, val));
+    EXPECT_TRUE(storeB->setKey(kTestingAreaName, key, val));
+  }
+
+  // storeA has (k0, 5, a), (k1, 1, a)
+  // storeB has             (k1, 9, b), (k2, 6, b)
+  const std::string k0{"key0"};
+  const std::string k1{"key1"};
+  const std::string k2{"key2"};
+  EXPECT_TRUE(
+      storeA->setKey(kTestingAreaName, k0, makeValue(5, "storeA", "a")));
+  EXPECT_TRUE(
+      storeA->setKey(kTestingAreaName, k1, makeValue(1, "storeA", "a")));
+  EXPECT_TRUE(
+      storeB->setKey(kTestingAreaName, k1, makeValue(9, "storeB", "b")));
+  EXPECT_TRUE(
+      storeB->setKey(kTestingAreaName, k2, makeValue(6, "storeB", "b")));
+
+  // let A sends a hash tree full sync request to B and wait for completion
+  storeA->addPeer(kTestingAreaName, "storeB", storeB->getPeerSpec());
+  OpenrEventBase evb;
+  folly::Baton waitBaton;
+  evb.scheduleTimeout(std::chrono::milliseconds(1000), [&]() noexcept {
+    // after full-sync, we expect both A and B have:
+    // (k0, 5, a), (k1, 9, b), (k2, 6, b) and all common keys
+    auto dumpA = storeA->dumpAll(kTestingAreaName);
+    auto dumpB = storeB->dumpAll(kTestingAreaName);
+    EXPECT_EQ(103, dumpA.size());
+    EXPECT_EQ(103, dumpB.size());
+    for (const auto& [key, valA] : dumpA) {
+      ASSERT_TRUE(dumpB.count(key));
+      EXPECT_EQ(valA.value().value(), dumpB.at(key).value().value());
+      EXPECT_EQ(*valA.version(), *dumpB.at(key).version());
+    }
+    EXPECT_EQ(*dumpA.at(k0).version(), 5);
+    EXPECT_EQ(*dumpA.at(k1).version(), 9);
+    EXPECT_EQ(dumpA.at(k1).value().value(), "b");
+    EXPECT_EQ(*dumpA.at(k2).version(), 6);
+
+    // both stores end up with the same hash tree
+    thrift::KvStoreHashTreeParams params;
+    params.level() = 0;
+    params.nodes() = {0};
+    auto treeA = storeA->getKvStore()
+                     ->semifuture_getKvStoreHashTree(kTestingAreaName, params)
+                     .get();
+    auto treeB = storeB->getKvStore()
+                     ->semifuture_getKvStoreHashTree(kTestingAreaName, params)
+                     .get();
+    EXPECT_EQ(*treeA->childHashes(), *treeB->childHashes());
+
+    // Synchronization primitive
+    waitBaton.post();
+  });
+
+  // Start the event loop and wait until it is finished execution.
+  std::thread evbThread([&]() { evb.run(); });
+  evb.waitUntilRunning();
+
+  // Synchronization primitive
+  waitBaton.wait();
+
+  evb.stop();
+  evb.waitUntilStopped();
+  evbThread.join();
+}
+
+/*
+ * Verify flood optimization builds a flooding spanning tree over a full-mesh
+ * and floods along it only. StoreE doesn't run DUAL and is always flooded to.
+ *
+ * Topology:
+ *
+ *  StoreA(root) -- full mesh -- StoreB, StoreC, StoreD
+ *                                  |
+ *                                StoreE (flood optimization disabled)
+ */
+TEST_F(KvStoreTestFixture, FloodOptimization) {
+  auto getFloodConf = [](std::string const& nodeId, bool isFloodRoot) {
+    auto conf = getTestKvConf(nodeId);
+    conf.enable_flood_optimization() = true;
+    conf.is_flood_root() = isFloodRoot;
+    return conf;
+  };
+
+  std::vector<KvStoreWrapper<thrift::KvStoreServiceAsyncClient>*> meshStores{
+      createKvStore(getFloodConf("storeA", true /* root */)),
+      createKvStore(getFloodConf("storeB", false)),
+      createKvStore(getFloodConf("storeC", false)),
+      createKvStore(getFloodConf("storeD", false))};
+  auto storeE = createKvStore(getTestKvConf("storeE"));
+  for (auto* store : meshStores) {
+    store->run();
+  }
+  storeE->run();
+
+  for (auto* store : meshStores) {
+    for (auto* peer : meshStores) {
+      if (store != peer) {
+        store->addPeer(
+            kTestingAreaName, peer->getNodeId(), peer->getPeerSpec());
+      }
+    }
+  }
+  auto storeB = meshStores.at(1);
+  storeB->addPeer(kTestingAreaName, "storeE", storeE->getPeerSpec());
+  storeE->addPeer(kTestingAreaName, "storeB", storeB->getPeerSpec());
+
+  // wait for DUAL to converge: every node picks storeA as flood root and
+  // storeB learns that storeE doesn't run DUAL
+  auto startTime = steady_clock::now();
+  auto converged = [&]() {
+    for (auto* store : meshStores) {
+      auto sptInfos = store->getFloodTopo(kTestingAreaName);
+      if (sptInfos.floodRootId().value_or("") != "storeA" or
+          not *sptInfos.infos()->at("storeA").passive()) {
+        return false;
+      }
+    }
+    return storeB->getFloodTopo(kTestingAreaName).floodPeers()->count(
+               "storeE") > 0;
+  };
+  while (not converged()) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  // storeA is the parent of all other mesh nodes
+  auto rootInfos = meshStores.front()->getFloodTopo(kTestingAreaName);
+  EXPECT_EQ(
+      std::set<std::string>({"storeB", "storeC", "storeD"}),
+      *rootInfos.infos()->at("storeA").children());
+  for (size_t i = 1; i < meshStores.size(); ++i) {
+    auto sptInfos = meshStores.at(i)->getFloodTopo(kTestingAreaName);
+    const auto& sptInfo = sptInfos.infos()->at("storeA");
+    EXPECT_EQ("storeA", sptInfo.parent().value_or(""));
+    EXPECT_EQ(1, *sptInfo.cost());
+    EXPECT_TRUE(sptInfo.children()->empty());
+  }
+
+  // storeD floods towards its parent only
+  auto storeD = meshStores.back();
+  EXPECT_EQ(
+      std::set<std::string>({"storeA"}),
+      *storeD->getFloodTopo(kTestingAreaName).floodPeers());
+  EXPECT_EQ(
+      std::set<std::string>({"storeA", "storeE"}),
+      *storeB->getFloodTopo(kTestingAreaName).floodPeers());
+
+  // key set by storeD reaches all nodes, including storeE
+  const std::string key{"flood-key"};
+  auto thriftVal = createThriftValue(
+      1 /* version */,
+      "storeD" /* originatorId */,
+      "value" /* value */,
+      300000 /* ttl */,
+      1 /* ttl version */,
+      0 /* hash */);
+  thriftVal.hash() = generateHash(
+      *thriftVal.version(), *thriftVal.originatorId(), thriftVal.value());
+  EXPECT_TRUE(storeD->setKey(kTestingAreaName, key, thriftVal));
+
+  startTime = steady_clock::now();
+  auto received = [&]() {
+    for (auto* store : meshStores) {
+      if (not store->getKey(kTestingAreaName, key).has_value()) {
+        return false;
+      }
+    }
+    return storeE->getKey(kTestingAreaName, key).has_value();
+  };
+  while (not received()) {
+    ASSERT_LT(steady_clock::now() - startTime, std::chrono::seconds(10));
+    /* sleep override */
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+}
+
 /*
  * Verify kvStore flooding is containted within an area.
  * Add a key in one area and verify that key is not flooded into the other.
@@ -468,6 +468,84 @@ TEST(KvStoreUtil, KvStoreFiltersTest) {
   ASSERT_FALSE(andFilter.keyMatch(node3_key1, node3_val1)); // No match
 }
 
+//
+// Test KvStoreHashTree APIs
+//
+TEST(KvStoreUtil, KvStoreHashTreeTest) {
+  thrift::KeyVals keyVals;
+  for (int i = 0; i < 100; ++i) {
+    keyVals.emplace(
+        fmt::format("key{}", i),
+        createThriftValue(
+            1, /* version */
+            "node1", /* node id */
+            fmt::format("value{}", i)));
+  }
+
+  // 1. Same content merged in different order yields identical tree
+  thrift::KeyVals store1, store2;
+  KvStoreHashTree tree1, tree2, emptyTree;
+  mergeKeyValues(store1, keyVals, std::nullopt, std::nullopt, &tree1);
+  for (auto const& [key, val] : keyVals) {
+    mergeKeyValues(store2, {{key, val}}, std::nullopt, std::nullopt, &tree2);
+  }
+  EXPECT_EQ(tree1.getHash(0, 0), tree2.getHash(0, 0));
+  EXPECT_NE(emptyTree.getHash(0, 0), tree1.getHash(0, 0));
+  EXPECT_EQ(
+      tree1.getChildHashes(0, {0}).size(),
+      static_cast<size_t>(KvStoreHashTree::kFanout));
+
+  // 2. Every key is indexed under its leaf
+  size_t numLeafKeys = 0;
+  for (int64_t leaf = 0;
+       leaf < (1 << (KvStoreHashTree::kFanoutBits * KvStoreHashTree::kDepth));
+       ++leaf) {
+    for (auto const& key : tree1.getLeafKeys(leaf)) {
+      EXPECT_EQ(leaf, KvStoreHashTree::getLeaf(key));
+      EXPECT_TRUE(store1.count(key));
+      ++numLeafKeys;
+    }
+  }
+  EXPECT_EQ(keyVals.size(), numLeafKeys);
+  EXPECT_TRUE(tree1.getLeafKeys(-1).empty());
+
+  // 3. Value update changes digests along the leaf path only
+  const auto oldRoot = tree1.getHash(0, 0);
+  const auto leaf = KvStoreHashTree::getLeaf("key0");
+  const auto sibling = leaf ^ 1;
+  const auto oldSibling = tree1.getHash(KvStoreHashTree::kDepth, sibling);
+  mergeKeyValues(
+      store1,
+      {{"key0", createThriftValue(2, "node1", "value0")}},
+      std::nullopt,
+      std::nullopt,
+      &tree1);
+  EXPECT_NE(oldRoot, tree1.getHash(0, 0));
+  EXPECT_EQ(oldSibling, tree1.getHash(KvStoreHashTree::kDepth, sibling));
+
+  // ttl-only update with higher ttlVersion is also reflected
+  auto ttlUpdate = store1.at("key1");
+  ttlUpdate.value().reset();
+  ttlUpdate.ttlVersion() = *ttlUpdate.ttlVersion() + 1;
+  const auto rootBeforeTtl = tree1.getHash(0, 0);
+  mergeKeyValues(
+      store1, {{"key1", ttlUpdate}}, std::nullopt, std::nullopt, &tree1);
+  EXPECT_NE(rootBeforeTtl, tree1.getHash(0, 0));
+
+  // 4. Erasing all keys brings the tree back to empty
+  for (auto const& [key, val] : store1) {
+    tree1.erase(key, val);
+  }
+  EXPECT_EQ(emptyTree.getHash(0, 0), tree1.getHash(0, 0));
+  EXPECT_TRUE(tree1.getLeafKeys(KvStoreHashTree::getLeaf("key0")).empty());
+
+  // 5. Invalid requests
+  EXPECT_THROW(
+      tree1.getChildHashes(KvStoreHashTree::kDepth, {0}), std::out_of_range);
+  EXPECT_THROW(
+      tree1.getChildHashes(0, {KvStoreHashTree::kFanout}), std::out_of_range);
+}
+
 TEST(KvStoreUtil, IsValidTtlTest) {
   EXPECT_TRUE(isValidTtl(1));
   EXPECT_TRUE(isValidTtl(Constants::kTtlInfinity));
@@ -11,11 +11,119 @@
 
 namespace openr::fbnl {
 
-NetlinkMessageBase::NetlinkMessageBase()
-    : msghdr_(reinterpret_cast<struct nlmsghdr*>(msg.data())) {}
+namespace {
+
+// Per thread scratch buffer for encoding messages. Messages are encoded and
+// sealed on the calling thread, one after another, hence a single scratch
+// buffer serves almost all of the messages of a thread.
+struct EncodeScratch {
+  alignas(struct nlmsghdr) std::array<char, kMaxNlPayloadSize> buf;
+  bool inUse{false};
+};
+
+EncodeScratch&
+getEncodeScratch() {
+  // NOTE: Lazily allocated to keep static TLS footprint small
+  thread_local auto scratch = std::make_unique<EncodeScratch>();
+  return *scratch;
+}
+
+} // namespace
+
+NetlinkBufferPool::Buffer::~Buffer() {
+  if (data_) {
+    pool_->release(data_, sizeClass_);
+  }
+}
+
+NetlinkBufferPool::Buffer::Buffer(Buffer&& other) noexcept
+    : pool_(other.pool_), data_(other.data_), sizeClass_(other.sizeClass_) {
+  other.data_ = nullptr;
+}
+
+NetlinkBufferPool::Buffer&
+NetlinkBufferPool::Buffer::operator=(Buffer&& other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  if (data_) {
+    pool_->release(data_, sizeClass_);
+  }
+  pool_ = other.pool_;
+  data_ = other.data_;
+  sizeClass_ = other.sizeClass_;
+  other.data_ = nullptr;
+  return *this;
+}
+
+NetlinkBufferPool::~NetlinkBufferPool() {
+  DCHECK_EQ(0, stats_.numInUse) << "Buffers must not outlive the pool";
+}
+
+NetlinkBufferPool::Buffer
+NetlinkBufferPool::allocate(uint32_t size) {
+  CHECK_LE(size, kMaxNlPayloadSize);
 
-NetlinkMessageBase::NetlinkMessageBase(int type)
-    : msghdr_(reinterpret_cast<struct nlmsghdr*>(msg.data())) {
+  // Find the smallest size class fitting the requested size
+  uint8_t sizeClass{0};
+  while ((1u << (kMinBufferSizeShift + sizeClass)) < size) {
+    ++sizeClass;
+  }
+  const uint32_t bufferSize = 1u << (kMinBufferSizeShift + sizeClass);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto& freeList = freeLists_.at(sizeClass);
+  if (freeList.empty()) {
+    // Carve a new slab into buffers of this size class
+    slabs_.emplace_back(std::make_unique<char[]>(kSlabSize));
+    char* slab = slabs_.back().get();
+    for (uint32_t offset = 0; offset + bufferSize <= kSlabSize;
+         offset += bufferSize) {
+      freeList.emplace_back(slab + offset);
+    }
+    stats_.numSlabs++;
+    stats_.slabBytes += kSlabSize;
+  }
+
+  char* data = freeList.back();
+  freeList.pop_back();
+  stats_.numAllocations++;
+  stats_.numInUse++;
+  stats_.bytesInUse += bufferSize;
+  return Buffer(this, data, sizeClass);
+}
+
+void
+NetlinkBufferPool::release(char* data, uint8_t sizeClass) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  freeLists_.at(sizeClass).emplace_back(data);
+  stats_.numInUse--;
+  stats_.bytesInUse -= 1u << (kMinBufferSizeShift + sizeClass);
+}
+
+NetlinkBufferPool::Stats
+NetlinkBufferPool::getStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+NetlinkMessageBase::NetlinkMessageBase() {
+  // Encode in thread's scratch buffer if available, else allocate one
+  char* buf{nullptr};
+  auto& scratch = getEncodeScratch();
+  if (not scratch.inUse) {
+    scratch.inUse = true;
+    scratchInUse_ = &scratch.inUse;
+    scratch.buf.fill(0);
+    buf = scratch.buf.data();
+  } else {
+    heapBuf_ = std::make_unique<char[]>(kMaxNlPayloadSize);
+    buf = heapBuf_.get();
+  }
+  msghdr_ = reinterpret_cast<struct nlmsghdr*>(buf);
+}
+
+NetlinkMessageBase::NetlinkMessageBase(int type) : NetlinkMessageBase() {
   // initialize netlink header
   msghdr_->nlmsg_len = NLMSG_LENGTH(0);
   msghdr_->nlmsg_type = type;
@@ -23,6 +131,28 @@ NetlinkMessageBase::NetlinkMessageBase(int type)
 
 NetlinkMessageBase::~NetlinkMessageBase() {
   CHECK(promise_.isFulfilled());
+  releaseEncodeBuffer();
+}
+
+void
+NetlinkMessageBase::seal(NetlinkBufferPool& pool) {
+  CHECK(sealedBuf_.data() == nullptr) << "Message is already sealed";
+  const uint32_t len = msghdr_->nlmsg_len;
+  sealedBuf_ = pool.allocate(len);
+  std::memcpy(sealedBuf_.data(), msghdr_, len);
+  msghdr_ = reinterpret_cast<struct nlmsghdr*>(sealedBuf_.data());
+  releaseEncodeBuffer();
+}
+
+void
+NetlinkMessageBase::releaseEncodeBuffer() {
+  // NOTE: Unsealed message must be destroyed on the thread it is created on,
+  // as it may hold the thread's scratch buffer
+  if (scratchInUse_) {
+    *scratchInUse_ = false;
+    scratchInUse_ = nullptr;
+  }
+  heapBuf_.reset();
 }
 
 struct nlmsghdr*
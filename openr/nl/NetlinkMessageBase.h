@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include <array>
 #include <memory>
+#include <mutex>
 #include <queue>
+#include <vector>
 
 #include <linux/lwtunnel.h>
 #include <linux/mpls.h>
@@ -25,6 +28,91 @@ namespace openr::fbnl {
 
 constexpr uint16_t kMaxNlPayloadSize{4096};
 
+/*
+ * Pool of right-sized buffers for encoded netlink messages.
+ *
+ * Buffers are served from power-of-two size classes (64 bytes up to
+ * `kMaxNlPayloadSize`). Each size class is carved out of fixed size slabs and
+ * released buffers are recycled through per size-class free lists. Hence a
+ * burst of N messages costs roughly N * (message size) bytes and a handful of
+ * slab allocations, instead of N maximum size allocations. Slabs are retained
+ * for reuse until the pool is destroyed.
+ *
+ * Thread-safe. Messages are encoded on the caller's thread and released on
+ * the event thread of `NetlinkProtocolSocket`.
+ */
+class NetlinkBufferPool final {
+ public:
+  /*
+   * Move-only handle of a pooled buffer. Buffer is returned to the pool on
+   * destruction. Pool must outlive all of its buffers.
+   */
+  class Buffer final {
+   public:
+    Buffer() = default;
+    ~Buffer();
+
+    Buffer(Buffer&& other) noexcept;
+    Buffer& operator=(Buffer&& other) noexcept;
+
+    char*
+    data() const {
+      return data_;
+    }
+
+   private:
+    friend class NetlinkBufferPool;
+    Buffer(NetlinkBufferPool* pool, char* data, uint8_t sizeClass)
+        : pool_(pool), data_(data), sizeClass_(sizeClass) {}
+
+    NetlinkBufferPool* pool_{nullptr};
+    char* data_{nullptr};
+    uint8_t sizeClass_{0};
+  };
+
+  struct Stats {
+    // Number and total bytes of slabs allocated from heap
+    uint64_t numSlabs{0};
+    uint64_t slabBytes{0};
+    // Number of buffers handed out over lifetime of the pool
+    uint64_t numAllocations{0};
+    // Number and total bytes of buffers currently in use
+    uint64_t numInUse{0};
+    uint64_t bytesInUse{0};
+  };
+
+  NetlinkBufferPool() = default;
+  ~NetlinkBufferPool();
+
+  /*
+   * Get buffer of at-least `size` bytes. `size` must not exceed
+   * `kMaxNlPayloadSize`.
+   */
+  Buffer allocate(uint32_t size);
+
+  Stats getStats() const;
+
+ private:
+  NetlinkBufferPool(NetlinkBufferPool const&) = delete;
+  NetlinkBufferPool& operator=(NetlinkBufferPool const&) = delete;
+
+  void release(char* data, uint8_t sizeClass);
+
+  // Size classes are power of two from 64 bytes to `kMaxNlPayloadSize`
+  static constexpr uint32_t kMinBufferSizeShift{6};
+  static constexpr uint8_t kNumSizeClasses{7};
+  static_assert(
+      (1u << (kMinBufferSizeShift + kNumSizeClasses - 1)) == kMaxNlPayloadSize);
+
+  // Size of slab buffers of a size class are carved out of
+  static constexpr uint32_t kSlabSize{64 * 1024};
+
+  mutable std::mutex mutex_;
+  std::array<std::vector<char*>, kNumSizeClasses> freeLists_;
+  std::vector<std::unique_ptr<char[]>> slabs_;
+  Stats stats_;
+};
+
 /*
  * Data structure representing a netlink message, either to be sent or received.
  * It wraps `struct nlmsghdr` and provides buffer for appending message payload.
@@ -35,6 +123,10 @@ constexpr uint16_t kMaxNlPayloadSize{4096};
  * C++ object (application) to/from bytes (kernel).
  *
  * Maximum size of message is limited by `kMaxNlPayloadSize` parameter.
+ *
+ * Message is encoded in a maximum size scratch buffer, which is shared by all
+ * the messages constructed on a thread. Once encoded, `seal()` moves it into a
+ * right-sized buffer from `NetlinkBufferPool` and releases the scratch buffer.
  */
 /*
  * For netlink reference:
@@ -100,8 +192,13 @@ class NetlinkMessageBase {
   // get current length
   uint32_t getDataLength() const;
 
-  // Buffer to create message
-  std::array<char, kMaxNlPayloadSize> msg = {};
+  /**
+   * Move encoded message into a right-sized buffer from the pool and release
+   * the encode buffer. Must be invoked once, after encoding is complete and
+   * before the message is queued for sending. Only netlink header fields (e.g.
+   * sequence number) may be modified afterwards.
+   */
+  void seal(NetlinkBufferPool& pool);
 
   /**
    * APIs for accumulating objects of `GET_<>` request. These APIs are invoked
@@ -138,6 +235,22 @@ class NetlinkMessageBase {
     CHECK(false) << "Must be implemented by subclass";
   }
 
+  virtual void
+  rcvdNexthop(uint32_t /* id */, uint8_t /* protocolId */) {
+    CHECK(false) << "Must be implemented by subclass";
+  }
+
+  /**
+   * Invoked for every route received in response to this message, before the
+   * route is parsed. Sub-classes can override it to filter out routes in place
+   * and save the cost of materializing them. `rcvdRoute(..)` is invoked only
+   * for the accepted routes.
+   */
+  virtual bool
+  acceptRoute(const struct nlmsghdr* /* nlmsg */) const {
+    return true;
+  }
+
   /**
    * Get SemiFuture associated with the the associated netlink request. Upon
    * receipt of the ack from kernel, the value will be set.
@@ -159,6 +272,16 @@ class NetlinkMessageBase {
     return createTs_;
   }
 
+  std::chrono::steady_clock::time_point
+  getSendTs() const {
+    return sendTs_;
+  }
+
+  void
+  setSendTs(std::chrono::steady_clock::time_point sendTs) {
+    sendTs_ = sendTs;
+  }
+
   // parse IP address
   static folly::Expected<folly::IPAddress, folly::IPAddressFormatError> parseIp(
       const struct rtattr* ipAttr, unsigned char family);
@@ -201,12 +324,28 @@ class NetlinkMessageBase {
   NetlinkMessageBase(NetlinkMessageBase const&) = delete;
   NetlinkMessageBase& operator=(NetlinkMessageBase const&) = delete;
 
+  // Release buffer message is encoded in (if still held)
+  void releaseEncodeBuffer();
+
+  // Thread-local scratch flag, set if message is being encoded in the scratch
+  // buffer of constructing thread
+  bool* scratchInUse_{nullptr};
+
+  // Encode buffer, when scratch buffer of the thread is already in use
+  std::unique_ptr<char[]> heapBuf_;
+
+  // Right-sized buffer holding the message once sealed
+  NetlinkBufferPool::Buffer sealedBuf_;
+
   // Promise to relay the status code received from kernel
   folly::Promise<int> promise_;
 
   // Timestamp when message object was created
   const std::chrono::steady_clock::time_point createTs_{
       std::chrono::steady_clock::now()};
+
+  // Timestamp when message was sent to kernel
+  std::chrono::steady_clock::time_point sendTs_;
 };
 
 } // namespace openr::fbnl
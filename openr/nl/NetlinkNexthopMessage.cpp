@@ -0,0 +1,218 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#include <folly/logging/xlog.h>
+
+#include <openr/nl/NetlinkNexthopMessage.h>
+#include <openr/nl/NetlinkRouteMessage.h>
+
+namespace openr::fbnl {
+NetlinkNexthopMessage::NetlinkNexthopMessage() : NetlinkMessageBase() {}
+
+NetlinkNexthopMessage::~NetlinkNexthopMessage() = default;
+
+void
+NetlinkNexthopMessage::rcvdNexthop(uint32_t id, uint8_t protocolId) {
+  rcvdNexthops_.emplace_back(id, protocolId);
+}
+
+void
+NetlinkNexthopMessage::setReturnStatus(int status) {
+  if (status == 0) {
+    nexthopPromise_.setValue(std::move(rcvdNexthops_));
+  } else {
+    nexthopPromise_.setValue(folly::makeUnexpected(status));
+  }
+  NetlinkMessageBase::setReturnStatus(status);
+}
+
+void
+NetlinkNexthopMessage::init(int type) {
+  if (type != RTM_NEWNEXTHOP && type != RTM_DELNEXTHOP &&
+      type != RTM_GETNEXTHOP) {
+    XLOG(ERR) << "Incorrect Netlink message type";
+    return;
+  }
+
+  // initialize netlink header
+  msghdr_->nlmsg_len = NLMSG_LENGTH(sizeof(struct nhmsg));
+  msghdr_->nlmsg_type = type;
+  msghdr_->nlmsg_flags = NLM_F_REQUEST | NLM_F_ACK;
+
+  if (type == RTM_NEWNEXTHOP) {
+    // We create new nexthop or replace existing. Replacing a nexthop object
+    // atomically updates all the routes referring to it.
+    msghdr_->nlmsg_flags |= NLM_F_CREATE;
+    msghdr_->nlmsg_flags |= NLM_F_REPLACE;
+  }
+
+  if (type == RTM_GETNEXTHOP) {
+    // Get all nexthop objects
+    msghdr_->nlmsg_flags |= NLM_F_DUMP;
+  }
+
+  // intialize the nexthop message header
+  auto nlmsgAlen = NLMSG_ALIGN(sizeof(struct nlmsghdr));
+  nhmsg_ = reinterpret_cast<struct nhmsg*>((char*)msghdr_ + nlmsgAlen);
+}
+
+std::pair<uint32_t, uint8_t>
+NetlinkNexthopMessage::parseMessage(const struct nlmsghdr* nlmsg) {
+  const struct nhmsg* const nhEntry =
+      reinterpret_cast<struct nhmsg*>(NLMSG_DATA(nlmsg));
+
+  uint32_t id{0};
+  const struct rtattr* nhAttr;
+  int nhAttrLen = nlmsg->nlmsg_len - NLMSG_LENGTH(sizeof(struct nhmsg));
+  // NHA_ID is the only attribute of interest
+  for (nhAttr = reinterpret_cast<const struct rtattr*>(
+           reinterpret_cast<const char*>(nhEntry) +
+           NLMSG_ALIGN(sizeof(struct nhmsg)));
+       RTA_OK(nhAttr, nhAttrLen);
+       nhAttr = RTA_NEXT(nhAttr, nhAttrLen)) {
+    if (nhAttr->rta_type == NHA_ID) {
+      id = *(reinterpret_cast<const uint32_t*> RTA_DATA(nhAttr));
+      break;
+    }
+  }
+  return {id, nhEntry->nh_protocol};
+}
+
+int
+NetlinkNexthopMessage::addNexthopId(uint32_t id) {
+  return addAttributes(
+      NHA_ID, reinterpret_cast<const char*>(&id), sizeof(uint32_t));
+}
+
+int
+NetlinkNexthopMessage::addNexthop(
+    uint32_t id, const NextHop& nextHop, uint8_t protocolId) {
+  const auto& via = nextHop.getGateway();
+  if (not via.has_value() or not nextHop.getIfIndex().has_value()) {
+    XLOG(ERR) << "Nexthop object requires gateway and interface";
+    return EINVAL;
+  }
+
+  init(RTM_NEWNEXTHOP);
+  nhmsg_->nh_family = via->family();
+  nhmsg_->nh_protocol = protocolId;
+
+  int status{0};
+  if ((status = addNexthopId(id))) {
+    return status;
+  }
+
+  const uint32_t oif = nextHop.getIfIndex().value();
+  if ((status = addAttributes(
+           NHA_OIF, reinterpret_cast<const char*>(&oif), sizeof(uint32_t)))) {
+    return status;
+  }
+
+  if ((status = addAttributes(
+           NHA_GATEWAY,
+           reinterpret_cast<const char*>(via->bytes()),
+           via->byteCount()))) {
+    return status;
+  }
+
+  const auto& labels = nextHop.getPushLabels();
+  if (labels.has_value()) {
+    return addPushLabels(labels.value());
+  }
+  return 0;
+}
+
+int
+NetlinkNexthopMessage::addPushLabels(const std::vector<int32_t>& labels) {
+  // abort immediately to bring attention
+  CHECK_LE(labels.size(), kMaxLabels);
+
+  // build nested [NHA_ENCAP - MPLS_IPTUNNEL_DST] attribute in scratch buffer
+  std::array<char, kMaxNlPayloadSize> encap = {};
+  struct rtattr* rta = reinterpret_cast<struct rtattr*>(encap.data());
+  rta->rta_type = NHA_ENCAP;
+  rta->rta_len = RTA_LENGTH(0);
+
+  // labels are encoded bottom of stack last
+  std::array<struct mpls_label, kMaxLabels> mplsLabel;
+  size_t i = 0;
+  for (auto it = labels.rbegin(); it != labels.rend(); ++it, ++i) {
+    mplsLabel[i].entry =
+        NetlinkRouteMessage::encodeLabel(*it, i == labels.size() - 1);
+  }
+  if (addSubAttributes(
+          rta,
+          MPLS_IPTUNNEL_DST,
+          &mplsLabel,
+          labels.size() * sizeof(struct mpls_label)) == nullptr) {
+    return ENOBUFS;
+  }
+
+  int status{0};
+  if ((status = addAttributes(
+           NHA_ENCAP,
+           reinterpret_cast<const char*>(RTA_DATA(rta)),
+           RTA_PAYLOAD(rta)))) {
+    return status;
+  }
+
+  const uint16_t encapType = LWTUNNEL_ENCAP_MPLS;
+  return addAttributes(
+      NHA_ENCAP_TYPE,
+      reinterpret_cast<const char*>(&encapType),
+      sizeof(uint16_t));
+}
+
+int
+NetlinkNexthopMessage::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t protocolId) {
+  if (members.empty()) {
+    XLOG(ERR) << "Nexthop group requires at least one member";
+    return EINVAL;
+  }
+
+  init(RTM_NEWNEXTHOP);
+  // group family is always unspecified
+  nhmsg_->nh_family = AF_UNSPEC;
+  nhmsg_->nh_protocol = protocolId;
+
+  int status{0};
+  if ((status = addNexthopId(id))) {
+    return status;
+  }
+
+  std::vector<struct nexthop_grp> grp(members.size());
+  for (size_t i = 0; i < members.size(); ++i) {
+    grp[i].id = members[i].first;
+    // kernel weight is (weight - 1), same as rtnh_hops
+    grp[i].weight = std::max(members[i].second, uint8_t(1)) - 1;
+  }
+  if ((status = addAttributes(
+           NHA_GROUP,
+           reinterpret_cast<const char*>(grp.data()),
+           grp.size() * sizeof(struct nexthop_grp)))) {
+    return status;
+  }
+
+  const uint16_t grpType = NEXTHOP_GRP_TYPE_MPATH;
+  return addAttributes(
+      NHA_GROUP_TYPE,
+      reinterpret_cast<const char*>(&grpType),
+      sizeof(uint16_t));
+}
+
+int
+NetlinkNexthopMessage::deleteNexthop(uint32_t id) {
+  init(RTM_DELNEXTHOP);
+  nhmsg_->nh_family = AF_UNSPEC;
+
+  return addNexthopId(id);
+}
+
+} // namespace openr::fbnl
@@ -0,0 +1,102 @@
+/*
+ * Copyright (c) Meta Platforms, Inc. and affiliates.
+ *
+ * This source code is licensed under the MIT license found in the
+ * LICENSE file in the root directory of this source tree.
+ */
+
+#pragma once
+
+#include <openr/nl/NetlinkMessageBase.h>
+#include <openr/nl/NetlinkTypes.h>
+
+extern "C" {
+#include <linux/nexthop.h>
+}
+
+namespace openr::fbnl {
+/**
+ * Message specialization for rtnetlink NEXTHOP type (Linux 5.3+)
+ *
+ * For reference: https://man7.org/linux/man-pages/man8/ip-nexthop.8.html
+ *
+ * RTM_NEWNEXTHOP, RTM_DELNEXTHOP
+ *    Create or remove a nexthop object. Nexthop object is either a single
+ *    path (gateway, device, optional MPLS push encap) or a group of other
+ *    nexthop objects. Routes refer to it via RTA_NH_ID attribute, which
+ *    allows the nexthops of many routes to be updated with one message.
+ *    These messages contain a nhmsg structure with an optional sequence of
+ *    rtattr structures following.
+ *
+ * RTM_GETNEXTHOP
+ *    Dump nexthop objects. Only id and protocol of the objects are retrieved.
+ */
+
+class NetlinkNexthopMessage final : public NetlinkMessageBase {
+ public:
+  NetlinkNexthopMessage();
+
+  ~NetlinkNexthopMessage() override;
+
+  // Override setReturnStatus. Set nexthopPromise_ with rcvdNexthops_
+  void setReturnStatus(int status) override;
+
+  // Get future for received nexthop objects in response to GET request.
+  // Objects are specified as pair of id and protocol.
+  folly::SemiFuture<
+      folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+  getNexthopsSemiFuture() {
+    return nexthopPromise_.getSemiFuture();
+  }
+
+  // initiallize nexthop message with default params
+  void init(int type);
+
+  // parse id and protocol of Netlink Nexthop message
+  static std::pair<uint32_t, uint8_t> parseMessage(const struct nlmsghdr* nlh);
+
+  // add (or replace) single path nexthop object with given id
+  int addNexthop(uint32_t id, const NextHop& nextHop, uint8_t protocolId);
+
+  // add (or replace) multipath nexthop group object with given id. Members
+  // are specified as pair of nexthop object id and weight.
+  int addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocolId);
+
+  // delete nexthop or nexthop group object with given id
+  int deleteNexthop(uint32_t id);
+
+ private:
+  // inherited class implementation
+  void rcvdNexthop(uint32_t id, uint8_t protocolId) override;
+
+  // add NHA_ID attribute
+  int addNexthopId(uint32_t id);
+
+  // add NHA_ENCAP_TYPE and NHA_ENCAP attributes for MPLS push labels
+  int addPushLabels(const std::vector<int32_t>& labels);
+
+  //
+  // Private variables for rtnetlink msg exchange
+  //
+
+  // pointer to nexthop message header
+  //   struct nhmsg {
+  //     unsigned char nh_family;
+  //     unsigned char nh_scope;     /* return only */
+  //     unsigned char nh_protocol;  /* Routing protocol that installed nh */
+  //     unsigned char resvd;
+  //     unsigned int  nh_flags;     /* RTNH_F flags */
+  //   };
+  struct nhmsg* nhmsg_{nullptr};
+
+  // promise to be fulfilled when receiving kernel reply
+  folly::Promise<
+      folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+      nexthopPromise_;
+  std::vector<std::pair<uint32_t, uint8_t>> rcvdNexthops_;
+};
+
+} // namespace openr::fbnl
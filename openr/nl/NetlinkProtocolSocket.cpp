@@ -15,57 +15,84 @@ namespace fb303 = facebook::fb303;
 
 namespace openr::fbnl {
 
+namespace {
+
+// Set receive buffer size of the socket, overriding the system limit if
+// permitted. Returns the size in effect or -1 on failure.
+int
+setSockRecvBuf(int fd, int size) {
+  if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &size, sizeof(size)) < 0 and
+      setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+    return -1;
+  }
+  int actualSize{0};
+  socklen_t len = sizeof(actualSize);
+  if (getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &actualSize, &len) < 0) {
+    return -1;
+  }
+  // Kernel doubles the value to account for bookkeeping overhead
+  return actualSize / 2;
+}
+
+} // namespace
+
+NetlinkProtocolSocket::Channel::Channel(
+    NetlinkProtocolSocket* parent, size_t index)
+    : EventHandler(parent->evb_), parent(parent), index(index) {
+  nlMessageTimer = folly::AsyncTimeout::make(*parent->evb_, [this]() noexcept {
+    this->parent->processTimeout(*this);
+  });
+}
+
+void
+NetlinkProtocolSocket::Channel::handlerReady(uint16_t events) noexcept {
+  CHECK_EQ(events, folly::EventHandler::READ);
+  try {
+    parent->recvNetlinkMessage(*this);
+  } catch (std::exception const& e) {
+    XLOG(ERR) << "Error processing netlink message" << folly::exceptionStr(e);
+    fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+  }
+}
+
 NetlinkProtocolSocket::NetlinkProtocolSocket(
     folly::EventBase* evb,
     messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
-    bool enableIPv6RouteReplaceSemantics)
-    : EventHandler(evb),
-      evb_(evb),
+    bool enableIPv6RouteReplaceSemantics,
+    size_t numRouteSockets)
+    : evb_(evb),
       netlinkEventsQueue_(netlinkEventsQ),
-      enableIPv6RouteReplaceSemantics_(enableIPv6RouteReplaceSemantics) {
+      enableIPv6RouteReplaceSemantics_(enableIPv6RouteReplaceSemantics),
+      numRouteSockets_(numRouteSockets) {
   // We expect ctrl-evb not be running. Attaching and scheduling
   // of timers is not thread safe.
   CHECK_NOTNULL(evb_);
   CHECK(not evb_->isRunning());
 
-  nlMessageTimer_ = folly::AsyncTimeout::make(*evb_, [this]() noexcept {
-    DCHECK(false) << "This shouldn't occur usually. Adding DCHECK to get "
-                  << "attention in UTs";
+  // Buffers for receiving messages, shared by all the sockets
+  recvBuf_ = std::make_unique<char[]>(kNlRecvBufSize * kNlRecvBatchSize);
 
-    fbData->addStatValue(
-        "netlink.requests.timeout", nlSeqNumMap_.size(), fb303::SUM);
-
-    XLOG(ERR) << "Timed-out receiving ack for " << nlSeqNumMap_.size()
-              << " message(s).";
-    fbData->addStatValue("netlink.errors", 1, fb303::SUM);
-    for (auto& kv : nlSeqNumMap_) {
-      XLOG(ERR) << "  Pending seq=" << kv.first << ", message-type="
-                << static_cast<int>(kv.second->getMessageType())
-                << ", message-size=" << kv.second->getDataLength();
-      // Set timeout to pending request
-      kv.second->setReturnStatus(-ETIMEDOUT);
-    }
-    nlSeqNumMap_.clear(); // Clear all timed out requests
-
-    XLOG(INFO) << "Closing netlink socket. fd=" << nlSock_
-               << ", port=" << portId_;
-    unregisterHandler();
-    close(nlSock_);
-    init();
-
-    // Resume sending netlink messages if any queued
-    sendNetlinkMessage();
-  });
+  // Primary socket followed by route sockets
+  for (size_t i = 0; i <= numRouteSockets_; ++i) {
+    channels_.emplace_back(std::make_unique<Channel>(this, i));
+  }
 
   // Create consumer for procesing netlink messages to be sent in an event loop
   notifConsumer_ =
-      folly::NotificationQueue<std::unique_ptr<NetlinkMessageBase>>::Consumer::
-          make([this](std::unique_ptr<NetlinkMessageBase>&& nlmsg) noexcept {
-            msgQueue_.push(std::move(nlmsg));
+      folly::NotificationQueue<ChannelMessage>::Consumer::make(
+          [this](ChannelMessage&& msg) noexcept {
+            auto& channel = *channels_.at(msg.first);
+            const size_t msgClass = channel.isRouteSocket() ? 1 : 0;
+            // Message must wait for the requests of other class, enqueued
+            // before it, to complete
+            numRequestsEnqueued_[msgClass]++;
+            channel.msgQueue.emplace(
+                numRequestsEnqueued_[1 - msgClass], std::move(msg.second));
             // Invoke send messages API if socket is initialized and no in
             // flight messages
-            if (nlSock_ >= 0 && !nlMessageTimer_->isScheduled()) {
-              sendNetlinkMessage();
+            if (channel.nlSock >= 0 &&
+                !channel.nlMessageTimer->isScheduled()) {
+              sendNetlinkMessage(channel);
             }
           });
 
@@ -81,44 +108,56 @@ NetlinkProtocolSocket::~NetlinkProtocolSocket() {
   XLOG(INFO) << "Shutting down netlink protocol socket";
 
   // Clear all requests expecting a reply
-  for (auto& kv : nlSeqNumMap_) {
-    XLOG(WARNING) << "Clearing netlink request. seq=" << kv.first
-                  << ", message-type=" << kv.second->getMessageType()
-                  << ", message-size=" << kv.second->getDataLength();
-    // Set timeout to pending request
-    kv.second->setReturnStatus(-ESHUTDOWN);
+  for (auto& channel : channels_) {
+    for (auto& kv : channel->nlSeqNumMap) {
+      XLOG(WARNING) << "Clearing netlink request. seq=" << kv.first
+                    << ", message-type=" << kv.second->getMessageType()
+                    << ", message-size=" << kv.second->getDataLength();
+      // Set timeout to pending request
+      kv.second->setReturnStatus(-ESHUTDOWN);
+    }
+    channel->nlSeqNumMap.clear(); // Clear all timed out requests
   }
-  nlSeqNumMap_.clear(); // Clear all timed out requests
 
   // Clear all requests that yet needs to be sent
-  std::unique_ptr<NetlinkMessageBase> msg;
+  ChannelMessage msg;
   while (notifQueue_.tryConsume(msg)) {
-    CHECK_NOTNULL(msg.get());
+    CHECK_NOTNULL(msg.second.get());
     XLOG(WARNING) << "Clearing netlink message, not yet send";
-    msg->setReturnStatus(-ESHUTDOWN);
+    msg.second->setReturnStatus(-ESHUTDOWN);
   }
 
-  if (nlSock_ > 0) {
-    XLOG(INFO) << "Closing netlink socket. fd=" << nlSock_
-               << ", port=" << portId_;
-    close(nlSock_);
-  } else {
-    XLOG(INFO) << "Netlink socket was never initialized";
+  for (auto& channel : channels_) {
+    if (channel->nlSock > 0) {
+      XLOG(INFO) << "Closing netlink socket. fd=" << channel->nlSock
+                 << ", port=" << channel->portId;
+      close(channel->nlSock);
+    } else {
+      XLOG(INFO) << "Netlink socket was never initialized";
+    }
   }
 }
 
 void
 NetlinkProtocolSocket::init() {
+  for (auto& channel : channels_) {
+    initChannel(*channel);
+  }
+}
+
+void
+NetlinkProtocolSocket::initChannel(Channel& channel) {
   // Create netlink socket
-  nlSock_ = ::socket(PF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
-  if (nlSock_ < 0) {
+  channel.nlSock = ::socket(PF_NETLINK, SOCK_RAW, NETLINK_ROUTE);
+  if (channel.nlSock < 0) {
     XLOG(FATAL) << "Netlink socket create failed.";
   }
-  int size = kNetlinkSockRecvBuf;
   // increase socket recv buffer size
-  if (setsockopt(nlSock_, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size)) < 0) {
+  const int recvBufSize = setSockRecvBuf(channel.nlSock, channel.recvBufSize);
+  if (recvBufSize < 0) {
     XLOG(FATAL) << "Netlink socket set recv buffer failed.";
   };
+  channel.recvBufSize = recvBufSize;
 
   // Bind on the source address. We let kernel chose the available port-ID
   struct sockaddr_nl saddr;
@@ -126,46 +165,171 @@ NetlinkProtocolSocket::init() {
   saddr.nl_family = AF_NETLINK;
   saddr.nl_pid = 0; // We let kernel assign the port-ID
   /* We can subscribe to different Netlink mutlicast groups for specific types
-   * of events: link, IPv4/IPv6 address and neighbor. */
-  saddr.nl_groups = RTMGRP_LINK // listen for link events
-      | RTMGRP_IPV4_IFADDR // listen for IPv4 address events
-      | RTMGRP_IPV6_IFADDR // listen for IPv6 address events
-      | RTMGRP_NEIGH; // listen for Neighbor (ARP) events
+   * of events: link, IPv4/IPv6 address, neighbor and optionally IPv4/IPv6
+   * route. Route sockets are used for requests only and don't subscribe to
+   * any. */
+  if (not channel.isRouteSocket()) {
+    saddr.nl_groups = RTMGRP_LINK // listen for link events
+        | RTMGRP_IPV4_IFADDR // listen for IPv4 address events
+        | RTMGRP_IPV6_IFADDR // listen for IPv6 address events
+        | RTMGRP_NEIGH; // listen for Neighbor (ARP) events
+    if (routeEventsSubscribed_) {
+      saddr.nl_groups |= RTMGRP_IPV4_ROUTE | RTMGRP_IPV6_ROUTE;
+    }
+  }
 
-  if (bind(nlSock_, (struct sockaddr*)&saddr, sizeof(saddr)) != 0) {
+  if (bind(channel.nlSock, (struct sockaddr*)&saddr, sizeof(saddr)) != 0) {
     XLOG(FATAL) << "Failed to bind netlink socket: " << folly::errnoStr(errno);
   }
 
   // Retrieve and set pid that we will use for all subsequent messages
-  portId_ = saddr.nl_pid;
-  XLOG(INFO) << "Created netlink socket. fd=" << nlSock_
-             << ", port=" << portId_;
+  channel.portId = saddr.nl_pid;
+  XLOG(INFO) << "Created netlink socket. fd=" << channel.nlSock
+             << ", port=" << channel.portId << ", channel=" << channel.index;
 
   // Set fd in event handler and register for polling
   // NOTE: We mask `READ` event with `PERSIST` to make sure the handler remains
   // registered after the read event
-  XLOG(INFO) << "Registering netlink socket fd " << nlSock_
+  XLOG(INFO) << "Registering netlink socket fd " << channel.nlSock
              << " with EventBase for read events";
-  changeHandlerFD(folly::NetworkSocket{nlSock_});
-  registerHandler(folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  channel.changeHandlerFD(folly::NetworkSocket{channel.nlSock});
+  channel.registerHandler(
+      folly::EventHandler::READ | folly::EventHandler::PERSIST);
+  exportWindowCounters();
 
   // Resume sending netlink messages if any queued
-  sendNetlinkMessage();
+  sendNetlinkMessage(channel);
 }
 
 void
-NetlinkProtocolSocket::handlerReady(uint16_t events) noexcept {
-  CHECK_EQ(events, folly::EventHandler::READ);
-  try {
-    recvNetlinkMessage();
-  } catch (std::exception const& e) {
-    XLOG(ERR) << "Error processing netlink message" << folly::exceptionStr(e);
-    fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+NetlinkProtocolSocket::processTimeout(Channel& channel) {
+  DCHECK(false) << "This shouldn't occur usually. Adding DCHECK to get "
+                << "attention in UTs";
+
+  auto& nlSeqNumMap = channel.nlSeqNumMap;
+  fbData->addStatValue(
+      "netlink.requests.timeout", nlSeqNumMap.size(), fb303::SUM);
+
+  XLOG(ERR) << "Timed-out receiving ack for " << nlSeqNumMap.size()
+            << " message(s).";
+  fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+  for (auto& kv : nlSeqNumMap) {
+    XLOG(ERR) << "  Pending seq=" << kv.first << ", message-type="
+              << static_cast<int>(kv.second->getMessageType())
+              << ", message-size=" << kv.second->getDataLength();
+    // Set timeout to pending request
+    kv.second->setReturnStatus(-ETIMEDOUT);
   }
+  const auto numTimedOut = nlSeqNumMap.size();
+  nlSeqNumMap.clear(); // Clear all timed out requests
+
+  // Start over with minimum window on the new socket
+  channel.window = kMinIovWindow;
+  channel.numAcksSinceIncrease = 0;
+  channel.windowDecreaseSeq = channel.nextNlSeqNum;
+  fbData->addStatValue("netlink.requests.window_decreases", 1, fb303::SUM);
+
+  XLOG(INFO) << "Closing netlink socket. fd=" << channel.nlSock
+             << ", port=" << channel.portId;
+  channel.unregisterHandler();
+  close(channel.nlSock);
+  initChannel(channel);
+
+  // Resume sending netlink messages if any queued
+  sendNetlinkMessage(channel);
+  completeRequests(channel, numTimedOut);
+}
+
+void
+NetlinkProtocolSocket::completeRequests(
+    const Channel& channel, size_t numRequests) {
+  numRequestsCompleted_[channel.isRouteSocket() ? 1 : 0] += numRequests;
+
+  // Resume idle channels of the other class. Busy ones resume on their acks
+  for (auto& other : channels_) {
+    if (other->isRouteSocket() != channel.isRouteSocket() and
+        other->nlSock >= 0 and other->nlSeqNumMap.empty()) {
+      sendNetlinkMessage(*other);
+    }
+  }
+}
+
+void
+NetlinkProtocolSocket::updateWindow(
+    Channel& channel, uint32_t ack, std::chrono::milliseconds latency) {
+  fbData->addStatValue(
+      "netlink.requests.ack_latency_ms", latency.count(), fb303::AVG);
+
+  if (latency > kNlAckLatencyThreshold) {
+    // Kernel is slow to process requests. Decrease the window unless request
+    // was already in flight when window was last decreased.
+    if (static_cast<int32_t>(ack - channel.windowDecreaseSeq) >= 0) {
+      decreaseWindow(channel);
+    }
+    return;
+  }
+
+  // Grow window additively for every window worth of acks, as long as there
+  // are requests waiting for it
+  if (channel.msgQueue.empty() or
+      ++channel.numAcksSinceIncrease < channel.window) {
+    return;
+  }
+  channel.numAcksSinceIncrease = 0;
+  const size_t window =
+      std::min(kMaxIovMsg, channel.window + kIovWindowIncrement);
+  const size_t newWindow = std::min(window, growRecvBuf(channel, window));
+  if (newWindow > channel.window) {
+    XLOG(DBG1) << "Increasing netlink window to " << newWindow
+               << ". fd=" << channel.nlSock;
+    channel.window = newWindow;
+    fbData->addStatValue("netlink.requests.window_increases", 1, fb303::SUM);
+    exportWindowCounters();
+  }
+}
+
+void
+NetlinkProtocolSocket::decreaseWindow(Channel& channel) {
+  channel.window = std::max(kMinIovWindow, channel.window / 2);
+  channel.numAcksSinceIncrease = 0;
+  channel.windowDecreaseSeq = channel.nextNlSeqNum;
+  XLOG(DBG1) << "Decreasing netlink window to " << channel.window
+             << ". fd=" << channel.nlSock;
+  fbData->addStatValue("netlink.requests.window_decreases", 1, fb303::SUM);
+  exportWindowCounters();
+}
+
+size_t
+NetlinkProtocolSocket::growRecvBuf(Channel& channel, size_t window) {
+  const uint32_t requiredSize = std::min<uint64_t>(
+      uint64_t(window) * kNetlinkSockRecvBufPerMsg, kNetlinkSockMaxRecvBuf);
+  if (channel.nlSock >= 0 and requiredSize > channel.recvBufSize) {
+    const int size = setSockRecvBuf(channel.nlSock, requiredSize);
+    if (size > static_cast<int>(channel.recvBufSize)) {
+      XLOG(INFO) << "Grew netlink socket recv buffer to " << size
+                 << " bytes. fd=" << channel.nlSock;
+      channel.recvBufSize = size;
+    }
+  }
+  // Initial window is allowed irrespective of the buffer size
+  return std::max<size_t>(
+      kInitIovWindow, channel.recvBufSize / kNetlinkSockRecvBufPerMsg);
 }
 
 void
-NetlinkProtocolSocket::processAck(uint32_t ack, int status) {
+NetlinkProtocolSocket::exportWindowCounters() const {
+  int64_t window{0};
+  int64_t recvBufSize{0};
+  for (const auto& channel : channels_) {
+    window += channel->window;
+    recvBufSize += channel->recvBufSize;
+  }
+  fbData->setCounter("netlink.requests.window", window);
+  fbData->setCounter("netlink.buffers.socket_recv_bytes", recvBufSize);
+}
+
+void
+NetlinkProtocolSocket::processAck(Channel& channel, uint32_t ack, int status) {
   XLOG(DBG2) << "Completed netlink request. seq=" << ack
              << ", retval=" << status;
   if (std::abs(status) != EEXIST && std::abs(status) != ESRCH && status != 0) {
@@ -176,48 +340,75 @@ NetlinkProtocolSocket::processAck(uint32_t ack, int status) {
     fbData->addStatValue("netlink.requests.success", 1, fb303::SUM);
   }
 
-  auto it = nlSeqNumMap_.find(ack);
-  if (it != nlSeqNumMap_.end()) {
+  auto& nlSeqNumMap = channel.nlSeqNumMap;
+  bool isCompleted{false};
+  auto it = nlSeqNumMap.find(ack);
+  if (it != nlSeqNumMap.end()) {
     // Calculate and add the latency of the request in fb303
     auto requestLatency = std::chrono::duration_cast<std::chrono::milliseconds>(
         std::chrono::steady_clock::now() - it->second->getCreateTs());
     fbData->addStatValue(
         "netlink.requests.latency_ms", requestLatency.count(), fb303::AVG);
+    const auto ackLatency =
+        std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - it->second->getSendTs());
+    const bool isDump =
+        (it->second->getMessagePtr()->nlmsg_flags & NLM_F_DUMP) == NLM_F_DUMP;
 
     // Set return status on promise
     it->second->setReturnStatus(status);
-    nlSeqNumMap_.erase(it);
+    nlSeqNumMap.erase(it);
+    isCompleted = true;
+
+    // Adapt window to the latency of kernel. Latency of dump requests depends
+    // on the size of the dump instead.
+    if (not isDump) {
+      updateWindow(channel, ack, ackLatency);
+    }
   } else {
     XLOG(ERR) << "Broken promise for netlink request. seq=" << ack;
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
   }
 
   // Cancel timer if there are no more expected responses
-  if (nlSeqNumMap_.empty()) {
-    nlMessageTimer_->cancelTimeout();
+  if (nlSeqNumMap.empty()) {
+    channel.nlMessageTimer->cancelTimeout();
   } else {
     // Extend timer and wait for next ack
-    nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+    channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
   }
 
   // We've successfully completed at-least one message. Send more messages
   // if any pending. Here we add optimization to wait for some more acks and
-  // send pending message in batch of atleast `kMinIovMsg`
-  if (nlSeqNumMap_.empty() or (kMaxIovMsg - nlSeqNumMap_.size() > kMinIovMsg)) {
-    sendNetlinkMessage();
+  // send pending message in batch of atleast `kMinIovMsg` (or half the window
+  // if smaller)
+  if (nlSeqNumMap.empty() or
+      (channel.window > nlSeqNumMap.size() and
+       channel.window - nlSeqNumMap.size() >
+           std::min(kMinIovMsg, channel.window / 2))) {
+    sendNetlinkMessage(channel);
+  }
+
+  // Requests on the other channels may be waiting for this one
+  if (isCompleted) {
+    completeRequests(channel, 1);
   }
 }
 
 void
-NetlinkProtocolSocket::sendNetlinkMessage() {
+NetlinkProtocolSocket::sendNetlinkMessage(Channel& channel) {
   CHECK(evb_->isInEventBaseThread());
   struct sockaddr_nl nladdr = {
       .nl_family = AF_NETLINK, .nl_pad = 0, .nl_pid = 0, .nl_groups = 0};
-  CHECK_LE(nlSeqNumMap_.size(), kMaxIovMsg)
-      << "We must have capacity to send at-least one message!";
+  auto& msgQueue = channel.msgQueue;
+  auto& nlSeqNumMap = channel.nlSeqNumMap;
+  // NOTE: Window may have shrunk below the number of in-flight messages
+  if (nlSeqNumMap.size() >= channel.window) {
+    return;
+  }
   uint32_t count{0};
   const uint32_t iovSize =
-      std::min(msgQueue_.size(), kMaxIovMsg - nlSeqNumMap_.size());
+      std::min(msgQueue.size(), channel.window - nlSeqNumMap.size());
 
   if (!iovSize) {
     return;
@@ -225,20 +416,31 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
 
   auto iov = std::make_unique<struct iovec[]>(iovSize);
 
-  while (count < iovSize && !msgQueue_.empty()) {
-    auto m = std::move(msgQueue_.front());
-    msgQueue_.pop();
+  // Requests of the other class (primary or route sockets), that queued
+  // messages may have to wait for
+  const auto numOtherCompleted =
+      numRequestsCompleted_[channel.isRouteSocket() ? 0 : 1];
+  const auto sendTs = std::chrono::steady_clock::now();
+
+  while (count < iovSize && !msgQueue.empty()) {
+    if (msgQueue.front().first > numOtherCompleted) {
+      // Wait for completion of the requests enqueued before the message
+      break;
+    }
+    auto m = std::move(msgQueue.front().second);
+    msgQueue.pop();
+    m->setSendTs(sendTs);
 
     struct nlmsghdr* nlmsg_hdr = m->getMessagePtr();
     iov[count].iov_base = reinterpret_cast<void*>(m->getMessagePtr());
     iov[count].iov_len = m->getDataLength();
 
     // fill sequence number and PID
-    nlmsg_hdr->nlmsg_pid = portId_;
-    nlmsg_hdr->nlmsg_seq = nextNlSeqNum_++;
-    if (nextNlSeqNum_ == 0) {
+    nlmsg_hdr->nlmsg_pid = channel.portId;
+    nlmsg_hdr->nlmsg_seq = channel.nextNlSeqNum++;
+    if (channel.nextNlSeqNum == 0) {
       // wrap around - we start from 1
-      nextNlSeqNum_ = 1;
+      channel.nextNlSeqNum = 1;
     }
 
     // check if one request per message
@@ -248,7 +450,7 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
     }
 
     // Add seq number -> netlink request mapping
-    auto res = nlSeqNumMap_.insert({nlmsg_hdr->nlmsg_seq, std::move(m)});
+    auto res = nlSeqNumMap.insert({nlmsg_hdr->nlmsg_seq, std::move(m)});
     CHECK(res.second) << "Entry exists for " << nlmsg_hdr->nlmsg_seq;
     count++;
     XLOG(DBG2) << "Sending netlink request." << " seq=" << nlmsg_hdr->nlmsg_seq
@@ -257,6 +459,10 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
                << ", flags=" << nlmsg_hdr->nlmsg_flags;
   }
 
+  if (!count) {
+    return;
+  }
+
   auto outMsg = std::make_unique<struct msghdr>();
   outMsg->msg_name = &nladdr;
   outMsg->msg_namelen = sizeof(nladdr);
@@ -265,28 +471,37 @@ NetlinkProtocolSocket::sendNetlinkMessage() {
 
   // `sendmsg` return -1 in case of error else number of bytes sent. `errno`
   // will be set to an appropriate code in case of error.
-  int bytesSent = sendmsg(nlSock_, outMsg.get(), 0);
+  int bytesSent = sendmsg(channel.nlSock, outMsg.get(), 0);
   if (bytesSent < 0) {
+    const int sendErrno = errno;
     XLOG(ERR) << "Error sending on netlink socket. Error: "
-              << folly::errnoStr(std::abs(errno)) << ", errno=" << errno
-              << ", fd=" << nlSock_ << ", num-messages=" << outMsg->msg_iovlen;
+              << folly::errnoStr(std::abs(sendErrno))
+              << ", errno=" << sendErrno << ", fd=" << channel.nlSock
+              << ", num-messages=" << outMsg->msg_iovlen;
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    if (sendErrno == ENOBUFS) {
+      // Kernel is out of buffer space for our requests
+      decreaseWindow(channel);
+    }
   } else {
     fbData->addStatValue("netlink.bytes.tx", bytesSent, fb303::SUM);
   }
   fbData->addStatValue("netlink.requests", outMsg->msg_iovlen, fb303::SUM);
+  const auto poolStats = bufferPool_.getStats();
+  fbData->setCounter("netlink.buffers.bytes_in_use", poolStats.bytesInUse);
+  fbData->setCounter("netlink.buffers.slab_bytes", poolStats.slabBytes);
   XLOG(DBG2) << "Sent " << outMsg->msg_iovlen << " netlink requests on fd "
-             << nlSock_;
+             << channel.nlSock;
 
   // Schedule timer to wait for acks and send next set of messages
-  nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+  channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
 }
 
 void
 NetlinkProtocolSocket::processMessage(
-    const std::array<char, kMaxNlPayloadSize>& rxMsg, uint32_t bytesRead) {
+    Channel& channel, const char* rxMsg, uint32_t bytesRead) {
   // first netlink message header
-  struct nlmsghdr* nlh = (struct nlmsghdr*)rxMsg.data();
+  struct nlmsghdr* nlh = (struct nlmsghdr*)rxMsg;
   do {
     if (!NLMSG_OK(nlh, bytesRead)) {
       break;
@@ -295,22 +510,32 @@ NetlinkProtocolSocket::processMessage(
     XLOG(DBG2) << "Received reply for netlink request."
                << " seq=" << nlh->nlmsg_seq << ", type=" << nlh->nlmsg_type
                << ", len=" << nlh->nlmsg_len << ", flags=" << nlh->nlmsg_flags;
-    auto nlSeqIt = nlSeqNumMap_.find(nlh->nlmsg_seq);
+    auto nlSeqIt = channel.nlSeqNumMap.find(nlh->nlmsg_seq);
 
     switch (nlh->nlmsg_type) {
     case RTM_NEWROUTE:
     case RTM_DELROUTE: {
-      // next RTM message to be processed
-      auto route = NetlinkRouteMessage::parseMessage(nlh);
-      if (nlSeqIt != nlSeqNumMap_.end()) {
+      // Route add/delete generates route event with the same sequence as the
+      // original request. Only routes of get request are its response.
+      if (nlSeqIt != channel.nlSeqNumMap.end() and
+          nlh->nlmsg_pid == channel.portId and
+          nlSeqIt->second->getMessageType() == RTM_GETROUTE) {
         // Extend message timer as we received a valid ack
-        nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
-        // Received route in response to request
-        nlSeqIt->second->rcvdRoute(std::move(route));
-      } else {
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
+        // Received route in response to request. Routes filtered out by
+        // request are skipped without being parsed.
+        if (nlSeqIt->second->acceptRoute(nlh)) {
+          nlSeqIt->second->rcvdRoute(NetlinkRouteMessage::parseMessage(nlh));
+        }
+      } else if (routeEventsSubscribed_) {
         // Route notification
         fbData->addStatValue("netlink.notifications.route", 1, fb303::SUM);
-        DCHECK(false) << "Route notifications are not subscribed";
+        RouteEvent event;
+        event.route = NetlinkRouteMessage::normalizeRoute(
+            NetlinkRouteMessage::parseMessage(nlh));
+        event.isDeleted = nlh->nlmsg_type == RTM_DELROUTE;
+        XLOG(DBG2) << "Route event. " << event.route->str();
+        notifyRouteEvent(std::move(event));
       }
     } break;
 
@@ -319,9 +544,9 @@ NetlinkProtocolSocket::processMessage(
       // process link information received from netlink
       auto link = NetlinkLinkMessage::parseMessage(nlh);
 
-      if (nlSeqIt != nlSeqNumMap_.end()) {
+      if (nlSeqIt != channel.nlSeqNumMap.end()) {
         // Extend message timer as we received a valid ack
-        nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
         // Received link in response to request
         nlSeqIt->second->rcvdLink(std::move(link));
       } else {
@@ -341,9 +566,9 @@ NetlinkProtocolSocket::processMessage(
         break;
       }
 
-      if (nlSeqIt != nlSeqNumMap_.end()) {
+      if (nlSeqIt != channel.nlSeqNumMap.end()) {
         // Extend message timer as we received a valid ack
-        nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
         // Response to a corresponding request
         auto& request = nlSeqIt->second;
         if (request->getMessageType() == RTM_GETADDR) {
@@ -372,9 +597,9 @@ NetlinkProtocolSocket::processMessage(
       // process neighbor information received from netlink
       auto neighbor = NetlinkNeighborMessage::parseMessage(nlh);
 
-      if (nlSeqIt != nlSeqNumMap_.end()) {
+      if (nlSeqIt != channel.nlSeqNumMap.end()) {
         // Extend message timer as we received a valid ack
-        nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
         // Received neighbor in response to request
         nlSeqIt->second->rcvdNeighbor(std::move(neighbor));
       } else {
@@ -390,9 +615,9 @@ NetlinkProtocolSocket::processMessage(
       // process rule information received from netlink
       auto rule = NetlinkRuleMessage::parseMessage(nlh);
 
-      if (nlSeqIt != nlSeqNumMap_.end()) {
+      if (nlSeqIt != channel.nlSeqNumMap.end()) {
         // Extend message timer as we received a valid ack
-        nlMessageTimer_->scheduleTimeout(kNlRequestAckTimeout);
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
         // Received rule in response to request
         nlSeqIt->second->rcvdRule(std::move(rule));
       } else {
@@ -403,16 +628,32 @@ NetlinkProtocolSocket::processMessage(
       }
     } break;
 
+    case RTM_DELNEXTHOP:
+    case RTM_NEWNEXTHOP: {
+      if (nlSeqIt != channel.nlSeqNumMap.end() and
+          nlh->nlmsg_pid == channel.portId and
+          nlSeqIt->second->getMessageType() == RTM_GETNEXTHOP) {
+        // Extend message timer as we received a valid ack
+        channel.nlMessageTimer->scheduleTimeout(kNlRequestAckTimeout);
+        // Received nexthop object in response to request
+        const auto [id, protocolId] = NetlinkNexthopMessage::parseMessage(nlh);
+        nlSeqIt->second->rcvdNexthop(id, protocolId);
+      } else {
+        // Notifications are ignored
+        XLOG(DBG2) << "Ignoring nexthop event. type=" << nlh->nlmsg_type;
+      }
+    } break;
+
     case NLMSG_ERROR: {
       const struct nlmsgerr* const ack =
           reinterpret_cast<struct nlmsgerr*>(NLMSG_DATA(nlh));
-      if (ack->msg.nlmsg_pid != portId_) {
+      if (ack->msg.nlmsg_pid != channel.portId) {
         XLOG(ERR) << "received netlink message with wrong PID, received: "
-                  << ack->msg.nlmsg_pid << " expected: " << portId_;
+                  << ack->msg.nlmsg_pid << " expected: " << channel.portId;
         fbData->addStatValue("netlink.errors", 1, fb303::SUM);
         break;
       }
-      processAck(ack->msg.nlmsg_seq, ack->error);
+      processAck(channel, ack->msg.nlmsg_seq, ack->error);
     } break;
 
     case NLMSG_NOOP:
@@ -421,7 +662,7 @@ NetlinkProtocolSocket::processMessage(
 
     case NLMSG_DONE: {
       // End of multipart message
-      processAck(nlh->nlmsg_seq, 0);
+      processAck(channel, nlh->nlmsg_seq, 0);
     } break;
 
     default:
@@ -432,25 +673,60 @@ NetlinkProtocolSocket::processMessage(
 }
 
 void
-NetlinkProtocolSocket::recvNetlinkMessage() {
-  // messages buffer
-  std::array<char, kMaxNlPayloadSize> recvMsg = {};
+NetlinkProtocolSocket::recvNetlinkMessage(Channel& channel) {
+  // Receive a batch of messages into pre-allocated buffers. Messages are
+  // processed in place.
+  std::array<struct iovec, kNlRecvBatchSize> iov{};
+  std::array<struct mmsghdr, kNlRecvBatchSize> msgs{};
+  for (size_t i = 0; i < kNlRecvBatchSize; ++i) {
+    iov[i].iov_base = recvBuf_.get() + i * kNlRecvBufSize;
+    iov[i].iov_len = kNlRecvBufSize;
+    msgs[i].msg_hdr.msg_iov = &iov[i];
+    msgs[i].msg_hdr.msg_iovlen = 1;
+  }
 
-  int32_t bytesRead = ::recv(nlSock_, recvMsg.data(), kMaxNlPayloadSize, 0);
-  XLOG(DBG4) << "Message received with size: " << bytesRead;
+  const int numMsgs = ::recvmmsg(
+      channel.nlSock, msgs.data(), kNlRecvBatchSize, MSG_DONTWAIT, nullptr);
+  XLOG(DBG4) << "Messages received: " << numMsgs;
 
-  if (bytesRead < 0) {
+  if (numMsgs < 0) {
     if (errno == EINTR || errno == EAGAIN) {
       return;
     }
-    XLOG(ERR) << "Error in netlink socket receive: " << bytesRead
-              << " err: " << folly::errnoStr(std::abs(errno));
+    const int recvErrno = errno;
+    XLOG(ERR) << "Error in netlink socket receive: " << numMsgs
+              << " err: " << folly::errnoStr(std::abs(recvErrno));
     fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    if (recvErrno == ENOBUFS) {
+      // Kernel dropped messages for lack of receive buffer space
+      decreaseWindow(channel);
+      if (not channel.isRouteSocket() and routeEventsSubscribed_) {
+        // Route notifications may have been lost
+        notifyRouteEvent(RouteEvent{});
+      }
+    }
     return;
-  } else {
+  }
+
+  for (int i = 0; i < numMsgs; ++i) {
+    const uint32_t bytesRead = msgs[i].msg_len;
+    XLOG(DBG4) << "Message received with size: " << bytesRead;
     fbData->addStatValue("netlink.bytes.rx", bytesRead, fb303::SUM);
+    if (msgs[i].msg_hdr.msg_flags & MSG_TRUNC) {
+      XLOG(ERR) << "Truncated netlink message of size " << bytesRead;
+      fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+      continue;
+    }
+    // Process remaining messages of the batch even if one fails
+    try {
+      processMessage(
+          channel, static_cast<const char*>(iov[i].iov_base), bytesRead);
+    } catch (std::exception const& e) {
+      XLOG(ERR) << "Error processing netlink message: "
+                << folly::exceptionStr(e);
+      fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    }
   }
-  processMessage(recvMsg, static_cast<uint32_t>(bytesRead));
 }
 
 folly::SemiFuture<folly::Unit>
@@ -471,22 +747,100 @@ NetlinkProtocolSocket::collectReturnStatus(
       });
 }
 
+void
+NetlinkProtocolSocket::enqueueMessage(
+    std::unique_ptr<NetlinkMessageBase> nlmsg, size_t channel) {
+  // Move encoded message into right-sized buffer before queuing. Also frees up
+  // the encode buffer of the calling thread for next message.
+  nlmsg->seal(bufferPool_);
+  notifQueue_.putMessage(ChannelMessage(channel, std::move(nlmsg)));
+}
+
+void
+NetlinkProtocolSocket::setRouteEventHandler(RouteEventHandler handler) {
+  routeEventsSubscribed_ = handler != nullptr;
+  *routeEventHandler_.wlock() = std::move(handler);
+
+  // Socket is subscribed on initialization if event base isn't running yet
+  if (evb_->isRunning()) {
+    evb_->runInEventBaseThread(
+        [this]() { updateRouteEventsMembership(*channels_.at(0)); });
+  }
+}
+
+void
+NetlinkProtocolSocket::notifyRouteEvent(RouteEvent&& event) {
+  auto handler = routeEventHandler_.rlock();
+  if (*handler) {
+    (*handler)(std::move(event));
+  }
+}
+
+void
+NetlinkProtocolSocket::updateRouteEventsMembership(Channel& channel) {
+  if (channel.nlSock < 0) {
+    // Socket is not initialized yet
+    return;
+  }
+  const int option = routeEventsSubscribed_ ? NETLINK_ADD_MEMBERSHIP
+                                            : NETLINK_DROP_MEMBERSHIP;
+  for (int group : {RTNLGRP_IPV4_ROUTE, RTNLGRP_IPV6_ROUTE}) {
+    if (::setsockopt(
+            channel.nlSock, SOL_NETLINK, option, &group, sizeof(group)) != 0) {
+      XLOG(ERR) << "Failed to update membership of netlink group " << group
+                << ": " << folly::errnoStr(errno);
+      fbData->addStatValue("netlink.errors", 1, fb303::SUM);
+    }
+  }
+}
+
+size_t
+NetlinkProtocolSocket::getRouteChannel(const Route& route) const {
+  if (numRouteSockets_ == 0) {
+    return 0;
+  }
+
+  // Spread (route-table, address-family) pairs over route sockets in round
+  // robin fashion. IPv4, IPv6 and MPLS routes of a table land on different
+  // sockets if there are enough of them.
+  size_t familyIndex{0};
+  switch (route.getFamily()) {
+  case AF_INET:
+    familyIndex = 0;
+    break;
+  case AF_INET6:
+    familyIndex = 1;
+    break;
+  default:
+    familyIndex = 2;
+  }
+  return 1 + (route.getRouteTable() * 3 + familyIndex) % numRouteSockets_;
+}
+
+NetlinkBufferPool::Stats
+NetlinkProtocolSocket::getBufferPoolStats() const {
+  return bufferPool_.getStats();
+}
+
 folly::SemiFuture<int>
 NetlinkProtocolSocket::addRoute(const openr::fbnl::Route& route) {
   XLOG(DBG1) << "Netlink add route. " << route.str();
+  if (route.getFamily() == AF_INET6 and
+      not enableIPv6RouteReplaceSemantics_) {
+    // Special case for IPv6 route add. We first delete the route and then
+    // add it.
+    // NOTE: We ignore the error for the deleteRoute
+    // NOTE: Delete message is encoded and sealed before the add message is
+    // created, so both can share the thread's encode buffer
+    deleteRoute(route);
+  }
+
   auto rtmMsg = std::make_unique<NetlinkRouteMessage>();
   auto future = rtmMsg->getSemiFuture();
 
   int status{0};
   switch (route.getFamily()) {
   case AF_INET6:
-    if (not enableIPv6RouteReplaceSemantics_) {
-      // Special case for IPv6 route add. We first delete the route and then
-      // add it.
-      // NOTE: We ignore the error for the deleteRoute
-      deleteRoute(route);
-    }
-    [[fallthrough]];
   case AF_INET:
     status = rtmMsg->addRoute(route);
     break;
@@ -500,7 +854,7 @@ NetlinkProtocolSocket::addRoute(const openr::fbnl::Route& route) {
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(rtmMsg));
+    enqueueMessage(std::move(rtmMsg), getRouteChannel(route));
   }
 
   return future;
@@ -528,7 +882,7 @@ NetlinkProtocolSocket::deleteRoute(const openr::fbnl::Route& route) {
   if (status != 0) {
     rtmMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(rtmMsg));
+    enqueueMessage(std::move(rtmMsg), getRouteChannel(route));
   }
 
   return future;
@@ -545,7 +899,7 @@ NetlinkProtocolSocket::addIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   if (status != 0) {
     addrMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(addrMsg));
+    enqueueMessage(std::move(addrMsg));
   }
 
   return future;
@@ -562,7 +916,7 @@ NetlinkProtocolSocket::deleteIfAddress(const openr::fbnl::IfAddress& ifAddr) {
   if (status != 0) {
     addrMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(addrMsg));
+    enqueueMessage(std::move(addrMsg));
   }
 
   return future;
@@ -578,7 +932,7 @@ NetlinkProtocolSocket::addLink(const openr::fbnl::Link& link) {
   if (status != 0) {
     linkMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(linkMsg));
+    enqueueMessage(std::move(linkMsg));
   }
 
   return future;
@@ -594,7 +948,7 @@ NetlinkProtocolSocket::deleteLink(const openr::fbnl::Link& link) {
   if (status != 0) {
     linkMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(linkMsg));
+    enqueueMessage(std::move(linkMsg));
   }
 
   return future;
@@ -610,7 +964,7 @@ NetlinkProtocolSocket::addRule(const openr::fbnl::Rule& rule) {
   if (status != 0) {
     ruleMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(ruleMsg));
+    enqueueMessage(std::move(ruleMsg));
   }
 
   return future;
@@ -626,7 +980,60 @@ NetlinkProtocolSocket::deleteRule(const openr::fbnl::Rule& rule) {
   if (status != 0) {
     ruleMsg->setReturnStatus(status);
   } else {
-    notifQueue_.putMessage(std::move(ruleMsg));
+    enqueueMessage(std::move(ruleMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::addNexthop(
+    uint32_t id, const openr::fbnl::NextHop& nextHop, uint8_t protocolId) {
+  XLOG(DBG1) << "Netlink add nexthop. id " << id << ", " << nextHop.str();
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->addNexthop(id, nextHop, protocolId);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    enqueueMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t protocolId) {
+  XLOG(DBG1) << "Netlink add nexthop group. id " << id << ", members "
+             << members.size();
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->addNexthopGroup(id, members, protocolId);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    enqueueMessage(std::move(nhMsg));
+  }
+
+  return future;
+}
+
+folly::SemiFuture<int>
+NetlinkProtocolSocket::deleteNexthop(uint32_t id) {
+  XLOG(DBG1) << "Netlink delete nexthop. id " << id;
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getSemiFuture();
+
+  int status = nhMsg->deleteNexthop(id);
+  if (status != 0) {
+    nhMsg->setReturnStatus(status);
+  } else {
+    enqueueMessage(std::move(nhMsg));
   }
 
   return future;
@@ -640,7 +1047,7 @@ NetlinkProtocolSocket::getAllLinks() {
 
   // Initialize message fields to get all links
   linkMsg->init(RTM_GETLINK, 0);
-  notifQueue_.putMessage(std::move(linkMsg));
+  enqueueMessage(std::move(linkMsg));
 
   return future;
 }
@@ -653,7 +1060,7 @@ NetlinkProtocolSocket::getAllIfAddresses() {
 
   // Initialize message fields to get all addresses
   addrMsg->init(RTM_GETADDR);
-  notifQueue_.putMessage(std::move(addrMsg));
+  enqueueMessage(std::move(addrMsg));
 
   return future;
 }
@@ -666,7 +1073,21 @@ NetlinkProtocolSocket::getAllNeighbors() {
 
   // Initialize message fields to get all neighbors
   neighMsg->init(RTM_GETNEIGH, 0);
-  notifQueue_.putMessage(std::move(neighMsg));
+  enqueueMessage(std::move(neighMsg));
+
+  return future;
+}
+
+folly::SemiFuture<
+    folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+NetlinkProtocolSocket::getAllNexthops() {
+  XLOG(DBG1) << "Netlink get nexthops";
+  auto nhMsg = std::make_unique<openr::fbnl::NetlinkNexthopMessage>();
+  auto future = nhMsg->getNexthopsSemiFuture();
+
+  // Initialize message fields to get all nexthop objects
+  nhMsg->init(RTM_GETNEXTHOP);
+  enqueueMessage(std::move(nhMsg));
 
   return future;
 }
@@ -679,7 +1100,7 @@ NetlinkProtocolSocket::getAllRules() {
 
   // Initialize message fields to get all rules
   ruleMsg->init(RTM_GETRULE);
-  notifQueue_.putMessage(std::move(ruleMsg));
+  enqueueMessage(std::move(ruleMsg));
 
   return future;
 }
@@ -692,7 +1113,7 @@ NetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
 
   // Initialize message fields to get all addresses
   routeMsg->initGet(0, filter);
-  notifQueue_.putMessage(std::move(routeMsg));
+  enqueueMessage(std::move(routeMsg));
 
   return future;
 }
@@ -7,7 +7,13 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <queue>
+
 #include <folly/IPAddress.h>
+#include <folly/Synchronized.h>
 #include <folly/futures/Future.h>
 #include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
@@ -19,6 +25,7 @@
 #include <openr/nl/NetlinkLinkMessage.h>
 #include <openr/nl/NetlinkMessageBase.h>
 #include <openr/nl/NetlinkNeighborMessage.h>
+#include <openr/nl/NetlinkNexthopMessage.h>
 #include <openr/nl/NetlinkRouteMessage.h>
 #include <openr/nl/NetlinkRuleMessage.h>
 #include <openr/nl/NetlinkTypes.h>
@@ -29,13 +36,41 @@ namespace openr::fbnl {
 using NetlinkEvent =
     std::variant<fbnl::Link, fbnl::IfAddress, fbnl::Neighbor, fbnl::Rule>;
 
-// Receive socket buffer for netlink socket
-constexpr uint32_t kNetlinkSockRecvBuf{1 * 1024 * 1024};
+// Notification of IPv4/IPv6 route added, replaced or deleted in kernel. Route
+// is not set if notifications were lost (e.g. socket receive buffer overrun)
+// and receiver must re-synchronize its state from kernel.
+struct RouteEvent {
+  std::optional<fbnl::Route> route;
+  bool isDeleted{false};
+};
+
+using RouteEventHandler = std::function<void(RouteEvent&&)>;
 
-// Maximum number of in-flight messages. `kMinIovMsg` indicates the soft
-// requirement for sending bufferred messages.
-constexpr size_t kMaxIovMsg{500};
+// Receive socket buffer for netlink socket. It is grown along with the window
+// of in-flight messages, by `kNetlinkSockRecvBufPerMsg` for every message, up
+// to `kNetlinkSockMaxRecvBuf`.
+constexpr uint32_t kNetlinkSockRecvBuf{1 * 1024 * 1024};
+constexpr uint32_t kNetlinkSockMaxRecvBuf{8 * 1024 * 1024};
+constexpr uint32_t kNetlinkSockRecvBufPerMsg{2 * 1024};
+
+// Number of in-flight messages per socket is limited by a window, adapted
+// between `kMinIovWindow` and `kMaxIovMsg` in AIMD fashion. It starts at
+// `kInitIovWindow` and grows by `kIovWindowIncrement` for every window worth
+// of acks. It is halved when an ack takes longer than `kNlAckLatencyThreshold`
+// or kernel reports lack of buffer space (ENOBUFS). `kMinIovMsg` indicates the
+// soft requirement for sending bufferred messages.
+constexpr size_t kMaxIovMsg{2000};
+constexpr size_t kInitIovWindow{500};
+constexpr size_t kMinIovWindow{50};
+constexpr size_t kIovWindowIncrement{50};
 constexpr size_t kMinIovMsg{200};
+constexpr std::chrono::milliseconds kNlAckLatencyThreshold{100};
+
+// Size and number of buffers for receiving messages in a batch (recvmmsg).
+// Kernel sizes the multipart messages of a dump according to the size of the
+// receive buffer, upto 32KB.
+constexpr uint32_t kNlRecvBufSize{32 * 1024};
+constexpr uint32_t kNlRecvBatchSize{8};
 
 // Timeout for an ack from kernel for netlink messages we sent. The response for
 // big request (e.g. adding 5k routes or getting 10k routes) is sent back in
@@ -66,9 +101,21 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  * Above threading model allows multiple requests to be sent in parallel and
  * process their response asynchronously. Outstanding requests to kernel is
  * rate-limited to not overwhelm the socket buffers. Rate-limiting of requests
- * is governed by params kMaxIovMsg and kMinIovMsg. This allows adding 100k
- * routes in under 2 seconds. These performance benchmarks can be observed
- * by running associated UTs and it might vary on different systems.
+ * is governed by an adaptive window (see kInitIovWindow) and kMinIovMsg. This
+ * allows adding 100k routes in under 2 seconds. These performance benchmarks
+ * can be observed by running associated UTs and it might vary on different
+ * systems.
+ *
+ * Optionally route add/delete requests can be spread over a pool of additional
+ * route sockets (see `numRouteSockets` in constructor), sharded by route table
+ * and address family. Every socket has its own window of in-flight requests,
+ * which lets a large route update of one table or family proceed without
+ * waiting behind the acks of another. Ordering guarantees are retained as
+ * following
+ * - Requests of a shard (e.g. IPv6 routes of main table) are sent in order
+ * - Route requests are sent only after all the other requests (e.g. nexthop
+ *   objects, links) enqueued before them have completed, and vice versa.
+ * Hence only route requests of different shards may complete out of order.
  *
  * NOTE Logging:
  * Netlink protocol is tricky when it comes to debugging. To faciliate debugging
@@ -89,19 +136,37 @@ constexpr std::chrono::milliseconds kNlRequestAckTimeout{1000};
  *   netlink.requests.success : Request that completed successfully
  *   netlink.requests.error : Request with non zero return code
  *   netlink.requests.latency_ms : Average latency of netlink request
+ *   netlink.requests.ack_latency_ms : Average latency of ack since send
+ *   netlink.requests.window : In-flight requests allowed across sockets
+ *   netlink.requests.window_increases : Increases of in-flight window
+ *   netlink.requests.window_decreases : Decreases of in-flight window
  *   netlink.bytes.rx : Bytes received over netlink socket
  *   netlink.bytes.tx : Bytes sent over netlink socket
  *   netlink.notifications.link : Received link notifications
  *   netlink.notifications.addr : Received address notifications
  *   netlink.notifications.neighbors : Received neighbor notifications
  *   netlink.notifications.route : Received route notifications
+ *   netlink.buffers.bytes_in_use : Bytes of queued and in-flight requests
+ *   netlink.buffers.slab_bytes : Bytes allocated for request buffer pool
+ *   netlink.buffers.socket_recv_bytes : Receive buffer size across sockets
+ *
+ * NOTE Memory:
+ * Requests are encoded in a per-thread scratch buffer and then moved into a
+ * right-sized buffer from `NetlinkBufferPool` owned by this class before being
+ * queued. Memory held by queued requests is proportional to their actual size
+ * rather than `kMaxNlPayloadSize` each.
  */
-class NetlinkProtocolSocket : public folly::EventHandler {
+class NetlinkProtocolSocket {
  public:
+  /**
+   * @param numRouteSockets Number of additional netlink sockets for route
+   *        add/delete requests. With 0, all requests share a single socket.
+   */
   explicit NetlinkProtocolSocket(
       folly::EventBase* evb,
       messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQ,
-      bool enableIPv6RouteReplaceSemantics = false);
+      bool enableIPv6RouteReplaceSemantics = false,
+      size_t numRouteSockets = 0);
 
   virtual ~NetlinkProtocolSocket();
 
@@ -179,6 +244,54 @@ class NetlinkProtocolSocket : public folly::EventHandler {
    */
   virtual folly::SemiFuture<int> deleteRule(const openr::fbnl::Rule& rule);
 
+  /**
+   * Add or replace kernel nexthop object with given id. Nexthop must have
+   * gateway and interface index set. Optionally MPLS PUSH labels.
+   *
+   * NOTE: Messages are sent in the order of API invocation. Hence nexthop
+   * objects can be created and referenced by route (RTA_NH_ID) in the
+   * subsequent API calls without waiting for the future.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> addNexthop(
+      uint32_t id, const openr::fbnl::NextHop& nextHop, uint8_t protocolId);
+
+  /**
+   * Add or replace kernel nexthop group object with given id. Members are
+   * pairs of nexthop object id and weight. Replacing the members of an
+   * existing group atomically updates all the routes referring to it.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocolId);
+
+  /**
+   * Delete kernel nexthop or nexthop group object with given id.
+   *
+   * NOTE: Kernel removes all the routes still referring to the deleted group.
+   *
+   * @returns 0 on success else appropriate system error code
+   */
+  virtual folly::SemiFuture<int> deleteNexthop(uint32_t id);
+
+  /**
+   * API to get kernel nexthop and nexthop group objects. Objects are
+   * specified as pairs of id and protocol.
+   */
+  virtual folly::SemiFuture<
+      folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+  getAllNexthops();
+
+  /**
+   * Get statistics of buffer pool used for requests. Used for monitoring
+   * memory footprint in tests and benchmarks.
+   */
+  NetlinkBufferPool::Stats getBufferPoolStats() const;
+
   /**
    * API to get interfaces from kernel
    */
@@ -231,6 +344,15 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   getMplsRoutes(
       uint8_t protocolId, std::optional<uint8_t> routeTableId = std::nullopt);
 
+  /**
+   * Subscribe to kernel notifications of IPv4/IPv6 routes of all tables,
+   * including the ones programmed via this socket. Handler is invoked in
+   * event base thread. Only one handler is supported; setting a handler
+   * replaces the previous one and `nullptr` unsubscribes. Once this returns,
+   * the previous handler is guaranteed not to be running.
+   */
+  virtual void setRouteEventHandler(RouteEventHandler handler);
+
   /**
    * Utility function to accumulate result of multiple requests into one.
    * It will throw the exception with the first non-zero value(aka error code),
@@ -244,28 +366,155 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Initialize netlink socket and add to eventloop for polling
   virtual void init();
 
+  // Invoke route event handler, if any
+  void notifyRouteEvent(RouteEvent&& event);
+
  private:
   NetlinkProtocolSocket(NetlinkProtocolSocket const&) = delete;
   NetlinkProtocolSocket& operator=(NetlinkProtocolSocket const&) = delete;
 
-  // Implement EventHandler callback for reading netlink messages
-  void handlerReady(uint16_t events) noexcept override;
-
-  // Send a message batch to netlink socket from queue_
-  void sendNetlinkMessage();
-
-  // Receive messages from netlink socket. Invoke `processMessage` for every
-  // message received.
-  void recvNetlinkMessage();
+  // Message along with index of the channel to send it on
+  using ChannelMessage = std::pair<size_t, std::unique_ptr<NetlinkMessageBase>>;
+
+  // Netlink socket along with its queued and in-flight requests. First channel
+  // is the primary socket, which is subscribed for notifications and carries
+  // all the requests except route add/delete when route sockets are enabled.
+  struct Channel : public folly::EventHandler {
+    Channel(NetlinkProtocolSocket* parent, size_t index);
+
+    // Implement EventHandler callback for reading netlink messages
+    void handlerReady(uint16_t events) noexcept override;
+
+    bool
+    isRouteSocket() const {
+      return index != 0;
+    }
+
+    NetlinkProtocolSocket* const parent{nullptr};
+
+    // Index of channel in `channels_`
+    const size_t index{0};
+
+    // Netlink socket fd. Created when class is constructed. Re-created on
+    // timeout when no response is received for any of our pending requests.
+    int nlSock{-1};
+
+    // nl_pid stands for port-ID and not process-ID. Netlink sockets are bound
+    // on this specified port. This must be unique for every netlink socket
+    // that is created on the system. Ironically kernel assigns the process-ID
+    // as the port-ID for the first socket that is created by process. All
+    // subsequent netlink sockets created by process gets assigned some
+    // unique-ID.
+    uint32_t portId{UINT_MAX};
+
+    // Next available sequence number to use. It is possible to wrap this
+    // around, and should be fine. We put hard check to avoid conflict between
+    // pending seq number with next sequence number.
+    // NOTE: We intentionally start from sequence from 1 and not 0.
+    // Notification messages from kernel are not associated with any sequence
+    // number and they have `nlmsg_seq` set to `0`. There are two message
+    // exchanges over nlSock.
+    // 1) REQ-REP (for querying data e.g. links/routes from kernel) -- Here we
+    //    send request with non-zero sequence number. The messages sent from
+    //    kernel in reply will bear the appropriate sequence numbers
+    // 2) PUSH (notification message from kernel) -- This notification is from
+    //    kernel on any event. There is no sequence number associated with it
+    //    and value of nlh->nlmsg_seq will set to 0.
+    uint32_t nextNlSeqNum{1};
+
+    // Netlink message queue. Every add/del/get call for
+    // route/addr/neighbor/link/rule translates into one or more
+    // NetlinkMessages. These messages are first stored in the queue and sent
+    // to kernel in rate limiting fashion. When ack for in-flight messages is
+    // received, subsequent messages are sent. Every message is queued along
+    // with the number of requests of the other channel class (primary or
+    // route sockets) that must complete before it can be sent.
+    std::queue<std::pair<uint64_t, std::unique_ptr<NetlinkMessageBase>>>
+        msgQueue;
+
+    // Sequence number to NetlinkMesage request mapping. Each in-flight message
+    // sent to kernel, is assigned a unique sequence-number and stored in this
+    // map. On receipt of ack from kernel (either success or error) we clear
+    // the corresponding entry from this map.
+    std::unordered_map<uint32_t, std::shared_ptr<NetlinkMessageBase>>
+        nlSeqNumMap;
+
+    // Timer to help keep track of timeout of messages sent to kernel. It also
+    // ensures the aliveness of the netlink socket-fd. Timer is
+    // - Started when a new message is sent
+    // - Reset whenever we receive update about one of the pending ack
+    // - Cleared when there is no pending ack in nlSeqNumMap
+    // When timer fires, it is an indication that we didn't receive the ack for
+    // one of the entry in nlSeqNoMap, for at-least past kNlRequestAckTimeout
+    // time. Netlink socket is re-initiaited on timeout for any of our pending
+    // message, and `nlSeqNumMap` is cleared.
+    std::unique_ptr<folly::AsyncTimeout> nlMessageTimer{nullptr};
+
+    // Limit of in-flight messages. Adapted to ack latency and buffer pressure
+    size_t window{kInitIovWindow};
+
+    // Number of acks received since window was last increased
+    size_t numAcksSinceIncrease{0};
+
+    // Messages sent before this sequence number were in flight when window
+    // was last decreased. Their latency doesn't decrease the window again.
+    uint32_t windowDecreaseSeq{0};
+
+    // Size of socket receive buffer. Preserved when socket is re-created.
+    uint32_t recvBufSize{kNetlinkSockRecvBuf};
+  };
+
+  // Create and bind netlink socket of the channel and add to eventloop for
+  // polling
+  void initChannel(Channel& channel);
+
+  // Send a message batch to netlink socket from queue of the channel
+  void sendNetlinkMessage(Channel& channel);
+
+  // Receive a batch of messages from netlink socket. Invoke `processMessage`
+  // for every message received.
+  void recvNetlinkMessage(Channel& channel);
 
   // Process received netlink message. Set return values for pending requests
   // or send notifications.
   void processMessage(
-      const std::array<char, kMaxNlPayloadSize>& rxMsg, uint32_t bytesRead);
+      Channel& channel, const char* rxMsg, uint32_t bytesRead);
+
+  // Process ack message. Set return status on pending requests in nlSeqNumMap
+  // Resume sending messages from queue if any pending
+  void processAck(Channel& channel, uint32_t ack, int status);
+
+  // Adapt window of the channel on ack of a request sent `latency` ago
+  void updateWindow(
+      Channel& channel, uint32_t ack, std::chrono::milliseconds latency);
 
-  // Process ack message. Set return status on pending requests in nlSeqNumMap_
-  // Resume sending messages from queue_ if any pending
-  void processAck(uint32_t ack, int status);
+  // Halve the window of the channel, bounded by `kMinIovWindow`
+  void decreaseWindow(Channel& channel);
+
+  // Grow socket receive buffer of the channel for acks of given window.
+  // Returns the largest window the buffer can accommodate.
+  size_t growRecvBuf(Channel& channel, size_t window);
+
+  // Export sum of windows and receive buffers of all channels
+  void exportWindowCounters() const;
+
+  // Time out all the pending requests of the channel and re-create its socket
+  void processTimeout(Channel& channel);
+
+  // Account completed requests of the channel and resume sending on channels
+  // of the other class, which may be waiting for them
+  void completeRequests(const Channel& channel, size_t numRequests);
+
+  // Index of the channel to send route add/delete request on
+  size_t getRouteChannel(const Route& route) const;
+
+  // Join or leave route notification groups on the primary socket
+  void updateRouteEventsMembership(Channel& channel);
+
+  // Seal the encoded message into pooled buffer and enqueue it for sending on
+  // the given channel
+  void enqueueMessage(
+      std::unique_ptr<NetlinkMessageBase> nlmsg, size_t channel = 0);
 
   // Event base for serializing read/write requests to netlink socket. Also
   // ensure thread safety of private member variables.
@@ -274,66 +523,46 @@ class NetlinkProtocolSocket : public folly::EventHandler {
   // Queue to publish LINK/ADDR/NEIGHBOR/RULE update received from kernel
   messaging::ReplicateQueue<NetlinkEvent>& netlinkEventsQueue_;
 
+  // Pool of right-sized buffers for encoded messages.
+  // NOTE: Declared ahead of the message queues below, as it must outlive all
+  // the messages holding its buffers
+  NetlinkBufferPool bufferPool_;
+
   // Notification queue for thread safe enqueuing of messages from external
   // threads. All the messages enqueued are processed by the event thread.
-  folly::NotificationQueue<std::unique_ptr<NetlinkMessageBase>> notifQueue_;
+  folly::NotificationQueue<ChannelMessage> notifQueue_;
   std::unique_ptr<
-      folly::NotificationQueue<std::unique_ptr<NetlinkMessageBase>>::Consumer,
+      folly::NotificationQueue<ChannelMessage>::Consumer,
       folly::DelayedDestruction::Destructor>
       notifConsumer_;
 
   // Use new IPv6 route replace semantics. See documentation for addRoute(...)
   const bool enableIPv6RouteReplaceSemantics_{false};
 
-  // Netlink socket fd. Created when class is constructed. Re-created on timeout
-  // when no response is received for any of our pending requests.
-  int nlSock_{-1};
-
-  // nl_pid stands for port-ID and not process-ID. Netlink sockets are bound on
-  // this specified port. This must be unique for every netlink socket that
-  // is created on the system. Ironically kernel assigns the process-ID as the
-  // port-ID for the first socket that is created by process. All subsequent
-  // netlink sockets created by process gets assigned some unique-ID.
-  uint32_t portId_{UINT_MAX};
-
-  // Next available sequence number to use. It is possible to wrap this around,
-  // and should be fine. We put hard check to avoid conflict between pending
-  // seq number with next sequence number.
-  // NOTE: We intentionally start from sequence from 1 and not 0. Notification
-  // messages from kernel are not associated with any sequence number and they
-  // have `nlmsg_seq` set to `0`. There are two message exchanges over nlSock.
-  // 1) REQ-REP (for querying data e.g. links/routes from kernel) -- Here we
-  //    send request with non-zero sequence number. The messages sent from
-  //    kernel in reply will bear the appropriate sequence numbers
-  // 2) PUSH (notification message from kernel) -- This notification is from
-  //    kernel on any event. There is no sequence number associated with it and
-  //    value of nlh->nlmsg_seq will set to 0.
-  uint32_t nextNlSeqNum_{1};
-
-  // Netlink message queue. Every add/del/get call for
-  // route/addr/neighbor/link/rule translates into one or more NetlinkMessages.
-  // These messages are first stored in the queue and sent to kernel in rate
-  // limiting fashion. When ack for in-flight messages is received, subsequent
-  // messages are sent.
-  std::queue<std::unique_ptr<NetlinkMessageBase>> msgQueue_;
-
-  // Sequence number to NetlinkMesage request mapping. Each in-flight message
-  // sent to kernel, is assigned a unique sequence-number and stored in this
-  // map. On receipt of ack from kernel (either success or error) we clear the
-  // corresponding entry from this map.
-  std::unordered_map<uint32_t, std::shared_ptr<NetlinkMessageBase>>
-      nlSeqNumMap_;
-
-  // Timer to help keep track of timeout of messages sent to kernel. It also
-  // ensures the aliveness of the netlink socket-fd. Timer is
-  // - Started when a new message is sent
-  // - Reset whenever we receive update about one of the pending ack
-  // - Cleared when there is no pending ack in nlSeqNumMap_
-  // When timer fires, it is an indication that we didn't receive the ack for
-  // one of the entry in nlSeqNoMap, for at-least past kNlRequestAckTimeout
-  // time. Netlink socket is re-initiaited on timeout for any of our pending
-  // message, and `nlSeqNumMap_` is cleared.
-  std::unique_ptr<folly::AsyncTimeout> nlMessageTimer_{nullptr};
+  // Number of additional sockets for route add/delete requests
+  const size_t numRouteSockets_{0};
+
+  // Primary socket followed by route sockets, if any
+  std::vector<std::unique_ptr<Channel>> channels_;
+
+  // Number of requests enqueued and completed (either acked or failed), for
+  // the primary socket and route sockets respectively. Requests of one class
+  // wait for requests of the other class enqueued before them to complete.
+  // NOTE: Completed count is exact for this purpose, as requests enqueued
+  // after a waiting request can't complete before it.
+  std::array<uint64_t, 2> numRequestsEnqueued_{};
+  std::array<uint64_t, 2> numRequestsCompleted_{};
+
+  // Handler of route notifications. Invoked with the lock held, so that
+  // handler can't be replaced while it is running.
+  folly::Synchronized<RouteEventHandler> routeEventHandler_;
+
+  // Primary socket should be subscribed to route notifications
+  std::atomic<bool> routeEventsSubscribed_{false};
+
+  // Buffers for receiving a batch of messages. Received messages are parsed in
+  // place and only routes accepted by the request are materialized.
+  std::unique_ptr<char[]> recvBuf_;
 
   // Timer for initializing this socket. This gets cancelled automatically if
   // event-base is never started
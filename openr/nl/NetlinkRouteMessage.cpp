@@ -11,30 +11,98 @@
 
 namespace openr::fbnl {
 
+NetlinkRouteMessageView::NetlinkRouteMessageView(const struct nlmsghdr* nlmsg)
+    : nlmsg_(nlmsg),
+      rtmsg_(reinterpret_cast<const struct rtmsg*>(NLMSG_DATA(nlmsg))) {}
+
+uint32_t
+NetlinkRouteMessageView::getRouteTable() const {
+  const auto routeAttr = getAttribute(RTA_TABLE);
+  if (routeAttr) {
+    return *(reinterpret_cast<const uint32_t*> RTA_DATA(routeAttr));
+  }
+  return rtmsg_->rtm_table;
+}
+
+std::optional<folly::CIDRNetwork>
+NetlinkRouteMessageView::getDestination() const {
+  if (rtmsg_->rtm_family != AF_INET and rtmsg_->rtm_family != AF_INET6) {
+    return std::nullopt;
+  }
+  const auto routeAttr = getAttribute(RTA_DST);
+  if (not routeAttr) {
+    return std::make_pair(
+        rtmsg_->rtm_family == AF_INET ? folly::IPAddress(folly::IPAddressV4())
+                                      : folly::IPAddress(folly::IPAddressV6()),
+        rtmsg_->rtm_dst_len);
+  }
+  auto ipAddress = NetlinkMessageBase::parseIp(routeAttr, rtmsg_->rtm_family);
+  if (ipAddress.hasError()) {
+    return std::nullopt;
+  }
+  return std::make_pair(ipAddress.value(), rtmsg_->rtm_dst_len);
+}
+
+const struct rtattr*
+NetlinkRouteMessageView::getAttribute(uint16_t type) const {
+  const struct rtattr* routeAttr;
+  auto routeAttrLen = RTM_PAYLOAD(nlmsg_);
+  for (routeAttr = RTM_RTA(rtmsg_); RTA_OK(routeAttr, routeAttrLen);
+       routeAttr = RTA_NEXT(routeAttr, routeAttrLen)) {
+    if (routeAttr->rta_type == type) {
+      return routeAttr;
+    }
+  }
+  return nullptr;
+}
+
 NetlinkRouteMessage::NetlinkRouteMessage() : NetlinkMessageBase() {}
 
 NetlinkRouteMessage::~NetlinkRouteMessage() {
   CHECK(routePromise_.isFulfilled());
 }
 
-void
-NetlinkRouteMessage::rcvdRoute(Route&& route) {
+bool
+NetlinkRouteMessage::acceptRoute(const struct nlmsghdr* nlmsg) const {
   //
-  // Implement application side filters for table and protocol if specified
+  // Implement application side filters for table, protocol, type and prefix
+  // if specified. Applied on the message in place, before route is parsed.
   //
-
-  if (filters_.table && filters_.table != route.getRouteTable()) {
-    return; // ignore the route
-  }
+  const NetlinkRouteMessageView route(nlmsg);
 
   if (filters_.protocol && filters_.protocol != route.getProtocolId()) {
-    return; // ignore the route
+    return false; // ignore the route
   }
 
   if (filters_.type && filters_.type != route.getType()) {
-    return; // ignore the route
+    return false; // ignore the route
+  }
+
+  if (filters_.table && filters_.table != route.getRouteTable()) {
+    return false; // ignore the route
+  }
+
+  if (filters_.prefix.has_value()) {
+    // Accept routes within the prefix only
+    const auto& [filterAddr, filterLen] = filters_.prefix.value();
+    const auto dst = route.getDestination();
+    if (not dst.has_value() or dst->second < filterLen or
+        dst->first.family() != filterAddr.family() or
+        not dst->first.inSubnet(filterAddr, filterLen)) {
+      return false; // ignore the route
+    }
   }
 
+  return true;
+}
+
+void
+NetlinkRouteMessage::rcvdRoute(Route&& route) {
+  rcvdRoutes_.emplace_back(normalizeRoute(std::move(route)));
+}
+
+Route
+NetlinkRouteMessage::normalizeRoute(Route&& route) {
   NextHopSet reversedMplsLabelNhs;
   bool reverted = false;
   for (auto nh : route.getNextHops()) {
@@ -50,8 +118,7 @@ NetlinkRouteMessage::rcvdRoute(Route&& route) {
   if (reverted) {
     route.setNextHops(reversedMplsLabelNhs);
   }
-
-  rcvdRoutes_.emplace_back(std::move(route));
+  return std::move(route);
 }
 
 void
@@ -85,6 +152,11 @@ NetlinkRouteMessage::init(int type, uint32_t rtFlags, const Route& route) {
     filters_.table = route.getRouteTable();
     filters_.type = route.getType();
     filters_.protocol = route.getProtocolId();
+    // Default prefix of the family (e.g. ::/0) doesn't filter any route
+    const auto& dst = route.getDestination();
+    if (route.getFamily() != AF_MPLS and dst.second > 0) {
+      filters_.prefix = dst;
+    }
 
     XLOG(DBG3) << "RTM_GETROUTE "
                << " table=" << static_cast<int>(filters_.table)
@@ -721,6 +793,12 @@ NetlinkRouteMessage::parseMessage(const struct nlmsghdr* nlmsg) {
         routeBuilder.setPrefSrc(ipAddr.value());
       }
     } break;
+
+    // Route resolved via kernel nexthop object. Kernel still reports the
+    // resolved nexthops along with it.
+    case RTA_NH_ID: {
+      routeBuilder.setNhId(*(reinterpret_cast<uint32_t*> RTA_DATA(routeAttr)));
+    } break;
     }
   }
 
@@ -844,6 +922,14 @@ NetlinkRouteMessage::addRoute(const Route& route) {
     }
   }
 
+  // setup RTA_NH_ID attribute. Nexthops are owned by the referenced nexthop
+  // object and must not be encoded inline.
+  if (route.getNhId()) {
+    const uint32_t nhId = route.getNhId().value();
+    return addAttributes(
+        RTA_NH_ID, reinterpret_cast<const char*>(&nhId), sizeof(uint32_t));
+  }
+
   return addNextHops(route);
 }
 
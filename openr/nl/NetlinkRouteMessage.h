@@ -22,6 +22,11 @@ extern "C" {
 #define MPLS_IPTUNNEL_DST 1
 #endif
 
+// Route attribute referring to kernel nexthop object (Linux 5.3+)
+#ifndef RTA_NH_ID
+#define RTA_NH_ID 30
+#endif
+
 namespace openr::fbnl {
 
 constexpr uint16_t kMaxLabels{16};
@@ -29,6 +34,47 @@ constexpr uint32_t kLabelBosShift{8};
 constexpr uint32_t kLabelShift{12};
 constexpr uint32_t kLabelSizeBits{20};
 
+/**
+ * Read-only view of a route message received from kernel. Header fields and
+ * attributes are read in place, without materializing the `Route` object and
+ * its nexthops. Useful for filtering routes of a large dump before parsing.
+ *
+ * NOTE: View must not outlive the buffer holding the message
+ */
+class NetlinkRouteMessageView {
+ public:
+  explicit NetlinkRouteMessageView(const struct nlmsghdr* nlmsg);
+
+  uint8_t
+  getFamily() const {
+    return rtmsg_->rtm_family;
+  }
+
+  uint8_t
+  getProtocolId() const {
+    return rtmsg_->rtm_protocol;
+  }
+
+  uint8_t
+  getType() const {
+    return rtmsg_->rtm_type;
+  }
+
+  // Route table. RTA_TABLE attribute takes precedence over `rtm_table`
+  uint32_t getRouteTable() const;
+
+  // Destination prefix of IPv4 or IPv6 route. Attribute is omitted by kernel
+  // for default route.
+  std::optional<folly::CIDRNetwork> getDestination() const;
+
+  // Find route attribute of given type. Returns nullptr if not present
+  const struct rtattr* getAttribute(uint16_t type) const;
+
+ private:
+  const struct nlmsghdr* const nlmsg_{nullptr};
+  const struct rtmsg* const rtmsg_{nullptr};
+};
+
 /**
  * Message specialization for rtnetlink ROUTE type
  *
@@ -73,7 +119,9 @@ class NetlinkRouteMessage final : public NetlinkMessageBase {
   // initiallize route message with default params
   void init(int type, uint32_t flags, const Route& route);
 
-  // initiallize get route message, with RTA_TABLE set
+  // initiallize get route message, with RTA_TABLE set. Filters on table,
+  // protocol, type and destination prefix (if non-default) of given route are
+  // applied to received routes.
   void initGet(uint32_t flags, const Route& route);
 
   // add a unicast route
@@ -94,8 +142,13 @@ class NetlinkRouteMessage final : public NetlinkMessageBase {
   // process netlink route message
   static Route parseMessage(const struct nlmsghdr* nlmsg);
 
+  // reverse push labels of nexthops from kernel to thrift order. Applied to
+  // routes received from kernel before handing them out.
+  static Route normalizeRoute(Route&& route);
+
  private:
   // inherited class implementation
+  bool acceptRoute(const struct nlmsghdr* nlmsg) const override;
   void rcvdRoute(Route&& route) override;
 
   // process netlink next hops
@@ -176,6 +229,7 @@ class NetlinkRouteMessage final : public NetlinkMessageBase {
     uint32_t table{0};
     uint8_t protocol{0};
     uint8_t type{0};
+    std::optional<folly::CIDRNetwork> prefix;
   } filters_;
 
   // promise to be fulfilled when receiving kernel reply
@@ -206,6 +206,17 @@ RouteBuilder::getPrefSrc() const {
   return prefSrc_;
 }
 
+RouteBuilder&
+RouteBuilder::setNhId(uint32_t nhId) {
+  nhId_ = nhId;
+  return *this;
+}
+
+std::optional<uint32_t>
+RouteBuilder::getNhId() const {
+  return nhId_;
+}
+
 void
 RouteBuilder::reset() {
   type_ = RTN_UNICAST;
@@ -222,6 +233,7 @@ RouteBuilder::reset() {
   isMultiPath_ = true;
   oif_ = std::nullopt;
   prefSrc_ = std::nullopt;
+  nhId_ = std::nullopt;
 }
 
 Route::Route(const RouteBuilder& builder)
@@ -241,7 +253,8 @@ Route::Route(const RouteBuilder& builder)
       mplsLabel_(builder.getMplsLabel()),
       isMultiPath_(builder.isMultiPath()),
       oif_(builder.getOIf()),
-      prefSrc_(builder.getPrefSrc()) {}
+      prefSrc_(builder.getPrefSrc()),
+      nhId_(builder.getNhId()) {}
 
 Route::~Route() = default;
 
@@ -271,6 +284,7 @@ Route::operator=(Route&& other) noexcept {
   isMultiPath_ = std::move(other.isMultiPath_);
   oif_ = std::move(other.oif_);
   prefSrc_ = std::move(other.prefSrc_);
+  nhId_ = std::move(other.nhId_);
   return *this;
 }
 
@@ -300,6 +314,7 @@ Route::operator=(const Route& other) {
   isMultiPath_ = other.isMultiPath_;
   oif_ = other.oif_;
   prefSrc_ = other.prefSrc_;
+  nhId_ = other.nhId_;
   return *this;
 }
 
@@ -316,7 +331,8 @@ operator==(const Route& lhs, const Route& rhs) {
        lhs.getFlags() == rhs.getFlags() &&
        lhs.getPriority() == rhs.getPriority() && lhs.getTos() == rhs.getTos() &&
        lhs.getMtu() == rhs.getMtu() && lhs.getAdvMss() == rhs.getAdvMss() &&
-       lhs.getFamily() == rhs.getFamily() && lhs.getOIf() == rhs.getOIf());
+       lhs.getFamily() == rhs.getFamily() && lhs.getOIf() == rhs.getOIf() &&
+       lhs.getNhId() == rhs.getNhId());
 
   if (!ret) {
     return false;
@@ -417,6 +433,16 @@ Route::getPrefSrc() const {
   return prefSrc_;
 }
 
+std::optional<uint32_t>
+Route::getNhId() const {
+  return nhId_;
+}
+
+void
+Route::setNhId(std::optional<uint32_t> nhId) {
+  nhId_ = nhId;
+}
+
 std::string
 Route::str() const {
   std::string result;
@@ -444,6 +470,9 @@ Route::str() const {
   if (prefSrc_) {
     result += fmt::format(", src {}", prefSrc_.value().str());
   }
+  if (nhId_) {
+    result += fmt::format(", nhid {}", nhId_.value());
+  }
 
   if (priority_) {
     result += fmt::format(", priority {}", priority_.value());
@@ -601,6 +630,16 @@ NextHopHash::operator()(const NextHop& nh) const {
   return res;
 }
 
+size_t
+NextHopSetHash::operator()(const NextHopSet& nextHops) const {
+  // NOTE: sum of member hashes is independent of iteration order
+  size_t res = nextHops.size();
+  for (const auto& nh : nextHops) {
+    res += NextHopHash()(nh);
+  }
+  return res;
+}
+
 std::optional<int>
 NextHop::getIfIndex() const {
   return ifIndex_;
@@ -119,6 +119,12 @@ struct NextHopHash {
 };
 
 using NextHopSet = std::unordered_set<NextHop, NextHopHash>;
+
+// Order independent hash of a set of nexthops. Used to key shared kernel
+// nexthop groups by their member set.
+struct NextHopSetHash {
+  size_t operator()(const openr::fbnl::NextHopSet& nextHops) const;
+};
 /**
  * Values for core fields
  * ============================
@@ -238,6 +244,11 @@ class RouteBuilder {
   RouteBuilder& setPrefSrc(folly::IPAddress src);
   std::optional<folly::IPAddress> getPrefSrc() const;
 
+  // set|get RTA_NH_ID attr. When set, route points to a kernel nexthop
+  // (group) object and nexthops are not encoded inline in rtm message.
+  RouteBuilder& setNhId(uint32_t nhId);
+  std::optional<uint32_t> getNhId() const;
+
   void reset();
 
  private:
@@ -258,6 +269,7 @@ class RouteBuilder {
   bool isMultiPath_{true};
   std::optional<int> oif_; // RTA_OIF
   std::optional<folly::IPAddress> prefSrc_;
+  std::optional<uint32_t> nhId_; // RTA_NH_ID
 };
 
 class Route final {
@@ -310,6 +322,10 @@ class Route final {
 
   std::optional<folly::IPAddress> getPrefSrc() const;
 
+  std::optional<uint32_t> getNhId() const;
+
+  void setNhId(std::optional<uint32_t> nhId);
+
  private:
   uint8_t type_{RTN_UNICAST};
   uint32_t routeTable_{RT_TABLE_MAIN};
@@ -328,6 +344,7 @@ class Route final {
   bool isMultiPath_{true};
   std::optional<uint32_t> oif_;
   std::optional<folly::IPAddress> prefSrc_;
+  std::optional<uint32_t> nhId_;
 };
 
 bool operator==(const Route& lhs, const Route& rhs);
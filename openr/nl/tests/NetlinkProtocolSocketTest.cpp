@@ -27,11 +27,14 @@ extern "C" {
 #include <linux/fib_rules.h>
 #include <linux/rtnetlink.h>
 #include <net/if.h>
+#include <sys/resource.h>
 #include <sys/socket.h>
 }
 
 DEFINE_bool(
     enable_ipv6_rr_semantics, false, "Enable ipv6 route replace semantics");
+DEFINE_int32(
+    netlink_route_sockets, 0, "Number of additional netlink route sockets");
 
 using namespace openr;
 using namespace openr::fbnl;
@@ -104,6 +107,17 @@ printCounters() {
   }
 }
 
+// Log memory footprint of netlink request buffers along with peak RSS
+void
+printMemoryStats(const NetlinkBufferPool::Stats& stats) {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  LOG(INFO) << "Peak RSS: " << usage.ru_maxrss << " KB"
+            << ", buffer allocations: " << stats.numAllocations
+            << ", slabs: " << stats.numSlabs
+            << ", slab bytes: " << stats.slabBytes;
+}
+
 class NlMessageFixture : public ::testing::Test {
  public:
   NlMessageFixture() = default;
@@ -143,7 +157,10 @@ class NlMessageFixture : public ::testing::Test {
 
     // netlink protocol socket
     nlSock = std::make_unique<NetlinkProtocolSocket>(
-        &evb, netlinkEventsQ, FLAGS_enable_ipv6_rr_semantics);
+        &evb,
+        netlinkEventsQ,
+        FLAGS_enable_ipv6_rr_semantics,
+        FLAGS_netlink_route_sockets);
 
     // start event thread
     eventThread = std::thread([&]() { evb.loopForever(); });
@@ -587,6 +604,152 @@ TEST(NetlinkRouteMessage, EncodeLabel) {
   }
 }
 
+/**
+ * Verify route attributes read in place by message view and filtering of
+ * received routes by get request before they're parsed
+ */
+TEST(NetlinkRouteMessage, MessageView) {
+  const uint32_t kTableId = 1000;
+  auto route = RouteBuilder()
+                   .setDestination(ipPrefix1)
+                   .setProtocolId(kRouteProtoId)
+                   .setRouteTable(kTableId)
+                   .addNextHop(NextHopBuilder().setGateway(ipAddrY1V6).build())
+                   .build();
+  NetlinkRouteMessage msg;
+  ASSERT_EQ(0, msg.addRoute(route));
+
+  // View reads the same attributes as full parsing
+  const NetlinkRouteMessageView view(msg.getMessagePtr());
+  const auto parsedRoute =
+      NetlinkRouteMessage::parseMessage(msg.getMessagePtr());
+  EXPECT_EQ(AF_INET6, view.getFamily());
+  EXPECT_EQ(kRouteProtoId, view.getProtocolId());
+  EXPECT_EQ(parsedRoute.getType(), view.getType());
+  EXPECT_EQ(kTableId, view.getRouteTable());
+  EXPECT_EQ(parsedRoute.getRouteTable(), view.getRouteTable());
+  EXPECT_EQ(ipPrefix1, view.getDestination());
+  EXPECT_NE(nullptr, view.getAttribute(RTA_TABLE));
+  EXPECT_EQ(nullptr, view.getAttribute(RTA_NH_ID));
+
+  // Get requests accept routes matching their filters only
+  auto acceptRoute = [&msg](const RouteBuilder& filter) {
+    NetlinkRouteMessage getMsg;
+    getMsg.initGet(0, filter.build());
+    const bool accepted = static_cast<NetlinkMessageBase&>(getMsg).acceptRoute(
+        msg.getMessagePtr());
+    getMsg.setReturnStatus(0);
+    return accepted;
+  };
+  auto filter = [&]() {
+    RouteBuilder builder;
+    builder.setProtocolId(RTPROT_UNSPEC)
+        .setType(RTN_UNSPEC)
+        .setRouteTable(kTableId);
+    return builder;
+  };
+  EXPECT_TRUE(acceptRoute(filter()));
+  EXPECT_TRUE(acceptRoute(filter().setProtocolId(kRouteProtoId)));
+  EXPECT_TRUE(
+      acceptRoute(filter().setDestination({folly::IPAddressV6("::"), 0})));
+  EXPECT_TRUE(acceptRoute(
+      filter().setDestination(folly::IPAddress::createNetwork("5500::/8"))));
+  EXPECT_TRUE(acceptRoute(filter().setDestination(ipPrefix1)));
+  EXPECT_FALSE(acceptRoute(filter().setDestination(ipPrefix2)));
+  EXPECT_FALSE(acceptRoute(
+      filter().setDestination(folly::IPAddress::createNetwork("5501::/96"))));
+  EXPECT_FALSE(acceptRoute(filter().setProtocolId(kBgpProtoId)));
+  EXPECT_FALSE(acceptRoute(filter().setRouteTable(kTableId + 1)));
+
+  msg.setReturnStatus(0);
+}
+
+/**
+ * Verify buffers are served from right size class and recycled
+ */
+TEST(NetlinkBufferPool, AllocateAndRecycle) {
+  NetlinkBufferPool pool;
+
+  {
+    auto small = pool.allocate(20);
+    auto large = pool.allocate(kMaxNlPayloadSize);
+    ASSERT_NE(nullptr, small.data());
+    ASSERT_NE(nullptr, large.data());
+    // Both buffers must be usable for their full size
+    std::memset(small.data(), 0xAB, 20);
+    std::memset(large.data(), 0xCD, kMaxNlPayloadSize);
+
+    const auto stats = pool.getStats();
+    EXPECT_EQ(2, stats.numAllocations);
+    EXPECT_EQ(2, stats.numInUse);
+    EXPECT_EQ(64 + kMaxNlPayloadSize, stats.bytesInUse);
+    EXPECT_EQ(2, stats.numSlabs);
+  }
+
+  // Buffers are returned on destruction
+  auto stats = pool.getStats();
+  EXPECT_EQ(0, stats.numInUse);
+  EXPECT_EQ(0, stats.bytesInUse);
+
+  // Allocating again reuses existing slabs
+  std::vector<NetlinkBufferPool::Buffer> buffers;
+  for (int i = 0; i < 100; ++i) {
+    buffers.emplace_back(pool.allocate(100));
+  }
+  stats = pool.getStats();
+  EXPECT_EQ(102, stats.numAllocations);
+  EXPECT_EQ(100, stats.numInUse);
+  EXPECT_EQ(100 * 128, stats.bytesInUse);
+  EXPECT_EQ(3, stats.numSlabs);
+}
+
+/**
+ * Verify message is moved into right-sized buffer on seal and thread's encode
+ * buffer is reused by subsequent messages
+ */
+TEST(NetlinkMessageBase, Seal) {
+  NetlinkBufferPool pool;
+  RouteBuilder builder;
+  auto route = builder.setDestination(ipPrefix1)
+                   .setProtocolId(kRouteProtoId)
+                   .addNextHop(NextHopBuilder().setGateway(ipAddrY1V6).build())
+                   .build();
+
+  // Encode message and take a copy of encoded bytes
+  auto msg1 = std::make_unique<NetlinkRouteMessage>();
+  ASSERT_EQ(0, msg1->addRoute(route));
+  const auto len = msg1->getDataLength();
+  ASSERT_LT(len, kMaxNlPayloadSize);
+  const std::string encoded(
+      reinterpret_cast<const char*>(msg1->getMessagePtr()), len);
+
+  // Seal and verify message content is preserved
+  msg1->seal(pool);
+  EXPECT_EQ(len, msg1->getDataLength());
+  EXPECT_EQ(
+      encoded,
+      std::string(
+          reinterpret_cast<const char*>(msg1->getMessagePtr()), len));
+  EXPECT_EQ(1, pool.getStats().numInUse);
+  EXPECT_GE(len * 2, pool.getStats().bytesInUse);
+
+  // Next message encodes identically in the released encode buffer
+  auto msg2 = std::make_unique<NetlinkRouteMessage>();
+  ASSERT_EQ(0, msg2->addRoute(route));
+  EXPECT_EQ(
+      encoded,
+      std::string(
+          reinterpret_cast<const char*>(msg2->getMessagePtr()),
+          msg2->getDataLength()));
+  msg2->seal(pool);
+
+  msg1->setReturnStatus(0);
+  msg2->setReturnStatus(0);
+  msg1.reset();
+  msg2.reset();
+  EXPECT_EQ(0, pool.getStats().numInUse);
+}
+
 /**
  * This test construct and destroy netlink socket without event base being
  * looped ever.
@@ -625,6 +788,49 @@ TEST(NetlinkProtocolSocket, DelayedEventBase) {
   evbThread.join();
 }
 
+/**
+ * Requests interleaved across primary and route sockets must all complete.
+ * Route requests fail with EPERM when not run as root, which still completes
+ * them and releases the requests waiting behind.
+ */
+TEST(NetlinkProtocolSocket, RouteSockets) {
+  folly::EventBase evb;
+  messaging::ReplicateQueue<NetlinkEvent> netlinkEventsQ;
+
+  // Create netlink protocol socket with two route sockets
+  NetlinkProtocolSocket nlSock(&evb, netlinkEventsQ, false, 2);
+
+  const auto nexthop = NextHopBuilder().setGateway(ipAddrY1V6).build();
+  const auto routeV4 =
+      RouteBuilder()
+          .setDestination(folly::IPAddress::createNetwork("192.0.2.0/24"))
+          .setProtocolId(kRouteProtoId)
+          .addNextHop(nexthop)
+          .build();
+  const auto routeV6 = RouteBuilder()
+                           .setDestination(ipPrefix1)
+                           .setProtocolId(kRouteProtoId)
+                           .addNextHop(nexthop)
+                           .build();
+
+  // NOTE: Eventbase is not started yet
+  auto links1 = nlSock.getAllLinks();
+  auto deleteV4 = nlSock.deleteRoute(routeV4);
+  auto deleteV6 = nlSock.deleteRoute(routeV6);
+  auto links2 = nlSock.getAllLinks();
+
+  // Start event thread
+  std::thread evbThread([&]() { evb.loopForever(); });
+
+  EXPECT_NO_THROW(std::move(links1).get().value());
+  EXPECT_NE(0, std::move(deleteV4).get());
+  EXPECT_NE(0, std::move(deleteV6).get());
+  EXPECT_NO_THROW(std::move(links2).get().value());
+
+  evb.terminateLoopSoon();
+  evbThread.join();
+}
+
 /**
  * Test error conditions for get<> APIs of each netlink message type.
  * - Enqueue request, but don't pump the event-base
@@ -959,6 +1165,60 @@ TEST_F(NlMessageFixture, NeighborEventPublication) {
   }
 }
 
+/*
+ * Subscribe to route notifications. Routes programmed via the same socket
+ * generate events as well, while requests get their responses as usual.
+ */
+TEST_F(NlMessageFixture, RouteEventPublication) {
+  folly::Synchronized<std::vector<RouteEvent>> events;
+  nlSock->setRouteEventHandler([&events](RouteEvent&& event) {
+    events.wlock()->emplace_back(std::move(event));
+  });
+
+  const auto network = folly::IPAddress::createNetwork("fc00:cafe:3::/64");
+  auto waitForRouteEvent = [&](bool isDeleted) {
+    auto startTime = std::chrono::steady_clock::now();
+    while (std::chrono::steady_clock::now() - startTime < kProcTimeout) {
+      for (const auto& event : *events.rlock()) {
+        if (event.route.has_value() and
+            event.route->getDestination() == network and
+            event.route->getProtocolId() == kRouteProtoId and
+            event.isDeleted == isDeleted) {
+          return true;
+        }
+      }
+      // yield CPU
+      std::this_thread::yield();
+    }
+    return false;
+  };
+
+  auto route = RouteBuilder()
+                   .setDestination(network)
+                   .setRouteTable(kRouteTableId)
+                   .setProtocolId(kRouteProtoId)
+                   .addNextHop(NextHopBuilder().setIfIndex(ifIndexX).build())
+                   .build();
+  EXPECT_EQ(0, nlSock->addRoute(route).get());
+  EXPECT_TRUE(waitForRouteEvent(false /* isDeleted */));
+
+  auto kernelRoutes =
+      nlSock->getIPv6Routes(kRouteProtoId, kRouteTableId).get().value();
+  ASSERT_EQ(1, kernelRoutes.size());
+  EXPECT_EQ(network, kernelRoutes.at(0).getDestination());
+
+  EXPECT_EQ(0, nlSock->deleteRoute(route).get());
+  EXPECT_TRUE(waitForRouteEvent(true /* isDeleted */));
+  EXPECT_EQ(0, getErrorCount());
+
+  // No more events once unsubscribed
+  nlSock->setRouteEventHandler(nullptr);
+  events.wlock()->clear();
+  EXPECT_EQ(0, nlSock->addRoute(route).get());
+  EXPECT_EQ(0, nlSock->deleteRoute(route).get());
+  EXPECT_TRUE(events.rlock()->empty());
+}
+
 /*
  * Check empty route from kernel
  */
@@ -1832,6 +2092,12 @@ TEST_F(NlMessageFixture, MultipleLabelRoutes) {
   EXPECT_GE(getAckCount(), ackCount + count);
   EXPECT_EQ(0, getErrorCount());
 
+  // Queued requests are held in right-sized buffers
+  const auto poolStats = nlSock->getBufferPoolStats();
+  printMemoryStats(poolStats);
+  EXPECT_GE(poolStats.numAllocations, count);
+  EXPECT_LT(poolStats.slabBytes, count * kMaxNlPayloadSize / 8);
+
   LOG(INFO) << "Getting all routes...";
   // verify Netlink getMplsRoutes at scale
   auto kernelRoutes = nlSock->getMplsRoutes(kRouteProtoId).get().value();
@@ -2394,6 +2660,151 @@ TEST_F(NlMessageFixture, SingleRouteWithSingleMplsNexthop) {
   EXPECT_FALSE(checkRouteInKernelRoutes(kernelRoutes, routeV6));
 }
 
+/*
+ * Add and delete IPv4 and IPv6 routes in bulk, with and without route sockets,
+ * and report time taken. Routes are read back without waiting for the add
+ * requests, which must be ordered before the dump request nonetheless.
+ */
+TEST_F(NlMessageFixture, RouteSocketsScaleTest) {
+  const uint32_t count{50000};
+  const auto v4Routes = buildV4RouteDb(count);
+  const auto v6Routes = buildV6RouteDb(count);
+
+  for (size_t numRouteSockets : {0, 2}) {
+    folly::EventBase routeEvb;
+    auto routeSock = std::make_unique<NetlinkProtocolSocket>(
+        &routeEvb,
+        netlinkEventsQ,
+        FLAGS_enable_ipv6_rr_semantics,
+        numRouteSockets);
+    std::thread routeEvbThread([&]() { routeEvb.loopForever(); });
+    routeEvb.waitUntilRunning();
+
+    // Add routes in bulk
+    auto startTime = std::chrono::steady_clock::now();
+    std::vector<folly::SemiFuture<int>> futures;
+    for (uint32_t i = 0; i < count; ++i) {
+      futures.emplace_back(routeSock->addRoute(v4Routes.at(i)));
+      futures.emplace_back(routeSock->addRoute(v6Routes.at(i)));
+    }
+    auto kernelV4Routes =
+        routeSock->getIPv4Routes(kRouteProtoId).get().value();
+    auto kernelV6Routes =
+        routeSock->getIPv6Routes(kRouteProtoId).get().value();
+    EXPECT_EQ(
+        NetlinkProtocolSocket::collectReturnStatus(std::move(futures)).get(),
+        folly::Unit());
+    LOG(INFO) << "Added " << 2 * count << " routes with " << numRouteSockets
+              << " route sockets in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count()
+              << "ms";
+    EXPECT_EQ(0, getErrorCount());
+    EXPECT_EQ(count, kernelV4Routes.size());
+    EXPECT_EQ(count, kernelV6Routes.size());
+    EXPECT_EQ(findRoutesInKernelRoutes(kernelV4Routes, v4Routes), count);
+    EXPECT_EQ(findRoutesInKernelRoutes(kernelV6Routes, v6Routes), count);
+
+    // Delete routes in bulk
+    startTime = std::chrono::steady_clock::now();
+    futures.clear();
+    for (uint32_t i = 0; i < count; ++i) {
+      futures.emplace_back(routeSock->deleteRoute(v4Routes.at(i)));
+      futures.emplace_back(routeSock->deleteRoute(v6Routes.at(i)));
+    }
+    kernelV4Routes = routeSock->getIPv4Routes(kRouteProtoId).get().value();
+    kernelV6Routes = routeSock->getIPv6Routes(kRouteProtoId).get().value();
+    EXPECT_EQ(
+        NetlinkProtocolSocket::collectReturnStatus(std::move(futures)).get(),
+        folly::Unit());
+    LOG(INFO) << "Deleted " << 2 * count << " routes with " << numRouteSockets
+              << " route sockets in "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - startTime)
+                     .count()
+              << "ms";
+    EXPECT_EQ(0, getErrorCount());
+    EXPECT_EQ(0, kernelV4Routes.size());
+    EXPECT_EQ(0, kernelV6Routes.size());
+
+    routeEvb.terminateLoopSoon();
+    routeEvbThread.join();
+    routeSock.reset();
+  }
+}
+
+/*
+ * Add routes in bulk and verify that window of in-flight requests is adapted
+ * within its bounds and exported
+ * - window grows above initial one under sustained load
+ * - window shrinks when acks are delayed (here by stalling the event loop)
+ */
+TEST_F(NlMessageFixture, AdaptiveWindowTest) {
+  const uint32_t count{100000};
+  const auto routes = buildV6RouteDb(count);
+  const size_t numSockets = FLAGS_netlink_route_sockets + 1;
+
+  auto counters = facebook::fb303::fbData->getCounters();
+  EXPECT_EQ(kInitIovWindow * numSockets, counters["netlink.requests.window"]);
+  EXPECT_LE(
+      kNetlinkSockRecvBuf * numSockets,
+      counters["netlink.buffers.socket_recv_bytes"]);
+
+  std::vector<folly::SemiFuture<int>> futures;
+  for (const auto& route : routes) {
+    futures.emplace_back(nlSock->addRoute(route));
+  }
+  EXPECT_EQ(
+      NetlinkProtocolSocket::collectReturnStatus(std::move(futures)).get(),
+      folly::Unit());
+  EXPECT_EQ(0, getErrorCount());
+
+  // All routes are of one shard, hence only its socket grows the window
+  counters = facebook::fb303::fbData->getCounters();
+  LOG(INFO) << "Window after adding " << count
+            << " routes: " << counters["netlink.requests.window"]
+            << ", increases: "
+            << counters["netlink.requests.window_increases.sum"]
+            << ", decreases: "
+            << counters["netlink.requests.window_decreases.sum"];
+  EXPECT_LT(0, counters["netlink.requests.window_increases.sum"]);
+  EXPECT_LT(kInitIovWindow * numSockets, counters["netlink.requests.window"]);
+  EXPECT_GE(kMaxIovMsg * numSockets, counters["netlink.requests.window"]);
+  EXPECT_LE(0, counters["netlink.requests.ack_latency_ms.avg"]);
+
+  // Delete routes while stalling the event loop beyond ack latency threshold
+  // every now and then. Acks pending meanwhile are late and shrink the window.
+  const auto numDecreases = counters["netlink.requests.window_decreases.sum"];
+  futures.clear();
+  for (const auto& route : routes) {
+    futures.emplace_back(nlSock->deleteRoute(route));
+  }
+  std::atomic<bool> deleted{false};
+  std::thread stallThread([&]() {
+    while (not deleted) {
+      evb.runInEventBaseThreadAndWait([]() {
+        /* sleep override */
+        std::this_thread::sleep_for(2 * kNlAckLatencyThreshold);
+      });
+    }
+  });
+  EXPECT_EQ(
+      NetlinkProtocolSocket::collectReturnStatus(std::move(futures)).get(),
+      folly::Unit());
+  deleted = true;
+  stallThread.join();
+  EXPECT_EQ(0, getErrorCount());
+
+  counters = facebook::fb303::fbData->getCounters();
+  LOG(INFO) << "Window after deleting " << count
+            << " routes: " << counters["netlink.requests.window"]
+            << ", decreases: "
+            << counters["netlink.requests.window_decreases.sum"];
+  EXPECT_LT(numDecreases, counters["netlink.requests.window_decreases.sum"]);
+  EXPECT_LE(kMinIovWindow * numSockets, counters["netlink.requests.window"]);
+}
+
 class NlMessageFixtureV4OrV6 : public NlMessageFixture,
                                public testing::WithParamInterface<bool> {};
 
@@ -5,7 +5,9 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <folly/futures/Future.h>
 #include <folly/init/Init.h>
+#include <folly/io/async/AsyncTimeout.h>
 #include <folly/io/async/EventBase.h>
 #include <folly/logging/xlog.h>
 #include <folly/system/ThreadName.h>
@@ -14,11 +16,27 @@
 #include <thrift/lib/cpp2/server/ThriftServer.h>
 
 #include <openr/common/OpenrEventBase.h>
+#include <openr/if/gen-cpp2/Platform_constants.h>
 #include <openr/nl/NetlinkProtocolSocket.h>
 #include <openr/platform/NetlinkFibHandler.h>
 
 DEFINE_int32(
     fib_thrift_port, 60100, "Thrift server port for the NetlinkFibHandler");
+DEFINE_bool(
+    enable_nexthop_groups,
+    false,
+    "Program unicast routes via shared kernel nexthop groups (Linux 5.3+)");
+DEFINE_int32(
+    netlink_route_sockets,
+    0,
+    "Number of additional netlink sockets for programming routes. Routes are "
+    "sharded over them by route table and address family");
+DEFINE_int32(
+    kernel_fib_repair_interval_s,
+    0,
+    "Track unicast routes in kernel from route notifications and repair the "
+    "ones drifted from programmed routes at this interval. 0 disables it, in "
+    "which case every syncFib dumps kernel routes to repair the drift");
 
 using openr::NetlinkFibHandler;
 
@@ -38,8 +56,12 @@ main(int argc, char** argv) {
   auto nlEvb = std::make_unique<folly::EventBase>();
   openr::messaging::ReplicateQueue<openr::fbnl::NetlinkEvent>
       netlinkEventsQueue;
+  CHECK_GE(FLAGS_netlink_route_sockets, 0);
   auto nlSock = std::make_unique<openr::fbnl::NetlinkProtocolSocket>(
-      nlEvb.get(), netlinkEventsQueue);
+      nlEvb.get(),
+      netlinkEventsQueue,
+      false /* enableIPv6RouteReplaceSemantics */,
+      FLAGS_netlink_route_sockets);
   allThreads.emplace_back([&nlEvb]() {
     XLOG(INFO) << "Starting NetlinkProtolSocketEvl thread...";
     folly::setThreadName("NetlinkProtolSocketEvl");
@@ -49,7 +71,48 @@ main(int argc, char** argv) {
   nlEvb->waitUntilRunning();
 
   apache::thrift::ThriftServer linuxFibAgentServer;
-  auto fibHandler = std::make_shared<NetlinkFibHandler>(nlSock.get());
+  auto fibHandler = std::make_shared<NetlinkFibHandler>(
+      nlSock.get(),
+      RT_TABLE_MAIN,
+      FLAGS_enable_nexthop_groups,
+      FLAGS_kernel_fib_repair_interval_s > 0 /* enableKernelFibTracking */);
+
+  // Periodically check routes of every client for drift and repair them
+  // NOTE: Repairs are not awaited on main event base. Timer is re-armed once
+  // all of them complete.
+  const std::chrono::seconds repairInterval(FLAGS_kernel_fib_repair_interval_s);
+  std::unique_ptr<folly::AsyncTimeout> repairTimer;
+  if (repairInterval.count() > 0) {
+    repairTimer = folly::AsyncTimeout::make(mainEvb, [&]() noexcept {
+      std::vector<folly::Future<folly::Unit>> repairs;
+      for (const auto& [id, _] :
+           openr::thrift::Platform_constants::clientIdtoProtocolId()) {
+        const auto clientId = id;
+        const auto digests = fibHandler->getUnicastFibDigests(clientId);
+        if (not digests.has_value() or digests->first == digests->second) {
+          continue;
+        }
+        repairs.emplace_back(
+            folly::makeSemiFutureWith([&fibHandler, clientId]() {
+              return fibHandler->semifuture_repairUnicastFib(clientId);
+            })
+                .via(&mainEvb)
+                .thenTry([clientId](folly::Try<size_t>&& result) {
+                  if (result.hasException()) {
+                    XLOG(ERR) << "Failed repairing routes of client "
+                              << NetlinkFibHandler::getClientName(clientId)
+                              << ": "
+                              << folly::exceptionStr(result.exception());
+                  }
+                }));
+      }
+      folly::collectAll(std::move(repairs))
+          .via(&mainEvb)
+          .thenValue(
+              [&](auto&&) { repairTimer->scheduleTimeout(repairInterval); });
+    });
+    repairTimer->scheduleTimeout(repairInterval);
+  }
 
   // start FibService thread
   auto fibThriftThread = std::thread([fibHandler, &linuxFibAgentServer]() {
@@ -6,6 +6,7 @@
  */
 
 #include <folly/gen/Base.h>
+#include <folly/hash/Hash.h>
 #include <folly/logging/xlog.h>
 
 #include <openr/common/LsdbUtil.h>
@@ -27,6 +28,12 @@ namespace {
 const uint8_t kMinRouteProtocolId = 17;
 const uint8_t kMaxRouteProtocolId = 253;
 
+// Kernel nexthop object IDs are a shared resource as well. Start allocating
+// from a high value to stay clear of IDs used by iproute2 and other daemons.
+// Objects left over by previous instance are learnt on first sync. IDs are
+// allocated past them and they are deleted once their routes are replaced.
+const uint32_t kMinNexthopId = 0x10000000;
+
 template <typename T>
 folly::SemiFuture<T>
 createSemiFutureWithClientIdError() {
@@ -35,19 +42,77 @@ createSemiFutureWithClientIdError() {
   return std::move(sf);
 }
 
+// Hash of forwarding state of unicast route. Nexthops of route referring to
+// nexthop group are owned by the group, hence only the group id is hashed.
+size_t
+getForwardingHash(const fbnl::Route& route) {
+  const auto& [addr, len] = route.getDestination();
+  const size_t hash =
+      folly::hash::hash_combine(addr.hash(), len, route.getType());
+  if (route.getNhId().has_value()) {
+    return folly::hash::hash_combine(hash, route.getNhId().value());
+  }
+  // NOTE: sum of nexthop hashes is independent of iteration order
+  size_t nhHash{0};
+  for (const auto& nh : route.getNextHops()) {
+    nhHash += folly::hash::hash_combine(
+        nh.getIfIndex().value_or(0),
+        nh.getGateway().has_value() ? nh.getGateway()->hash() : 0,
+        std::max(nh.getWeight(), uint8_t(1)));
+  }
+  return folly::hash::hash_combine(hash, nhHash);
+}
+
+// Returns true if routes have same forwarding state. See `getForwardingHash`
+bool
+isSameForwarding(const fbnl::Route& lhs, const fbnl::Route& rhs) {
+  if (lhs.getType() != rhs.getType() or lhs.getNhId() != rhs.getNhId()) {
+    return false;
+  }
+  return lhs.getNhId().has_value() or lhs.getNextHops() == rhs.getNextHops();
+}
+
 } // namespace
 
 NetlinkFibHandler::NetlinkFibHandler(
-    fbnl::NetlinkProtocolSocket* nlSock, uint8_t routeTable)
+    fbnl::NetlinkProtocolSocket* nlSock,
+    uint8_t routeTable,
+    bool enableNexthopGroups,
+    bool enableKernelFibTracking)
     : facebook::fb303::BaseService("openr"),
       nlSock_(nlSock),
       startTime_(std::chrono::duration_cast<std::chrono::seconds>(
                      std::chrono::system_clock::now().time_since_epoch())
                      .count()),
-      routeTable_(routeTable) {
+      routeTable_(routeTable),
+      enableNexthopGroups_(enableNexthopGroups),
+      enableKernelFibTracking_(enableKernelFibTracking) {
   CHECK_NOTNULL(nlSock);
+  nhGroupState_.wlock()->nextId = kMinNexthopId;
+  if (enableKernelFibTracking_) {
+    nlSock_->setRouteEventHandler([this](fbnl::RouteEvent&& event) {
+      processRouteEvent(std::move(event));
+    });
+  }
+}
+
+NetlinkFibHandler::~NetlinkFibHandler() {
+  if (enableKernelFibTracking_) {
+    nlSock_->setRouteEventHandler(nullptr);
+  }
+}
+
+void
+NetlinkFibHandler::RouteDigest::add(const fbnl::Route& route) {
+  ++numRoutes;
+  hash += getForwardingHash(route);
+}
+
+void
+NetlinkFibHandler::RouteDigest::remove(const fbnl::Route& route) {
+  --numRoutes;
+  hash -= getForwardingHash(route);
 }
-NetlinkFibHandler::~NetlinkFibHandler() = default;
 
 std::optional<int16_t>
 NetlinkFibHandler::getProtocol(int16_t clientId) {
@@ -108,14 +173,48 @@ NetlinkFibHandler::semifuture_addUnicastRoutes(
   CHECK(protocol.has_value());
   XLOG(INFO) << "Adding/Updating unicast routes of client "
              << getClientName(clientId) << ", numRoutes=" << routes->size();
+  seedNexthopGroupState();
+
+  std::vector<fbnl::Route> nlRoutes;
+  nlRoutes.reserve(routes->size());
+  for (auto& route : *routes) {
+    nlRoutes.emplace_back(buildRoute(route, protocol.value()));
+  }
 
   // Add routes and return a collected semifuture
+  // NOTE: Messages are sent in order. Nexthop objects are created before the
+  // routes referring to them and released after.
   std::vector<folly::SemiFuture<int>> result;
-  for (auto& route : *routes) {
-    result.emplace_back(nlSock_->addRoute(buildRoute(route, protocol.value())));
+  auto state = nhGroupState_.wlock();
+  auto shadowFibs = shadowFibs_.wlock();
+  auto& shadowFib = (*shadowFibs)[protocol.value()];
+  const auto rebound =
+      rebindNexthopGroups(*state, nlRoutes, protocol.value(), result);
+  for (auto& nlRoute : nlRoutes) {
+    if (rebound.count(nlRoute.getDestination())) {
+      // Route follows its group. SKIP programming
+      nlRoute.setNhId(state->groups.at(nlRoute.getNextHops()).first);
+    } else {
+      auto oldNextHops =
+          bindNexthopGroup(*state, nlRoute, protocol.value(), result);
+      result.emplace_back(nlSock_->addRoute(nlRoute));
+      if (oldNextHops.has_value()) {
+        releaseNexthopGroup(*state, oldNextHops.value(), result);
+      }
+    }
+    if (shadowFib.valid) {
+      auto prefix = nlRoute.getDestination();
+      auto it = shadowFib.routes.find(prefix);
+      if (it != shadowFib.routes.end()) {
+        shadowFib.digest.remove(it->second.first);
+      }
+      shadowFib.digest.add(nlRoute);
+      shadowFib.routes.insert_or_assign(
+          std::move(prefix), std::make_pair(std::move(nlRoute), 0));
+    }
   }
-  return fbnl::NetlinkProtocolSocket::collectReturnStatus(
-      std::move(result), {EEXIST});
+  return collectUnicastReturnStatus(
+      protocol.value(), std::move(result), {EEXIST});
 }
 
 folly::SemiFuture<folly::Unit>
@@ -128,18 +227,32 @@ NetlinkFibHandler::semifuture_deleteUnicastRoutes(
   CHECK(protocol.has_value());
   XLOG(INFO) << "Deleting unicast routes of client " << getClientName(clientId)
              << ", numRoutes=" << prefixes->size();
+  seedNexthopGroupState();
 
   // Delete routes and return a collected semifuture
   std::vector<folly::SemiFuture<int>> result;
+  auto state = nhGroupState_.wlock();
+  auto shadowFibs = shadowFibs_.wlock();
+  auto& shadowFib = (*shadowFibs)[protocol.value()];
   for (auto& prefix : *prefixes) {
     fbnl::RouteBuilder rtBuilder;
     rtBuilder.setDestination(toIPNetwork(prefix))
         .setRouteTable(routeTable_)
         .setProtocolId(protocol.value());
     result.emplace_back(nlSock_->deleteRoute(rtBuilder.build()));
+    auto oldNextHops = unbindNexthopGroup(
+        *state, rtBuilder.getDestination(), protocol.value());
+    if (oldNextHops.has_value()) {
+      releaseNexthopGroup(*state, oldNextHops.value(), result);
+    }
+    auto it = shadowFib.routes.find(rtBuilder.getDestination());
+    if (it != shadowFib.routes.end()) {
+      shadowFib.digest.remove(it->second.first);
+      shadowFib.routes.erase(it);
+    }
   }
-  return fbnl::NetlinkProtocolSocket::collectReturnStatus(
-      std::move(result), {ESRCH});
+  return collectUnicastReturnStatus(
+      protocol.value(), std::move(result), {ESRCH});
 }
 
 folly::SemiFuture<folly::Unit>
@@ -199,74 +312,112 @@ NetlinkFibHandler::semifuture_syncFib(
   XLOG(INFO) << "Syncing unicast FIB for client " << getClientName(clientId)
              << ", numRoutes=" << unicastRoutes->size();
 
+  // Seed shadow FIB from kernel if it can't be trusted
+  // NOTE: With kernel FIB tracking, kernel routing table is dumped only on
+  // first sync and after a programming failure, and routes drifted in kernel
+  // are repaired by `repairUnicastFib`. Without it, nothing detects routes
+  // changed behind our back, hence every sync is diffed against kernel.
+  const bool isShadowFibValid = [&]() {
+    auto shadowFibs = shadowFibs_.rlock();
+    auto it = shadowFibs->find(protocol.value());
+    return it != shadowFibs->end() and it->second.valid;
+  }();
+  if (not isShadowFibValid or not enableKernelFibTracking_) {
+    seedShadowFib(protocol.value());
+  }
+  seedNexthopGroupState();
+
   // SemiFuture vector for collecting return values of all API calls
   std::vector<folly::SemiFuture<int>> result;
 
-  // Create set of existing route
-  // NOTE: Synchronous call to retrieve all the routes. We first make both
-  // requests to retrieve IPv4 and IPv6 routes. Subsequently we wait on them
-  // to complete and prepare the map of existing routes
-  std::unordered_map<folly::CIDRNetwork, fbnl::Route> existingRoutes;
-  {
-    auto v4Routes = nlSock_->getIPv4Routes(protocol.value(), routeTable_).get();
-    auto v6Routes = nlSock_->getIPv6Routes(protocol.value(), routeTable_).get();
-    if (v4Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv4 routes", v4Routes.error());
-    }
-    if (v6Routes.hasError()) {
-      throw fbnl::NlException("Failed fetching IPv6 routes", v6Routes.error());
-    }
-    for (auto& routesPtr : {&v4Routes, &v6Routes}) {
-      for (auto& route : routesPtr->value()) {
-        const auto prefix = route.getDestination();
-        // Linux will report a null next-hop for RTN_BLACKHOLE type while
-        // RIB does not
-        if (route.getType() == RTN_BLACKHOLE) {
-          route.setNextHops({});
-        }
-        existingRoutes.emplace(prefix, std::move(route));
-      }
-    }
-  }
-
-  // Go over the new routes. Add or update
-  std::unordered_set<folly::CIDRNetwork> newPrefixes;
+  // Go over the new routes. Add or update. Routes seen are marked with the
+  // generation of this sync
+  // NOTE: Routes are programmed in the order given, which lets the client
+  // install its high priority routes first. Stale routes are deleted after.
+  auto state = nhGroupState_.wlock();
+  auto shadowFibs = shadowFibs_.wlock();
+  auto& shadowFib = (*shadowFibs)[protocol.value()];
+  const auto syncGen = ++shadowFib.syncGen;
   for (auto& route : *unicastRoutes) {
     const auto network = toIPNetwork(*route.dest());
-    newPrefixes.insert(network);
     auto nlRoute = buildRoute(route, protocol.value());
-    auto it = existingRoutes.find(network);
-    if (it != existingRoutes.end() and it->second == nlRoute) {
+    auto oldNextHops =
+        bindNexthopGroup(*state, nlRoute, protocol.value(), result);
+    auto it = shadowFib.routes.find(network);
+    if (it != shadowFib.routes.end() and it->second.first == nlRoute) {
       // Existing route is same as the one we're trying to add. SKIP
-      continue;
-    }
-    if (it != existingRoutes.end()) {
-      XLOG(INFO) << "Updating unicast-route " << "\n[OLD] " << it->second.str()
-                 << "\n[NEW] " << nlRoute.str();
+      it->second.second = syncGen;
     } else {
-      XLOG(INFO) << "Adding unicast-route \n[NEW]" << nlRoute.str();
+      if (it != shadowFib.routes.end()) {
+        XLOG(INFO) << "Updating unicast-route " << "\n[OLD] "
+                   << it->second.first.str() << "\n[NEW] " << nlRoute.str();
+      } else {
+        XLOG(INFO) << "Adding unicast-route \n[NEW]" << nlRoute.str();
+      }
+      // Add new route or replace existing one
+      result.emplace_back(nlSock_->addRoute(nlRoute));
+      if (it != shadowFib.routes.end()) {
+        shadowFib.digest.remove(it->second.first);
+      }
+      shadowFib.digest.add(nlRoute);
+      shadowFib.routes.insert_or_assign(
+          network, std::make_pair(std::move(nlRoute), syncGen));
+    }
+    if (oldNextHops.has_value()) {
+      releaseNexthopGroup(*state, oldNextHops.value(), result);
     }
-    // Add new route or replace existing one
-    result.emplace_back(nlSock_->addRoute(nlRoute));
   }
 
   // Go over the old routes to remove stale ones
-  for (auto& [prefix, nlRoute] : existingRoutes) {
-    if (newPrefixes.count(prefix)) {
+  for (auto it = shadowFib.routes.begin(); it != shadowFib.routes.end();) {
+    if (it->second.second == syncGen) {
       // not a stale route
+      ++it;
       continue;
     }
     // Delete stale route
     XLOG(INFO) << "Deleting unicast-route "
-               << folly::IPAddress::networkToString(prefix);
-    result.emplace_back(nlSock_->deleteRoute(nlRoute));
+               << folly::IPAddress::networkToString(it->first);
+    result.emplace_back(nlSock_->deleteRoute(it->second.first));
+    shadowFib.digest.remove(it->second.first);
+    it = shadowFib.routes.erase(it);
+  }
+
+  // Release groups of the routes no longer present
+  std::vector<folly::CIDRNetwork> stalePrefixes;
+  for (const auto& [prefix, _] : state->routes[protocol.value()]) {
+    if (not shadowFib.routes.count(prefix)) {
+      stalePrefixes.emplace_back(prefix);
+    }
+  }
+  for (const auto& prefix : stalePrefixes) {
+    auto oldNextHops = unbindNexthopGroup(*state, prefix, protocol.value());
+    releaseNexthopGroup(*state, oldNextHops.value(), result);
+  }
+
+  // Delete objects left over by previous instance. Routes referring to them
+  // have been replaced or deleted above.
+  if (state->staleIds.has_value()) {
+    auto it = state->staleIds->find(protocol.value());
+    if (it != state->staleIds->end()) {
+      XLOG(INFO) << "Deleting " << it->second.size()
+                 << " stale nexthop objects";
+      for (const auto id : it->second) {
+        // Kernel deletes group along with its last member. Ignore ENOENT.
+        result.emplace_back(
+            nlSock_->deleteNexthop(id).deferValue([](int status) {
+              return std::abs(status) == ENOENT ? 0 : status;
+            }));
+      }
+      state->staleIds->erase(it);
+    }
   }
 
   // Return collected result
   // NOTE: We're ignoring EEXIST error code. ESRCH error code must not be
   // raised because we're deleting route that already exist
-  return fbnl::NetlinkProtocolSocket::collectReturnStatus(
-      std::move(result), {EEXIST});
+  return collectUnicastReturnStatus(
+      protocol.value(), std::move(result), {EEXIST});
 }
 
 folly::SemiFuture<folly::Unit>
@@ -412,6 +563,100 @@ NetlinkFibHandler::semifuture_getMplsRouteTableByClient(int16_t clientId) {
           });
 }
 
+std::optional<
+    std::pair<NetlinkFibHandler::RouteDigest, NetlinkFibHandler::RouteDigest>>
+NetlinkFibHandler::getUnicastFibDigests(int16_t clientId) {
+  const auto protocol = getProtocol(clientId);
+  if (not protocol.has_value() or not enableKernelFibTracking_) {
+    return std::nullopt;
+  }
+
+  auto shadowFibs = shadowFibs_.rlock();
+  auto kernelFibs = kernelFibs_.rlock();
+  auto shadowIt = shadowFibs->find(protocol.value());
+  auto kernelIt = kernelFibs->find(protocol.value());
+  if (shadowIt == shadowFibs->end() or not shadowIt->second.valid or
+      kernelIt == kernelFibs->end() or not kernelIt->second.valid) {
+    return std::nullopt;
+  }
+  return std::make_pair(shadowIt->second.digest, kernelIt->second.digest);
+}
+
+folly::SemiFuture<size_t>
+NetlinkFibHandler::semifuture_repairUnicastFib(int16_t clientId) {
+  const auto protocol = getProtocol(clientId);
+  if (not protocol.has_value()) {
+    return createSemiFutureWithClientIdError<size_t>();
+  }
+  if (not enableKernelFibTracking_) {
+    return folly::makeSemiFuture<size_t>(
+        folly::make_exception_wrapper<fbnl::NlException>(
+            "Kernel FIB tracking is disabled"));
+  }
+
+  // Re-seed kernel FIB if route notifications were lost
+  const bool isKernelFibValid = [&]() {
+    auto kernelFibs = kernelFibs_.rlock();
+    auto it = kernelFibs->find(protocol.value());
+    return it != kernelFibs->end() and it->second.valid;
+  }();
+  if (not isKernelFibValid) {
+    dumpUnicastRoutes(protocol.value());
+  }
+
+  // Diff routes as programmed against the ones in kernel
+  // NOTE: Kernel FIB lock is released before programming routes
+  std::vector<folly::SemiFuture<int>> result;
+  auto state = nhGroupState_.wlock();
+  auto shadowFibs = shadowFibs_.wlock();
+  auto shadowIt = shadowFibs->find(protocol.value());
+  if (shadowIt == shadowFibs->end() or not shadowIt->second.valid) {
+    return folly::makeSemiFuture<size_t>(
+        folly::make_exception_wrapper<fbnl::NlException>(
+            "Unicast routes of client are not synced"));
+  }
+  const auto& shadowFib = shadowIt->second;
+  std::vector<const fbnl::Route*> staleRoutes;
+  std::vector<fbnl::Route> unknownRoutes;
+  {
+    auto kernelFibs = kernelFibs_.rlock();
+    const auto& kernelFib = kernelFibs->at(protocol.value());
+    if (shadowFib.digest == kernelFib.digest) {
+      // No drift
+      return folly::makeSemiFuture<size_t>(0);
+    }
+    for (const auto& [prefix, entry] : shadowFib.routes) {
+      auto it = kernelFib.routes.find(prefix);
+      if (it == kernelFib.routes.end() or
+          not isSameForwarding(entry.first, it->second)) {
+        staleRoutes.emplace_back(&entry.first);
+      }
+    }
+    for (const auto& [prefix, route] : kernelFib.routes) {
+      if (not shadowFib.routes.count(prefix)) {
+        unknownRoutes.emplace_back(route);
+      }
+    }
+  }
+
+  for (const auto* route : staleRoutes) {
+    XLOG(INFO) << "Repairing unicast-route \n[NEW] " << route->str();
+    result.emplace_back(nlSock_->addRoute(*route));
+  }
+  for (const auto& route : unknownRoutes) {
+    XLOG(INFO) << "Deleting unknown unicast-route "
+               << folly::IPAddress::networkToString(route.getDestination());
+    result.emplace_back(nlSock_->deleteRoute(route));
+  }
+
+  const size_t numRepaired = staleRoutes.size() + unknownRoutes.size();
+  XLOG(INFO) << "Repairing " << numRepaired << " drifted unicast routes of "
+             << "client " << getClientName(clientId);
+  return collectUnicastReturnStatus(
+             protocol.value(), std::move(result), {EEXIST, ESRCH})
+      .deferValue([numRepaired](folly::Unit&&) { return numRepaired; });
+}
+
 std::vector<thrift::NextHopThrift>
 NetlinkFibHandler::toThriftNextHops(const fbnl::NextHopSet& nextHops) {
   std::vector<thrift::NextHopThrift> thriftNextHops;
@@ -585,6 +830,405 @@ NetlinkFibHandler::buildMplsRoute(
   return rtBuilder.setValid(true).build();
 }
 
+std::vector<fbnl::Route>
+NetlinkFibHandler::dumpUnicastRoutes(uint8_t protocol) {
+  // Route notifications received from now on are more recent than the dump
+  if (enableKernelFibTracking_) {
+    auto kernelFibs = kernelFibs_.wlock();
+    auto& kernelFib = (*kernelFibs)[protocol];
+    kernelFib = KernelFib();
+    kernelFib.seeding = true;
+  }
+
+  // NOTE: We first make both requests to retrieve IPv4 and IPv6 routes.
+  // Subsequently we wait on them to complete
+  auto v4Routes = nlSock_->getIPv4Routes(protocol, routeTable_).get();
+  auto v6Routes = nlSock_->getIPv6Routes(protocol, routeTable_).get();
+  if (v4Routes.hasError()) {
+    throw fbnl::NlException("Failed fetching IPv4 routes", v4Routes.error());
+  }
+  if (v6Routes.hasError()) {
+    throw fbnl::NlException("Failed fetching IPv6 routes", v6Routes.error());
+  }
+
+  std::vector<fbnl::Route> routes = std::move(v4Routes.value());
+  routes.reserve(routes.size() + v6Routes->size());
+  for (auto& route : v6Routes.value()) {
+    routes.emplace_back(std::move(route));
+  }
+  for (auto& route : routes) {
+    // Linux will report a null next-hop for RTN_BLACKHOLE type while
+    // RIB does not
+    if (route.getType() == RTN_BLACKHOLE) {
+      route.setNextHops({});
+    }
+  }
+
+  if (enableKernelFibTracking_) {
+    auto kernelFibs = kernelFibs_.wlock();
+    auto& kernelFib = (*kernelFibs)[protocol];
+    if (kernelFib.seeding) {
+      // Add dumped routes, unless notified meanwhile
+      for (const auto& route : routes) {
+        if (kernelFib.notifiedPrefixes.count(route.getDestination())) {
+          continue;
+        }
+        kernelFib.digest.add(route);
+        kernelFib.routes.emplace(route.getDestination(), route);
+      }
+      kernelFib.notifiedPrefixes.clear();
+      kernelFib.seeding = false;
+      kernelFib.valid = true;
+    }
+  }
+  return routes;
+}
+
+void
+NetlinkFibHandler::seedShadowFib(uint8_t protocol) {
+  auto routes = dumpUnicastRoutes(protocol);
+
+  auto shadowFibs = shadowFibs_.wlock();
+  auto& shadowFib = (*shadowFibs)[protocol];
+  shadowFib.routes.clear();
+  shadowFib.routes.reserve(routes.size());
+  shadowFib.digest = RouteDigest();
+  for (auto& route : routes) {
+    auto prefix = route.getDestination();
+    shadowFib.digest.add(route);
+    shadowFib.routes.emplace(
+        std::move(prefix), std::make_pair(std::move(route), 0));
+  }
+  shadowFib.valid = true;
+  XLOG(INFO) << "Seeded shadow FIB of protocol " << static_cast<int>(protocol)
+             << " with " << shadowFib.routes.size() << " routes from kernel";
+}
+
+void
+NetlinkFibHandler::seedNexthopGroupState() {
+  if (not enableNexthopGroups_ or nhGroupState_.rlock()->staleIds.has_value()) {
+    return;
+  }
+
+  auto nexthops = nlSock_->getAllNexthops().get();
+  if (nexthops.hasError()) {
+    throw fbnl::NlException("Failed fetching nexthops", nexthops.error());
+  }
+
+  auto state = nhGroupState_.wlock();
+  if (state->staleIds.has_value()) {
+    return; // Seeded concurrently
+  }
+  // No id is allocated before seeding, thus every object found is stale
+  DCHECK(state->nexthops.empty() and state->groups.empty());
+
+  size_t numStaleIds{0};
+  state->staleIds.emplace();
+  for (const auto& [id, protocol] : nexthops.value()) {
+    if (id < kMinNexthopId) {
+      continue; // Not ours
+    }
+    (*state->staleIds)[protocol].emplace_back(id);
+    state->nextId = std::max(state->nextId, id + 1);
+    ++numStaleIds;
+  }
+  XLOG(INFO) << "Found " << numStaleIds << " stale nexthop objects in kernel";
+}
+
+void
+NetlinkFibHandler::processRouteEvent(fbnl::RouteEvent&& event) {
+  auto kernelFibs = kernelFibs_.wlock();
+  if (not event.route.has_value()) {
+    // Kernel FIB is unknown. Re-seed on next repair
+    XLOG(WARNING) << "Lost route notifications. Invalidating kernel FIB";
+    for (auto& [_, kernelFib] : *kernelFibs) {
+      kernelFib.valid = false;
+      kernelFib.seeding = false;
+    }
+    return;
+  }
+
+  // Track unicast routes of our table only, skipping IPv6 cached routes
+  auto& route = event.route.value();
+  if (route.getFamily() == AF_MPLS or route.getRouteTable() != routeTable_ or
+      (route.getFlags().value_or(0) & RTM_F_CLONED)) {
+    return;
+  }
+  auto kernelFibIt = kernelFibs->find(route.getProtocolId());
+  if (kernelFibIt == kernelFibs->end()) {
+    // Route of another protocol may replace ours (e.g. `ip route replace ...
+    // proto static`). Kernel notifies only the new route for IPv4.
+    if (not event.isDeleted) {
+      evictReplacedRoute(*kernelFibs, route);
+    }
+    return;
+  }
+  auto& kernelFib = kernelFibIt->second;
+  if (kernelFib.seeding) {
+    kernelFib.notifiedPrefixes.emplace(route.getDestination());
+  } else if (not kernelFib.valid) {
+    return;
+  }
+
+  // Linux will report a null next-hop for RTN_BLACKHOLE type while
+  // RIB does not
+  if (route.getType() == RTN_BLACKHOLE) {
+    route.setNextHops({});
+  }
+  auto it = kernelFib.routes.find(route.getDestination());
+  if (it != kernelFib.routes.end()) {
+    kernelFib.digest.remove(it->second);
+    kernelFib.routes.erase(it);
+  }
+  if (not event.isDeleted) {
+    kernelFib.digest.add(route);
+    auto prefix = route.getDestination();
+    kernelFib.routes.emplace(std::move(prefix), std::move(route));
+  }
+}
+
+void
+NetlinkFibHandler::evictReplacedRoute(
+    std::unordered_map<uint8_t, KernelFib>& kernelFibs,
+    const fbnl::Route& route) {
+  const auto& prefix = route.getDestination();
+  for (auto& [_, kernelFib] : kernelFibs) {
+    if (kernelFib.seeding) {
+      // Dumped route, if any, is stale
+      kernelFib.notifiedPrefixes.emplace(prefix);
+    }
+    auto it = kernelFib.routes.find(prefix);
+    if (it == kernelFib.routes.end()) {
+      continue;
+    }
+    // Routes with different priorities co-exist in kernel
+    if (route.getPriority().has_value() and
+        it->second.getPriority() != route.getPriority()) {
+      continue;
+    }
+    kernelFib.digest.remove(it->second);
+    kernelFib.routes.erase(it);
+  }
+}
+
+folly::SemiFuture<folly::Unit>
+NetlinkFibHandler::collectUnicastReturnStatus(
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>&& result,
+    std::unordered_set<int> ignoredErrors) {
+  return fbnl::NetlinkProtocolSocket::collectReturnStatus(
+             std::move(result), std::move(ignoredErrors))
+      .deferError([this, protocol](folly::exception_wrapper&& ew) {
+        // Kernel state is unknown. Re-seed shadow FIB on next sync
+        (*shadowFibs_.wlock())[protocol].valid = false;
+        return folly::makeSemiFuture<folly::Unit>(std::move(ew));
+      });
+}
+
+bool
+NetlinkFibHandler::isNexthopGroupEligible(const fbnl::Route& route) const {
+  if (not enableNexthopGroups_ or route.getType() != RTN_UNICAST or
+      route.getNextHops().empty()) {
+    return false;
+  }
+  for (const auto& nh : route.getNextHops()) {
+    if (not nh.getGateway().has_value() or not nh.getIfIndex().has_value()) {
+      return false;
+    }
+    const auto action = nh.getLabelAction();
+    if (action.has_value() and action.value() != thrift::MplsActionCode::PUSH) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::optional<fbnl::NextHopSet>
+NetlinkFibHandler::bindNexthopGroup(
+    NexthopGroupState& state,
+    fbnl::Route& route,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  const bool isEligible = isNexthopGroupEligible(route);
+  const auto& prefix = route.getDestination();
+  auto& boundRoutes = state.routes[protocol];
+
+  std::optional<fbnl::NextHopSet> oldNextHops;
+  auto it = boundRoutes.find(prefix);
+  if (it != boundRoutes.end()) {
+    if (isEligible and it->second == route.getNextHops()) {
+      // Route already refers to the group of its nexthops
+      route.setNhId(state.groups.at(it->second).first);
+      return std::nullopt;
+    }
+    oldNextHops = std::move(it->second);
+    boundRoutes.erase(it);
+  }
+
+  if (isEligible) {
+    route.setNhId(
+        acquireNexthopGroup(state, route.getNextHops(), protocol, result));
+    boundRoutes.emplace(prefix, route.getNextHops());
+  }
+  return oldNextHops;
+}
+
+std::optional<fbnl::NextHopSet>
+NetlinkFibHandler::unbindNexthopGroup(
+    NexthopGroupState& state,
+    const folly::CIDRNetwork& prefix,
+    uint8_t protocol) {
+  auto& boundRoutes = state.routes[protocol];
+  auto it = boundRoutes.find(prefix);
+  if (it == boundRoutes.end()) {
+    return std::nullopt;
+  }
+  auto oldNextHops = std::move(it->second);
+  boundRoutes.erase(it);
+  return oldNextHops;
+}
+
+std::unordered_set<folly::CIDRNetwork>
+NetlinkFibHandler::rebindNexthopGroups(
+    NexthopGroupState& state,
+    const std::vector<fbnl::Route>& routes,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  std::unordered_set<folly::CIDRNetwork> rebound;
+  auto& boundRoutes = state.routes[protocol];
+  if (boundRoutes.empty()) {
+    return rebound;
+  }
+
+  // Group routes changing nexthops by their current group. New nexthops are
+  // reset if routes of a group are not moving to the same set.
+  std::unordered_map<
+      fbnl::NextHopSet,
+      std::pair<
+          std::optional<fbnl::NextHopSet>,
+          std::vector<folly::CIDRNetwork>>,
+      fbnl::NextHopSetHash>
+      moves;
+  for (const auto& route : routes) {
+    auto it = boundRoutes.find(route.getDestination());
+    if (it == boundRoutes.end() or it->second == route.getNextHops()) {
+      continue;
+    }
+    auto& [newNextHops, prefixes] =
+        moves
+            .try_emplace(
+                it->second,
+                route.getNextHops(),
+                std::vector<folly::CIDRNetwork>{})
+            .first->second;
+    if (not isNexthopGroupEligible(route) or
+        newNextHops != route.getNextHops()) {
+      newNextHops = std::nullopt;
+    }
+    prefixes.emplace_back(route.getDestination());
+  }
+
+  for (auto& [oldNextHops, move] : moves) {
+    auto& [newNextHops, prefixes] = move;
+    auto groupIt = state.groups.find(oldNextHops);
+    CHECK(groupIt != state.groups.end());
+    // Group can be updated in place only if all of its routes are moving and
+    // there is no existing group for the new nexthops
+    if (not newNextHops.has_value() or
+        groupIt->second.second != prefixes.size() or
+        state.groups.count(newNextHops.value())) {
+      continue;
+    }
+
+    // Replace group members. Kernel updates all the routes referring to it
+    const auto [groupId, refCount] = groupIt->second;
+    auto members =
+        acquireNexthops(state, newNextHops.value(), protocol, result);
+    result.emplace_back(nlSock_->addNexthopGroup(groupId, members, protocol));
+    releaseNexthops(state, oldNextHops, result);
+    state.groups.erase(groupIt);
+    state.groups.emplace(
+        newNextHops.value(), std::make_pair(groupId, refCount));
+
+    for (const auto& prefix : prefixes) {
+      boundRoutes[prefix] = newNextHops.value();
+      rebound.emplace(prefix);
+    }
+  }
+  return rebound;
+}
+
+uint32_t
+NetlinkFibHandler::acquireNexthopGroup(
+    NexthopGroupState& state,
+    const fbnl::NextHopSet& nextHops,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto it = state.groups.find(nextHops);
+  if (it == state.groups.end()) {
+    auto members = acquireNexthops(state, nextHops, protocol, result);
+    const auto groupId = state.nextId++;
+    it = state.groups.emplace(nextHops, std::make_pair(groupId, 0)).first;
+    result.emplace_back(nlSock_->addNexthopGroup(groupId, members, protocol));
+  }
+  it->second.second++;
+  return it->second.first;
+}
+
+void
+NetlinkFibHandler::releaseNexthopGroup(
+    NexthopGroupState& state,
+    const fbnl::NextHopSet& nextHops,
+    std::vector<folly::SemiFuture<int>>& result) {
+  auto it = state.groups.find(nextHops);
+  CHECK(it != state.groups.end());
+  if (--it->second.second > 0) {
+    return;
+  }
+
+  // Delete group before its members
+  result.emplace_back(nlSock_->deleteNexthop(it->second.first));
+  releaseNexthops(state, it->first, result);
+  state.groups.erase(it);
+}
+
+std::vector<std::pair<uint32_t, uint8_t>>
+NetlinkFibHandler::acquireNexthops(
+    NexthopGroupState& state,
+    const fbnl::NextHopSet& nextHops,
+    uint8_t protocol,
+    std::vector<folly::SemiFuture<int>>& result) {
+  std::vector<std::pair<uint32_t, uint8_t>> members;
+  members.reserve(nextHops.size());
+  for (const auto& nh : nextHops) {
+    auto it = state.nexthops.find(nh);
+    if (it == state.nexthops.end()) {
+      const auto nhId = state.nextId++;
+      it = state.nexthops.emplace(nh, std::make_pair(nhId, 0)).first;
+      result.emplace_back(nlSock_->addNexthop(nhId, nh, protocol));
+    }
+    it->second.second++;
+    members.emplace_back(
+        it->second.first, std::max(nh.getWeight(), uint8_t(1)));
+  }
+  return members;
+}
+
+void
+NetlinkFibHandler::releaseNexthops(
+    NexthopGroupState& state,
+    const fbnl::NextHopSet& nextHops,
+    std::vector<folly::SemiFuture<int>>& result) {
+  for (const auto& nh : nextHops) {
+    auto it = state.nexthops.find(nh);
+    CHECK(it != state.nexthops.end());
+    if (--it->second.second == 0) {
+      result.emplace_back(nlSock_->deleteNexthop(it->second.first));
+      state.nexthops.erase(it);
+    }
+  }
+}
+
 void
 NetlinkFibHandler::checkIfIndex(const int ifIndex) {
   char indexName[IF_NAMESIZE];
@@ -28,14 +28,57 @@ namespace openr {
  * - Translates netlink representation of routes to thrift for get* queries
  * - All APIs exposed are asynchronous. Sync API retries the existing routing
  *   state in synchronous way and program changes asynchrnously.
+ * - Optionally unicast routes are programmed via shared kernel nexthop group
+ *   objects (Linux 5.3+). Routes with same set of nexthops refer to the same
+ *   refcounted group. When all the routes of a group move to the same new set
+ *   of nexthops (e.g. on link failure), only the group is updated in kernel
+ *   instead of every route.
+ * - Unicast routes programmed for each client are cached in a shadow FIB,
+ *   seeded from kernel on first sync and kept up to date with every route
+ *   programmed thereafter. `syncFib` is diffed against the shadow, hence
+ *   a no-op sync doesn't dump kernel routing table nor program anything.
+ *   Shadow is re-seeded from kernel after any programming failure, and on
+ *   every sync when kernel FIB tracking is disabled.
+ * - Optionally unicast routes in kernel are tracked from kernel route
+ *   notifications, seeded along with shadow FIB. Drift of kernel routes from
+ *   the programmed ones (e.g. routes modified by other processes) is detected
+ *   by comparing digests of both and repaired by re-programming only the
+ *   drifted routes, without dumping kernel routing table.
  */
 class NetlinkFibHandler : public virtual thrift::FibServiceSvIf,
                           public facebook::fb303::BaseService {
  public:
   explicit NetlinkFibHandler(
-      fbnl::NetlinkProtocolSocket* nlSock, uint8_t routeTable = RT_TABLE_MAIN);
+      fbnl::NetlinkProtocolSocket* nlSock,
+      uint8_t routeTable = RT_TABLE_MAIN,
+      bool enableNexthopGroups = false,
+      bool enableKernelFibTracking = false);
   ~NetlinkFibHandler() override;
 
+  /**
+   * Order independent digest of a set of unicast routes. Routes are hashed on
+   * their forwarding state only (destination, type and nexthops or nexthop
+   * group), hence digests of routes as programmed and as reported by kernel
+   * are comparable.
+   */
+  struct RouteDigest {
+    size_t numRoutes{0};
+    size_t hash{0};
+
+    void add(const fbnl::Route& route);
+    void remove(const fbnl::Route& route);
+
+    bool
+    operator==(const RouteDigest& other) const {
+      return numRoutes == other.numRoutes and hash == other.hash;
+    }
+
+    bool
+    operator!=(const RouteDigest& other) const {
+      return not(*this == other);
+    }
+  };
+
   void
   getCounters(std::map<std::string, int64_t>& /* counters */) override {
     // No counters. Return empty
@@ -86,6 +129,27 @@ class NetlinkFibHandler : public virtual thrift::FibServiceSvIf,
   folly::SemiFuture<std::unique_ptr<std::vector<openr::thrift::MplsRoute>>>
   semifuture_getMplsRouteTableByClient(int16_t clientId) override;
 
+  /**
+   * Digests of unicast routes of client as programmed by this handler and as
+   * tracked in kernel. They're equal unless kernel routes drifted (or
+   * programming is in progress). Cheap check without dumping kernel routes.
+   *
+   * Returns `std::nullopt` if kernel FIB tracking is disabled or routes of
+   * client are not known (not synced since start or last failure).
+   */
+  std::optional<std::pair<RouteDigest, RouteDigest>> getUnicastFibDigests(
+      int16_t clientId);
+
+  /**
+   * Re-program only the unicast routes of client that drifted in kernel.
+   * Missing or modified routes are re-added and unknown routes of client's
+   * protocol are deleted. Kernel routing table is dumped only if route
+   * notifications were lost.
+   *
+   * @returns number of routes repaired
+   */
+  folly::SemiFuture<size_t> semifuture_repairUnicastFib(int16_t clientId);
+
   /**
    * Static API to convert protocol to clientId
    */
@@ -174,6 +238,185 @@ class NetlinkFibHandler : public virtual thrift::FibServiceSvIf,
   fbnl::NetlinkProtocolSocket* nlSock_{nullptr};
 
  private:
+  /**
+   * State of kernel nexthop objects owned by this handler. Nexthop objects
+   * are refcounted by the groups using them and groups are refcounted by the
+   * routes referring to them.
+   */
+  struct NexthopGroupState {
+    // nexthop -> (nexthop object id, number of groups using it)
+    std::unordered_map<
+        fbnl::NextHop,
+        std::pair<uint32_t, size_t>,
+        fbnl::NextHopHash>
+        nexthops;
+
+    // set of nexthops -> (group object id, number of routes using it)
+    std::unordered_map<
+        fbnl::NextHopSet,
+        std::pair<uint32_t, size_t>,
+        fbnl::NextHopSetHash>
+        groups;
+
+    // protocol -> prefix -> set of nexthops of the group route refers to
+    std::unordered_map<
+        uint8_t,
+        std::unordered_map<folly::CIDRNetwork, fbnl::NextHopSet>>
+        routes;
+
+    // next object id to allocate
+    uint32_t nextId{0};
+
+    // protocol -> ids of nexthop objects left over in kernel by previous
+    // instance. Unset until kernel is dumped.
+    std::optional<std::unordered_map<uint8_t, std::vector<uint32_t>>>
+        staleIds;
+  };
+
+  /**
+   * Unicast routes of a protocol as programmed in kernel by this handler
+   */
+  struct ShadowFib {
+    // Routes are not trusted until seeded from kernel
+    bool valid{false};
+
+    // Generation of the latest sync. Used for marking routes seen in a sync
+    uint64_t syncGen{0};
+
+    // prefix -> (route as programmed, generation of last sync it was seen in)
+    std::unordered_map<folly::CIDRNetwork, std::pair<fbnl::Route, uint64_t>>
+        routes;
+
+    // Digest of `routes`, updated along with them
+    RouteDigest digest;
+  };
+
+  /**
+   * Unicast routes of a protocol in kernel, tracked from route notifications
+   */
+  struct KernelFib {
+    // Routes are not trusted until seeded from kernel and after any
+    // notification is lost
+    bool valid{false};
+
+    // Seeding from kernel is in progress. Routes notified meanwhile are more
+    // recent than the ones dumped.
+    bool seeding{false};
+    std::unordered_set<folly::CIDRNetwork> notifiedPrefixes;
+
+    // prefix -> route in kernel
+    std::unordered_map<folly::CIDRNetwork, fbnl::Route> routes;
+
+    // Digest of `routes`, updated along with them
+    RouteDigest digest;
+  };
+
+  /**
+   * Dump unicast routes of protocol from kernel. Also seeds kernel FIB of
+   * protocol, if tracked.
+   * NOTE: Synchronous call
+   */
+  std::vector<fbnl::Route> dumpUnicastRoutes(uint8_t protocol);
+
+  /**
+   * Seed shadow FIB of protocol with unicast routes dumped from kernel.
+   * NOTE: Synchronous call
+   */
+  void seedShadowFib(uint8_t protocol);
+
+  /**
+   * Learn nexthop objects left over in kernel by previous instance. Ids are
+   * allocated past them so that their routes are not altered before being
+   * re-programmed. Seeding must precede any id allocation, thus it is invoked
+   * by every unicast programming call. No-op once seeded or if nexthop groups
+   * are disabled.
+   * NOTE: Synchronous call
+   */
+  void seedNexthopGroupState();
+
+  /**
+   * Update kernel FIB with route notification. Invoked in netlink event base
+   * thread.
+   */
+  void processRouteEvent(fbnl::RouteEvent&& event);
+
+  /**
+   * Remove tracked route replaced in kernel by `route` of an untracked
+   * protocol, i.e. route to the same destination and of the same priority
+   */
+  static void evictReplacedRoute(
+      std::unordered_map<uint8_t, KernelFib>& kernelFibs,
+      const fbnl::Route& route);
+
+  /**
+   * Collect return status of unicast route programming. On failure shadow
+   * FIB of protocol is invalidated and gets re-seeded on next sync.
+   */
+  folly::SemiFuture<folly::Unit> collectUnicastReturnStatus(
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>&& result,
+      std::unordered_set<int> ignoredErrors);
+
+  /**
+   * Returns true if route can be programmed via kernel nexthop group. Only
+   * unicast routes with gateway + interface nexthops (optionally with MPLS
+   * PUSH) are eligible. MPLS routes doesn't support nexthop objects.
+   */
+  bool isNexthopGroupEligible(const fbnl::Route& route) const;
+
+  /**
+   * Point route to the group of its nexthops (creating group and member
+   * nexthop objects if needed) or detach it from group if not eligible.
+   * Returns previous set of nexthops route was bound to, which must be
+   * released after route is programmed.
+   */
+  std::optional<fbnl::NextHopSet> bindNexthopGroup(
+      NexthopGroupState& state,
+      fbnl::Route& route,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  /**
+   * Unbind route of given prefix. Returns set of nexthops it was bound to.
+   */
+  std::optional<fbnl::NextHopSet> unbindNexthopGroup(
+      NexthopGroupState& state,
+      const folly::CIDRNetwork& prefix,
+      uint8_t protocol);
+
+  /**
+   * Update all the routes of an existing group, moving to the same new set of
+   * nexthops, by replacing group members in place. Routes themselves are not
+   * re-programmed. Returns the routes that were handled.
+   */
+  std::unordered_set<folly::CIDRNetwork> rebindNexthopGroups(
+      NexthopGroupState& state,
+      const std::vector<fbnl::Route>& routes,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Acquire/Release reference of group and its member nexthop objects
+  uint32_t acquireNexthopGroup(
+      NexthopGroupState& state,
+      const fbnl::NextHopSet& nextHops,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+  void releaseNexthopGroup(
+      NexthopGroupState& state,
+      const fbnl::NextHopSet& nextHops,
+      std::vector<folly::SemiFuture<int>>& result);
+
+  // Acquire member nexthop objects of a group and return group members
+  std::vector<std::pair<uint32_t, uint8_t>> acquireNexthops(
+      NexthopGroupState& state,
+      const fbnl::NextHopSet& nextHops,
+      uint8_t protocol,
+      std::vector<folly::SemiFuture<int>>& result);
+  void releaseNexthops(
+      NexthopGroupState& state,
+      const fbnl::NextHopSet& nextHops,
+      std::vector<folly::SemiFuture<int>>& result);
+
   /**
    * Disable copy & assignment operators
    */
@@ -207,6 +450,25 @@ class NetlinkFibHandler : public virtual thrift::FibServiceSvIf,
 
   // RouteTable ID this FibHandler will program into
   uint8_t routeTable_{RT_TABLE_MAIN};
+
+  // Program unicast routes via shared kernel nexthop groups
+  const bool enableNexthopGroups_{false};
+
+  // Kernel nexthop objects. Lock is held for entire API call to keep object
+  // state in sync with order of messages sent to kernel.
+  folly::Synchronized<NexthopGroupState> nhGroupState_;
+
+  // protocol -> shadow FIB of unicast routes. Always locked after
+  // `nhGroupState_` when both are needed.
+  folly::Synchronized<std::unordered_map<uint8_t, ShadowFib>> shadowFibs_;
+
+  // Track unicast routes in kernel from route notifications
+  const bool enableKernelFibTracking_{false};
+
+  // protocol -> unicast routes in kernel. Always locked after `shadowFibs_`
+  // when both are needed. Never held while making netlink requests, as route
+  // notifications may be delivered synchronously.
+  folly::Synchronized<std::unordered_map<uint8_t, KernelFib>> kernelFibs_;
 };
 
 } // namespace openr
@@ -10,6 +10,7 @@
 #include <string>
 #include <thread>
 
+#include <fb303/ServiceData.h>
 #include <folly/Benchmark.h>
 #include <folly/Exception.h>
 #include <folly/Format.h>
@@ -28,6 +29,17 @@
 
 using namespace openr::fbnl;
 
+#define BENCHMARK_COUNTERS_NAME_PARAM(name, counters, param_name, ...) \
+  BENCHMARK_IMPL_COUNTERS(                                            \
+      FB_CONCATENATE(name, FB_CONCATENATE(_, param_name)),            \
+      FOLLY_PP_STRINGIZE(name) "(" FOLLY_PP_STRINGIZE(param_name) ")", \
+      counters,                                                       \
+      iters,                                                          \
+      unsigned,                                                       \
+      iters) {                                                        \
+    name(counters, iters, ##__VA_ARGS__);                             \
+  }
+
 namespace {
 // Virtual interfaces
 const std::string kVethNameX("vethTestX");
@@ -36,9 +48,18 @@ const std::string kVethNameY("vethTestY");
 static const uint8_t kBitMaskLen = 128;
 // Number of nexthops
 const uint8_t kNumOfNexthops = 128;
+// Number of ECMP nexthops shared by all the prefixes
+const uint8_t kNumOfSharedNexthops = 64;
 
 const int16_t kFibId{static_cast<int16_t>(openr::thrift::FibClient::OPENR)};
 
+int64_t
+getCounter(const std::string& key) {
+  auto counters = facebook::fb303::fbData->getCounters();
+  auto it = counters.find(key);
+  return it == counters.end() ? 0 : it->second;
+}
+
 } // namespace
 
 namespace openr {
@@ -47,14 +68,15 @@ namespace openr {
 // which the Benchmark test can use to add routes (via interface)
 class NetlinkFibWrapper {
  public:
-  NetlinkFibWrapper() {
+  explicit NetlinkFibWrapper(bool enableNexthopGroups = false) {
     // Create NetlinkProtocolSocket
     nlSock = std::make_unique<MockNetlinkProtocolSocket>(&evb);
     nlSock->addLink(utils::createLink(0, kVethNameX)).get();
     nlSock->addLink(utils::createLink(1, kVethNameY)).get();
 
     // Start FibService thread
-    fibHandler = std::make_unique<NetlinkFibHandler>(nlSock.get());
+    fibHandler = std::make_unique<NetlinkFibHandler>(
+        nlSock.get(), RT_TABLE_MAIN, enableNexthopGroups);
   }
 
   ~NetlinkFibWrapper() {
@@ -106,12 +128,102 @@ BM_NetlinkFibHandler(uint32_t iters, size_t numOfPrefixes) {
   }
 }
 
+/**
+ * Benchmark test to measure the cost of mass nexthop failure
+ * 1. Create a NetlinkFibHandler with or without kernel nexthop groups
+ * 2. Add routes sharing the same ECMP set of nexthops
+ * 3. Remove one nexthop from all the routes (e.g. link failure)
+ * 4. Wait until the completion of routes update
+ *
+ * Reports number of route and nexthop group messages sent per failure
+ */
+static void
+BM_NetlinkFibHandlerNexthopFailure(
+    folly::UserCounters& counters,
+    uint32_t iters,
+    size_t numOfPrefixes,
+    bool enableNexthopGroups) {
+  auto suspender = folly::BenchmarkSuspender();
+  auto netlinkFibWrapper =
+      std::make_unique<NetlinkFibWrapper>(enableNexthopGroups);
+
+  // Randomly generate IPV6 prefixes and shared nexthops
+  auto prefixes = netlinkFibWrapper->prefixGenerator.ipv6PrefixGenerator(
+      numOfPrefixes, kBitMaskLen);
+  const auto nextHops = PrefixGenerator::getRandomNextHops(
+      kNumOfSharedNexthops, kVethNameY);
+  auto failedNextHops = nextHops;
+  failedNextHops.pop_back();
+
+  auto createRoutes = [&](const std::vector<thrift::NextHopThrift>& nhs) {
+    auto routes = std::make_unique<std::vector<thrift::UnicastRoute>>();
+    routes->reserve(prefixes.size());
+    for (const auto& prefix : prefixes) {
+      routes->emplace_back(createUnicastRoute(prefix, nhs));
+    }
+    return routes;
+  };
+
+  int64_t numRouteAdds{0};
+  int64_t numGroupAdds{0};
+  for (uint32_t i = 0; i < iters; i++) {
+    // Program routes with all nexthops
+    netlinkFibWrapper->fibHandler
+        ->semifuture_addUnicastRoutes(kFibId, createRoutes(nextHops))
+        .wait();
+    auto routes = createRoutes(failedNextHops);
+    const auto routeAdds = getCounter("nlmock.add_route.sum");
+    const auto groupAdds = getCounter("nlmock.add_nexthop_group.sum");
+
+    suspender.dismiss(); // Start measuring benchmark time
+    // Update routes with one nexthop less
+    netlinkFibWrapper->fibHandler
+        ->semifuture_addUnicastRoutes(kFibId, std::move(routes))
+        .wait();
+    suspender.rehire(); // Stop measuring time again
+
+    numRouteAdds += getCounter("nlmock.add_route.sum") - routeAdds;
+    numGroupAdds += getCounter("nlmock.add_nexthop_group.sum") - groupAdds;
+  }
+
+  counters["route_adds"] = numRouteAdds / iters;
+  counters["nexthop_group_adds"] = numGroupAdds / iters;
+}
+
 // The parameter is the number of prefixes
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 10);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 100);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 1000);
 BENCHMARK_PARAM(BM_NetlinkFibHandler, 10000);
 
+BENCHMARK_DRAW_LINE();
+
+// The parameters are the number of prefixes and enableNexthopGroups
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_NetlinkFibHandlerNexthopFailure,
+    counters,
+    1000_INLINE_NEXTHOPS,
+    1000,
+    false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_NetlinkFibHandlerNexthopFailure,
+    counters,
+    1000_NEXTHOP_GROUPS,
+    1000,
+    true);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_NetlinkFibHandlerNexthopFailure,
+    counters,
+    10000_INLINE_NEXTHOPS,
+    10000,
+    false);
+BENCHMARK_COUNTERS_NAME_PARAM(
+    BM_NetlinkFibHandlerNexthopFailure,
+    counters,
+    10000_NEXTHOP_GROUPS,
+    10000,
+    true);
+
 } // namespace openr
 
 int
@@ -5,6 +5,7 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <fb303/ServiceData.h>
 #include <folly/Format.h>
 #include <folly/IPAddress.h>
 #include <folly/Random.h>
@@ -160,6 +161,33 @@ class FibHandlerFixture : public testing::TestWithParam<bool> {
     }
   }
 
+  // Number of kernel nexthop objects and groups in fake netlink
+  size_t
+  getNumNexthops() const {
+    return nlSock_.getNumNexthops();
+  }
+
+  size_t
+  getNumNexthopGroups() const {
+    return nlSock_.getNumNexthopGroups();
+  }
+
+  // New FibHandler using kernel nexthop groups, e.g. to emulate restart
+  std::unique_ptr<NetlinkFibHandler>
+  createNexthopGroupHandler() {
+    return std::make_unique<NetlinkFibHandler>(
+        dynamic_cast<fbnl::NetlinkProtocolSocket*>(&nlSock_),
+        RT_TABLE_MAIN,
+        true /* enableNexthopGroups */);
+  }
+
+  // Program route in fake netlink bypassing FibHandler, like other routing
+  // daemons or an operator would
+  void
+  addKernelRoute(const fbnl::Route& route) {
+    ASSERT_EQ(0, nlSock_.addRoute(route).get());
+  }
+
  private:
   // Intentionally keeping private to not expose in UTs
   folly::EventBase nlEvb_;
@@ -169,6 +197,19 @@ class FibHandlerFixture : public testing::TestWithParam<bool> {
   // FibHandler is accessible in UTs for testing
   NetlinkFibHandler handler{
       dynamic_cast<fbnl::NetlinkProtocolSocket*>(&nlSock_)};
+
+  // FibHandler programming unicast routes via kernel nexthop groups
+  NetlinkFibHandler nhGroupHandler{
+      dynamic_cast<fbnl::NetlinkProtocolSocket*>(&nlSock_),
+      RT_TABLE_MAIN,
+      true /* enableNexthopGroups */};
+
+  // FibHandler tracking unicast routes in kernel from route notifications
+  NetlinkFibHandler trackingHandler{
+      dynamic_cast<fbnl::NetlinkProtocolSocket*>(&nlSock_),
+      RT_TABLE_MAIN,
+      false /* enableNexthopGroups */,
+      true /* enableKernelFibTracking */};
 };
 
 //
@@ -412,6 +453,461 @@ TEST_P(FibHandlerFixture, UnicastSync) {
   EXPECT_EQ(rts, *routes);
 }
 
+//
+// Test syncFib is diffed against shadow FIB with kernel FIB tracking
+//
+// - first sync dumps kernel routes
+// - no-op sync neither dumps kernel routes nor programs anything
+// - routes programmed via add/delete APIs are reflected in next sync
+//
+TEST_P(FibHandlerFixture, UnicastSyncShadow) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+  auto getCounter = [](const std::string& name) {
+    return facebook::fb303::fbData->getCounter(name + ".sum");
+  };
+  auto syncFib = [&](const std::vector<thrift::UnicastRoute>& rts) {
+    trackingHandler
+        .semifuture_syncFib(
+            kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+        .get();
+  };
+
+  // First sync seeds shadow FIB from kernel
+  auto rts = createUnicastRoutes(10, isV4);
+  const auto numGetRoutes = getCounter("nlmock.get_routes");
+  syncFib(rts);
+  EXPECT_LT(numGetRoutes, getCounter("nlmock.get_routes"));
+
+  // No-op sync
+  const auto numAddRoutes = getCounter("nlmock.add_route");
+  const auto numDelRoutes = getCounter("nlmock.delete_route");
+  const auto numGetRoutes2 = getCounter("nlmock.get_routes");
+  syncFib(rts);
+  EXPECT_EQ(numAddRoutes, getCounter("nlmock.add_route"));
+  EXPECT_EQ(numDelRoutes, getCounter("nlmock.delete_route"));
+  EXPECT_EQ(numGetRoutes2, getCounter("nlmock.get_routes"));
+
+  // Update one route and delete another one via incremental APIs. Sync with
+  // same routes is a no-op
+  rts.at(0).nextHops() = {createNextHop(10, isV4)};
+  trackingHandler
+      .semifuture_addUnicastRoute(
+          kClientId, std::make_unique<thrift::UnicastRoute>(rts.at(0)))
+      .get();
+  trackingHandler
+      .semifuture_deleteUnicastRoute(
+          kClientId, std::make_unique<thrift::IpPrefix>(*rts.back().dest()))
+      .get();
+  rts.pop_back();
+  syncFib(rts);
+  EXPECT_EQ(numAddRoutes + 1, getCounter("nlmock.add_route"));
+  EXPECT_EQ(numDelRoutes + 1, getCounter("nlmock.delete_route"));
+  EXPECT_EQ(numGetRoutes2, getCounter("nlmock.get_routes"));
+
+  // Sync with one updated and one stale route
+  rts.at(1).nextHops() = {createNextHop(11, isV4)};
+  rts.pop_back();
+  syncFib(rts);
+  EXPECT_EQ(numAddRoutes + 2, getCounter("nlmock.add_route"));
+  EXPECT_EQ(numDelRoutes + 2, getCounter("nlmock.delete_route"));
+  EXPECT_EQ(numGetRoutes2, getCounter("nlmock.get_routes"));
+  auto routes =
+      trackingHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(8, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+}
+
+//
+//
+// Test syncFib without kernel FIB tracking repairs routes changed in kernel
+//
+// - every sync dumps kernel routes
+// - route deleted in kernel behind the back of handler (here by another
+//   handler) is re-added by next sync
+//
+TEST_P(FibHandlerFixture, UnicastSyncWithoutTracking) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+  auto getCounter = [](const std::string& name) {
+    return facebook::fb303::fbData->getCounter(name + ".sum");
+  };
+  auto syncFib = [&](const std::vector<thrift::UnicastRoute>& rts) {
+    handler
+        .semifuture_syncFib(
+            kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+        .get();
+  };
+
+  auto rts = createUnicastRoutes(10, isV4);
+  syncFib(rts);
+
+  // Delete a route behind the back of handler
+  trackingHandler
+      .semifuture_deleteUnicastRoute(
+          kClientId, std::make_unique<thrift::IpPrefix>(*rts.front().dest()))
+      .get();
+
+  // Sync dumps kernel routes and re-adds only the deleted route
+  const auto numAddRoutes = getCounter("nlmock.add_route");
+  const auto numDelRoutes = getCounter("nlmock.delete_route");
+  const auto numGetRoutes = getCounter("nlmock.get_routes");
+  syncFib(rts);
+  EXPECT_EQ(numAddRoutes + 1, getCounter("nlmock.add_route"));
+  EXPECT_EQ(numDelRoutes, getCounter("nlmock.delete_route"));
+  EXPECT_LT(numGetRoutes, getCounter("nlmock.get_routes"));
+  auto routes = handler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+}
+
+// Test detection and repair of drift of kernel routes from programmed ones
+//
+// - digests match after sync and incremental updates
+// - routes deleted, modified or added in kernel behind the back of handler
+//   (here by another handler) are detected
+// - repair re-programs only the drifted routes, without dumping kernel routes
+//
+TEST_P(FibHandlerFixture, UnicastKernelFibDrift) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+  auto getCounter = [](const std::string& name) {
+    return facebook::fb303::fbData->getCounter(name + ".sum");
+  };
+  auto addRoute = [&](NetlinkFibHandler& fibHandler,
+                      const thrift::UnicastRoute& route) {
+    fibHandler
+        .semifuture_addUnicastRoute(
+            kClientId, std::make_unique<thrift::UnicastRoute>(route))
+        .get();
+  };
+  auto expectNoDrift = [&]() {
+    const auto digests = trackingHandler.getUnicastFibDigests(kClientId);
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_EQ(digests->first, digests->second);
+  };
+
+  // Routes are known only after first sync
+  EXPECT_FALSE(trackingHandler.getUnicastFibDigests(kClientId).has_value());
+  auto rts = createUnicastRoutes(10, isV4);
+  trackingHandler
+      .semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  expectNoDrift();
+  EXPECT_EQ(
+      10, trackingHandler.getUnicastFibDigests(kClientId)->first.numRoutes);
+  EXPECT_EQ(0, trackingHandler.semifuture_repairUnicastFib(kClientId).get());
+
+  // Incremental updates
+  rts.at(0).nextHops() = {createNextHop(10, isV4)};
+  addRoute(trackingHandler, rts.at(0));
+  expectNoDrift();
+
+  // Delete, modify and add a route behind the back of handler
+  handler
+      .semifuture_deleteUnicastRoute(
+          kClientId, std::make_unique<thrift::IpPrefix>(*rts.at(1).dest()))
+      .get();
+  auto modifiedRoute = rts.at(2);
+  modifiedRoute.nextHops() = {createNextHop(11, isV4)};
+  addRoute(handler, modifiedRoute);
+  addRoute(handler, createUnicastRoute(100, 1, isV4));
+  const auto digests = trackingHandler.getUnicastFibDigests(kClientId);
+  ASSERT_TRUE(digests.has_value());
+  EXPECT_NE(digests->first, digests->second);
+  EXPECT_EQ(10, digests->second.numRoutes);
+
+  // Repair only the drifted routes
+  const auto numAddRoutes = getCounter("nlmock.add_route");
+  const auto numDelRoutes = getCounter("nlmock.delete_route");
+  const auto numGetRoutes = getCounter("nlmock.get_routes");
+  EXPECT_EQ(3, trackingHandler.semifuture_repairUnicastFib(kClientId).get());
+  EXPECT_EQ(numAddRoutes + 2, getCounter("nlmock.add_route"));
+  EXPECT_EQ(numDelRoutes + 1, getCounter("nlmock.delete_route"));
+  EXPECT_EQ(numGetRoutes, getCounter("nlmock.get_routes"));
+  expectNoDrift();
+
+  auto routes =
+      trackingHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  std::sort(rts.begin(), rts.end());
+  std::sort(routes->begin(), routes->end());
+  EXPECT_EQ(rts, *routes);
+}
+
+//
+// Test tracking of routes replaced in kernel by route of another protocol
+//
+// - route of the same destination and priority replaces tracked route
+//   without delete notification, hence tracked route must be evicted
+// - route of another priority co-exists and doesn't cause drift
+// - repair re-programs the replaced route
+//
+TEST_P(FibHandlerFixture, UnicastKernelFibReplacedByOtherProtocol) {
+  const int16_t kClientId = 786;
+  const uint8_t kPriority = NetlinkFibHandler::protocolToPriority(
+      NetlinkFibHandler::getProtocol(kClientId).value());
+  const bool isV4 = GetParam();
+  auto createStaticRoute = [&](const thrift::UnicastRoute& route,
+                               uint32_t priority) {
+    fbnl::RouteBuilder builder;
+    return builder.setDestination(toIPNetwork(*route.dest()))
+        .setRouteTable(RT_TABLE_MAIN)
+        .setProtocolId(RTPROT_STATIC)
+        .setPriority(priority)
+        .build();
+  };
+  auto expectNoDrift = [&]() {
+    const auto digests = trackingHandler.getUnicastFibDigests(kClientId);
+    ASSERT_TRUE(digests.has_value());
+    EXPECT_EQ(digests->first, digests->second);
+  };
+
+  auto rts = createUnicastRoutes(10, isV4);
+  trackingHandler
+      .semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  expectNoDrift();
+
+  // Route of another priority doesn't replace ours
+  addKernelRoute(createStaticRoute(rts.at(2), kPriority + 1));
+  expectNoDrift();
+
+  // Route of same priority replaces ours
+  addKernelRoute(createStaticRoute(rts.at(3), kPriority));
+  auto digests = trackingHandler.getUnicastFibDigests(kClientId);
+  ASSERT_TRUE(digests.has_value());
+  EXPECT_NE(digests->first, digests->second);
+  EXPECT_EQ(9, digests->second.numRoutes);
+
+  // Repair re-programs replaced route
+  EXPECT_EQ(1, trackingHandler.semifuture_repairUnicastFib(kClientId).get());
+  expectNoDrift();
+  EXPECT_EQ(
+      10, trackingHandler.getUnicastFibDigests(kClientId)->second.numRoutes);
+}
+
+//
+// Test programming of unicast routes via shared kernel nexthop groups
+//
+// - routes with same nexthops share one group
+// - all routes of a group moving to same new nexthops update group in place
+//   without re-programming routes
+// - routes diverging get their own groups
+// - deleting routes frees groups and nexthop objects
+//
+TEST_P(FibHandlerFixture, UnicastNexthopGroups) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+  auto getNumRouteAdds = []() {
+    return facebook::fb303::fbData->getCounter("nlmock.add_route.sum");
+  };
+
+  // Create 10 routes sharing the same 3 nexthops
+  const auto nextHops = createNextHops(3, isV4);
+  std::vector<thrift::UnicastRoute> rts;
+  for (size_t i = 0; i < 10; ++i) {
+    auto route = createUnicastRoute(i, 1, isV4);
+    route.nextHops() = nextHops;
+    rts.emplace_back(std::move(route));
+  }
+  nhGroupHandler
+      .semifuture_addUnicastRoutes(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  auto routes =
+      nhGroupHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(3, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+
+  // Remove one nexthop from all the routes (e.g. link failure). Group is
+  // updated in place and no route is re-programmed
+  const auto numRouteAdds = getNumRouteAdds();
+  for (auto& route : rts) {
+    route.nextHops()->pop_back();
+  }
+  nhGroupHandler
+      .semifuture_addUnicastRoutes(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  routes = nhGroupHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(numRouteAdds, getNumRouteAdds());
+  EXPECT_EQ(2, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+
+  // Update only one route. It gets its own group
+  rts.at(0).nextHops()->pop_back();
+  nhGroupHandler
+      .semifuture_addUnicastRoute(
+          kClientId, std::make_unique<thrift::UnicastRoute>(rts.at(0)))
+      .get();
+  routes = nhGroupHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(numRouteAdds + 1, getNumRouteAdds());
+  EXPECT_EQ(2, getNumNexthops());
+  EXPECT_EQ(2, getNumNexthopGroups());
+
+  // Sync only first two routes. Stale routes and their group are removed
+  rts.resize(2);
+  nhGroupHandler
+      .semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  routes = nhGroupHandler.semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(2, routes->size());
+  sortNextHops(*routes);
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(2, getNumNexthops());
+  EXPECT_EQ(2, getNumNexthopGroups());
+
+  // Delete routes. All nexthop objects are freed
+  auto prefixes = std::make_unique<std::vector<thrift::IpPrefix>>();
+  for (const auto& route : rts) {
+    prefixes->emplace_back(*route.dest());
+  }
+  nhGroupHandler.semifuture_deleteUnicastRoutes(kClientId, std::move(prefixes))
+      .get();
+  routes = nhGroupHandler.semifuture_getRouteTableByClient(kClientId).get();
+  EXPECT_EQ(0, routes->size());
+  EXPECT_EQ(0, getNumNexthops());
+  EXPECT_EQ(0, getNumNexthopGroups());
+}
+
+//
+// Test cleanup of nexthop objects left over by previous instance
+//
+// - restarted handler allocates object ids past the left over ones, hence
+//   routes of previous instance are not altered before being re-programmed
+// - left over objects are deleted on first sync
+//
+TEST_P(FibHandlerFixture, UnicastNexthopGroupsRestart) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+
+  // Create 10 routes sharing the same 3 nexthops
+  std::vector<thrift::UnicastRoute> rts;
+  for (size_t i = 0; i < 10; ++i) {
+    auto route = createUnicastRoute(i, 1, isV4);
+    route.nextHops() = createNextHops(3, isV4);
+    rts.emplace_back(std::move(route));
+  }
+  nhGroupHandler
+      .semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  EXPECT_EQ(3, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+
+  // Restart and sync routes with a nexthop less
+  for (auto& route : rts) {
+    route.nextHops()->pop_back();
+  }
+  auto restartedHandler = createNexthopGroupHandler();
+  restartedHandler
+      ->semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  auto routes =
+      restartedHandler->semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(10, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  std::sort(rts.begin(), rts.end());
+  std::sort(routes->begin(), routes->end());
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(2, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+
+  // Left over objects are deleted only once
+  const auto numDeletes =
+      facebook::fb303::fbData->getCounter("nlmock.delete_nexthop.sum");
+  restartedHandler
+      ->semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  EXPECT_EQ(
+      numDeletes,
+      facebook::fb303::fbData->getCounter("nlmock.delete_nexthop.sum"));
+  EXPECT_EQ(2, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+}
+
+/**
+ * Routes added before the first sync after restart, e.g. high priority routes,
+ * don't alter nexthop objects left over by the previous instance.
+ */
+TEST_P(FibHandlerFixture, UnicastNexthopGroupsAddBeforeSync) {
+  const int16_t kClientId = 786;
+  const bool isV4 = GetParam();
+
+  // Create 10 routes sharing the same 3 nexthops
+  std::vector<thrift::UnicastRoute> rts;
+  for (size_t i = 0; i < 10; ++i) {
+    auto route = createUnicastRoute(i, 1, isV4);
+    route.nextHops() = createNextHops(3, isV4);
+    rts.emplace_back(std::move(route));
+  }
+  nhGroupHandler
+      .semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  EXPECT_EQ(3, getNumNexthops());
+  EXPECT_EQ(1, getNumNexthopGroups());
+
+  // Restart and add a route via a new nexthop before syncing
+  auto route = createUnicastRoute(10, 1, isV4);
+  route.nextHops() = {createNextHops(4, isV4).back()};
+  rts.emplace_back(route);
+  auto restartedHandler = createNexthopGroupHandler();
+  restartedHandler
+      ->semifuture_addUnicastRoutes(
+          kClientId,
+          std::make_unique<std::vector<thrift::UnicastRoute>>(
+              std::vector<thrift::UnicastRoute>{route}))
+      .get();
+
+  // Routes of previous instance keep their nexthops
+  auto routes =
+      restartedHandler->semifuture_getRouteTableByClient(kClientId).get();
+  ASSERT_EQ(11, routes->size());
+  sortNextHops(rts);
+  sortNextHops(*routes);
+  std::sort(rts.begin(), rts.end());
+  std::sort(routes->begin(), routes->end());
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(4, getNumNexthops());
+  EXPECT_EQ(2, getNumNexthopGroups());
+
+  // Sync re-programs routes of previous instance and deletes its objects
+  restartedHandler
+      ->semifuture_syncFib(
+          kClientId, std::make_unique<std::vector<thrift::UnicastRoute>>(rts))
+      .get();
+  routes = restartedHandler->semifuture_getRouteTableByClient(kClientId).get();
+  sortNextHops(*routes);
+  std::sort(routes->begin(), routes->end());
+  EXPECT_EQ(rts, *routes);
+  EXPECT_EQ(4, getNumNexthops());
+  EXPECT_EQ(2, getNumNexthopGroups());
+}
+
 //
 // Test correctness of multiple client support. Incrementally add and remove
 // route for same prefix1 from client1 and client2. Verify that addition or
@@ -38,6 +38,7 @@ PrefixManager::PrefixManager(
     std::shared_ptr<const Config> config)
     : nodeId_(config->getNodeName()),
       config_(config),
+      numPrefixShards_(config->getPrefixDbNumShards()),
       staticRouteUpdatesQueue_(staticRouteUpdatesQueue),
       kvRequestQueue_(kvRequestQueue),
       initializationEventQueue_(initializationEventQueue) {
@@ -241,32 +242,64 @@ PrefixManager::processPublication(thrift::Publication&& thriftPub) {
     try {
       const auto prefixDb =
           readThriftObjStr<thrift::PrefixDatabase>(*val.value(), serializer_);
-      if (prefixDb.prefixEntries()->size() != 1) {
+      const bool isShardKey = PrefixShardKey::isPrefixShardKey(keyStr);
+      if (not isShardKey and prefixDb.prefixEntries()->size() != 1) {
         LOG(WARNING) << "Skip processing unexpected number of prefix entries";
         continue;
       }
 
-      if (not *prefixDb.deletePrefix()) {
-        // get the key prefix and area from the thrift::PrefixDatabase
-        auto const& tPrefixEntry = prefixDb.prefixEntries()->front();
-        auto const& thisNodeName = *prefixDb.thisNodeName();
+      // Skip none-self advertised prefixes
+      if (*prefixDb.deletePrefix() or *prefixDb.thisNodeName() != nodeId_) {
+        continue;
+      }
+
+      bool needsSync{false};
+      if (isShardKey != (numPrefixShards_ > 0)) {
+        // Own key in the format not in use. Withdraw it after its prefixes
+        // are re-advertised in current format.
+        thrift::PrefixDatabase deletedPrefixDb;
+        deletedPrefixDb.thisNodeName() = nodeId_;
+        deletedPrefixDb.deletePrefix() = true;
+        if (not isShardKey) {
+          deletedPrefixDb.prefixEntries() = *prefixDb.prefixEntries();
+        }
+        staleKeysToWithdraw_[area].insert_or_assign(
+            keyStr, writeThriftObjStr(std::move(deletedPrefixDb), serializer_));
+        needsSync = true;
+      } else if (isShardKey) {
+        // Shard not populated by this incarnation. Mark it to be withdrawn,
+        // unless it gets re-populated.
+        auto maybeShardKey = PrefixShardKey::fromStr(keyStr, area);
+        if (maybeShardKey.hasValue() and
+            not prefixShards_[area].count(maybeShardKey->getShardId())) {
+          dirtyPrefixShards_[area].emplace(maybeShardKey->getShardId());
+          needsSync = true;
+        }
+      }
+
+      for (auto const& tPrefixEntry : *prefixDb.prefixEntries()) {
         auto const& network = toIPNetwork(*tPrefixEntry.prefix());
 
-        // Skip none-self advertised prefixes or already persisted keys.
-        if (thisNodeName != nodeId_ or advertiseStatus_.count(network) > 0) {
+        // Skip already persisted keys.
+        if (advertiseStatus_.count(network) > 0) {
           continue;
         }
 
         XLOG(DBG1) << fmt::format(
-            "[Prefix Update]: Area: {}, {} updated inside KvStore",
+            "[Prefix Update]: Area: {}, {} ({}) updated inside KvStore",
             area,
-            keyStr);
+            keyStr,
+            folly::IPAddress::networkToString(network));
         // populate advertiseStatus_ collection to make sure we can find
         // <key, area> when clear key from `KvStore`
         advertiseStatus_[network].areas.emplace(area);
 
         // Populate pendingState to check keys
         pendingUpdates_.addPrefixChange(network);
+        needsSync = true;
+      }
+
+      if (needsSync) {
         syncKvStoreThrottled_->operator()();
       }
     } catch (const std::exception& ex) {
@@ -505,15 +538,24 @@ PrefixManager::addKvStoreKeyHelper(const PrefixEntry& entry) {
       postPolicyTPrefixEntry = tPrefixEntry;
     }
 
-    const auto prefixKeyStr =
-        PrefixKey(nodeId_, entry.network, toArea).getPrefixKeyV2();
-    auto prefixDb = createPrefixDb(nodeId_, {*postPolicyTPrefixEntry});
-    auto prefixDbStr = writeThriftObjStr(std::move(prefixDb), serializer_);
-
-    // advertise key to `KvStore`
-    auto persistPrefixKeyVal =
-        PersistKeyValueRequest(AreaId{toArea}, prefixKeyStr, prefixDbStr);
-    kvRequestQueue_.push(std::move(persistPrefixKeyVal));
+    if (numPrefixShards_ > 0) {
+      // pack entry into its shard, advertised at the end of sync
+      const auto shardId =
+          PrefixShardKey::getShardOf(entry.network, numPrefixShards_);
+      prefixShards_[toArea][shardId].insert_or_assign(
+          entry.network, *postPolicyTPrefixEntry);
+      dirtyPrefixShards_[toArea].emplace(shardId);
+    } else {
+      const auto prefixKeyStr =
+          PrefixKey(nodeId_, entry.network, toArea).getPrefixKeyV2();
+      auto prefixDb = createPrefixDb(nodeId_, {*postPolicyTPrefixEntry});
+      auto prefixDbStr = writeThriftObjStr(std::move(prefixDb), serializer_);
+
+      // advertise key to `KvStore`
+      auto persistPrefixKeyVal =
+          PersistKeyValueRequest(AreaId{toArea}, prefixKeyStr, prefixDbStr);
+      kvRequestQueue_.push(std::move(persistPrefixKeyVal));
+    }
 
     fb303::fbData->addStatValue(
         "prefix_manager.route_advertisements", 1, fb303::SUM);
@@ -549,6 +591,25 @@ PrefixManager::deleteKvStoreKeyHelper(
     const folly::CIDRNetwork& prefix,
     const std::unordered_set<std::string>& deletedArea) {
   for (const auto& area : deletedArea) {
+    if (numPrefixShards_ > 0) {
+      // remove entry from its shard, withdrawn at the end of sync
+      const auto shardId = PrefixShardKey::getShardOf(prefix, numPrefixShards_);
+      auto areaIt = prefixShards_.find(area);
+      if (areaIt != prefixShards_.end()) {
+        auto shardIt = areaIt->second.find(shardId);
+        if (shardIt != areaIt->second.end()) {
+          shardIt->second.erase(prefix);
+        }
+      }
+      dirtyPrefixShards_[area].emplace(shardId);
+
+      XLOG(DBG1) << "[Prefix Withdraw] " << "Area: " << area << ", "
+                 << folly::IPAddress::networkToString(prefix);
+      fb303::fbData->addStatValue(
+          "prefix_manager.route_withdraws", 1, fb303::SUM);
+      continue;
+    }
+
     // Prepare thrift::PrefixDatabase object for deletion
     thrift::PrefixDatabase deletedPrefixDb;
     deletedPrefixDb.thisNodeName() = nodeId_;
@@ -582,6 +643,75 @@ PrefixManager::deleteKvStoreKeyHelper(
   }
 }
 
+void
+PrefixManager::syncPrefixShardsInKvStore() {
+  for (const auto& [area, shardIds] : dirtyPrefixShards_) {
+    auto& shards = prefixShards_[area];
+    for (const auto shardId : shardIds) {
+      const auto shardKeyStr =
+          PrefixShardKey(nodeId_, shardId, area).getPrefixShardKey();
+
+      auto shardIt = shards.find(shardId);
+      if (shardIt == shards.end() or shardIt->second.empty()) {
+        // Remove shard from KvStore and flood deletion by setting deleted
+        // value.
+        thrift::PrefixDatabase deletedPrefixDb;
+        deletedPrefixDb.thisNodeName() = nodeId_;
+        deletedPrefixDb.deletePrefix() = true;
+        kvRequestQueue_.push(ClearKeyValueRequest(
+            AreaId{area},
+            shardKeyStr,
+            writeThriftObjStr(std::move(deletedPrefixDb), serializer_),
+            true));
+        if (shardIt != shards.end()) {
+          shards.erase(shardIt);
+        }
+        XLOG(DBG1) << "[Prefix Shard Withdraw] " << "Area: " << area << ", "
+                   << shardKeyStr;
+        continue;
+      }
+
+      std::vector<thrift::PrefixEntry> entries;
+      entries.reserve(shardIt->second.size());
+      for (const auto& [_, tPrefixEntry] : shardIt->second) {
+        entries.emplace_back(tPrefixEntry);
+      }
+      auto prefixDb = createPrefixDb(nodeId_, std::move(entries));
+      kvRequestQueue_.push(PersistKeyValueRequest(
+          AreaId{area},
+          shardKeyStr,
+          writeThriftObjStr(std::move(prefixDb), serializer_)));
+      XLOG(DBG1) << "[Prefix Shard Advertisement] " << "Area: " << area
+                 << ", " << shardKeyStr << " with "
+                 << shardIt->second.size() << " prefixes";
+    }
+  }
+  dirtyPrefixShards_.clear();
+
+  // ATTN: withdraw stale keys only after their prefixes are re-advertised in
+  // current format, so that receivers never see the prefixes flap.
+  for (const auto& [area, keyVals] : staleKeysToWithdraw_) {
+    for (const auto& [key, value] : keyVals) {
+      XLOG(DBG1) << "[Stale Key Withdraw] " << "Area: " << area << ", " << key;
+      kvRequestQueue_.push(
+          ClearKeyValueRequest(AreaId{area}, key, value, true));
+    }
+  }
+  staleKeysToWithdraw_.clear();
+
+  size_t numShards{0};
+  size_t maxShardPrefixes{0};
+  for (const auto& [_, shards] : prefixShards_) {
+    numShards += shards.size();
+    for (const auto& shard : shards) {
+      maxShardPrefixes = std::max(maxShardPrefixes, shard.second.size());
+    }
+  }
+  fb303::fbData->setCounter("prefix_manager.advertised_shards", numShards);
+  fb303::fbData->setCounter(
+      "prefix_manager.max_shard_prefixes", maxShardPrefixes);
+}
+
 void
 PrefixManager::triggerInitialPrefixDbSync() {
   if (uninitializedPrefixTypes_.empty()) {
@@ -692,6 +822,10 @@ PrefixManager::syncKvStore() {
     }
   } // for
 
+  // Advertise modified shards, if prefixes are packed, and withdraw stale
+  // keys
+  syncPrefixShardsInKvStore();
+
   // Reset pendingUpdates_ since all pending updates are processed.
   pendingUpdates_.clear();
 
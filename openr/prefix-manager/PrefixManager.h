@@ -292,6 +292,15 @@ class PrefixManager final : public OpenrEventBase {
       const folly::CIDRNetwork& prefix,
       const std::unordered_set<std::string>& deletedArea);
 
+  /*
+   * [Util function]
+   *
+   * Advertise or withdraw shard keys modified by addKvStoreKeyHelper() and
+   * deleteKvStoreKeyHelper() with packed prefix database. Withdraw own stale
+   * keys of the format not in use afterwards.
+   */
+  void syncPrefixShardsInKvStore();
+
   /*
    * Perform best entry selection among the given prefixTypeToEntry
    */
@@ -388,6 +397,10 @@ class PrefixManager final : public OpenrEventBase {
   // Openr config
   std::shared_ptr<const Config> config_;
 
+  // Number of shard keys prefixes are packed into per area. 0 advertises one
+  // key per prefix
+  const uint32_t numPrefixShards_{0};
+
   // map from area id to area policy
   std::unordered_map<std::string, std::optional<std::string>> areaToPolicy_;
 
@@ -449,6 +462,30 @@ class PrefixManager final : public OpenrEventBase {
   };
   std::unordered_map<folly::CIDRNetwork, AdvertiseStatus> advertiseStatus_{};
 
+  /*
+   * [Packed Prefix Database]
+   *
+   * With `numPrefixShards_` set, every prefix is hashed into one shard and
+   * each shard is advertised to KvStore as a single key carrying post-policy
+   * entries of all of its prefixes.
+   */
+  // area -> shard id -> post-policy entry of each prefix in the shard
+  std::unordered_map<
+      std::string,
+      std::unordered_map<
+          uint32_t,
+          std::unordered_map<folly::CIDRNetwork, thrift::PrefixEntry>>>
+      prefixShards_;
+
+  // area -> shards modified since last sync
+  std::unordered_map<std::string, std::unordered_set<uint32_t>>
+      dirtyPrefixShards_;
+
+  // area -> own key of the format not in use -> value withdrawing it. E.g.
+  // keys advertised before restart with different number of shards.
+  std::unordered_map<std::string, std::unordered_map<std::string, std::string>>
+      staleKeysToWithdraw_;
+
   // store pending updates from advertise/withdraw operation
   detail::PrefixManagerPendingUpdates pendingUpdates_;
 
@@ -5,6 +5,8 @@
  * LICENSE file in the root directory of this source tree.
  */
 
+#include <set>
+
 #include <folly/IPAddress.h>
 #include <folly/init/Init.h>
 #include <glog/logging.h>
@@ -814,6 +816,111 @@ TEST_F(PrefixManagerSmallTtlTestFixture, PrefixWithdrawExpiry) {
   evb.run();
 }
 
+class PrefixManagerPackedTestFixture : public PrefixManagerTestFixture {
+ public:
+  virtual thrift::OpenrConfig
+  createConfig() override {
+    auto tConfig = PrefixManagerTestFixture::createConfig();
+    tConfig.prefix_db_num_shards() = kNumShards;
+    return tConfig;
+  }
+
+  // Prefixes advertised across all shard keys
+  std::set<folly::CIDRNetwork>
+  getShardPrefixes() {
+    std::set<folly::CIDRNetwork> prefixes;
+    for (uint32_t shardId = 0; shardId < kNumShards; ++shardId) {
+      auto maybeValue = kvStoreWrapper->getKey(
+          kTestingAreaName,
+          PrefixShardKey(nodeId_, shardId, kTestingAreaName)
+              .getPrefixShardKey());
+      if (not maybeValue.has_value()) {
+        continue;
+      }
+      auto prefixDb = readThriftObjStr<thrift::PrefixDatabase>(
+          *maybeValue->value(), serializer);
+      if (*prefixDb.deletePrefix()) {
+        EXPECT_TRUE(prefixDb.prefixEntries()->empty());
+        continue;
+      }
+      EXPECT_FALSE(prefixDb.prefixEntries()->empty());
+      for (const auto& entry : *prefixDb.prefixEntries()) {
+        const auto prefix = toIPNetwork(*entry.prefix());
+        EXPECT_EQ(shardId, PrefixShardKey::getShardOf(prefix, kNumShards));
+        prefixes.emplace(prefix);
+      }
+    }
+    return prefixes;
+  }
+
+ protected:
+  static constexpr uint32_t kNumShards{2};
+};
+
+/**
+ * Verifies prefixes are packed into shard keys instead of per prefix keys, and
+ * shards are re-advertised or withdrawn as their prefixes change
+ */
+TEST_F(PrefixManagerPackedTestFixture, AdvertiseWithdrawShards) {
+  int scheduleAt{0};
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(scheduleAt += 0), [&]() noexcept {
+        prefixManager
+            ->advertisePrefixes(
+                {prefixEntry1, prefixEntry2, prefixEntry5, prefixEntry6})
+            .get();
+      });
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(
+          scheduleAt += 3 * Constants::kKvStoreSyncThrottleTimeout.count()),
+      [&]() noexcept {
+        EXPECT_THAT(
+            getShardPrefixes(),
+            testing::UnorderedElementsAre(
+                toIPNetwork(addr1),
+                toIPNetwork(addr2),
+                toIPNetwork(addr5),
+                toIPNetwork(addr6)));
+        // no per prefix key is advertised
+        EXPECT_GE(
+            kNumShards,
+            getNumPrefixes(Constants::kPrefixDbMarker.toString()));
+        // 4 prefixes across 2 shards, largest shard has at least half
+        EXPECT_LE(
+            2,
+            fb303::fbData->getCounter("prefix_manager.max_shard_prefixes"));
+
+        prefixManager->withdrawPrefixes({prefixEntry1, prefixEntry5}).get();
+      });
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(
+          scheduleAt += 3 * Constants::kKvStoreSyncThrottleTimeout.count()),
+      [&]() noexcept {
+        EXPECT_THAT(
+            getShardPrefixes(),
+            testing::UnorderedElementsAre(
+                toIPNetwork(addr2), toIPNetwork(addr6)));
+
+        prefixManager->withdrawPrefixes({prefixEntry2, prefixEntry6}).get();
+      });
+
+  evb.scheduleTimeout(
+      std::chrono::milliseconds(
+          scheduleAt += 3 * Constants::kKvStoreSyncThrottleTimeout.count()),
+      [&]() noexcept {
+        EXPECT_TRUE(getShardPrefixes().empty());
+        EXPECT_EQ(
+            0, fb303::fbData->getCounter("prefix_manager.max_shard_prefixes"));
+        evb.stop();
+      });
+
+  // let magic happen
+  evb.run();
+}
+
 TEST_F(PrefixManagerTestFixture, GetPrefixes) {
   prefixManager->advertisePrefixes({prefixEntry1});
   prefixManager->advertisePrefixes({prefixEntry2});
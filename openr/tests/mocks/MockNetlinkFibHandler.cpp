@@ -68,6 +68,7 @@ MockNetlinkFibHandler::addUnicastRoutes(
     unicastRouteDb->emplace(prefix, newNextHops);
   }
   addRoutesCount_ += routes->size() - failedPrefixes.size();
+  addRoutesBatchSizes_.wlock()->emplace_back(routes->size());
   updateUnicastRoutesBaton_.post();
 
   // Throw FibUpdateError if applicable
@@ -207,6 +208,9 @@ void
 MockNetlinkFibHandler::syncMplsFib(
     int16_t, std::unique_ptr<std::vector<openr::thrift::MplsRoute>> routes) {
   ensureHealthy();
+  if (not isMplsSyncHealthy_) {
+    throw std::runtime_error("Handler rejects mpls route sync");
+  }
 
   // Acquire locks
   auto mplsRouteDb = mplsRouteDb_.wlock();
@@ -355,6 +359,7 @@ MockNetlinkFibHandler::stop() {
   mplsRouteDb_->clear();
   fibSyncCount_ = 0;
   addRoutesCount_ = 0;
+  addRoutesBatchSizes_.wlock()->clear();
   delRoutesCount_ = 0;
   fibMplsSyncCount_ = 0;
   addMplsRoutesCount_ = 0;
@@ -372,6 +377,7 @@ MockNetlinkFibHandler::restart() {
   });
   fibSyncCount_ = 0;
   addRoutesCount_ = 0;
+  addRoutesBatchSizes_.wlock()->clear();
   delRoutesCount_ = 0;
   fibMplsSyncCount_ = 0;
   addMplsRoutesCount_ = 0;
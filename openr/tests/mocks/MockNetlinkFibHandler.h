@@ -97,6 +97,12 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
     return addRoutesCount_;
   }
 
+  // Number of routes in every addUnicastRoutes call, in order
+  std::vector<size_t>
+  getAddRoutesBatchSizes() {
+    return *addRoutesBatchSizes_.rlock();
+  }
+
   size_t
   getDelRoutesCount() {
     return delRoutesCount_;
@@ -119,6 +125,12 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
     isHealthy_ = isHealthy;
   }
 
+  // Fail MPLS route sync only, with std::exception
+  void
+  setMplsSyncHealthyState(bool isHealthy) {
+    isMplsSyncHealthy_ = isHealthy;
+  }
+
   /**
    * Marks following prefixes as dirty. This means any subsequent updates about
    * these prefixes would fail to program. Deletion may succeed.
@@ -153,11 +165,13 @@ class MockNetlinkFibHandler final : public thrift::FibServiceSvIf {
   // Stats
   std::atomic<size_t> fibSyncCount_{0};
   std::atomic<size_t> addRoutesCount_{0};
+  folly::Synchronized<std::vector<size_t>> addRoutesBatchSizes_;
   std::atomic<size_t> delRoutesCount_{0};
   std::atomic<size_t> fibMplsSyncCount_{0};
   std::atomic<size_t> addMplsRoutesCount_{0};
   std::atomic<size_t> delMplsRoutesCount_{0};
   std::atomic<bool> isHealthy_{true};
+  std::atomic<bool> isMplsSyncHealthy_{true};
 
   // A baton for synchronization
   folly::Baton<> updateUnicastRoutesBaton_;
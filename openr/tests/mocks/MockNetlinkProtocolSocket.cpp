@@ -54,6 +54,10 @@ MockNetlinkProtocolSocket::MockNetlinkProtocolSocket(folly::EventBase* evb)
   // Initialize stats
   fb303::fbData->addStatExportType("nlmock.add_route", fb303::SUM);
   fb303::fbData->addStatExportType("nlmock.delete_route", fb303::SUM);
+  fb303::fbData->addStatExportType("nlmock.add_nexthop", fb303::SUM);
+  fb303::fbData->addStatExportType("nlmock.add_nexthop_group", fb303::SUM);
+  fb303::fbData->addStatExportType("nlmock.delete_nexthop", fb303::SUM);
+  fb303::fbData->addStatExportType("nlmock.get_routes", fb303::SUM);
 }
 
 folly::SemiFuture<int>
@@ -64,7 +68,19 @@ MockNetlinkProtocolSocket::addRoute(const fbnl::Route& route) {
   if (route.getFamily() == AF_MPLS) {
     mplsRoutes_[proto][route.getMplsLabel().value()] = route;
   } else {
+    // Like kernel, replace route of any protocol with the same destination
+    // and priority. Only the new route is notified.
+    if (route.getPriority().has_value()) {
+      for (auto& [otherProto, routes] : unicastRoutes_) {
+        auto it = routes.find(route.getDestination());
+        if (otherProto != proto and it != routes.end() and
+            it->second.getPriority() == route.getPriority()) {
+          routes.erase(it);
+        }
+      }
+    }
     unicastRoutes_[proto][route.getDestination()] = route;
+    notifyRouteEvent(RouteEvent{route, false /* isDeleted */});
   }
   return folly::SemiFuture<int>(0);
 }
@@ -78,7 +94,13 @@ MockNetlinkProtocolSocket::deleteRoute(const fbnl::Route& route) {
   if (route.getFamily() == AF_MPLS) {
     cnt = mplsRoutes_[proto].erase(route.getMplsLabel().value());
   } else {
-    cnt = unicastRoutes_[proto].erase(route.getDestination());
+    auto& routes = unicastRoutes_[proto];
+    auto it = routes.find(route.getDestination());
+    if (it != routes.end()) {
+      notifyRouteEvent(RouteEvent{std::move(it->second), true /* isDeleted */});
+      routes.erase(it);
+      cnt = 1;
+    }
   }
   // Return 0 on success else ESRCH (no such process) error code
   return folly::SemiFuture<int>(cnt ? 0 : ESRCH);
@@ -86,6 +108,7 @@ MockNetlinkProtocolSocket::deleteRoute(const fbnl::Route& route) {
 
 folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>>
 MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
+  fb303::fbData->addStatValue("nlmock.get_routes", 1, fb303::SUM);
   const auto filterFamily = filter.getFamily();
   const auto filterProto = filter.getProtocolId();
   const auto filterType = filter.getType();
@@ -108,6 +131,19 @@ MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
     }
 
     result.emplace_back(route);
+
+    // Resolve nexthops of route referring to nexthop group, the same way
+    // kernel reports them
+    if (route.getNhId().has_value()) {
+      NextHopSet nextHops;
+      auto groupIt = nexthopGroups_.find(route.getNhId().value());
+      if (groupIt != nexthopGroups_.end()) {
+        for (const auto& [nhId, _] : groupIt->second) {
+          nextHops.emplace(nexthops_.at(nhId));
+        }
+      }
+      result.back().setNextHops(nextHops);
+    }
   };
 
   // Loop through mpls routes
@@ -127,6 +163,53 @@ MockNetlinkProtocolSocket::getRoutes(const fbnl::Route& filter) {
   return result;
 }
 
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::addNexthop(
+    uint32_t id, const fbnl::NextHop& nextHop, uint8_t protocolId) {
+  fb303::fbData->addStatValue("nlmock.add_nexthop", 1, fb303::SUM);
+  // Blindly replace existing nexthop
+  nexthops_.insert_or_assign(id, nextHop);
+  nexthopProtocols_[id] = protocolId;
+  return folly::SemiFuture<int>(0);
+}
+
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::addNexthopGroup(
+    uint32_t id,
+    const std::vector<std::pair<uint32_t, uint8_t>>& members,
+    uint8_t protocolId) {
+  fb303::fbData->addStatValue("nlmock.add_nexthop_group", 1, fb303::SUM);
+  // All members must exist
+  for (const auto& [nhId, _] : members) {
+    if (not nexthops_.count(nhId)) {
+      return folly::SemiFuture<int>(-EINVAL);
+    }
+  }
+  // Blindly replace existing group
+  nexthopGroups_[id] = members;
+  nexthopProtocols_[id] = protocolId;
+  return folly::SemiFuture<int>(0);
+}
+
+folly::SemiFuture<int>
+MockNetlinkProtocolSocket::deleteNexthop(uint32_t id) {
+  fb303::fbData->addStatValue("nlmock.delete_nexthop", 1, fb303::SUM);
+  // Count number of elements erased
+  int cnt = nexthops_.erase(id) + nexthopGroups_.erase(id);
+  nexthopProtocols_.erase(id);
+  // Return 0 on success else ENOENT error code
+  return folly::SemiFuture<int>(cnt ? 0 : -ENOENT);
+}
+
+folly::SemiFuture<
+    folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+MockNetlinkProtocolSocket::getAllNexthops() {
+  fb303::fbData->addStatValue("nlmock.get_nexthops", 1, fb303::SUM);
+  std::vector<std::pair<uint32_t, uint8_t>> nexthops(
+      nexthopProtocols_.begin(), nexthopProtocols_.end());
+  return nexthops;
+}
+
 folly::SemiFuture<int>
 MockNetlinkProtocolSocket::addIfAddress(const fbnl::IfAddress& addr) {
   // Search for addr list of interface index (it must exists)
@@ -55,6 +55,30 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
   folly::SemiFuture<folly::Expected<std::vector<fbnl::Route>, int>> getRoutes(
       const fbnl::Route& filter) override;
 
+  folly::SemiFuture<int> addNexthop(
+      uint32_t id, const fbnl::NextHop& nextHop, uint8_t protocolId) override;
+  folly::SemiFuture<int> addNexthopGroup(
+      uint32_t id,
+      const std::vector<std::pair<uint32_t, uint8_t>>& members,
+      uint8_t protocolId) override;
+  folly::SemiFuture<int> deleteNexthop(uint32_t id) override;
+  folly::SemiFuture<
+      folly::Expected<std::vector<std::pair<uint32_t, uint8_t>>, int>>
+  getAllNexthops() override;
+
+  /**
+   * API to inspect nexthop objects for testing purposes
+   */
+  size_t
+  getNumNexthops() const {
+    return nexthops_.size();
+  }
+
+  size_t
+  getNumNexthopGroups() const {
+    return nexthopGroups_.size();
+  }
+
   folly::SemiFuture<int> addIfAddress(const fbnl::IfAddress&) override;
   folly::SemiFuture<int> deleteIfAddress(const fbnl::IfAddress&) override;
   folly::SemiFuture<folly::Expected<std::vector<fbnl::IfAddress>, int>>
@@ -105,6 +129,15 @@ class MockNetlinkProtocolSocket : public NetlinkProtocolSocket {
       unicastRoutes_;
   std::unordered_map<uint8_t, std::map<uint32_t, fbnl::Route>> mplsRoutes_;
 
+  // map<id -> NextHop> and map<id -> list<member id, weight>> of kernel
+  // nexthop objects. Routes with nhId resolve their nexthops from these.
+  std::unordered_map<uint32_t, fbnl::NextHop> nexthops_;
+  std::unordered_map<uint32_t, std::vector<std::pair<uint32_t, uint8_t>>>
+      nexthopGroups_;
+
+  // map<id -> protocol> of kernel nexthop objects
+  std::unordered_map<uint32_t, uint8_t> nexthopProtocols_;
+
   // queue to publish LINK/ADDR updates
   messaging::ReplicateQueue<NetlinkEvent> netlinkEventsQueue_;
 };
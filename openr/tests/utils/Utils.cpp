@@ -427,6 +427,27 @@ generateTopo(
     }
     break;
   }
+  /*
+   * Full Mesh Topology Illustration:
+   *  0 --- 1
+   *  | \ / |
+   *  | / \ |
+   *  3 --- 2
+   * Every node is directly connected to every other node
+   */
+  case ClusterTopology::FULL_MESH: {
+    for (size_t i = 0; i < stores.size(); i++) {
+      for (size_t j = i + 1; j < stores.size(); j++) {
+        KvStoreWrapper<apache::thrift::Client<thrift::KvStoreService>>* a =
+            stores.at(i).get();
+        KvStoreWrapper<apache::thrift::Client<thrift::KvStoreService>>* b =
+            stores.at(j).get();
+        a->addPeer(kTestingAreaName, b->getNodeId(), b->getPeerSpec());
+        b->addPeer(kTestingAreaName, a->getNodeId(), a->getPeerSpec());
+      }
+    }
+    break;
+  }
   default: {
     throw std::runtime_error("invalid topology type");
   }
@@ -141,6 +141,7 @@ enum class ClusterTopology {
   LINEAR = 0,
   RING = 1,
   STAR = 2,
+  FULL_MESH = 3,
   // TODO: add more topo
 };
 